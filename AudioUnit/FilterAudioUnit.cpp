@@ -1,6 +1,7 @@
 #include "FilterAudioUnit.h"
 #include <cmath>
 #include <algorithm>
+#include <cstdio>
 
 // Component registration
 static const ComponentDescription kAudioUnitDescription = {
@@ -13,12 +14,15 @@ static const ComponentDescription kAudioUnitDescription = {
 
 FilterAudioUnit::FilterAudioUnit(AudioUnit inAudioUnit)
     : mAudioUnit(inAudioUnit)
-    , mCutoffFrequency(1000.0f)
-    , mFilterType(kFilterType_LowPass)
     , mSampleRate(44100.0)
+    , mMaxFramesPerSlice(FilterDSP::kDefaultMaxBlockSize)
     , mInitialized(false)
 {
     // Initialize filter state
+    mFilter.setSampleRate((float)mSampleRate);
+    mFilter.setCutoff(1000.0f);
+    mFilter.setFilterType(kFilterType_LowPass);
+    mFilter.setSmoothingTime((float)FilterDSP::kDefaultSmoothingTime);  // Ramp cutoff changes
     ResetFilter();
     
     // Set default stream format
@@ -40,6 +44,15 @@ OSStatus FilterAudioUnit::Initialize() {
         return noErr;
     }
     
+    // Size filter state for the negotiated channel count
+    if (mStreamFormat.mChannelsPerFrame < 1 || mStreamFormat.mChannelsPerFrame > (UInt32)FilterDSP::kMaxChannels) {
+        return kAudioUnitErr_FormatNotSupported;
+    }
+    mFilter.prepare((int)mStreamFormat.mChannelsPerFrame, (int)mMaxFramesPerSlice);
+    mBypass.setFadeLength((int)(FilterDSP::kDefaultBypassFadeTime * mSampleRate));
+    mBypass.prepare((int)mStreamFormat.mChannelsPerFrame, mFilter.getMaxLatencySamples());
+    mBypass.setDryDelay(mFilter.getLatencySamples());
+    
     ResetFilter();
     mInitialized = true;
     return noErr;
@@ -76,6 +89,26 @@ OSStatus FilterAudioUnit::GetPropertyInfo(AudioUnitPropertyID inID,
             outWritable = false;
             return noErr;
             
+        case kAudioUnitProperty_SupportedNumChannels:
+            outDataSize = sizeof(AUChannelInfo);
+            outWritable = false;
+            return noErr;
+            
+        case kAudioUnitProperty_BypassEffect:
+            outDataSize = sizeof(UInt32);
+            outWritable = true;
+            return noErr;
+            
+        case kAudioUnitProperty_TailTime:
+            outDataSize = sizeof(Float64);
+            outWritable = false;
+            return noErr;
+            
+        case kAudioUnitProperty_Latency:
+            outDataSize = sizeof(Float64);
+            outWritable = false;
+            return noErr;
+            
         default:
             return kAudioUnitErr_InvalidProperty;
     }
@@ -103,15 +136,74 @@ OSStatus FilterAudioUnit::GetProperty(AudioUnitPropertyID inID,
             ioDataSize = sizeof(Float64);
             return noErr;
             
-        case kAudioUnitProperty_ParameterList:
+        case kAudioUnitProperty_MaximumFramesPerSlice:
+            if (ioDataSize < sizeof(UInt32)) {
+                return kAudioUnitErr_InvalidPropertyValue;
+            }
+            *(UInt32*)outData = mMaxFramesPerSlice;
+            ioDataSize = sizeof(UInt32);
+            return noErr;
+            
+        case kAudioUnitProperty_ParameterList: {
             if (ioDataSize < kNumberOfParameters * sizeof(AudioUnitParameterID)) {
                 return kAudioUnitErr_InvalidPropertyValue;
             }
             AudioUnitParameterID* paramList = (AudioUnitParameterID*)outData;
             paramList[0] = kParam_FilterType;
             paramList[1] = kParam_CutoffFrequency;
+            paramList[2] = kParam_Slope;
+            paramList[3] = kParam_Alignment;
+            paramList[4] = kParam_Mode;
+            paramList[5] = kParam_Oversampling;
+            paramList[6] = kParam_Resonance;
+            paramList[7] = kParam_Q;
+            paramList[8] = kParam_Gain;
+            paramList[9] = kParam_BankBands;
+            paramList[10] = kParam_BankLayout;
+            for (int band = 0; band < FilterDSP::kMaxBankBands; band++) {
+                paramList[kParam_BandGain + band] = kParam_BandGain + band;
+            }
             ioDataSize = kNumberOfParameters * sizeof(AudioUnitParameterID);
             return noErr;
+        }
+            
+        case kAudioUnitProperty_SupportedNumChannels: {
+            if (ioDataSize < sizeof(AUChannelInfo)) {
+                return kAudioUnitErr_InvalidPropertyValue;
+            }
+            // Any channel count, as long as input and output match
+            AUChannelInfo* channelInfo = (AUChannelInfo*)outData;
+            channelInfo->inChannels = -1;
+            channelInfo->outChannels = -1;
+            ioDataSize = sizeof(AUChannelInfo);
+            return noErr;
+        }
+            
+        case kAudioUnitProperty_BypassEffect:
+            if (ioDataSize < sizeof(UInt32)) {
+                return kAudioUnitErr_InvalidPropertyValue;
+            }
+            *(UInt32*)outData = mBypass.isBypassed() ? 1 : 0;
+            ioDataSize = sizeof(UInt32);
+            return noErr;
+            
+        case kAudioUnitProperty_TailTime:
+            if (ioDataSize < sizeof(Float64)) {
+                return kAudioUnitErr_InvalidPropertyValue;
+            }
+            // Time for the current settings to ring out
+            *(Float64*)outData = mFilter.getTailSamples() / mSampleRate;
+            ioDataSize = sizeof(Float64);
+            return noErr;
+            
+        case kAudioUnitProperty_Latency:
+            if (ioDataSize < sizeof(Float64)) {
+                return kAudioUnitErr_InvalidPropertyValue;
+            }
+            // Delay of the oversampling filters or the linear-phase FIR
+            *(Float64*)outData = mFilter.getLatencySamples() / mSampleRate;
+            ioDataSize = sizeof(Float64);
+            return noErr;
             
         default:
             return kAudioUnitErr_InvalidProperty;
@@ -124,13 +216,19 @@ OSStatus FilterAudioUnit::SetProperty(AudioUnitPropertyID inID,
                                      const void* inData,
                                      UInt32 inDataSize) {
     switch (inID) {
-        case kAudioUnitProperty_StreamFormat:
+        case kAudioUnitProperty_StreamFormat: {
             if (inDataSize < sizeof(AudioStreamBasicDescription)) {
                 return kAudioUnitErr_InvalidPropertyValue;
             }
-            mStreamFormat = *(const AudioStreamBasicDescription*)inData;
+            const AudioStreamBasicDescription& format = *(const AudioStreamBasicDescription*)inData;
+            if (format.mChannelsPerFrame < 1 || format.mChannelsPerFrame > (UInt32)FilterDSP::kMaxChannels) {
+                return kAudioUnitErr_FormatNotSupported;
+            }
+            mStreamFormat = format;
             mSampleRate = mStreamFormat.mSampleRate;
+            mFilter.setSampleRate((float)mSampleRate);
             return noErr;
+        }
             
         case kAudioUnitProperty_SampleRate:
             if (inDataSize < sizeof(Float64)) {
@@ -138,6 +236,23 @@ OSStatus FilterAudioUnit::SetProperty(AudioUnitPropertyID inID,
             }
             mSampleRate = *(const Float64*)inData;
             mStreamFormat.mSampleRate = mSampleRate;
+            mFilter.setSampleRate((float)mSampleRate);
+            return noErr;
+            
+        case kAudioUnitProperty_MaximumFramesPerSlice:
+            if (inDataSize < sizeof(UInt32) || *(const UInt32*)inData == 0) {
+                return kAudioUnitErr_InvalidPropertyValue;
+            }
+            // Takes effect at the next Initialize
+            mMaxFramesPerSlice = *(const UInt32*)inData;
+            return noErr;
+            
+        case kAudioUnitProperty_BypassEffect:
+            if (inDataSize < sizeof(UInt32)) {
+                return kAudioUnitErr_InvalidPropertyValue;
+            }
+            // Crossfades; the filter keeps its memory while bypassed
+            mBypass.setBypassed(*(const UInt32*)inData != 0);
             return noErr;
             
         default:
@@ -153,10 +268,12 @@ OSStatus FilterAudioUnit::GetParameterInfo(AudioUnitParameterID inID,
     
     switch (inID) {
         case kParam_FilterType:
+            // Low pass, high pass, band pass, notch, bell, low shelf, high
+            // shelf, all pass (band pass onwards are one biquad set by Q and gain)
             strncpy(outParameterInfo.name, "Filter Type", sizeof(outParameterInfo.name));
             outParameterInfo.unit = kAudioUnitParameterUnit_Indexed;
-            outParameterInfo.minValue = 0;
-            outParameterInfo.maxValue = 1;
+            outParameterInfo.minValue = kFilterType_LowPass;
+            outParameterInfo.maxValue = kFilterType_AllPass;
             outParameterInfo.defaultValue = 0;
             return noErr;
             
@@ -169,7 +286,99 @@ OSStatus FilterAudioUnit::GetParameterInfo(AudioUnitParameterID inID,
             outParameterInfo.flags |= kAudioUnitParameterFlag_DisplayLogarithmic;
             return noErr;
             
+        case kParam_Slope:
+            // 6, 12, 24, 36, 48 dB/oct
+            strncpy(outParameterInfo.name, "Slope", sizeof(outParameterInfo.name));
+            outParameterInfo.unit = kAudioUnitParameterUnit_Indexed;
+            outParameterInfo.minValue = FilterDSP::kSlope6dB;
+            outParameterInfo.maxValue = FilterDSP::kSlope48dB;
+            outParameterInfo.defaultValue = FilterDSP::kSlope6dB;
+            return noErr;
+            
+        case kParam_Alignment:
+            // Butterworth, Linkwitz-Riley
+            strncpy(outParameterInfo.name, "Alignment", sizeof(outParameterInfo.name));
+            outParameterInfo.unit = kAudioUnitParameterUnit_Indexed;
+            outParameterInfo.minValue = FilterDSP::kAlignmentButterworth;
+            outParameterInfo.maxValue = FilterDSP::kAlignmentLinkwitzRiley;
+            outParameterInfo.defaultValue = FilterDSP::kAlignmentButterworth;
+            return noErr;
+            
+        case kParam_Mode:
+            // Standard (one-pole / biquad cascade), state variable, linear
+            // phase, ladder, graphic EQ; linear phase changes the latency
+            strncpy(outParameterInfo.name, "Mode", sizeof(outParameterInfo.name));
+            outParameterInfo.unit = kAudioUnitParameterUnit_Indexed;
+            outParameterInfo.minValue = FilterDSP::kFilterModeStandard;
+            outParameterInfo.maxValue = FilterDSP::kFilterModeGraphicEq;
+            outParameterInfo.defaultValue = FilterDSP::kFilterModeStandard;
+            return noErr;
+            
+        case kParam_Oversampling:
+            // 1x, 2x, 4x, 8x; changes the latency
+            strncpy(outParameterInfo.name, "Oversampling", sizeof(outParameterInfo.name));
+            outParameterInfo.unit = kAudioUnitParameterUnit_Indexed;
+            outParameterInfo.minValue = FilterDSP::kOversampling1x;
+            outParameterInfo.maxValue = FilterDSP::kOversampling8x;
+            outParameterInfo.defaultValue = FilterDSP::kOversampling1x;
+            return noErr;
+            
+        case kParam_Resonance:
+            // Ladder mode only; 1 is the edge of self-oscillation
+            strncpy(outParameterInfo.name, "Resonance", sizeof(outParameterInfo.name));
+            outParameterInfo.unit = kAudioUnitParameterUnit_Generic;
+            outParameterInfo.minValue = 0.0f;
+            outParameterInfo.maxValue = 1.0f;
+            outParameterInfo.defaultValue = 0.0f;
+            return noErr;
+            
+        case kParam_Q:
+            // Band pass to all pass, and the state variable filter's resonance
+            strncpy(outParameterInfo.name, "Q", sizeof(outParameterInfo.name));
+            outParameterInfo.unit = kAudioUnitParameterUnit_Generic;
+            outParameterInfo.minValue = (float)FilterDSP::kMinQ;
+            outParameterInfo.maxValue = (float)FilterDSP::kMaxQ;
+            outParameterInfo.defaultValue = (float)FilterDSP::kDefaultQ;
+            outParameterInfo.flags |= kAudioUnitParameterFlag_DisplayLogarithmic;
+            return noErr;
+            
+        case kParam_Gain:
+            // Bell and shelves only
+            strncpy(outParameterInfo.name, "Gain", sizeof(outParameterInfo.name));
+            outParameterInfo.unit = kAudioUnitParameterUnit_Decibels;
+            outParameterInfo.minValue = (float)-FilterDSP::kMaxGainDb;
+            outParameterInfo.maxValue = (float)FilterDSP::kMaxGainDb;
+            outParameterInfo.defaultValue = 0.0f;
+            return noErr;
+            
+        case kParam_BankBands:
+            // Graphic EQ bands spread evenly over 20 Hz - 20 kHz (31 = third octaves)
+            strncpy(outParameterInfo.name, "EQ Bands", sizeof(outParameterInfo.name));
+            outParameterInfo.unit = kAudioUnitParameterUnit_Generic;
+            outParameterInfo.minValue = 1.0f;
+            outParameterInfo.maxValue = (float)FilterDSP::kMaxBankBands;
+            outParameterInfo.defaultValue = (float)FilterDSP::kMaxBankBands;
+            return noErr;
+            
+        case kParam_BankLayout:
+            // Serial, parallel
+            strncpy(outParameterInfo.name, "EQ Layout", sizeof(outParameterInfo.name));
+            outParameterInfo.unit = kAudioUnitParameterUnit_Indexed;
+            outParameterInfo.minValue = FilterDSP::kBankLayoutSerial;
+            outParameterInfo.maxValue = FilterDSP::kBankLayoutParallel;
+            outParameterInfo.defaultValue = FilterDSP::kBankLayoutSerial;
+            return noErr;
+            
         default:
+            // One gain per graphic EQ band; bands at 0 dB cost nothing
+            if (inID >= kParam_BandGain && inID < kNumberOfParameters) {
+                snprintf(outParameterInfo.name, sizeof(outParameterInfo.name), "EQ Band %d Gain", (int)(inID - kParam_BandGain) + 1);
+                outParameterInfo.unit = kAudioUnitParameterUnit_Decibels;
+                outParameterInfo.minValue = (float)-FilterDSP::kMaxBankGainDb;
+                outParameterInfo.maxValue = (float)FilterDSP::kMaxBankGainDb;
+                outParameterInfo.defaultValue = 0.0f;
+                return noErr;
+            }
             return kAudioUnitErr_InvalidParameter;
     }
 }
@@ -180,14 +389,54 @@ OSStatus FilterAudioUnit::GetParameter(AudioUnitParameterID inID,
                                       AudioUnitParameterValue& outValue) {
     switch (inID) {
         case kParam_FilterType:
-            outValue = mFilterType;
+            outValue = mFilter.getFilterType();
             return noErr;
             
         case kParam_CutoffFrequency:
-            outValue = mCutoffFrequency;
+            outValue = mFilter.getCutoff();
+            return noErr;
+            
+        case kParam_Slope:
+            outValue = mFilter.getSlope();
+            return noErr;
+            
+        case kParam_Alignment:
+            outValue = mFilter.getAlignment();
+            return noErr;
+            
+        case kParam_Mode:
+            outValue = mFilter.getMode();
+            return noErr;
+            
+        case kParam_Oversampling:
+            outValue = mFilter.getOversampling();
+            return noErr;
+            
+        case kParam_Resonance:
+            outValue = mFilter.getResonance();
+            return noErr;
+            
+        case kParam_Q:
+            outValue = (float)mFilter.getQ();
+            return noErr;
+            
+        case kParam_Gain:
+            outValue = (float)mFilter.getGain();
+            return noErr;
+            
+        case kParam_BankBands:
+            outValue = mFilter.getNumBands();
+            return noErr;
+            
+        case kParam_BankLayout:
+            outValue = mFilter.getBankLayout();
             return noErr;
             
         default:
+            if (inID >= kParam_BandGain && inID < kNumberOfParameters) {
+                outValue = (float)mFilter.getBandGain((int)(inID - kParam_BandGain));
+                return noErr;
+            }
             return kAudioUnitErr_InvalidParameter;
     }
 }
@@ -199,15 +448,64 @@ OSStatus FilterAudioUnit::SetParameter(AudioUnitParameterID inID,
                                       UInt32 inBufferOffsetInFrames) {
     switch (inID) {
         case kParam_FilterType:
-            mFilterType = (int)inValue;
+            mFilter.setFilterType((int)inValue);
             ResetFilter();  // Reset filter state when changing type
             return noErr;
             
         case kParam_CutoffFrequency:
-            mCutoffFrequency = std::max(50.0f, std::min(8000.0f, inValue));
+            mFilter.setCutoff(std::max(50.0f, std::min(8000.0f, inValue)));
+            return noErr;
+            
+        case kParam_Slope:
+            mFilter.setSlope(std::max(0, std::min((int)FilterDSP::kSlope48dB, (int)inValue)));
+            return noErr;
+            
+        case kParam_Alignment:
+            mFilter.setAlignment((int)inValue == FilterDSP::kAlignmentLinkwitzRiley
+                                 ? FilterDSP::kAlignmentLinkwitzRiley : FilterDSP::kAlignmentButterworth);
+            return noErr;
+            
+        case kParam_Mode:
+            mFilter.setMode(std::max(0, std::min((int)FilterDSP::kFilterModeGraphicEq, (int)inValue)));
+            // Linear phase is allocated on selection here, as the AU is not
+            // initialized again for the latency change
+            if (mInitialized) {
+                mFilter.prepareLinearPhase();
+            }
+            mBypass.setDryDelay(mFilter.getLatencySamples());
+            return noErr;
+            
+        case kParam_Oversampling:
+            mFilter.setOversampling(std::max(0, std::min((int)FilterDSP::kOversampling8x, (int)inValue)));
+            mBypass.setDryDelay(mFilter.getLatencySamples());  // Bypass keeps the latency
+            return noErr;
+            
+        case kParam_Resonance:
+            mFilter.setResonance(inValue);
+            return noErr;
+            
+        case kParam_Q:
+            mFilter.setQ(inValue);
+            return noErr;
+            
+        case kParam_Gain:
+            mFilter.setGain(inValue);
+            return noErr;
+            
+        case kParam_BankBands:
+            mFilter.setNumBands((int)(inValue + 0.5f));
+            return noErr;
+            
+        case kParam_BankLayout:
+            mFilter.setBankLayout((int)inValue == FilterDSP::kBankLayoutParallel
+                                  ? FilterDSP::kBankLayoutParallel : FilterDSP::kBankLayoutSerial);
             return noErr;
             
         default:
+            if (inID >= kParam_BandGain && inID < kNumberOfParameters) {
+                mFilter.setBandGain((int)(inID - kParam_BandGain), inValue);
+                return noErr;
+            }
             return kAudioUnitErr_InvalidParameter;
     }
 }
@@ -220,59 +518,35 @@ OSStatus FilterAudioUnit::Render(AudioUnitRenderActionFlags& ioActionFlags,
         return kAudioUnitErr_Uninitialized;
     }
     
-    // Process each channel
-    for (UInt32 channel = 0; channel < ioData.mNumberBuffers; ++channel) {
-        Float32* channelData = (Float32*)ioData.mBuffers[channel].mData;
-        UInt32 numSamples = inFramesToProcess;
-        
-        // Process each sample
-        for (UInt32 sample = 0; sample < numSamples; ++sample) {
-            float input = channelData[sample];
-            float output;
-            
-            if (mFilterType == kFilterType_LowPass) {
-                output = ApplyLowPassFilter(input, channel);
-            } else {
-                output = ApplyHighPassFilter(input, channel);
-            }
-            
-            channelData[sample] = output;
-        }
+    // Flush subnormals to zero for the whole callback
+    FilterDSP::ScopedNoDenormals noDenormals;
+    
+    UInt32 numChannels = std::min<UInt32>(ioData.mNumberBuffers, (UInt32)mFilter.getNumChannels());
+    
+    // Silent input with decayed filter memory and no bypass crossfade or
+    // delayed dry signal left: the output is silent too, so keep the
+    // silence flag and skip all work. The dry delay line still takes the
+    // block's silence.
+    if ((ioActionFlags & kAudioUnitRenderAction_OutputIsSilence) && mFilter.isDecayed() && mBypass.isSilent()) {
+        mBypass.skipSilence((int)numChannels, (int)inFramesToProcess);
+        return noErr;
+    }
+    ioActionFlags &= ~kAudioUnitRenderAction_OutputIsSilence;
+    
+    // Gather the non-interleaved channel buffers (processed in place)
+    Float32* channels[FilterDSP::kMaxChannels];
+    for (UInt32 channel = 0; channel < numChannels; ++channel) {
+        channels[channel] = (Float32*)ioData.mBuffers[channel].mData;
     }
     
+    // While bypassed the filter does not run and the buffers are left as is
+    mBypass.process(mFilter, channels, channels, (int)numChannels, (int)inFramesToProcess);
+    
     return noErr;
 }
 
-float FilterAudioUnit::ApplyLowPassFilter(float input, int channel) {
-    // y[n] = (1-α)·x[n] + α·y[n-1]
-    // where α = 1 / (1 + fc/sample_rate)
-    float alpha = CalculateAlpha(mCutoffFrequency, mSampleRate, kFilterType_LowPass);
-    float output = (1.0f - alpha) * input + alpha * mPrevOutput[channel];
-    mPrevOutput[channel] = output;
-    return output;
-}
-
-float FilterAudioUnit::ApplyHighPassFilter(float input, int channel) {
-    // y[n] = α·(y[n-1] + x[n] - x[n-1])
-    // where α = fc / (fc + sample_rate)
-    float alpha = CalculateAlpha(mCutoffFrequency, mSampleRate, kFilterType_HighPass);
-    float output = alpha * (mPrevOutput[channel] + input - mPrevInput[channel]);
-    mPrevInput[channel] = input;
-    mPrevOutput[channel] = output;
-    return output;
-}
-
 void FilterAudioUnit::ResetFilter() {
-    mPrevOutput[0] = mPrevOutput[1] = 0.0f;
-    mPrevInput[0] = mPrevInput[1] = 0.0f;
-}
-
-float FilterAudioUnit::CalculateAlpha(float cutoffFreq, float sampleRate, int filterType) {
-    if (filterType == kFilterType_LowPass) {
-        return 1.0f / (1.0f + cutoffFreq / sampleRate);
-    } else {
-        return cutoffFreq / (cutoffFreq + sampleRate);
-    }
+    mFilter.reset();
 }
 
 // Component dispatch functions
@@ -3,6 +3,9 @@
 #include <AudioUnit/AudioUnit.h>
 #include <AudioToolbox/AudioToolbox.h>
 #include <CoreFoundation/CoreFoundation.h>
+#include "BypassFader.h"
+#include "DenormalGuard.h"
+#include "FilterEngine.h"
 
 // Audio Unit Component Entry Point
 extern "C" {
@@ -13,13 +16,29 @@ extern "C" {
 enum {
     kParam_FilterType = 0,
     kParam_CutoffFrequency = 1,
-    kNumberOfParameters = 2
+    kParam_Slope = 2,
+    kParam_Alignment = 3,
+    kParam_Mode = 4,
+    kParam_Oversampling = 5,
+    kParam_Resonance = 6,
+    kParam_Q = 7,
+    kParam_Gain = 8,
+    kParam_BankBands = 9,
+    kParam_BankLayout = 10,
+    kParam_BandGain = 11,   // Graphic EQ band gains, kParam_BandGain + band
+    kNumberOfParameters = kParam_BandGain + FilterDSP::kMaxBankBands
 };
 
 // Filter types
 enum {
     kFilterType_LowPass = 0,
-    kFilterType_HighPass = 1
+    kFilterType_HighPass = 1,
+    kFilterType_BandPass = 2,
+    kFilterType_Notch = 3,
+    kFilterType_Peak = 4,
+    kFilterType_LowShelf = 5,
+    kFilterType_HighShelf = 6,
+    kFilterType_AllPass = 7
 };
 
 class FilterAudioUnit {
@@ -71,25 +90,20 @@ public:
 
 private:
     // Filter implementation
-    float ApplyLowPassFilter(float input, int channel);
-    float ApplyHighPassFilter(float input, int channel);
-    
     void ResetFilter();
-    float CalculateAlpha(float cutoffFreq, float sampleRate, int filterType);
     
     // Audio Unit instance
     AudioUnit mAudioUnit;
     
-    // Parameters
-    float mCutoffFrequency;
-    int mFilterType;
+    // Shared filter engine (parameters and per-channel filter state)
+    FilterDSP::FilterEngine<float> mFilter;
     
-    // Filter state (stereo)
-    float mPrevOutput[2];
-    float mPrevInput[2];
+    // kAudioUnitProperty_BypassEffect crossfade and pass-through
+    FilterDSP::BypassFader<float> mBypass;
     
     // Audio properties
     Float64 mSampleRate;
+    UInt32 mMaxFramesPerSlice;  // sizes the linear-phase partitions
     bool mInitialized;
     
     // Audio stream format
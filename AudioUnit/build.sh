@@ -18,12 +18,13 @@ mkdir -p $BUILD_DIR
 
 # Compile the Audio Unit
 echo "Compiling source files..."
-g++ -c -Wall -O2 \
+g++ -c -std=c++17 -Wall -O2 \
     -arch x86_64 -arch arm64 \
     -mmacosx-version-min=10.9 \
     -I/System/Library/Frameworks/AudioUnit.framework/Headers \
     -I/System/Library/Frameworks/AudioToolbox.framework/Headers \
     -I/System/Library/Frameworks/CoreFoundation.framework/Headers \
+    -I../DSP \
     -fPIC \
     FilterAudioUnit.cpp \
     -o $BUILD_DIR/FilterAudioUnit.o
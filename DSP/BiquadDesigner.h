@@ -0,0 +1,257 @@
+#pragma once
+
+// Biquad coefficient design for the 12-48 dB/oct cascades and the
+// single-section band, bell, shelf and all-pass types.
+// Sections are second-order bilinear-transform designs (prewarped at the
+// cutoff) in the form
+//   H(z) = (b0 + b1·z^-1 + b2·z^-2) / (1 + a1·z^-1 + a2·z^-2)
+// so every type runs on the same cascade kernel (BiquadKernels.h).
+
+#include "CoefficientTables.h"
+#include "FilterCoefficients.h"
+
+#include <cmath>
+
+namespace FilterDSP {
+
+// Filter slopes (kSlopeId / kParam_Slope). 6 dB/oct is the one-pole engine.
+enum FilterSlope
+{
+    kSlope6dB = 0,
+    kSlope12dB = 1,
+    kSlope24dB = 2,
+    kSlope36dB = 3,
+    kSlope48dB = 4,
+    kNumSlopes = 5
+};
+
+// Cascade alignment (kAlignmentId / kParam_Alignment)
+enum FilterAlignment
+{
+    kAlignmentButterworth = 0,
+    kAlignmentLinkwitzRiley = 1,
+    kNumAlignments = 2
+};
+
+// 48 dB/oct needs four second-order sections
+static const int kMaxBiquadSections = 4;
+
+// Q and gain of the single-section types (kQId / kParam_Q, kGainId /
+// kParam_Gain). The default Q is Butterworth: a maximally flat shelf, and
+// the band pass and notch of the 12 dB/oct state variable filter.
+static const double kDefaultQ = 0.70710678118654752440;
+static const double kMinQ = 0.1;
+static const double kMaxQ = 20.0;
+static const double kMaxGainDb = 24.0;
+
+template <typename SampleType>
+struct BiquadCoefficients
+{
+    SampleType b0;
+    SampleType b1;
+    SampleType b2;
+    SampleType a1;
+    SampleType a2;
+};
+
+template <typename SampleType>
+struct BiquadCascadeCoefficients
+{
+    int numSections;
+    BiquadCoefficients<SampleType> sections[kMaxBiquadSections];
+};
+
+// Filter order for a slope (6 dB/oct per order)
+inline int getSlopeOrder(int slope)
+{
+    return slope <= kSlope6dB ? 1 : 2 * slope;
+}
+
+// Highest cutoff the designers accept, as a fraction of the sample rate
+static const double kMaxCutoffRatio = 0.49;
+
+// sin(π·fc/sample_rate) and cos(π·fc/sample_rate), half the biquad's w0,
+// from the cutoff tables (computed directly outside them)
+inline CutoffSineCosine halfWarpedCutoff(double cutoffFreq, double sampleRate)
+{
+    const double pi = 3.14159265358979323846;
+    const double ratio = std::fmin(cutoffFreq, kMaxCutoffRatio * sampleRate) / sampleRate;
+    CutoffSineCosine half;
+    if (!lookupCutoff(ratio, half)) {
+        half.sine = std::sin(pi * ratio);
+        half.cosine = std::cos(pi * ratio);
+    }
+    return half;
+}
+
+// Second-order low/high pass with quality factor q, with sin(w0) = 2·s·c,
+// 1 - cos(w0) = 2·s² and 1 + cos(w0) = 2·c² from the half angle
+template <typename SampleType>
+inline BiquadCoefficients<SampleType> designBiquad(int filterType, const CutoffSineCosine& half, double q)
+{
+    const double s = half.sine;
+    const double c = half.cosine;
+    const double cosw = c * c - s * s;
+    const double alpha = s * c / q;
+    const double a0 = 1.0 + alpha;
+
+    double b0, b1;
+    if (filterType == kFilterTypeLowPass) {
+        b0 = s * s;
+        b1 = 2.0 * s * s;
+    }
+    else {
+        b0 = c * c;
+        b1 = -2.0 * c * c;
+    }
+
+    BiquadCoefficients<SampleType> coeffs;
+    coeffs.b0 = SampleType(b0 / a0);
+    coeffs.b1 = SampleType(b1 / a0);
+    coeffs.b2 = SampleType(b0 / a0);
+    coeffs.a1 = SampleType(-2.0 * cosw / a0);
+    coeffs.a2 = SampleType((1.0 - alpha) / a0);
+    return coeffs;
+}
+
+template <typename SampleType>
+inline BiquadCoefficients<SampleType> designBiquad(int filterType, double cutoffFreq, double sampleRate, double q)
+{
+    return designBiquad<SampleType>(filterType, halfWarpedCutoff(cutoffFreq, sampleRate), q);
+}
+
+// Band pass (0 dB at the centre), notch, bell, low/high shelf and all-pass
+// sections of the Audio EQ Cookbook, with A = 10^(gain/40). The cos(w0)
+// terms are written with the half angle, which keeps the low cutoffs
+// accurate:
+//   (A+1) ∓ (A-1)·cos(w0) = 2·(A·s² + c²) or 2·(s² + A·c²)
+//   (A-1) ∓ (A+1)·cos(w0) = 2·(A·s² - c²) or 2·(A·c² - s²)
+template <typename SampleType>
+inline BiquadCoefficients<SampleType> designSection(int filterType, const CutoffSineCosine& half, double q, double gainDb)
+{
+    const double s = half.sine;
+    const double c = half.cosine;
+    const double cosw = c * c - s * s;
+    const double alpha = s * c / q;
+    const double a = std::pow(10.0, gainDb / 40.0);
+
+    double b0, b1, b2, a0, a1, a2;
+    switch (filterType)
+    {
+        case kFilterTypeBandPass:
+            b0 = alpha;
+            b1 = 0.0;
+            b2 = -alpha;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cosw;
+            a2 = 1.0 - alpha;
+            break;
+        case kFilterTypeNotch:
+            b0 = 1.0;
+            b1 = -2.0 * cosw;
+            b2 = 1.0;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cosw;
+            a2 = 1.0 - alpha;
+            break;
+        case kFilterTypePeak:
+            b0 = 1.0 + alpha * a;
+            b1 = -2.0 * cosw;
+            b2 = 1.0 - alpha * a;
+            a0 = 1.0 + alpha / a;
+            a1 = -2.0 * cosw;
+            a2 = 1.0 - alpha / a;
+            break;
+        case kFilterTypeLowShelf: {
+            const double root = 2.0 * std::sqrt(a) * alpha;
+            b0 = a * (2.0 * (a * s * s + c * c) + root);
+            b1 = 4.0 * a * (a * s * s - c * c);
+            b2 = a * (2.0 * (a * s * s + c * c) - root);
+            a0 = 2.0 * (s * s + a * c * c) + root;
+            a1 = -4.0 * (a * c * c - s * s);
+            a2 = 2.0 * (s * s + a * c * c) - root;
+            break;
+        }
+        case kFilterTypeHighShelf: {
+            const double root = 2.0 * std::sqrt(a) * alpha;
+            b0 = a * (2.0 * (s * s + a * c * c) + root);
+            b1 = -4.0 * a * (a * c * c - s * s);
+            b2 = a * (2.0 * (s * s + a * c * c) - root);
+            a0 = 2.0 * (a * s * s + c * c) + root;
+            a1 = 4.0 * (a * s * s - c * c);
+            a2 = 2.0 * (a * s * s + c * c) - root;
+            break;
+        }
+        default:
+            b0 = 1.0 - alpha;
+            b1 = -2.0 * cosw;
+            b2 = 1.0 + alpha;
+            a0 = 1.0 + alpha;
+            a1 = -2.0 * cosw;
+            a2 = 1.0 - alpha;
+            break;
+    }
+
+    BiquadCoefficients<SampleType> coeffs;
+    coeffs.b0 = SampleType(b0 / a0);
+    coeffs.b1 = SampleType(b1 / a0);
+    coeffs.b2 = SampleType(b2 / a0);
+    coeffs.a1 = SampleType(a1 / a0);
+    coeffs.a2 = SampleType(a2 / a0);
+    return coeffs;
+}
+
+template <typename SampleType>
+inline BiquadCoefficients<SampleType> designSection(int filterType, double cutoffFreq, double sampleRate,
+                                                    double q, double gainDb)
+{
+    return designSection<SampleType>(filterType, halfWarpedCutoff(cutoffFreq, sampleRate), q, gainDb);
+}
+
+// Section Qs of an even-order Butterworth filter: 1 / (2·sin((2k+1)·π / 2N))
+constexpr double butterworthQ(int order, int section)
+{
+    const double pi = 3.14159265358979323846;
+    return 1.0 / (2.0 * constexprSin((2 * section + 1) * pi / (2.0 * order)));
+}
+
+// Cascade for a 12-48 dB/oct slope.
+// Butterworth order N: N/2 sections with the Butterworth Qs.
+// Linkwitz-Riley order N: a Butterworth filter of order N/2 applied twice.
+// An odd N/2 contributes a squared first-order section, which is exactly a
+// second-order section with Q = 0.5.
+// The other types are one section whatever the slope and alignment.
+template <typename SampleType>
+inline BiquadCascadeCoefficients<SampleType> designCascade(int filterType, int slope, int alignment,
+                                                           double cutoffFreq, double sampleRate,
+                                                           double q = kDefaultQ, double gainDb = 0.0)
+{
+    const int order = getSlopeOrder(slope);
+
+    const CutoffSineCosine half = halfWarpedCutoff(cutoffFreq, sampleRate);
+
+    BiquadCascadeCoefficients<SampleType> cascade;
+    cascade.numSections = 0;
+
+    if (filterType != kFilterTypeLowPass && filterType != kFilterTypeHighPass)
+        cascade.sections[cascade.numSections++] = designSection<SampleType>(filterType, half, q, gainDb);
+    else if (alignment == kAlignmentLinkwitzRiley) {
+        const int halfOrder = order / 2;
+        for (int k = 0; k < halfOrder / 2; ++k) {
+            const BiquadCoefficients<SampleType> section =
+                designBiquad<SampleType>(filterType, half, butterworthQ(halfOrder, k));
+            cascade.sections[cascade.numSections++] = section;
+            cascade.sections[cascade.numSections++] = section;
+        }
+        if (halfOrder % 2 != 0)
+            cascade.sections[cascade.numSections++] = designBiquad<SampleType>(filterType, half, 0.5);
+    }
+    else {
+        for (int k = 0; k < order / 2; ++k)
+            cascade.sections[cascade.numSections++] =
+                designBiquad<SampleType>(filterType, half, butterworthQ(order, k));
+    }
+    return cascade;
+}
+
+} // namespace FilterDSP
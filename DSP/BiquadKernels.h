@@ -0,0 +1,216 @@
+#pragma once
+
+// Block kernels for the biquad cascades (transposed direct form II).
+// Like SimdOnePoleKernel, one channel occupies one SIMD lane and square
+// tiles of the non-interleaved buffers are transposed in registers. Each
+// tile runs section by section, so a section's coefficients and state stay
+// in registers while it processes the tile.
+//
+// Cascade state is laid out as a structure of arrays, stride = the prepared
+// channel count: [s1 of section 0 | s2 of section 0 | s1 of section 1 | ...]
+
+#include "BiquadDesigner.h"
+#include "SimdOps.h"
+
+namespace FilterDSP {
+FILTERDSP_ISA_NAMESPACE_BEGIN
+
+// c += delta, for scalar and vector coefficient sets
+template <typename T>
+inline void advanceCoefficients(BiquadCoefficients<T>& c, const BiquadCoefficients<T>& delta)
+{
+    c.b0 = c.b0 + delta.b0;
+    c.b1 = c.b1 + delta.b1;
+    c.b2 = c.b2 + delta.b2;
+    c.a1 = c.a1 + delta.a1;
+    c.a2 = c.a2 + delta.a2;
+}
+
+template <typename Vector>
+inline BiquadCoefficients<Vector> broadcastCoefficients(const BiquadCoefficients<typename Vector::Scalar>& c)
+{
+    BiquadCoefficients<Vector> v;
+    v.b0 = Vector::broadcast(c.b0);
+    v.b1 = Vector::broadcast(c.b1);
+    v.b2 = Vector::broadcast(c.b2);
+    v.a1 = Vector::broadcast(c.a1);
+    v.a2 = Vector::broadcast(c.a2);
+    return v;
+}
+
+struct BiquadStep
+{
+    // y[n]  = b0·x[n] + s1
+    // s1    = b1·x[n] - a1·y[n] + s2
+    // s2    = b2·x[n] - a2·y[n]
+    template <typename T>
+    static T tick(const BiquadCoefficients<T>& c, T x, T& s1, T& s2)
+    {
+        T y = c.b0 * x + s1;
+        s1 = c.b1 * x - c.a1 * y + s2;
+        s2 = c.b2 * x - c.a2 * y;
+        return y;
+    }
+};
+
+template <bool Ramped, int NumSections, typename Vector>
+struct SimdBiquadKernel
+{
+    typedef typename Vector::Scalar SampleType;
+    static const int kWidth = Vector::kWidth;
+
+    static void process(const BiquadCascadeCoefficients<SampleType>& c,
+                        const BiquadCascadeCoefficients<SampleType>& delta,
+                        const SampleType* const* inputs, SampleType* const* outputs,
+                        int numChannels, int numSamples,
+                        SampleType* state, int stateStride)
+    {
+        BiquadCoefficients<Vector> steps[NumSections];
+        for (int k = 0; k < NumSections; ++k)
+            steps[k] = broadcastCoefficients<Vector>(delta.sections[k]);
+
+        for (int first = 0; first < numChannels; first += kWidth) {
+            const int active = numChannels - first < kWidth ? numChannels - first : kWidth;
+
+            const SampleType* in[kWidth];
+            SampleType* out[kWidth];
+            SampleType lanes[kWidth];
+            for (int lane = 0; lane < kWidth; ++lane)
+                in[lane] = inputs[first + (lane < active ? lane : 0)];
+            for (int lane = 0; lane < active; ++lane)
+                out[lane] = outputs[first + lane];
+
+            BiquadCoefficients<Vector> coeffs[NumSections];
+            Vector s1[NumSections];
+            Vector s2[NumSections];
+            for (int k = 0; k < NumSections; ++k) {
+                coeffs[k] = broadcastCoefficients<Vector>(c.sections[k]);
+                s1[k] = loadState(state + (2 * k) * stateStride + first, active, lanes);
+                s2[k] = loadState(state + (2 * k + 1) * stateStride + first, active, lanes);
+            }
+
+            int sample = 0;
+            for (; sample + kWidth <= numSamples; sample += kWidth) {
+                Vector tile[kWidth];
+                for (int lane = 0; lane < kWidth; ++lane)
+                    tile[lane] = Vector::loadu(in[lane] + sample);
+                Vector::transpose(tile);
+
+                for (int k = 0; k < NumSections; ++k) {
+                    for (int step = 0; step < kWidth; ++step) {
+                        tile[step] = BiquadStep::tick(coeffs[k], tile[step], s1[k], s2[k]);
+                        if (Ramped)
+                            advanceCoefficients(coeffs[k], steps[k]);
+                    }
+                }
+
+                Vector::transpose(tile);
+                for (int lane = 0; lane < active; ++lane)
+                    tile[lane].storeu(out[lane] + sample);
+            }
+
+            // Remaining samples, one time step at a time
+            for (; sample < numSamples; ++sample) {
+                for (int lane = 0; lane < kWidth; ++lane)
+                    lanes[lane] = in[lane][sample];
+                Vector x = Vector::loadu(lanes);
+                for (int k = 0; k < NumSections; ++k) {
+                    x = BiquadStep::tick(coeffs[k], x, s1[k], s2[k]);
+                    if (Ramped)
+                        advanceCoefficients(coeffs[k], steps[k]);
+                }
+                x.storeu(lanes);
+                for (int lane = 0; lane < active; ++lane)
+                    out[lane][sample] = lanes[lane];
+            }
+
+            for (int k = 0; k < NumSections; ++k) {
+                storeState(s1[k], state + (2 * k) * stateStride + first, active, lanes);
+                storeState(s2[k], state + (2 * k + 1) * stateStride + first, active, lanes);
+            }
+        }
+    }
+
+private:
+    static Vector loadState(const SampleType* src, int active, SampleType* lanes)
+    {
+        for (int lane = 0; lane < kWidth; ++lane)
+            lanes[lane] = lane < active ? src[lane] : SampleType(0);
+        return Vector::loadu(lanes);
+    }
+
+    static void storeState(Vector v, SampleType* dst, int active, SampleType* lanes)
+    {
+        v.storeu(lanes);
+        for (int lane = 0; lane < active; ++lane)
+            dst[lane] = lanes[lane];
+    }
+};
+
+template <bool Ramped, int NumSections, typename SampleType>
+inline void processBiquadSections(const BiquadCascadeCoefficients<SampleType>& c,
+                                  const BiquadCascadeCoefficients<SampleType>& delta,
+                                  const SampleType* const* inputs, SampleType* const* outputs,
+                                  int numChannels, int numSamples,
+                                  SampleType* state, int stateStride)
+{
+    typedef typename SimdTraits<SampleType>::Narrow Narrow;
+    typedef typename SimdTraits<SampleType>::Wide Wide;
+    typedef typename SimdTraits<SampleType>::Widest Widest;
+
+    if (numChannels <= Narrow::kWidth)
+        SimdBiquadKernel<Ramped, NumSections, Narrow>::process(c, delta, inputs, outputs, numChannels, numSamples, state, stateStride);
+    else if (numChannels <= Wide::kWidth)
+        SimdBiquadKernel<Ramped, NumSections, Wide>::process(c, delta, inputs, outputs, numChannels, numSamples, state, stateStride);
+    else
+        SimdBiquadKernel<Ramped, NumSections, Widest>::process(c, delta, inputs, outputs, numChannels, numSamples, state, stateStride);
+}
+
+// Picks the kernel for the section count once per block
+template <bool Ramped, typename SampleType>
+inline void processBiquadCascade(const BiquadCascadeCoefficients<SampleType>& c,
+                                 const BiquadCascadeCoefficients<SampleType>& delta,
+                                 const SampleType* const* inputs, SampleType* const* outputs,
+                                 int numChannels, int numSamples,
+                                 SampleType* state, int stateStride)
+{
+    switch (c.numSections)
+    {
+        case 1:
+            processBiquadSections<Ramped, 1>(c, delta, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case 2:
+            processBiquadSections<Ramped, 2>(c, delta, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case 3:
+            processBiquadSections<Ramped, 3>(c, delta, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case 4:
+            processBiquadSections<Ramped, 4>(c, delta, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+    }
+}
+
+// Fixed coefficients for the whole block
+template <typename SampleType>
+inline void processBiquadBlock(const BiquadCascadeCoefficients<SampleType>& c,
+                               const SampleType* const* inputs, SampleType* const* outputs,
+                               int numChannels, int numSamples,
+                               SampleType* state, int stateStride)
+{
+    processBiquadCascade<false>(c, c, inputs, outputs, numChannels, numSamples, state, stateStride);
+}
+
+// Coefficients start at c and move by delta after every sample
+template <typename SampleType>
+inline void processBiquadRamp(const BiquadCascadeCoefficients<SampleType>& c,
+                              const BiquadCascadeCoefficients<SampleType>& delta,
+                              const SampleType* const* inputs, SampleType* const* outputs,
+                              int numChannels, int numSamples,
+                              SampleType* state, int stateStride)
+{
+    processBiquadCascade<true>(c, delta, inputs, outputs, numChannels, numSamples, state, stateStride);
+}
+
+FILTERDSP_ISA_NAMESPACE_END
+} // namespace FilterDSP
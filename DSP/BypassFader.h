@@ -0,0 +1,326 @@
+#pragma once
+
+// Bypass state machine shared by the plugin wrappers.
+// Toggling bypass crossfades between the filtered and the dry signal over
+// a short fade; once bypassed, the filter is not run at all and the audio
+// is copied through (or left alone when processing in place). The filter
+// memory is kept, so un-bypassing resumes from it under the crossfade.
+// When the filter has latency (oversampling, linear phase) the dry signal
+// is delayed by the same amount, so bypass does not change the plugin's
+// delay. With several outputs (the crossover bands) the first one is
+// crossfaded with the dry signal and the others fade to silence.
+
+#include "FilterEngine.h"
+
+#include <cstring>
+#include <vector>
+
+namespace FilterDSP {
+
+// Bypass crossfade time used by the plugin wrappers, in seconds
+static const double kDefaultBypassFadeTime = 0.01;
+
+template <typename SampleType>
+class BypassFader
+{
+public:
+    BypassFader()
+    : m_bypassed(false)
+    , m_fadeLength(0)
+    , m_fadePosition(0)
+    , m_numDelayChannels(0)
+    , m_maxDryDelay(0)
+    , m_dryDelay(0)
+    , m_dryPosition(0)
+    , m_dryLineSilent(true)
+    {
+    }
+
+    // Allocate the dry delay lines (FilterEngine::getMaxLatencySamples()).
+    // Call it from setupProcessing/Initialize, never from the audio thread.
+    void prepare(int numChannels, int maxDryDelay)
+    {
+        m_numDelayChannels = std::max(0, std::min(numChannels, kMaxChannels));
+        m_maxDryDelay = std::max(0, maxDryDelay);
+        m_dryLine.assign(static_cast<size_t>(m_numDelayChannels) * m_maxDryDelay, SampleType(0));
+        m_dryDelay = std::min(m_dryDelay, m_maxDryDelay);
+        m_dryPosition = 0;
+        m_dryLineSilent = true;
+    }
+
+    // Delay of the dry signal in samples; set it to the filter's latency.
+    // Clears the delay line when it changes.
+    void setDryDelay(int numSamples)
+    {
+        numSamples = std::max(0, std::min(numSamples, m_maxDryDelay));
+        if (numSamples == m_dryDelay)
+            return;
+        m_dryDelay = numSamples;
+        m_dryPosition = 0;
+        std::fill(m_dryLine.begin(), m_dryLine.end(), SampleType(0));
+        m_dryLineSilent = true;
+    }
+
+    // Crossfade duration in samples (0 = switch immediately)
+    void setFadeLength(int numSamples)
+    {
+        m_fadeLength = numSamples > 0 ? numSamples : 0;
+        if (m_fadePosition > m_fadeLength)
+            m_fadePosition = m_fadeLength;
+    }
+
+    // Start a crossfade towards the new bypass state
+    void setBypassed(bool bypassed)
+    {
+        if (bypassed == m_bypassed)
+            return;
+        m_bypassed = bypassed;
+        if (m_fadeLength == 0)
+            m_fadePosition = 0;
+        else
+            m_fadePosition = m_fadeLength - m_fadePosition;
+    }
+
+    // Jump to a bypass state without a crossfade (e.g. when loading state)
+    void reset(bool bypassed)
+    {
+        m_bypassed = bypassed;
+        m_fadePosition = 0;
+    }
+
+    bool isBypassed() const { return m_bypassed; }
+    bool isFading() const { return m_fadePosition > 0; }
+
+    // True when silent input gives silent output without calling process()
+    // (given a decayed filter): no crossfade is running and, while
+    // bypassed, the dry delay line holds no signal. The line is scanned
+    // once after it last took audio.
+    bool isSilent()
+    {
+        if (m_fadePosition > 0)
+            return false;
+        if (!m_dryLineSilent) {
+            for (size_t i = 0; i < m_dryLine.size(); ++i)
+                if (m_dryLine[i] != SampleType(0))
+                    return !m_bypassed;
+            m_dryLineSilent = true;
+        }
+        return true;
+    }
+
+    // Stands in for process() on a block of silent input the wrapper skips
+    // (see isSilent): the dry delay line takes the block's zeros, so no
+    // earlier input comes out of it later.
+    void skipSilence(int numChannels, int numSamples)
+    {
+        if (m_dryDelay == 0 || m_dryLineSilent)
+            return;
+        numChannels = std::min(numChannels, m_numDelayChannels);
+        const int count = std::min(numSamples, m_dryDelay);
+        const int skip = numSamples - count;
+        for (int channel = 0; channel < numChannels; ++channel) {
+            SampleType* line = &m_dryLine[static_cast<size_t>(channel) * m_maxDryDelay];
+            int position = (m_dryPosition + skip) % m_dryDelay;
+            for (int sample = 0; sample < count; ++sample) {
+                line[position] = SampleType(0);
+                if (++position == m_dryDelay)
+                    position = 0;
+            }
+        }
+        m_dryPosition = (m_dryPosition + numSamples) % m_dryDelay;
+    }
+
+    // Runs filter.processBlock for the wet signal. Inputs and outputs may
+    // alias. Only the prepared channels of the filter are touched.
+    template <typename Filter>
+    void process(Filter& filter, const SampleType* const* inputs, SampleType* const* outputs,
+                 int numChannels, int numSamples)
+    {
+        process(filter, inputs, &outputs, 1, numChannels, numSamples);
+    }
+
+    // numOutputs outputs of numChannels buffers each (FilterEngine's
+    // multi-output processBlock); outputs after the first may be null. While
+    // bypassed every output but the first is silent.
+    template <typename Filter>
+    void process(Filter& filter, const SampleType* const* inputs, SampleType* const* const* outputs,
+                 int numOutputs, int numChannels, int numSamples)
+    {
+        if (numChannels > filter.getNumChannels())
+            numChannels = filter.getNumChannels();
+        if (m_dryDelay > 0 && numChannels > m_numDelayChannels)
+            numChannels = m_numDelayChannels;
+
+        int sample = 0;
+        while (m_fadePosition > 0 && sample < numSamples) {
+            const int chunk = std::min(std::min(kFadeChunk, m_fadePosition), numSamples - sample);
+            processFade(filter, inputs, outputs, numOutputs, numChannels, sample, chunk);
+            m_fadePosition -= chunk;
+            sample += chunk;
+        }
+        if (sample == numSamples)
+            return;
+
+        if (!m_bypassed) {
+            if (m_dryDelay > 0)
+                pushDry(inputs, numChannels, sample, numSamples - sample);
+            filter.processRange(inputs, outputs, numOutputs, numChannels, sample, numSamples - sample);
+            return;
+        }
+
+        for (int output = 1; output < numOutputs; ++output) {
+            if (!outputs[output])
+                continue;
+            for (int channel = 0; channel < numChannels; ++channel)
+                std::memset(outputs[output][channel] + sample, 0, sizeof(SampleType) * static_cast<size_t>(numSamples - sample));
+        }
+
+        if (m_dryDelay > 0) {
+            for (; sample < numSamples; sample += kFadeChunk) {
+                const int chunk = std::min(kFadeChunk, numSamples - sample);
+                delayDry(inputs, numChannels, sample, chunk);
+                for (int channel = 0; channel < numChannels; ++channel)
+                    std::memcpy(outputs[0][channel] + sample, m_dry[channel], sizeof(SampleType) * static_cast<size_t>(chunk));
+            }
+            return;
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            if (outputs[0][channel] != inputs[channel])
+                std::memcpy(outputs[0][channel] + sample, inputs[channel] + sample,
+                            sizeof(SampleType) * static_cast<size_t>(numSamples - sample));
+        }
+    }
+
+    // Process numSamples samples starting at startSample
+    template <typename Filter>
+    void processRange(Filter& filter, const SampleType* const* inputs, SampleType* const* outputs,
+                      int numChannels, int startSample, int numSamples)
+    {
+        processRange(filter, inputs, &outputs, 1, numChannels, startSample, numSamples);
+    }
+
+    template <typename Filter>
+    void processRange(Filter& filter, const SampleType* const* inputs, SampleType* const* const* outputs,
+                      int numOutputs, int numChannels, int startSample, int numSamples)
+    {
+        if (numChannels > filter.getNumChannels())
+            numChannels = filter.getNumChannels();
+        numOutputs = std::min(numOutputs, kMaxCrossoverBands);
+
+        const SampleType* in[kMaxChannels];
+        SampleType* out[kMaxCrossoverBands][kMaxChannels];
+        SampleType* const* outs[kMaxCrossoverBands];
+        for (int channel = 0; channel < numChannels; ++channel)
+            in[channel] = inputs[channel] + startSample;
+        for (int output = 0; output < numOutputs; ++output) {
+            outs[output] = outputs[output] ? out[output] : nullptr;
+            for (int channel = 0; outputs[output] && channel < numChannels; ++channel)
+                out[output][channel] = outputs[output][channel] + startSample;
+        }
+        process(filter, in, outs, numOutputs, numChannels, numSamples);
+    }
+
+private:
+    static const int kFadeChunk = 64;
+
+    // Linear crossfade; m_fadePosition counts down to 0 at the end of the fade
+    template <typename Filter>
+    void processFade(Filter& filter, const SampleType* const* inputs, SampleType* const* const* outputs,
+                     int numOutputs, int numChannels, int startSample, int numSamples)
+    {
+        delayDry(inputs, numChannels, startSample, numSamples);
+
+        filter.processRange(inputs, outputs, numOutputs, numChannels, startSample, numSamples);
+
+        // Gain of the filtered signal at the first sample and its step
+        const SampleType step = SampleType(1) / SampleType(m_fadeLength);
+        const SampleType remaining = SampleType(m_fadePosition - 1) * step;
+        const SampleType start = m_bypassed ? remaining : SampleType(1) - remaining;
+        const SampleType delta = m_bypassed ? -step : step;
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            SampleType* out = outputs[0][channel] + startSample;
+            const SampleType* dry = m_dry[channel];
+            SampleType gain = start;
+            for (int sample = 0; sample < numSamples; ++sample) {
+                out[sample] = dry[sample] + gain * (out[sample] - dry[sample]);
+                gain += delta;
+            }
+        }
+
+        // The other outputs have no dry signal
+        for (int output = 1; output < numOutputs; ++output) {
+            for (int channel = 0; outputs[output] && channel < numChannels; ++channel) {
+                SampleType* out = outputs[output][channel] + startSample;
+                SampleType gain = start;
+                for (int sample = 0; sample < numSamples; ++sample) {
+                    out[sample] *= gain;
+                    gain += delta;
+                }
+            }
+        }
+    }
+
+    // Copy up to kFadeChunk dry samples into m_dry, delayed by m_dryDelay
+    void delayDry(const SampleType* const* inputs, int numChannels, int startSample, int numSamples)
+    {
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const SampleType* in = inputs[channel] + startSample;
+            if (m_dryDelay == 0) {
+                std::memcpy(m_dry[channel], in, sizeof(SampleType) * static_cast<size_t>(numSamples));
+                continue;
+            }
+            SampleType* line = &m_dryLine[static_cast<size_t>(channel) * m_maxDryDelay];
+            int position = m_dryPosition;
+            for (int sample = 0; sample < numSamples; ++sample) {
+                m_dry[channel][sample] = line[position];
+                line[position] = in[sample];
+                if (++position == m_dryDelay)
+                    position = 0;
+            }
+        }
+        if (m_dryDelay > 0) {
+            m_dryPosition = (m_dryPosition + numSamples) % m_dryDelay;
+            m_dryLineSilent = false;
+        }
+    }
+
+    // Feed the delay line while the wet signal is playing; only the last
+    // m_dryDelay samples of the range are kept
+    void pushDry(const SampleType* const* inputs, int numChannels, int startSample, int numSamples)
+    {
+        const int skip = numSamples > m_dryDelay ? numSamples - m_dryDelay : 0;
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const SampleType* in = inputs[channel] + startSample;
+            SampleType* line = &m_dryLine[static_cast<size_t>(channel) * m_maxDryDelay];
+            int position = (m_dryPosition + skip) % m_dryDelay;
+            for (int sample = skip; sample < numSamples; ++sample) {
+                line[position] = in[sample];
+                if (++position == m_dryDelay)
+                    position = 0;
+            }
+        }
+        m_dryPosition = (m_dryPosition + numSamples) % m_dryDelay;
+        m_dryLineSilent = false;
+    }
+
+    bool m_bypassed;
+    int m_fadeLength;
+    int m_fadePosition;     // samples left in the current crossfade
+
+    // Dry copy of the inputs during a crossfade (processing may be in place)
+    SampleType m_dry[kMaxChannels][kFadeChunk];
+
+    // Dry delay lines, m_maxDryDelay apart (ring buffers of m_dryDelay samples)
+    int m_numDelayChannels;
+    int m_maxDryDelay;
+    int m_dryDelay;
+    int m_dryPosition;
+    std::vector<SampleType> m_dryLine;
+
+    // The delay line is known to hold only zeros (see isSilent)
+    bool m_dryLineSilent;
+};
+
+} // namespace FilterDSP
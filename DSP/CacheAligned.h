@@ -0,0 +1,125 @@
+#pragma once
+
+// Cache-line-aligned allocations for state the audio thread writes every
+// block. Hosts process instances on different threads, and state sharing a
+// cache line with another instance's data (or with members other threads
+// write) moves that line between cores on every write. Allocations here
+// start on a line boundary and are padded to whole lines, so nothing else
+// lands on their lines.
+//
+// The alignment is done by hand rather than with C++17 aligned new, which
+// macOS only provides from 10.14 (the Audio Unit targets 10.9).
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace FilterDSP {
+
+// L1 line size of current x86 and ARM cores
+static const size_t kCacheLineSize = 64;
+
+inline size_t roundUpToCacheLine(size_t bytes)
+{
+    return (bytes + kCacheLineSize - 1) / kCacheLineSize * kCacheLineSize;
+}
+
+// bytes rounded up to whole lines, starting on a line; the block's own
+// address is kept in the line before
+inline void* allocateCacheAligned(size_t bytes)
+{
+    char* block = static_cast<char*>(::operator new(roundUpToCacheLine(bytes) + kCacheLineSize + sizeof(void*)));
+    const std::uintptr_t start = reinterpret_cast<std::uintptr_t>(block + sizeof(void*));
+    char* aligned = block + sizeof(void*) + (kCacheLineSize - start % kCacheLineSize) % kCacheLineSize;
+    reinterpret_cast<void**>(aligned)[-1] = block;
+    return aligned;
+}
+
+inline void freeCacheAligned(void* aligned)
+{
+    if (aligned)
+        ::operator delete(reinterpret_cast<void**>(aligned)[-1]);
+}
+
+// Allocator for std::vector
+template <typename T>
+struct CacheAlignedAllocator
+{
+    typedef T value_type;
+
+    CacheAlignedAllocator() {}
+
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(allocateCacheAligned(n * sizeof(T))); }
+    void deallocate(T* p, size_t) { freeCacheAligned(p); }
+
+    template <typename U>
+    bool operator==(const CacheAlignedAllocator<U>&) const { return true; }
+    template <typename U>
+    bool operator!=(const CacheAlignedAllocator<U>&) const { return false; }
+};
+
+template <typename T>
+using CacheAlignedVector = std::vector<T, CacheAlignedAllocator<T>>;
+
+// Owns one T in its own cache-aligned allocation, like std::unique_ptr<T>
+template <typename T>
+class CacheAlignedPtr
+{
+public:
+    template <typename... Args>
+    static CacheAlignedPtr make(Args&&... args)
+    {
+        void* memory = allocateCacheAligned(sizeof(T));
+        try {
+            return CacheAlignedPtr(new (memory) T(std::forward<Args>(args)...));
+        }
+        catch (...) {
+            freeCacheAligned(memory);
+            throw;
+        }
+    }
+
+    CacheAlignedPtr() : m_object(nullptr) {}
+    CacheAlignedPtr(CacheAlignedPtr&& other) : m_object(other.m_object) { other.m_object = nullptr; }
+
+    CacheAlignedPtr& operator=(CacheAlignedPtr&& other)
+    {
+        if (this != &other) {
+            reset();
+            m_object = other.m_object;
+            other.m_object = nullptr;
+        }
+        return *this;
+    }
+
+    CacheAlignedPtr(const CacheAlignedPtr&) = delete;
+    CacheAlignedPtr& operator=(const CacheAlignedPtr&) = delete;
+
+    ~CacheAlignedPtr() { reset(); }
+
+    void reset()
+    {
+        if (m_object) {
+            m_object->~T();
+            freeCacheAligned(m_object);
+            m_object = nullptr;
+        }
+    }
+
+    T* get() const { return m_object; }
+    T& operator*() const { return *m_object; }
+    T* operator->() const { return m_object; }
+    explicit operator bool() const { return m_object != nullptr; }
+
+private:
+    explicit CacheAlignedPtr(T* object) : m_object(object) {}
+
+    T* m_object;
+};
+
+} // namespace FilterDSP
@@ -0,0 +1,204 @@
+#pragma once
+
+// Caches the designed coefficients and only redesigns when the cutoff,
+// type, slope, alignment, mode, resonance, Q, gain or sample rate actually
+// change. Only the design for the active structure is computed (none for linear phase,
+// whose kernel is designed by LinearPhaseFilter, or for the graphic EQ and
+// the crossover, designed by FilterBank and Crossover).
+
+#include "BiquadDesigner.h"
+#include "FilterCoefficients.h"
+#include "LadderDesigner.h"
+#include "SvfDesigner.h"
+
+namespace FilterDSP {
+
+// Filter structure that realizes the current parameters
+enum FilterStructure
+{
+    kStructureOnePole = 0,
+    kStructureBiquad = 1,
+    kStructureStateVariable = 2,
+    kStructureLinearPhase = 3,
+    kStructureLadder = 4,
+    kStructureFilterBank = 5,
+    kStructureCrossover = 6
+};
+
+template <typename SampleType>
+class FilterCoefficientCache
+{
+public:
+    FilterCoefficientCache()
+    : m_sampleRate(SampleType(44100))
+    , m_cutoffFreq(SampleType(1000))
+    , m_filterType(kFilterTypeLowPass)
+    , m_slope(kSlope6dB)
+    , m_alignment(kAlignmentButterworth)
+    , m_mode(kFilterModeStandard)
+    , m_resonance(SampleType(0))
+    , m_q(kDefaultQ)
+    , m_gainDb(0.0)
+    {
+        update();
+    }
+
+    void setSampleRate(SampleType sampleRate)
+    {
+        if (sampleRate != m_sampleRate) {
+            m_sampleRate = sampleRate;
+            update();
+        }
+    }
+
+    void setCutoff(SampleType cutoffFreq)
+    {
+        if (cutoffFreq != m_cutoffFreq) {
+            m_cutoffFreq = cutoffFreq;
+            update();
+        }
+    }
+
+    void setFilterType(int filterType)
+    {
+        if (filterType != m_filterType) {
+            m_filterType = filterType;
+            update();
+        }
+    }
+
+    void setSlope(int slope)
+    {
+        if (slope != m_slope) {
+            m_slope = slope;
+            update();
+        }
+    }
+
+    void setAlignment(int alignment)
+    {
+        if (alignment != m_alignment) {
+            m_alignment = alignment;
+            update();
+        }
+    }
+
+    void setMode(int mode)
+    {
+        if (mode != m_mode) {
+            m_mode = mode;
+            update();
+        }
+    }
+
+    // Only the ladder resonates; the other structures are not redesigned
+    void setResonance(SampleType resonance)
+    {
+        if (resonance != m_resonance) {
+            m_resonance = resonance;
+            if (m_mode == kFilterModeLadder)
+                update();
+        }
+    }
+
+    // Q of the single-section types and the state variable filter
+    void setQ(double q)
+    {
+        if (q != m_q) {
+            m_q = q;
+            if (getStructure() == kStructureStateVariable || isSingleSection())
+                update();
+        }
+    }
+
+    // Bell and shelf gain in dB
+    void setGain(double gainDb)
+    {
+        if (gainDb != m_gainDb) {
+            m_gainDb = gainDb;
+            if (isSingleSection())
+                update();
+        }
+    }
+
+    SampleType getSampleRate() const { return m_sampleRate; }
+    SampleType getCutoff() const { return m_cutoffFreq; }
+    int getFilterType() const { return m_filterType; }
+    int getSlope() const { return m_slope; }
+    int getAlignment() const { return m_alignment; }
+    int getMode() const { return m_mode; }
+    SampleType getResonance() const { return m_resonance; }
+    double getQ() const { return m_q; }
+    double getGain() const { return m_gainDb; }
+
+    int getStructure() const
+    {
+        if (m_mode == kFilterModeGraphicEq)
+            return kStructureFilterBank;
+        if (m_mode == kFilterModeCrossover)
+            return kStructureCrossover;
+        if (m_mode == kFilterModeLinearPhase)
+            return kStructureLinearPhase;
+        if (isBiquadOnlyType(m_filterType))
+            return kStructureBiquad;
+        if (m_mode == kFilterModeLadder)
+            return kStructureLadder;
+        if (m_mode == kFilterModeStateVariable)
+            return kStructureStateVariable;
+        if (m_filterType != kFilterTypeLowPass && m_filterType != kFilterTypeHighPass)
+            return kStructureBiquad;
+        return m_slope == kSlope6dB ? kStructureOnePole : kStructureBiquad;
+    }
+
+    // The biquad is one section shaped by Q and gain (BiquadDesigner.h)
+    bool isSingleSection() const
+    {
+        return getStructure() == kStructureBiquad && m_filterType != kFilterTypeLowPass && m_filterType != kFilterTypeHighPass;
+    }
+
+    const OnePoleCoefficients<SampleType>& get() const { return m_onePole; }
+    const BiquadCascadeCoefficients<SampleType>& getBiquads() const { return m_biquads; }
+    const SvfCoefficients<SampleType>& getSvf() const { return m_svf; }
+    const LadderCoefficients<SampleType>& getLadder() const { return m_ladder; }
+
+private:
+    void update()
+    {
+        switch (getStructure())
+        {
+            case kStructureOnePole:
+                m_onePole = OnePoleCoefficients<SampleType>::design(m_filterType, m_cutoffFreq, m_sampleRate);
+                break;
+            case kStructureBiquad:
+                m_biquads = designCascade<SampleType>(m_filterType, m_slope, m_alignment, m_cutoffFreq, m_sampleRate, m_q, m_gainDb);
+                break;
+            case kStructureStateVariable:
+                m_svf = SvfCoefficients<SampleType>::design(m_cutoffFreq, m_sampleRate, m_q);
+                break;
+            case kStructureLadder:
+                m_ladder = LadderCoefficients<SampleType>::design(m_cutoffFreq, m_sampleRate, m_resonance);
+                break;
+            case kStructureLinearPhase:
+            case kStructureFilterBank:
+            case kStructureCrossover:
+                break;
+        }
+    }
+
+    SampleType m_sampleRate;
+    SampleType m_cutoffFreq;
+    int m_filterType;
+    int m_slope;
+    int m_alignment;
+    int m_mode;
+    SampleType m_resonance;
+    double m_q;
+    double m_gainDb;
+
+    OnePoleCoefficients<SampleType> m_onePole;
+    BiquadCascadeCoefficients<SampleType> m_biquads;
+    SvfCoefficients<SampleType> m_svf;
+    LadderCoefficients<SampleType> m_ladder;
+};
+
+} // namespace FilterDSP
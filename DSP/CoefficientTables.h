@@ -0,0 +1,127 @@
+#pragma once
+
+// Compile-time lookup tables for the cutoff prewarping.
+// Every prewarped coefficient the designers need follows from sin(π·r) and
+// cos(π·r), with r = fc/sample_rate:
+//   state variable filter  g = tan(π·r) = sin/cos
+//   biquad (w0 = 2π·r)     sin(w0) = 2·sin·cos, 1 - cos(w0) = 2·sin²,
+//                          1 + cos(w0) = 2·cos²
+// Both are tabulated over r on a logarithmic grid: kCutoffTablePointsPerOctave
+// evenly spaced points per octave, so the octave and the position in it come
+// straight from the exponent and mantissa bits of r (no log() per lookup),
+// and interpolated with a 4-point cubic. The tables are indexed by r rather
+// than by frequency, so one table serves every sample rate; the 44.1 and
+// 48 kHz families only shift the lookups by whole octaves.
+//
+// The tables are generated by constexpr series at compile time. Lookups
+// outside the covered range fail and the designers compute directly.
+
+#include <cstdint>
+#include <cstring>
+
+namespace FilterDSP {
+
+// Grid resolution and covered range of r: [2^kCutoffTableMinOctave, 0.5)
+static const int kCutoffTablePointsPerOctave = 64;
+static const int kCutoffTableMinOctave = -16;
+static const int kCutoffTableMaxOctave = -2;
+
+// Each octave also stores one point below and two above it, so a cubic
+// never straddles the change of spacing between octaves
+static const int kCutoffTableOctaveSize = kCutoffTablePointsPerOctave + 3;
+static const int kCutoffTableSize = (kCutoffTableMaxOctave - kCutoffTableMinOctave + 1) * kCutoffTableOctaveSize;
+
+// Taylor series, accurate to rounding for |x| <= 1.1·π
+constexpr double constexprSin(double x)
+{
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 16; ++n) {
+        term *= -x * x / double((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double constexprCos(double x)
+{
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 16; ++n) {
+        term *= -x * x / double((2 * n - 1) * (2 * n));
+        sum += term;
+    }
+    return sum;
+}
+
+struct CutoffTable
+{
+    double sine[kCutoffTableSize];      // sin(π·r)
+    double cosine[kCutoffTableSize];    // cos(π·r)
+};
+
+constexpr CutoffTable makeCutoffTable()
+{
+    const double pi = 3.14159265358979323846;
+    CutoffTable table = {};
+    double octaveStart = 1.0;
+    for (int octave = 0; octave > kCutoffTableMinOctave; --octave)
+        octaveStart *= 0.5;
+
+    int index = 0;
+    for (int octave = kCutoffTableMinOctave; octave <= kCutoffTableMaxOctave; ++octave) {
+        for (int point = -1; point <= kCutoffTablePointsPerOctave + 1; ++point) {
+            const double ratio = octaveStart * (1.0 + double(point) / kCutoffTablePointsPerOctave);
+            table.sine[index] = constexprSin(pi * ratio);
+            table.cosine[index] = constexprCos(pi * ratio);
+            ++index;
+        }
+        octaveStart *= 2.0;
+    }
+    return table;
+}
+
+inline constexpr CutoffTable kCutoffTable = makeCutoffTable();
+
+// sin(π·r) and cos(π·r) from the table
+struct CutoffSineCosine
+{
+    double sine;
+    double cosine;
+};
+
+// False (and out untouched) when r is outside the table
+inline bool lookupCutoff(double ratio, CutoffSineCosine& out)
+{
+    uint64_t bits = 0;
+    std::memcpy(&bits, &ratio, sizeof(bits));
+
+    // Positive, and in the covered octaves (this also rejects 0, NaN and inf)
+    const int octave = static_cast<int>((bits >> 52) & 0x7ff) - 1023;
+    if ((bits >> 63) != 0 || octave < kCutoffTableMinOctave || octave > kCutoffTableMaxOctave)
+        return false;
+
+    // Mantissa in [1, 2) -> grid position within the octave
+    bits = (bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull;
+    double mantissa = 0.0;
+    std::memcpy(&mantissa, &bits, sizeof(mantissa));
+    const double position = (mantissa - 1.0) * kCutoffTablePointsPerOctave;
+    const int point = static_cast<int>(position);
+    const double t = position - point;
+
+    // Lagrange weights for the points at -1, 0, 1, 2 around t
+    const double tp1 = t + 1.0, tm1 = t - 1.0, tm2 = t - 2.0;
+    const double w0 = -t * tm1 * tm2 * (1.0 / 6.0);
+    const double w1 = tp1 * tm1 * tm2 * 0.5;
+    const double w2 = -tp1 * t * tm2 * 0.5;
+    const double w3 = tp1 * t * tm1 * (1.0 / 6.0);
+
+    const int index = (octave - kCutoffTableMinOctave) * kCutoffTableOctaveSize + point;
+    const double* s = kCutoffTable.sine + index;
+    const double* c = kCutoffTable.cosine + index;
+    out.sine = w0 * s[0] + w1 * s[1] + w2 * s[2] + w3 * s[3];
+    out.cosine = w0 * c[0] + w1 * c[1] + w2 * c[2] + w3 * c[3];
+    return true;
+}
+
+} // namespace FilterDSP
@@ -0,0 +1,158 @@
+#pragma once
+
+// Linkwitz-Riley crossover for kFilterModeCrossover: the band count and
+// split frequencies, their design (CrossoverDesigner.h) and the filter
+// memory of every channel, run by the crossover kernels
+// (CrossoverKernels.h).
+//
+// Frequency changes are collected and the crossover redesigned once, at
+// the start of the next block; the state variable filters take the new
+// coefficients without clearing their memory. Changing the band count
+// rebuilds the chain of splits and clears it.
+
+#include "CacheAligned.h"
+#include "KernelDispatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace FilterDSP {
+
+template <typename SampleType>
+class Crossover
+{
+public:
+    Crossover()
+    : m_sampleRate(44100.0)
+    , m_numBands(kMinCrossoverBands)
+    , m_numChannels(0)
+    , m_dirty(true)
+    {
+        std::copy(kDefaultCrossoverFrequencies, kDefaultCrossoverFrequencies + kMaxCrossoverSplits, m_frequencies);
+        m_coeffs = designCrossover<SampleType>(m_numBands, m_frequencies, m_sampleRate);
+    }
+
+    // Allocates; called from FilterEngine::prepare
+    void prepare(int numChannels)
+    {
+        m_numChannels = numChannels;
+        m_state.assign(static_cast<size_t>(numChannels) * kCrossoverStateRows, SampleType(0));
+    }
+
+    void reset() { std::fill(m_state.begin(), m_state.end(), SampleType(0)); }
+
+    void setSampleRate(double sampleRate)
+    {
+        if (sampleRate != m_sampleRate) {
+            m_sampleRate = sampleRate;
+            m_dirty = true;
+        }
+    }
+
+    // kMinCrossoverBands to kMaxCrossoverBands
+    void setNumBands(int numBands)
+    {
+        numBands = std::max(kMinCrossoverBands, std::min(kMaxCrossoverBands, numBands));
+        if (numBands != m_numBands) {
+            m_numBands = numBands;
+            m_dirty = true;
+            reset();
+        }
+    }
+
+    // Frequency of one split in Hz; the bands follow the splits in order of
+    // frequency, whatever their index
+    void setFrequency(int split, double frequency)
+    {
+        if (split < 0 || split >= kMaxCrossoverSplits)
+            return;
+        frequency = std::max(kCrossoverMinFreq, std::min(kCrossoverMaxFreq, frequency));
+        if (frequency != m_frequencies[split]) {
+            m_frequencies[split] = frequency;
+            m_dirty = true;
+        }
+    }
+
+    int getNumBands() const { return m_numBands; }
+    double getFrequency(int split) const { return split >= 0 && split < kMaxCrossoverSplits ? m_frequencies[split] : 0.0; }
+
+    // bandOutputs holds getNumBands() entries, the lowest band first; null
+    // entries are not written
+    void process(const SampleType* const* inputs, SampleType* const* const* bandOutputs, int numChannels, int numSamples)
+    {
+        update();
+        getFilterKernels<SampleType>().crossoverBlock(m_coeffs, inputs, bandOutputs, numChannels, numSamples,
+                                                      m_state.data(), m_numChannels);
+    }
+
+    // Single-sample path; returns the lowest band
+    SampleType processSample(SampleType input, int channel)
+    {
+        update();
+        SampleType state[kCrossoverStateRows];
+        for (int row = 0; row < kCrossoverStateRows; ++row)
+            state[row] = m_state[row * m_numChannels + channel];
+
+        SampleType bands[kMaxCrossoverBands];
+        switch (m_numBands)
+        {
+            case 2: CrossoverChain<0, 1>::tick(m_coeffs.splits, input, state, bands); break;
+            case 3: CrossoverChain<0, 2>::tick(m_coeffs.splits, input, state, bands); break;
+            case 4: CrossoverChain<0, 3>::tick(m_coeffs.splits, input, state, bands); break;
+            default: CrossoverChain<0, 4>::tick(m_coeffs.splits, input, state, bands); break;
+        }
+
+        for (int row = 0; row < kCrossoverStateRows; ++row)
+            m_state[row * m_numChannels + channel] = state[row];
+        return bands[0];
+    }
+
+    // Zero memory smaller in magnitude than threshold (see FilterState::flush)
+    void flush(SampleType threshold)
+    {
+        for (size_t i = 0; i < m_state.size(); ++i)
+            m_state[i] = std::fabs(m_state[i]) < threshold ? SampleType(0) : m_state[i];
+    }
+
+    SampleType getPeak() const
+    {
+        SampleType peak = SampleType(0);
+        for (size_t i = 0; i < m_state.size(); ++i)
+            peak = std::max(peak, std::fabs(m_state[i]));
+        return peak;
+    }
+
+    // Pole radius of the lowest split, the slowest to decay; the same as
+    // for the state variable filter mode
+    double getPoleRadius() const
+    {
+        const double lowest = *std::min_element(m_frequencies, m_frequencies + m_numBands - 1);
+        const SvfCoefficients<double> c = SvfCoefficients<double>::design(lowest, m_sampleRate, kDefaultQ);
+        const double g = c.a2 / c.a1;
+        return std::sqrt(std::fabs((1.0 - g * c.k + g * g) * c.a1));
+    }
+
+private:
+    void update()
+    {
+        if (!m_dirty)
+            return;
+        m_dirty = false;
+        m_coeffs = designCrossover<SampleType>(m_numBands, m_frequencies, m_sampleRate);
+    }
+
+    double m_sampleRate;
+    int m_numBands;
+    double m_frequencies[kMaxCrossoverSplits];
+
+    CrossoverCoefficients<SampleType> m_coeffs;
+
+    // kCrossoverStateRows rows of m_numChannels values (see CrossoverKernels.h)
+    int m_numChannels;
+    CacheAlignedVector<SampleType> m_state;
+
+    // Frequencies, band count or rate changed since the last design
+    bool m_dirty;
+};
+
+} // namespace FilterDSP
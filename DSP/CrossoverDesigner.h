@@ -0,0 +1,70 @@
+#pragma once
+
+// Coefficients of the Linkwitz-Riley crossover: 2 to 5 bands split at 1 to
+// 4 frequencies by fourth-order (24 dB/oct) Linkwitz-Riley low and high
+// passes.
+//
+// Every split is built from state variable filters with Butterworth damping
+// and shares their memory between its two outputs. One filter on the input
+// gives the second-order all pass AP = x - 2·band pass, a second filter on
+// the first one's low pass gives the LR4 low pass, and the high pass is
+// what the all pass leaves: HP = AP - LP. The two bands therefore add up to
+// the all pass exactly, with 2 filters instead of the 4 sections of
+// separate LR4 low and high passes.
+//
+// Each band also passes through the all passes of the splits it is not
+// taken from (CrossoverKernels.h), so every band has the same phase and
+// the bands sum to a flat response: the product of the all passes.
+
+#include "SvfDesigner.h"
+
+namespace FilterDSP {
+
+static const int kMinCrossoverBands = 2;
+static const int kMaxCrossoverBands = 5;
+static const int kMaxCrossoverSplits = kMaxCrossoverBands - 1;
+
+// State variable filters of the largest crossover, two memory rows each
+// (CrossoverKernels.h): 4 splits of 2 filters and 6 phase all passes
+static const int kMaxCrossoverFilters = 14;
+static const int kCrossoverStateRows = 2 * kMaxCrossoverFilters;
+
+static const double kCrossoverMinFreq = 20.0;
+static const double kCrossoverMaxFreq = 20000.0;
+
+// Two octaves apart; the usual low, low-mid, high-mid and high splits
+static const double kDefaultCrossoverFrequencies[kMaxCrossoverSplits] = { 120.0, 500.0, 2000.0, 8000.0 };
+
+template <typename SampleType>
+struct CrossoverCoefficients
+{
+    int numBands;
+
+    // One Butterworth state variable filter per split, lowest first
+    SvfCoefficients<SampleType> splits[kMaxCrossoverSplits];
+};
+
+// The first numBands - 1 frequencies, in any order; the bands follow them
+// from the lowest up
+template <typename SampleType>
+inline CrossoverCoefficients<SampleType> designCrossover(int numBands, const double* frequencies, double sampleRate)
+{
+    // At most four splits: insertion sort
+    double sorted[kMaxCrossoverSplits];
+    for (int split = 0; split < numBands - 1; ++split) {
+        int position = split;
+        for (; position > 0 && sorted[position - 1] > frequencies[split]; --position)
+            sorted[position] = sorted[position - 1];
+        sorted[position] = frequencies[split];
+    }
+
+    CrossoverCoefficients<SampleType> c;
+    c.numBands = numBands;
+    for (int split = 0; split < kMaxCrossoverSplits; ++split) {
+        const double fc = split < numBands - 1 ? sorted[split] : kCrossoverMaxFreq;
+        c.splits[split] = SvfCoefficients<SampleType>::design(SampleType(fc), SampleType(sampleRate), kDefaultQ);
+    }
+    return c;
+}
+
+} // namespace FilterDSP
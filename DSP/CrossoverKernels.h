@@ -0,0 +1,262 @@
+#pragma once
+
+// Block kernels for the Linkwitz-Riley crossover (CrossoverDesigner.h).
+// One pass over the input writes every band.
+//
+// The splits run from the lowest up: each takes the lowest band off the
+// rest of the signal, and that band then passes the all passes of the
+// splits above it. Every band is then the LR4 band pass of its two splits
+// times the all passes of the others, the same phase in every band. With 5
+// bands that is 4 splits and 6 all passes, 14 state variable filters; the
+// chain is unrolled at compile time for each band count.
+//
+// Like the other kernels, one channel occupies one SIMD lane. Within a
+// tile the chain runs one filter at a time over every time step, so only
+// that filter's memory is held in registers rather than all 28 rows. The
+// band outputs may alias the inputs; a band whose output is null is
+// computed (its filters feed the others) but not stored.
+//
+// State is kCrossoverStateRows rows of numChannels values, two per
+// filter, in chain order.
+
+#include "CrossoverDesigner.h"
+#include "SvfKernels.h"
+
+namespace FilterDSP {
+FILTERDSP_ISA_NAMESPACE_BEGIN
+
+struct CrossoverStep
+{
+    // LR4 low and high pass around one Butterworth filter on the input;
+    // state holds the memory of both filters
+    template <typename T>
+    static void split(const SvfCoefficients<T>& c, T x, T* state, T& low, T& high)
+    {
+        const SvfOutputs<T> first = SvfStep::tickAll(c, x, state[0], state[1]);
+        low = SvfStep::tick<kFilterTypeLowPass>(c, first.lowPass, state[2], state[3]);
+        high = x - splat<T>(2.0) * first.bandPass - low;
+    }
+
+    // The all pass of a split on its own, for the bands not taken from it
+    template <typename T>
+    static T allPass(const SvfCoefficients<T>& c, T x, T* state)
+    {
+        return x - splat<T>(2.0) * SvfStep::tick<kFilterTypeBandPass>(c, x, state[0], state[1]);
+    }
+
+    // The same over N time steps; high may alias x
+    template <int N, typename T>
+    static void splitTile(const SvfCoefficients<T>& c, const T* x, T* state, T* low, T* high)
+    {
+        T s[4] = { state[0], state[1], state[2], state[3] };
+        for (int step = 0; step < N; ++step)
+            split(c, x[step], s, low[step], high[step]);
+        for (int row = 0; row < 4; ++row)
+            state[row] = s[row];
+    }
+
+    template <int N, typename T>
+    static void allPassTile(const SvfCoefficients<T>& c, T* x, T* state)
+    {
+        T s[2] = { state[0], state[1] };
+        for (int step = 0; step < N; ++step)
+            x[step] = allPass(c, x[step], s);
+        state[0] = s[0];
+        state[1] = s[1];
+    }
+};
+
+// All passes of splits First..Last-1
+template <int First, int Last>
+struct CrossoverAllPasses
+{
+    static const int kNumFilters = Last - First;
+
+    template <typename T>
+    static T tick(const SvfCoefficients<T>* c, T x, T* state)
+    {
+        return CrossoverAllPasses<First + 1, Last>::tick(c, CrossoverStep::allPass(c[First], x, state), state + 2);
+    }
+};
+
+template <int Last>
+struct CrossoverAllPasses<Last, Last>
+{
+    static const int kNumFilters = 0;
+
+    template <typename T>
+    static T tick(const SvfCoefficients<T>*, T x, T*) { return x; }
+};
+
+// Bands Band..Last from splits Band..Last-1: the lowest split takes band
+// Band off the rest, and that band passes the all passes of the splits
+// above it
+template <int Band, int Last>
+struct CrossoverChain
+{
+    typedef CrossoverAllPasses<Band + 1, Last> Phase;
+    typedef CrossoverChain<Band + 1, Last> Rest;
+
+    static const int kNumFilters = 2 + Phase::kNumFilters + Rest::kNumFilters;
+
+    template <typename T>
+    static void tick(const SvfCoefficients<T>* c, T x, T* state, T* bands)
+    {
+        T low, high;
+        CrossoverStep::split(c[Band], x, state, low, high);
+        bands[Band] = Phase::tick(c, low, state + 4);
+        Rest::tick(c, high, state + 4 + 2 * Phase::kNumFilters, bands);
+    }
+};
+
+template <int Last>
+struct CrossoverChain<Last, Last>
+{
+    static const int kNumFilters = 0;
+
+    template <typename T>
+    static void tick(const SvfCoefficients<T>*, T x, T*, T* bands) { bands[Last] = x; }
+};
+
+static_assert(CrossoverChain<0, kMaxCrossoverBands - 1>::kNumFilters <= kMaxCrossoverFilters,
+              "kCrossoverStateRows does not hold the largest crossover");
+
+template <int NumBands, typename Vector>
+struct SimdCrossoverKernel
+{
+    typedef typename Vector::Scalar SampleType;
+    typedef CrossoverChain<0, NumBands - 1> Chain;
+    static const int kWidth = Vector::kWidth;
+    static const int kNumRows = 2 * Chain::kNumFilters;
+
+    static void process(const CrossoverCoefficients<SampleType>& coeffs,
+                        const SampleType* const* inputs, SampleType* const* const* bandOutputs,
+                        int numChannels, int numSamples,
+                        SampleType* state, int stateStride)
+    {
+        SvfCoefficients<Vector> c[NumBands - 1];
+        for (int split = 0; split < NumBands - 1; ++split)
+            c[split] = broadcastCoefficients<Vector>(coeffs.splits[split]);
+
+        for (int first = 0; first < numChannels; first += kWidth) {
+            const int active = numChannels - first < kWidth ? numChannels - first : kWidth;
+
+            const SampleType* in[kWidth];
+            SampleType lanes[kWidth];
+            for (int lane = 0; lane < kWidth; ++lane)
+                in[lane] = inputs[first + (lane < active ? lane : 0)];
+
+            Vector s[kNumRows];
+            for (int row = 0; row < kNumRows; ++row)
+                s[row] = loadState(state + row * stateStride + first, active, lanes);
+
+            int sample = 0;
+            for (; sample + kWidth <= numSamples; sample += kWidth) {
+                Vector tile[kWidth];
+                for (int lane = 0; lane < kWidth; ++lane)
+                    tile[lane] = Vector::loadu(in[lane] + sample);
+                Vector::transpose(tile);
+
+                // The chain one filter at a time, its rows in chain order;
+                // the tile carries what is left above each split
+                Vector bands[NumBands][kWidth];
+                Vector* rows = s;
+                for (int band = 0; band < NumBands - 1; ++band) {
+                    CrossoverStep::splitTile<kWidth>(c[band], tile, rows, bands[band], tile);
+                    rows += 4;
+                    for (int split = band + 1; split < NumBands - 1; ++split, rows += 2)
+                        CrossoverStep::allPassTile<kWidth>(c[split], bands[band], rows);
+                }
+                for (int step = 0; step < kWidth; ++step)
+                    bands[NumBands - 1][step] = tile[step];
+
+                for (int band = 0; band < NumBands; ++band) {
+                    if (!bandOutputs[band])
+                        continue;
+                    Vector::transpose(bands[band]);
+                    for (int lane = 0; lane < active; ++lane)
+                        bands[band][lane].storeu(bandOutputs[band][first + lane] + sample);
+                }
+            }
+
+            // Remaining samples, one time step at a time
+            for (; sample < numSamples; ++sample) {
+                for (int lane = 0; lane < kWidth; ++lane)
+                    lanes[lane] = in[lane][sample];
+                Vector y[NumBands];
+                Chain::tick(c, Vector::loadu(lanes), s, y);
+                for (int band = 0; band < NumBands; ++band) {
+                    if (!bandOutputs[band])
+                        continue;
+                    y[band].storeu(lanes);
+                    for (int lane = 0; lane < active; ++lane)
+                        bandOutputs[band][first + lane][sample] = lanes[lane];
+                }
+            }
+
+            for (int row = 0; row < kNumRows; ++row)
+                storeState(s[row], state + row * stateStride + first, active, lanes);
+        }
+    }
+
+private:
+    static Vector loadState(const SampleType* src, int active, SampleType* lanes)
+    {
+        for (int lane = 0; lane < kWidth; ++lane)
+            lanes[lane] = lane < active ? src[lane] : SampleType(0);
+        return Vector::loadu(lanes);
+    }
+
+    static void storeState(Vector v, SampleType* dst, int active, SampleType* lanes)
+    {
+        v.storeu(lanes);
+        for (int lane = 0; lane < active; ++lane)
+            dst[lane] = lanes[lane];
+    }
+};
+
+template <int NumBands, typename SampleType>
+inline void processCrossoverBlock(const CrossoverCoefficients<SampleType>& coeffs,
+                                  const SampleType* const* inputs, SampleType* const* const* bandOutputs,
+                                  int numChannels, int numSamples,
+                                  SampleType* state, int stateStride)
+{
+    typedef typename SimdTraits<SampleType>::Narrow Narrow;
+    typedef typename SimdTraits<SampleType>::Wide Wide;
+    typedef typename SimdTraits<SampleType>::Widest Widest;
+
+    if (numChannels <= Narrow::kWidth)
+        SimdCrossoverKernel<NumBands, Narrow>::process(coeffs, inputs, bandOutputs, numChannels, numSamples, state, stateStride);
+    else if (numChannels <= Wide::kWidth)
+        SimdCrossoverKernel<NumBands, Wide>::process(coeffs, inputs, bandOutputs, numChannels, numSamples, state, stateStride);
+    else
+        SimdCrossoverKernel<NumBands, Widest>::process(coeffs, inputs, bandOutputs, numChannels, numSamples, state, stateStride);
+}
+
+// Picks the chain for the band count once per block. bandOutputs holds
+// coeffs.numBands entries, the lowest band first.
+template <typename SampleType>
+inline void processCrossoverBlock(const CrossoverCoefficients<SampleType>& coeffs,
+                                  const SampleType* const* inputs, SampleType* const* const* bandOutputs,
+                                  int numChannels, int numSamples,
+                                  SampleType* state, int stateStride)
+{
+    switch (coeffs.numBands)
+    {
+        case 2:
+            processCrossoverBlock<2>(coeffs, inputs, bandOutputs, numChannels, numSamples, state, stateStride);
+            break;
+        case 3:
+            processCrossoverBlock<3>(coeffs, inputs, bandOutputs, numChannels, numSamples, state, stateStride);
+            break;
+        case 4:
+            processCrossoverBlock<4>(coeffs, inputs, bandOutputs, numChannels, numSamples, state, stateStride);
+            break;
+        case 5:
+            processCrossoverBlock<5>(coeffs, inputs, bandOutputs, numChannels, numSamples, state, stateStride);
+            break;
+    }
+}
+
+FILTERDSP_ISA_NAMESPACE_END
+} // namespace FilterDSP
@@ -0,0 +1,80 @@
+#pragma once
+
+// Scoped denormal protection for the audio callbacks.
+// Subnormal floats make every multiply on x86 take 100+ cycles, and filter
+// memory decays into that range whenever the input goes quiet. For its
+// lifetime, ScopedNoDenormals sets flush-to-zero (results) and
+// denormals-are-zero (inputs) on SSE, or FZ on ARM, and restores the
+// caller's floating-point mode on exit.
+//
+// On other targets it does nothing; FilterEngine also flushes tiny filter
+// memory to zero after every block (kDenormalThreshold), so the state
+// never stays subnormal even without the hardware modes.
+
+#include "SimdOps.h"
+
+#if defined(FILTERDSP_HAS_SSE2)
+    #include <xmmintrin.h>
+#endif
+
+namespace FilterDSP {
+
+class ScopedNoDenormals
+{
+public:
+    ScopedNoDenormals()
+    : m_previous(getMode())
+    {
+        setMode(m_previous | kFlushMask);
+    }
+
+    ~ScopedNoDenormals()
+    {
+        setMode(m_previous);
+    }
+
+private:
+    ScopedNoDenormals(const ScopedNoDenormals&);
+    ScopedNoDenormals& operator=(const ScopedNoDenormals&);
+
+#if defined(FILTERDSP_HAS_SSE2)
+    typedef unsigned int Mode;
+    static const Mode kFlushMask = 0x8040;      // MXCSR FTZ (bit 15) | DAZ (bit 6)
+
+    static Mode getMode() { return _mm_getcsr(); }
+    static void setMode(Mode mode) { _mm_setcsr(mode); }
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+    typedef unsigned long long Mode;
+    static const Mode kFlushMask = 1ull << 24;  // FPCR FZ
+
+    static Mode getMode()
+    {
+        Mode mode;
+        __asm__ __volatile__("mrs %0, fpcr" : "=r"(mode));
+        return mode;
+    }
+    static void setMode(Mode mode) { __asm__ __volatile__("msr fpcr, %0" : : "r"(mode)); }
+#elif defined(__arm__) && defined(__ARM_FP) && !defined(_MSC_VER)
+    typedef unsigned int Mode;
+    static const Mode kFlushMask = 1u << 24;    // FPSCR FZ
+
+    static Mode getMode()
+    {
+        Mode mode;
+        __asm__ __volatile__("vmrs %0, fpscr" : "=r"(mode));
+        return mode;
+    }
+    static void setMode(Mode mode) { __asm__ __volatile__("vmsr fpscr, %0" : : "r"(mode)); }
+#else
+    // Portable fallback: rely on the engine's state flushing
+    typedef unsigned int Mode;
+    static const Mode kFlushMask = 0;
+
+    static Mode getMode() { return 0; }
+    static void setMode(Mode) {}
+#endif
+
+    Mode m_previous;
+};
+
+} // namespace FilterDSP
@@ -0,0 +1,268 @@
+#pragma once
+
+// Process-wide cache of immutable filter designs, shared by every instance
+// in the plugin module.
+//
+// Instances running the same preset need the same designs, so the cache
+// keeps one copy of each, reference-counted by the instances that play
+// it. find() is wait-free and never allocates, so the audio thread can call
+// it: it probes at most kMaxProbes slots of an open-addressing table of
+// atomic pointers, and takes one atomic increment on a hit. Misses are
+// filled by acquire() on another thread (the background worker, or
+// prepare). It designs under a mutex the audio thread never takes, so
+// concurrent misses for the same key design it once.
+//
+// Releasing a reference only decrements the count, so it is safe on the
+// audio thread. Entries are deleted only inside acquire(), and only while
+// more than kMaxUnused entries are unreferenced. The least recently used
+// entry is unlinked from the table first, and is deleted once every find()
+// that may have seen it has finished (two reader counters flipped by the
+// writer, as in counter-based RCU), provided it is still unreferenced
+// then. find() can miss an entry the writer is moving; the caller then
+// falls back to acquire().
+//
+// Key needs operator== and a size_t hash() const. Value is built by the
+// make function given to acquire().
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace FilterDSP {
+
+template <typename Key, typename Value>
+class SharedDesignCache
+{
+public:
+    // Lookup table size and probe limit; entries that do not fit are still
+    // shared through acquire(), just not found by find()
+    static const int kTableSize = 256;
+    static const int kMaxProbes = 8;
+
+    // Unreferenced designs kept for instances that come back to them
+    static const int kMaxUnused = 32;
+
+    class Entry
+    {
+    public:
+        const Key key;
+        const Value value;
+
+    private:
+        friend class SharedDesignCache;
+
+        Entry(const Key& k, Value&& v, size_t h)
+        : key(k)
+        , value(std::move(v))
+        , hash(h)
+        , references(1)
+        , lastUse(0)
+        , linked(false)
+        {
+        }
+
+        const size_t hash;
+        mutable std::atomic<int> references;
+        mutable std::atomic<unsigned> lastUse;
+        bool linked;                // in the table (writer only)
+    };
+
+    static SharedDesignCache& get()
+    {
+        static SharedDesignCache cache;
+        return cache;
+    }
+
+    // Audio thread: a counted reference to the entry for key, or nullptr
+    const Entry* find(const Key& key)
+    {
+        const size_t hash = key.hash();
+        std::atomic<int>& readers = m_readers[m_epoch.load() & 1];
+        readers.fetch_add(1);
+
+        const Entry* found = nullptr;
+        for (int probe = 0; probe < kMaxProbes; ++probe) {
+            const Entry* entry = m_table[(hash + probe) & (kTableSize - 1)].load();
+            if (!entry)
+                break;
+            if (entry->hash == hash && entry->key == key) {
+                entry->references.fetch_add(1, std::memory_order_relaxed);
+                entry->lastUse.store(m_clock.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                found = entry;
+                break;
+            }
+        }
+
+        readers.fetch_sub(1);
+        return found;
+    }
+
+    // Not the audio thread: a counted reference to the entry for key,
+    // designed with make(key) if it is not cached. Blocks while another
+    // thread designs.
+    template <typename Make>
+    const Entry* acquire(const Key& key, Make make)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const unsigned now = m_clock.load(std::memory_order_relaxed) + 1;
+        m_clock.store(now, std::memory_order_relaxed);
+
+        // Unlinked entries are still alive (only this thread deletes them)
+        const size_t hash = key.hash();
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            Entry* entry = m_entries[i];
+            if (entry->hash == hash && entry->key == key) {
+                entry->references.fetch_add(1, std::memory_order_relaxed);
+                entry->lastUse.store(now, std::memory_order_relaxed);
+                if (!entry->linked)
+                    link(entry);
+                return entry;
+            }
+        }
+
+        Entry* entry = new Entry(key, make(key), hash);
+        entry->lastUse.store(now, std::memory_order_relaxed);
+        m_entries.push_back(entry);
+        link(entry);
+        collect();
+        return entry;
+    }
+
+    // Another reference to an entry the caller holds
+    static const Entry* retain(const Entry* entry)
+    {
+        if (entry)
+            entry->references.fetch_add(1, std::memory_order_relaxed);
+        return entry;
+    }
+
+    // Any thread; never deletes
+    static void release(const Entry* entry)
+    {
+        if (entry)
+            entry->references.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Designs held, referenced or not
+    int getNumEntries()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return static_cast<int>(m_entries.size());
+    }
+
+private:
+    SharedDesignCache()
+    : m_epoch(0)
+    , m_clock(0)
+    {
+        for (int i = 0; i < kTableSize; ++i)
+            m_table[i].store(nullptr);
+        m_readers[0].store(0);
+        m_readers[1].store(0);
+    }
+
+    // Entries still referenced at exit belong to objects destroyed after
+    // the cache, and are left to the OS
+    ~SharedDesignCache()
+    {
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            if (m_entries[i]->references.load(std::memory_order_acquire) == 0)
+                delete m_entries[i];
+        }
+    }
+
+    SharedDesignCache(const SharedDesignCache&) = delete;
+    SharedDesignCache& operator=(const SharedDesignCache&) = delete;
+
+    void link(Entry* entry)
+    {
+        for (int probe = 0; probe < kMaxProbes; ++probe) {
+            std::atomic<const Entry*>& slot = m_table[(entry->hash + probe) & (kTableSize - 1)];
+            if (!slot.load()) {
+                slot.store(entry);
+                entry->linked = true;
+                return;
+            }
+        }
+    }
+
+    // Backward-shift deletion: later entries of the cluster move into the
+    // gap when it lies on their probe path, so no lookup stops short of
+    // them once the shift is done
+    void unlink(Entry* entry)
+    {
+        const size_t mask = kTableSize - 1;
+        size_t gap = entry->hash & mask;
+        while (m_table[gap].load() != entry)
+            gap = (gap + 1) & mask;
+        m_table[gap].store(nullptr);
+        entry->linked = false;
+
+        for (size_t index = (gap + 1) & mask; ; index = (index + 1) & mask) {
+            const Entry* moved = m_table[index].load();
+            if (!moved)
+                break;
+            const size_t home = moved->hash & mask;
+            if (((gap - home) & mask) < ((index - home) & mask)) {
+                m_table[gap].store(moved);
+                m_table[index].store(nullptr);
+                gap = index;
+            }
+        }
+    }
+
+    // Waits until no find() can still hold a pointer it read before now
+    void synchronize()
+    {
+        for (int pass = 0; pass < 2; ++pass) {
+            const unsigned epoch = m_epoch.fetch_add(1);
+            while (m_readers[epoch & 1].load() != 0)
+                std::this_thread::yield();
+        }
+    }
+
+    // Deletes the least recently used unreferenced entries beyond kMaxUnused
+    void collect()
+    {
+        std::vector<Entry*> unused;
+        for (size_t i = 0; i < m_entries.size(); ++i) {
+            if (m_entries[i]->references.load(std::memory_order_acquire) == 0)
+                unused.push_back(m_entries[i]);
+        }
+        if (unused.size() <= static_cast<size_t>(kMaxUnused))
+            return;
+
+        std::sort(unused.begin(), unused.end(), [](const Entry* a, const Entry* b) {
+            return a->lastUse.load(std::memory_order_relaxed) < b->lastUse.load(std::memory_order_relaxed);
+        });
+        unused.resize(unused.size() - kMaxUnused);
+        for (size_t i = 0; i < unused.size(); ++i) {
+            if (unused[i]->linked)
+                unlink(unused[i]);
+        }
+        synchronize();
+
+        // An entry found again in the meantime stays, unlinked, until a
+        // later collect() sees it unreferenced
+        for (size_t i = 0; i < unused.size(); ++i) {
+            Entry* entry = unused[i];
+            if (entry->references.load(std::memory_order_acquire) == 0) {
+                m_entries.erase(std::find(m_entries.begin(), m_entries.end(), entry));
+                delete entry;
+            }
+        }
+    }
+
+    std::atomic<const Entry*> m_table[kTableSize];
+    std::atomic<unsigned> m_epoch;
+    std::atomic<int> m_readers[2];          // find() calls in progress, by epoch parity
+    std::atomic<unsigned> m_clock;          // acquire() count, for lastUse
+
+    std::mutex m_mutex;                     // writers
+    std::vector<Entry*> m_entries;
+};
+
+} // namespace FilterDSP
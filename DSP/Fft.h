@@ -0,0 +1,183 @@
+#pragma once
+
+// Real-input FFT for the partitioned convolution. A real signal of length N
+// is transformed as a complex signal of length N/2 (even samples real, odd
+// samples imaginary) and split into the N/2 + 1 bins of the real spectrum.
+// Spectra are kept as separate real and imaginary arrays so bin-wise
+// products vectorize like the filter kernels do.
+//
+// The complex transform is an iterative radix-2 FFT with per-stage twiddle
+// tables; stages at least one vector wide run in SIMD lanes. All memory is
+// allocated in prepare().
+
+#include "SimdOps.h"
+
+#include <cmath>
+#include <vector>
+
+namespace FilterDSP {
+
+template <typename SampleType>
+class RealFft
+{
+public:
+    RealFft() : m_size(0) {}
+
+    // Power of two, at least 4
+    void prepare(int size)
+    {
+        const double pi = 3.14159265358979323846;
+        m_size = size;
+        const int half = size / 2;
+
+        int bits = 0;
+        while ((1 << bits) < half)
+            ++bits;
+        m_bitReverse.resize(half);
+        for (int n = 0; n < half; ++n) {
+            int reversed = 0;
+            for (int bit = 0; bit < bits; ++bit)
+                reversed |= ((n >> bit) & 1) << (bits - 1 - bit);
+            m_bitReverse[n] = reversed;
+        }
+
+        // Twiddles of the stage with butterfly span s at [s, 2s): e^(-iπj/s)
+        m_twiddleRe.assign(half > 1 ? half : 2, SampleType(0));
+        m_twiddleIm.assign(half > 1 ? half : 2, SampleType(0));
+        for (int span = 1; span < half; span *= 2) {
+            for (int j = 0; j < span; ++j) {
+                m_twiddleRe[span + j] = SampleType(std::cos(pi * j / span));
+                m_twiddleIm[span + j] = SampleType(-std::sin(pi * j / span));
+            }
+        }
+
+        // Split twiddles e^(-2πik/N)
+        m_splitRe.resize(half);
+        m_splitIm.resize(half);
+        for (int k = 0; k < half; ++k) {
+            m_splitRe[k] = SampleType(std::cos(2.0 * pi * k / size));
+            m_splitIm[k] = SampleType(-std::sin(2.0 * pi * k / size));
+        }
+
+        m_re.assign(half, SampleType(0));
+        m_im.assign(half, SampleType(0));
+    }
+
+    int getSize() const { return m_size; }
+    int getNumBins() const { return m_size / 2 + 1; }
+
+    // getSize() samples -> getNumBins() bins
+    void forward(const SampleType* input, SampleType* re, SampleType* im)
+    {
+        const int half = m_size / 2;
+        for (int n = 0; n < half; ++n) {
+            m_re[m_bitReverse[n]] = input[2 * n];
+            m_im[m_bitReverse[n]] = input[2 * n + 1];
+        }
+        transform<false>();
+
+        // X[k] = E[k] + W^k·O[k], with E = (Z[k] + Z*[M-k]) / 2 and
+        // O = (Z[k] - Z*[M-k]) / 2i
+        const SampleType h = SampleType(0.5);
+        re[0] = m_re[0] + m_im[0];
+        im[0] = SampleType(0);
+        re[half] = m_re[0] - m_im[0];
+        im[half] = SampleType(0);
+        for (int k = 1; k < half; ++k) {
+            const SampleType zr = m_re[k], zi = m_im[k];
+            const SampleType cr = m_re[half - k], ci = -m_im[half - k];
+            const SampleType er = h * (zr + cr), ei = h * (zi + ci);
+            const SampleType orr = h * (zi - ci), oi = h * (cr - zr);
+            re[k] = er + m_splitRe[k] * orr - m_splitIm[k] * oi;
+            im[k] = ei + m_splitRe[k] * oi + m_splitIm[k] * orr;
+        }
+    }
+
+    // getNumBins() bins -> getSize() samples; inverse(forward(x)) == x
+    void inverse(const SampleType* re, const SampleType* im, SampleType* output)
+    {
+        const int half = m_size / 2;
+
+        // Z[k] = E[k] + i·O[k], with E = (X[k] + X*[M-k]) / 2 and
+        // O = (X[k] - X*[M-k]) / 2 · W^-k
+        const SampleType h = SampleType(0.5);
+        for (int k = 0; k < half; ++k) {
+            const SampleType xr = re[k], xi = im[k];
+            const SampleType cr = re[half - k], ci = -im[half - k];
+            const SampleType er = h * (xr + cr), ei = h * (xi + ci);
+            const SampleType dr = h * (xr - cr), di = h * (xi - ci);
+            const SampleType orr = dr * m_splitRe[k] + di * m_splitIm[k];
+            const SampleType oi = di * m_splitRe[k] - dr * m_splitIm[k];
+            const int target = m_bitReverse[k];
+            m_re[target] = er - oi;
+            m_im[target] = ei + orr;
+        }
+        transform<true>();
+
+        const SampleType scale = SampleType(1) / SampleType(half);
+        for (int n = 0; n < half; ++n) {
+            output[2 * n] = m_re[n] * scale;
+            output[2 * n + 1] = m_im[n] * scale;
+        }
+    }
+
+private:
+    // In-place complex FFT of m_re/m_im (bit-reversed input)
+    template <bool Inverse>
+    void transform()
+    {
+        typedef typename SimdTraits<SampleType>::Wide Vector;
+        const int width = Vector::kWidth;
+        const int half = m_size / 2;
+
+        for (int span = 1; span < half; span *= 2) {
+            const SampleType* wr = &m_twiddleRe[span];
+            const SampleType* wi = &m_twiddleIm[span];
+            for (int start = 0; start < half; start += 2 * span) {
+                SampleType* ar = &m_re[start];
+                SampleType* ai = &m_im[start];
+                SampleType* br = ar + span;
+                SampleType* bi = ai + span;
+
+                int j = 0;
+                if (span >= width) {
+                    for (; j < span; j += width) {
+                        const Vector twr = Vector::loadu(wr + j);
+                        const Vector twi = Inverse ? Vector::broadcast(SampleType(0)) - Vector::loadu(wi + j) : Vector::loadu(wi + j);
+                        const Vector xr = Vector::loadu(br + j), xi = Vector::loadu(bi + j);
+                        const Vector tr = xr * twr - xi * twi;
+                        const Vector ti = xr * twi + xi * twr;
+                        const Vector ur = Vector::loadu(ar + j), ui = Vector::loadu(ai + j);
+                        (ur + tr).storeu(ar + j);
+                        (ui + ti).storeu(ai + j);
+                        (ur - tr).storeu(br + j);
+                        (ui - ti).storeu(bi + j);
+                    }
+                }
+                for (; j < span; ++j) {
+                    const SampleType twi = Inverse ? -wi[j] : wi[j];
+                    const SampleType tr = br[j] * wr[j] - bi[j] * twi;
+                    const SampleType ti = br[j] * twi + bi[j] * wr[j];
+                    const SampleType ur = ar[j], ui = ai[j];
+                    ar[j] = ur + tr;
+                    ai[j] = ui + ti;
+                    br[j] = ur - tr;
+                    bi[j] = ui - ti;
+                }
+            }
+        }
+    }
+
+    int m_size;
+    std::vector<int> m_bitReverse;
+    std::vector<SampleType> m_twiddleRe;
+    std::vector<SampleType> m_twiddleIm;
+    std::vector<SampleType> m_splitRe;
+    std::vector<SampleType> m_splitIm;
+
+    // Complex work buffer (size/2)
+    std::vector<SampleType> m_re;
+    std::vector<SampleType> m_im;
+};
+
+} // namespace FilterDSP
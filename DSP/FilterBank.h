@@ -0,0 +1,190 @@
+#pragma once
+
+// Graphic EQ bank for kFilterModeGraphicEq: the band gains, the packed
+// design of the active bands (FilterBankDesigner.h) and the filter memory
+// of every channel, run by the bank kernels (FilterBankKernels.h).
+//
+// Gain changes are collected and the bank redesigned once, at the start of
+// the next block. A band keeps its memory while it stays active, even when
+// other bands turning on or off move it to another lane, so adjusting one
+// band does not disturb the rest. Changing the band count or the layout
+// moves every band and clears the memory.
+
+#include "CacheAligned.h"
+#include "KernelDispatch.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace FilterDSP {
+
+template <typename SampleType>
+class FilterBank
+{
+public:
+    FilterBank()
+    : m_sampleRate(44100.0)
+    , m_numBands(kMaxBankBands)
+    , m_layout(kBankLayoutSerial)
+    , m_numChannels(0)
+    , m_dirty(true)
+    {
+        std::fill(m_gainsDb, m_gainsDb + kMaxBankBands, 0.0);
+        m_bank = designFilterBank<SampleType>(m_layout, m_numBands, m_gainsDb, m_sampleRate);
+    }
+
+    // Allocates; called from FilterEngine::prepare
+    void prepare(int numChannels)
+    {
+        m_numChannels = numChannels;
+        m_state.assign(static_cast<size_t>(numChannels) * kBankStateSize, SampleType(0));
+    }
+
+    void reset() { std::fill(m_state.begin(), m_state.end(), SampleType(0)); }
+
+    void setSampleRate(double sampleRate)
+    {
+        if (sampleRate != m_sampleRate) {
+            m_sampleRate = sampleRate;
+            m_dirty = true;
+        }
+    }
+
+    // 1 to kMaxBankBands bands over 20 Hz - 20 kHz
+    void setNumBands(int numBands)
+    {
+        numBands = std::max(1, std::min(kMaxBankBands, numBands));
+        if (numBands != m_numBands) {
+            m_numBands = numBands;
+            m_dirty = true;
+            reset();
+        }
+    }
+
+    // BankLayout
+    void setLayout(int layout)
+    {
+        if (layout < kBankLayoutSerial || layout >= kNumBankLayouts || layout == m_layout)
+            return;
+        m_layout = layout;
+        m_dirty = true;
+        reset();
+    }
+
+    // Gain of one band in dB, ±kMaxBankGainDb
+    void setBandGain(int band, double gainDb)
+    {
+        if (band < 0 || band >= kMaxBankBands)
+            return;
+        gainDb = std::max(-kMaxBankGainDb, std::min(kMaxBankGainDb, gainDb));
+        if (gainDb != m_gainsDb[band]) {
+            m_gainsDb[band] = gainDb;
+            m_dirty = true;
+        }
+    }
+
+    int getNumBands() const { return m_numBands; }
+    int getLayout() const { return m_layout; }
+    double getBandGain(int band) const { return band >= 0 && band < kMaxBankBands ? m_gainsDb[band] : 0.0; }
+
+    // Bands away from unity gain, i.e. the lanes the kernels run
+    int getNumActiveBands()
+    {
+        update();
+        return m_bank.numActive;
+    }
+
+    void process(const SampleType* const* inputs, SampleType* const* outputs, int numChannels, int numSamples)
+    {
+        update();
+        getFilterKernels<SampleType>().bankBlock(m_bank, inputs, outputs, numChannels, numSamples, m_state.data());
+    }
+
+    // Single-sample path, lane by lane
+    SampleType processSample(SampleType input, int channel)
+    {
+        update();
+        SampleType* s1 = m_state.data() + channel * kBankStateSize;
+        SampleType* s2 = s1 + kMaxBankLanes;
+        if (m_bank.layout == kBankLayoutParallel) {
+            SampleType output = input;
+            for (int lane = 0; lane < m_bank.numActive; ++lane)
+                output += BiquadStep::tick(m_bank.getSection(lane), input, s1[lane], s2[lane]);
+            return output;
+        }
+        for (int lane = 0; lane < m_bank.numActive; ++lane)
+            input = BiquadStep::tick(m_bank.getSection(lane), input, s1[lane], s2[lane]);
+        return input;
+    }
+
+    // Zero memory smaller in magnitude than threshold (see FilterState::flush)
+    void flush(SampleType threshold)
+    {
+        for (size_t i = 0; i < m_state.size(); ++i)
+            m_state[i] = std::fabs(m_state[i]) < threshold ? SampleType(0) : m_state[i];
+    }
+
+    SampleType getPeak() const
+    {
+        SampleType peak = SampleType(0);
+        for (size_t i = 0; i < m_state.size(); ++i)
+            peak = std::max(peak, std::fabs(m_state[i]));
+        return peak;
+    }
+
+    // Slowest pole radius of the active bands, for the tail length
+    double getPoleRadius() const
+    {
+        double radius = 0.0;
+        for (int lane = 0; lane < m_bank.numActive; ++lane)
+            radius = std::max(radius, std::sqrt(std::fabs(double(m_bank.a2[lane]))));
+        return radius;
+    }
+
+private:
+    // Redesign after parameter changes, moving each band's memory to its
+    // new lane
+    void update()
+    {
+        if (!m_dirty)
+            return;
+        m_dirty = false;
+
+        const FilterBankCoefficients<SampleType> bank = designFilterBank<SampleType>(m_layout, m_numBands, m_gainsDb, m_sampleRate);
+        int previousLane[kMaxBankBands];
+        std::fill(previousLane, previousLane + kMaxBankBands, -1);
+        for (int lane = 0; lane < m_bank.numActive; ++lane)
+            previousLane[m_bank.bands[lane]] = lane;
+
+        SampleType moved[kBankStateSize];
+        for (int channel = 0; channel < m_numChannels; ++channel) {
+            SampleType* state = m_state.data() + channel * kBankStateSize;
+            std::fill(moved, moved + kBankStateSize, SampleType(0));
+            for (int lane = 0; lane < bank.numActive; ++lane) {
+                const int from = previousLane[bank.bands[lane]];
+                if (from < 0)
+                    continue;
+                moved[lane] = state[from];
+                moved[kMaxBankLanes + lane] = state[kMaxBankLanes + from];
+            }
+            std::copy(moved, moved + kBankStateSize, state);
+        }
+        m_bank = bank;
+    }
+
+    double m_sampleRate;
+    int m_numBands;
+    int m_layout;
+    double m_gainsDb[kMaxBankBands];
+
+    FilterBankCoefficients<SampleType> m_bank;
+
+    // kBankStateSize values per channel (see FilterBankKernels.h)
+    int m_numChannels;
+    CacheAlignedVector<SampleType> m_state;
+
+    // Gains, band count, layout or rate changed since the last design
+    bool m_dirty;
+};
+
+} // namespace FilterDSP
@@ -0,0 +1,142 @@
+#pragma once
+
+// Coefficients of the graphic EQ bank: up to 31 bell bands spaced evenly
+// in log frequency from 20 Hz to 20 kHz, each with its own gain.
+//
+// The bands run either in series (a cascade of bell sections, the classic
+// graphic EQ) or in parallel, where the output is the input plus a
+// weighted band pass per band. A bell of gain A² is exactly
+//   1 + (A² - 1)·BP(Q·A)
+// with BP a 0 dB band pass, so one band on its own is identical in both
+// layouts; with several bands the parallel sum lets neighbouring bands
+// add instead of multiply.
+//
+// Bands at unity gain are left out: the active bands are packed into the
+// first lanes (one band per SIMD lane, see FilterBankKernels.h) and the
+// remaining lanes hold sections that do nothing.
+
+#include "BiquadDesigner.h"
+
+#include <cmath>
+
+namespace FilterDSP {
+
+// Band layouts (kBankLayoutId / kParam_BankLayout)
+enum BankLayout
+{
+    kBankLayoutSerial = 0,
+    kBankLayoutParallel = 1,
+    kNumBankLayouts = 2
+};
+
+// 1/3-octave bands over the audio range
+static const int kMaxBankBands = 31;
+
+// Lanes of the packed designs: the bands, rounded up to whole vectors of
+// the widest instruction set (16 floats)
+static const int kMaxBankLanes = 32;
+
+// Filter memory per channel: s1 and s2 of every lane (FilterBankKernels.h)
+static const int kBankStateSize = 2 * kMaxBankLanes;
+
+// Band gain range, and the gain below which a band counts as unity
+static const double kMaxBankGainDb = 12.0;
+static const double kBankUnityGainDb = 1e-3;
+
+static const double kBankMinFreq = 20.0;
+static const double kBankMaxFreq = 20000.0;
+
+// Centre of band k of numBands, at the middle of its share of the range
+inline double getBankBandFrequency(int band, int numBands)
+{
+    return kBankMinFreq * std::pow(kBankMaxFreq / kBankMinFreq, (band + 0.5) / numBands);
+}
+
+// Q of a bell one band spacing wide: √(2^b) / (2^b - 1) for b octaves
+inline double getBankQ(int numBands)
+{
+    const double ratio = std::pow(kBankMaxFreq / kBankMinFreq, 1.0 / numBands);
+    return std::fmax(kMinQ, std::sqrt(ratio) / (ratio - 1.0));
+}
+
+template <typename SampleType>
+struct FilterBankCoefficients
+{
+    int layout;
+    int numActive;                  // lanes 0..numActive-1 hold bands
+    int bands[kMaxBankLanes];       // band of each active lane
+
+    // One section per lane, structure of arrays for the vector loads
+    SampleType b0[kMaxBankLanes];
+    SampleType b1[kMaxBankLanes];
+    SampleType b2[kMaxBankLanes];
+    SampleType a1[kMaxBankLanes];
+    SampleType a2[kMaxBankLanes];
+
+    BiquadCoefficients<SampleType> getSection(int lane) const
+    {
+        BiquadCoefficients<SampleType> c;
+        c.b0 = b0[lane];
+        c.b1 = b1[lane];
+        c.b2 = b2[lane];
+        c.a1 = a1[lane];
+        c.a2 = a2[lane];
+        return c;
+    }
+
+    void setSection(int lane, const BiquadCoefficients<SampleType>& c)
+    {
+        b0[lane] = c.b0;
+        b1[lane] = c.b1;
+        b2[lane] = c.b2;
+        a1[lane] = c.a1;
+        a2[lane] = c.a2;
+    }
+};
+
+// Serial lanes hold the bells; parallel lanes the band passes scaled by
+// A² - 1, summed onto the input. Unused lanes pass their input (serial)
+// or add nothing (parallel).
+template <typename SampleType>
+inline FilterBankCoefficients<SampleType> designFilterBank(int layout, int numBands, const double* gainsDb, double sampleRate)
+{
+    FilterBankCoefficients<SampleType> bank;
+    bank.layout = layout;
+    bank.numActive = 0;
+
+    BiquadCoefficients<SampleType> unused;
+    unused.b0 = SampleType(layout == kBankLayoutSerial ? 1 : 0);
+    unused.b1 = unused.b2 = unused.a1 = unused.a2 = SampleType(0);
+    for (int lane = 0; lane < kMaxBankLanes; ++lane) {
+        bank.bands[lane] = -1;
+        bank.setSection(lane, unused);
+    }
+
+    const double q = getBankQ(numBands);
+    for (int band = 0; band < numBands; ++band) {
+        const double gainDb = gainsDb[band];
+        if (std::fabs(gainDb) < kBankUnityGainDb)
+            continue;
+
+        const double fc = getBankBandFrequency(band, numBands);
+        const int lane = bank.numActive++;
+        bank.bands[lane] = band;
+        if (layout == kBankLayoutSerial) {
+            bank.setSection(lane, designSection<SampleType>(kFilterTypePeak, fc, sampleRate, q, gainDb));
+            continue;
+        }
+
+        const double a = std::pow(10.0, gainDb / 40.0);
+        const BiquadCoefficients<double> bandPass = designSection<double>(kFilterTypeBandPass, fc, sampleRate, q * a, 0.0);
+        BiquadCoefficients<SampleType> weighted;
+        weighted.b0 = SampleType((a * a - 1.0) * bandPass.b0);
+        weighted.b1 = SampleType(0);
+        weighted.b2 = SampleType((a * a - 1.0) * bandPass.b2);
+        weighted.a1 = SampleType(bandPass.a1);
+        weighted.a2 = SampleType(bandPass.a2);
+        bank.setSection(lane, weighted);
+    }
+    return bank;
+}
+
+} // namespace FilterDSP
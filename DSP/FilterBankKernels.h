@@ -0,0 +1,206 @@
+#pragma once
+
+// Block kernels for the graphic EQ bank (FilterBankDesigner.h). Unlike the
+// other kernels, which put one channel in each SIMD lane, these put one
+// band in each lane and run the channels one after another: a 31-band bank
+// is one or two vectors of sections per channel, however few channels the
+// bus has.
+//
+// Parallel layout: every band sees the same input sample, so each sample is
+// one vector tick per group of bands. The band outputs of a square tile of
+// samples are transposed in registers and summed, giving the wet signal of
+// the tile as one vector.
+//
+// Serial layout: band k needs the output of band k-1, so the bands run as a
+// skewed wavefront - at step t, lane k processes sample t - k, its input
+// being the previous step's output of lane k-1, moved up one lane in
+// registers (shiftUp). The first and last numActive-1 steps have lanes
+// outside the block, whose state is masked out; a block is
+// numSamples + numActive - 1 steps.
+//
+// State is 2·kMaxBankLanes values per channel: the s1 of every lane, then
+// the s2 of every lane. Only lanes below numActive are touched.
+
+#include "BiquadKernels.h"
+#include "FilterBankDesigner.h"
+#include "SimdOps.h"
+
+namespace FilterDSP {
+FILTERDSP_ISA_NAMESPACE_BEGIN
+
+template <typename Vector>
+struct SimdFilterBankKernel
+{
+    typedef typename Vector::Scalar SampleType;
+    static const int kWidth = Vector::kWidth;
+    static const int kMaxGroups = kMaxBankLanes / kWidth;
+
+    static void process(const FilterBankCoefficients<SampleType>& bank,
+                        const SampleType* const* inputs, SampleType* const* outputs,
+                        int numChannels, int numSamples, SampleType* state)
+    {
+        const int numGroups = (bank.numActive + kWidth - 1) / kWidth;
+        BiquadCoefficients<Vector> c[kMaxGroups];
+        for (int group = 0; group < numGroups; ++group) {
+            const int lane = group * kWidth;
+            c[group].b0 = Vector::loadu(bank.b0 + lane);
+            c[group].b1 = Vector::loadu(bank.b1 + lane);
+            c[group].b2 = Vector::loadu(bank.b2 + lane);
+            c[group].a1 = Vector::loadu(bank.a1 + lane);
+            c[group].a2 = Vector::loadu(bank.a2 + lane);
+        }
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            SampleType* s1 = state + channel * kBankStateSize;
+            SampleType* s2 = s1 + kMaxBankLanes;
+            if (bank.layout == kBankLayoutParallel)
+                processParallel(c, numGroups, inputs[channel], outputs[channel], numSamples, s1, s2);
+            else
+                processSerial(c, numGroups, bank.numActive - 1, inputs[channel], outputs[channel], numSamples, s1, s2);
+        }
+    }
+
+private:
+    static void processParallel(const BiquadCoefficients<Vector>* c, int numGroups,
+                                const SampleType* in, SampleType* out, int numSamples,
+                                SampleType* state1, SampleType* state2)
+    {
+        Vector s1[kMaxGroups] = {};
+        Vector s2[kMaxGroups] = {};
+        for (int group = 0; group < numGroups; ++group) {
+            s1[group] = Vector::loadu(state1 + group * kWidth);
+            s2[group] = Vector::loadu(state2 + group * kWidth);
+        }
+
+        int sample = 0;
+        for (; sample + kWidth <= numSamples; sample += kWidth) {
+            Vector tile[kWidth];
+            for (int step = 0; step < kWidth; ++step) {
+                const Vector x = Vector::broadcast(in[sample + step]);
+                Vector wet = BiquadStep::tick(c[0], x, s1[0], s2[0]);
+                for (int group = 1; group < numGroups; ++group)
+                    wet = wet + BiquadStep::tick(c[group], x, s1[group], s2[group]);
+                tile[step] = wet;
+            }
+
+            // Row k now holds band lane k over the tile's samples
+            Vector::transpose(tile);
+            Vector y = Vector::loadu(in + sample);
+            for (int lane = 0; lane < kWidth; ++lane)
+                y = y + tile[lane];
+            y.storeu(out + sample);
+        }
+
+        SampleType lanes[kWidth];
+        for (; sample < numSamples; ++sample) {
+            const Vector x = Vector::broadcast(in[sample]);
+            Vector wet = BiquadStep::tick(c[0], x, s1[0], s2[0]);
+            for (int group = 1; group < numGroups; ++group)
+                wet = wet + BiquadStep::tick(c[group], x, s1[group], s2[group]);
+            wet.storeu(lanes);
+            SampleType y = in[sample];
+            for (int lane = 0; lane < kWidth; ++lane)
+                y += lanes[lane];
+            out[sample] = y;
+        }
+
+        for (int group = 0; group < numGroups; ++group) {
+            s1[group].storeu(state1 + group * kWidth);
+            s2[group].storeu(state2 + group * kWidth);
+        }
+    }
+
+    static void processSerial(const BiquadCoefficients<Vector>* c, int numGroups, int last,
+                              const SampleType* in, SampleType* out, int numSamples,
+                              SampleType* state1, SampleType* state2)
+    {
+        // The last step's output of every lane
+        Vector y[kMaxGroups] = {};
+        Vector s1[kMaxGroups] = {};
+        Vector s2[kMaxGroups] = {};
+        for (int group = 0; group < numGroups; ++group) {
+            y[group] = Vector::broadcast(SampleType(0));
+            s1[group] = Vector::loadu(state1 + group * kWidth);
+            s2[group] = Vector::loadu(state2 + group * kWidth);
+        }
+
+        const int lastGroup = last / kWidth;
+        const int lastLane = last % kWidth;
+        SampleType lanes[kWidth];
+        const int numSteps = numSamples + last;
+        for (int t = 0; t < numSteps; ++t) {
+            const Vector input = Vector::broadcast(t < numSamples ? in[t] : SampleType(0));
+
+            // From the last group down, so each group shifts in the lane
+            // below it before that lane moves on
+            if (t >= last && t < numSamples) {
+                for (int group = numGroups - 1; group >= 0; --group) {
+                    const Vector x = Vector::shiftUp(y[group], group > 0 ? y[group - 1] : input);
+                    y[group] = BiquadStep::tick(c[group], x, s1[group], s2[group]);
+                }
+            } else {
+                for (int group = numGroups - 1; group >= 0; --group) {
+                    const Vector x = Vector::shiftUp(y[group], group > 0 ? y[group - 1] : input);
+                    const Vector m = getLaneMask(t - numSamples + 1 - group * kWidth, t + 1 - group * kWidth);
+                    const Vector keep = Vector::broadcast(SampleType(1)) - m;
+                    Vector n1 = s1[group];
+                    Vector n2 = s2[group];
+                    y[group] = BiquadStep::tick(c[group], x, n1, n2);
+                    s1[group] = m * n1 + keep * s1[group];
+                    s2[group] = m * n2 + keep * s2[group];
+                }
+            }
+
+            if (t >= last) {
+                y[lastGroup].storeu(lanes);
+                out[t - last] = lanes[lastLane];
+            }
+        }
+
+        for (int group = 0; group < numGroups; ++group) {
+            s1[group].storeu(state1 + group * kWidth);
+            s2[group].storeu(state2 + group * kWidth);
+        }
+    }
+
+    // 1 in lanes first..end-1 (clamped to the vector), 0 elsewhere
+    static Vector getLaneMask(int first, int end)
+    {
+        // 16 ones, then 16 zeros: kPrefix + 16 - n starts with n ones
+        static const SampleType kPrefix[32] = {
+            1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1
+        };
+        first = first < 0 ? 0 : (first > kWidth ? kWidth : first);
+        end = end < 0 ? 0 : (end > kWidth ? kWidth : end);
+        return Vector::loadu(kPrefix + 16 - end) - Vector::loadu(kPrefix + 16 - first);
+    }
+};
+
+// Picks the narrowest vector that holds the active bands
+template <typename SampleType>
+inline void processFilterBankBlock(const FilterBankCoefficients<SampleType>& bank,
+                                   const SampleType* const* inputs, SampleType* const* outputs,
+                                   int numChannels, int numSamples, SampleType* state)
+{
+    typedef typename SimdTraits<SampleType>::Narrow Narrow;
+    typedef typename SimdTraits<SampleType>::Wide Wide;
+    typedef typename SimdTraits<SampleType>::Widest Widest;
+
+    if (bank.numActive == 0) {
+        for (int channel = 0; channel < numChannels; ++channel)
+            if (outputs[channel] != inputs[channel])
+                for (int sample = 0; sample < numSamples; ++sample)
+                    outputs[channel][sample] = inputs[channel][sample];
+        return;
+    }
+
+    if (bank.numActive <= Narrow::kWidth)
+        SimdFilterBankKernel<Narrow>::process(bank, inputs, outputs, numChannels, numSamples, state);
+    else if (bank.numActive <= Wide::kWidth)
+        SimdFilterBankKernel<Wide>::process(bank, inputs, outputs, numChannels, numSamples, state);
+    else
+        SimdFilterBankKernel<Widest>::process(bank, inputs, outputs, numChannels, numSamples, state);
+}
+
+FILTERDSP_ISA_NAMESPACE_END
+} // namespace FilterDSP
@@ -0,0 +1,69 @@
+#pragma once
+
+// Block-rate coefficients for the first-order filters.
+// Both responses are expressed as y[n] = b0·x[n] + b1·x[n-1] + a1·y[n-1]
+// so the inner loop is a handful of multiply-adds with no divisions.
+
+namespace FilterDSP {
+
+// Filter types (values match kFilterTypeId / kParam_FilterType).
+// Low and high pass follow the slope; the others are one second-order
+// section shaped by the Q and gain parameters (see BiquadDesigner.h).
+enum FilterType
+{
+    kFilterTypeLowPass = 0,
+    kFilterTypeHighPass = 1,
+    kFilterTypeBandPass = 2,
+    kFilterTypeNotch = 3,
+    kFilterTypePeak = 4,
+    kFilterTypeLowShelf = 5,
+    kFilterTypeHighShelf = 6,
+    kFilterTypeAllPass = 7,
+    kNumFilterTypes = 8
+};
+
+// Band pass and notch also have state variable and ladder forms; the bell,
+// shelves and all-pass are biquads in every recursive mode
+inline bool isBiquadOnlyType(int filterType)
+{
+    return filterType >= kFilterTypePeak;
+}
+
+// Low Pass:  α = 1 / (1 + fc/sample_rate)
+// High Pass: α = fc / (fc + sample_rate)
+template <typename SampleType>
+inline SampleType calculateAlpha(SampleType cutoffFreq, SampleType sampleRate, int filterType)
+{
+    if (filterType == kFilterTypeLowPass)
+        return SampleType(1) / (SampleType(1) + cutoffFreq / sampleRate);
+    return cutoffFreq / (cutoffFreq + sampleRate);
+}
+
+template <typename SampleType>
+struct OnePoleCoefficients
+{
+    SampleType b0;
+    SampleType b1;
+    SampleType a1;
+
+    // LPF: y[n] = (1-α)·x[n] + α·y[n-1]
+    // HPF: y[n] = α·(y[n-1] + x[n] - x[n-1])
+    static OnePoleCoefficients design(int filterType, SampleType cutoffFreq, SampleType sampleRate)
+    {
+        const SampleType alpha = calculateAlpha(cutoffFreq, sampleRate, filterType);
+
+        OnePoleCoefficients coeffs;
+        if (filterType == kFilterTypeLowPass) {
+            coeffs.b0 = SampleType(1) - alpha;
+            coeffs.b1 = SampleType(0);
+        }
+        else {
+            coeffs.b0 = alpha;
+            coeffs.b1 = -alpha;
+        }
+        coeffs.a1 = alpha;
+        return coeffs;
+    }
+};
+
+} // namespace FilterDSP
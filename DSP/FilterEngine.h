@@ -0,0 +1,899 @@
+#pragma once
+
+// Shared filter engine used by the VST3 and Audio Unit wrappers.
+// Header-only and free of any plugin SDK dependency so it can be built,
+// benchmarked and verified on its own (see DSP/CMakeLists.txt).
+
+#include "CacheAligned.h"
+#include "CoefficientCache.h"
+#include "Crossover.h"
+#include "FilterBank.h"
+#include "KernelDispatch.h"
+#include "LinearPhaseFilter.h"
+#include "Oversampler.h"
+#include "ParallelScan.h"
+#include "ParameterSmoother.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace FilterDSP {
+
+// Largest bus the engine accepts (covers 7.1.4 and 16-channel layouts)
+static const int kMaxChannels = 16;
+
+// Filter memory below this magnitude (-120 dB) counts as decayed
+static const double kSilenceThreshold = 1e-6;
+
+// Filter memory below this magnitude (-300 dB) is set to zero after every
+// block, long before it could decay into the subnormal range
+static const double kDenormalThreshold = 1e-15;
+
+// Upper bound for the reported tail, in seconds
+static const double kMaxTailTime = 10.0;
+
+// Per-channel filter memory as a structure of arrays in one contiguous
+// allocation: [lastInput | lastOutput | biquad s1/s2 per section], each
+// array numChannels long. The state variable filter uses the two rows of
+// the first biquad section, the ladder the four rows of the first two. Sized outside the audio thread
+// (setupProcessing / Initialize), in whole cache lines of its own.
+template <typename SampleType>
+class FilterState
+{
+public:
+    static const int kNumRows = 2 + 2 * kMaxBiquadSections;
+
+    FilterState() : m_numChannels(0) {}
+
+    void resize(int numChannels)
+    {
+        m_numChannels = numChannels;
+        m_memory.assign(kNumRows * static_cast<size_t>(numChannels), SampleType(0));
+    }
+
+    void clear() { std::fill(m_memory.begin(), m_memory.end(), SampleType(0)); }
+
+    // Zero every value smaller in magnitude than threshold in the first
+    // numRows rows (numChannels values each)
+    void flush(int numRows, SampleType threshold)
+    {
+        SampleType* memory = m_memory.data();
+        const int size = numRows * m_numChannels;
+        for (int i = 0; i < size; ++i)
+            memory[i] = std::fabs(memory[i]) < threshold ? SampleType(0) : memory[i];
+    }
+
+    // Largest magnitude in the filter memory
+    SampleType getPeak() const
+    {
+        SampleType peak = SampleType(0);
+        for (size_t i = 0; i < m_memory.size(); ++i)
+            peak = std::max(peak, std::fabs(m_memory[i]));
+        return peak;
+    }
+
+    int getNumChannels() const { return m_numChannels; }
+
+    // Row r, channel c at r * numChannels + c
+    SampleType* data() { return m_memory.data(); }
+
+    SampleType* lastInput() { return m_memory.data(); }
+    SampleType* lastOutput() { return m_memory.data() + m_numChannels; }
+
+    // Cascade state, stride numChannels (see BiquadKernels.h)
+    SampleType* biquadState() { return m_memory.data() + 2 * m_numChannels; }
+
+private:
+    int m_numChannels;
+    CacheAlignedVector<SampleType> m_memory;
+};
+
+// LPF/HPF with independent state for each channel of the bus: the
+// first-order filter at 6 dB/oct, biquad cascades from 12 to 48 dB/oct, or
+// the state variable filter, the saturating ladder filter, or a
+// linear-phase FIR with the same magnitude response (see
+// LinearPhaseFilter.h). Band pass, notch, bell, shelf and all-pass
+// responses are single biquad sections set by Q and gain. The graphic EQ
+// mode runs a bank of up to 31 bells instead (FilterBank.h), and the
+// crossover mode splits the input into 2 to 5 Linkwitz-Riley bands, one
+// per output (Crossover.h). The other recursive filters optionally run at
+// 2x/4x/8x the host rate (see Oversampler.h), which also keeps the
+// ladder's saturation from aliasing.
+template <typename SampleType>
+class FilterEngine
+{
+public:
+    FilterEngine()
+    : m_mode(kFilterModeStandard)
+    , m_smoothingTime(SampleType(0))
+    , m_oversampling(kOversampling1x)
+    , m_maxBlockSize(kDefaultMaxBlockSize)
+    , m_parallelEnabled(false)
+    {
+        m_cutoffSmoother.reset(m_coeffs.getCutoff());
+        prepare(2);
+    }
+
+    // Size the filter memory for the bus and the host's largest block, and
+    // clear it. Allocates, so call it from setupProcessing/setActive/
+    // Initialize, never from the audio thread. The linear-phase convolution
+    // is only allocated (and its kernel designed) in its mode, and freed
+    // otherwise; its kernel length follows the sample rate set before this
+    // call.
+    void prepare(int numChannels, int maxBlockSize = kDefaultMaxBlockSize)
+    {
+        if (numChannels < 1)
+            numChannels = 1;
+        if (numChannels > kMaxChannels)
+            numChannels = kMaxChannels;
+        m_maxBlockSize = maxBlockSize > 0 ? maxBlockSize : kDefaultMaxBlockSize;
+        m_state.resize(numChannels);
+        m_bank.prepare(numChannels);
+        m_crossover.prepare(numChannels);
+        m_oversampler.prepare(numChannels);
+        m_cutoffSmoother.reset(m_cutoffSmoother.getTarget());
+        m_coeffs.setCutoff(m_cutoffSmoother.getTarget());
+
+        if (m_mode == kFilterModeLinearPhase) {
+            const LinearPhaseDesign design = getLinearPhaseDesign();
+            m_linearPhase.prepare(numChannels, m_maxBlockSize, double(getSampleRate()), &design);
+        }
+        else {
+            m_linearPhase.plan(numChannels, m_maxBlockSize, double(getSampleRate()));
+        }
+        m_parallel.prepare(m_parallelEnabled ? numChannels : 0, m_maxBlockSize, FilterState<SampleType>::kNumRows);
+        playMode();
+    }
+
+    // Allocates the linear-phase convolution after a switch to its mode and
+    // starts playing it, for hosts that do not prepare() again when the
+    // latency changes. Never from the audio thread.
+    void prepareLinearPhase()
+    {
+        if (m_mode != kFilterModeLinearPhase || m_linearPhase.isPrepared())
+            return;
+        const LinearPhaseDesign design = getLinearPhaseDesign();
+        m_linearPhase.prepare(getNumChannels(), m_maxBlockSize, double(getSampleRate()), &design);
+        playMode();
+    }
+
+    int getNumChannels() const { return m_state.getNumChannels(); }
+
+    // Offline rendering: blocks of kMinParallelBlockSize samples or more
+    // with fixed coefficients run as parallel chunks (ParallelScan.h).
+    // Takes effect at the next prepare(), which allocates for it, and only
+    // when the largest block is long enough.
+    void setParallelProcessing(bool enabled) { m_parallelEnabled = enabled; }
+    bool isParallelProcessing() const { return m_parallel.isPrepared(); }
+
+    // Coefficients are redesigned here, never in the sample loop
+    void setSampleRate(SampleType sampleRate)
+    {
+        m_coeffs.setSampleRate(sampleRate * SampleType(getOversamplingRatio()));
+        m_bank.setSampleRate(double(m_coeffs.getSampleRate()));
+        m_crossover.setSampleRate(double(sampleRate));
+        updateRampLength();
+        requestLinearPhaseDesign();
+    }
+
+    // Oversampling factor (OversamplingFactor). The filter is redesigned
+    // for the higher rate and its memory cleared; the reported latency
+    // changes with the factor. Ignored in linear-phase and crossover mode:
+    // the factor is kept for the other modes, but the playing filter and
+    // its memory are left alone.
+    void setOversampling(int factor)
+    {
+        if (factor < kOversampling1x || factor >= kNumOversamplingFactors || factor == m_oversampling)
+            return;
+        const SampleType sampleRate = getSampleRate();
+        m_oversampling = factor;
+        m_coeffs.setSampleRate(sampleRate * SampleType(getOversamplingRatio()));
+        m_bank.setSampleRate(double(m_coeffs.getSampleRate()));
+        updateRampLength();
+        if (isLinearPhase() || isCrossover())
+            return;
+        m_state.clear();
+        m_bank.reset();
+        m_oversampler.reset();
+    }
+
+    // With smoothing enabled the cutoff ramps to the new value over the
+    // smoothing time; otherwise it changes immediately.
+    void setCutoff(SampleType cutoffFreq)
+    {
+        m_cutoffSmoother.setTarget(cutoffFreq);
+        if (!m_cutoffSmoother.isSmoothing())
+            m_coeffs.setCutoff(cutoffFreq);
+        requestLinearPhaseDesign();
+    }
+
+    // Between the cascades and the single-section types the number of
+    // sections changes, so memory is cleared as for a slope change
+    void setFilterType(int filterType)
+    {
+        if (filterType < kFilterTypeLowPass || filterType >= kNumFilterTypes)
+            return;
+        const int structure = m_coeffs.getStructure();
+        const int numSections = structure == kStructureBiquad ? m_coeffs.getBiquads().numSections : 0;
+        m_coeffs.setFilterType(filterType);
+        if (structure == kStructureBiquad && m_coeffs.getStructure() == kStructureBiquad
+            && m_coeffs.getBiquads().numSections != numSections)
+            reset();
+        resetIfStructureChanged(structure);
+        requestLinearPhaseDesign();
+    }
+
+    // Changing the slope changes the number of sections, so memory is
+    // cleared (the linear-phase kernel crossfades instead)
+    void setSlope(int slope)
+    {
+        if (slope < kSlope6dB || slope >= kNumSlopes || slope == m_coeffs.getSlope())
+            return;
+        const int structure = m_coeffs.getStructure();
+        m_coeffs.setSlope(slope);
+        if (structure == kStructureOnePole || structure == kStructureBiquad)
+            reset();
+        requestLinearPhaseDesign();
+    }
+
+    void setAlignment(int alignment)
+    {
+        m_coeffs.setAlignment(alignment);
+        requestLinearPhaseDesign();
+    }
+
+    // Linear phase plays once prepare() or prepareLinearPhase() has
+    // allocated it, with its kernel already designed; until then the
+    // previous mode keeps playing, at the latency the host still
+    // compensates. A convolution left allocated from earlier plays at once
+    // and crossfades to the new kernel.
+    void setMode(int mode)
+    {
+        if (mode < kFilterModeStandard || mode >= kNumFilterModes)
+            return;
+        m_mode = mode;
+        if (mode != kFilterModeLinearPhase || m_linearPhase.isPrepared())
+            playMode();
+    }
+
+    // Ladder resonance, 0 to 1 (self-oscillation); the other modes ignore
+    // it. Applied from the next block, without a ramp.
+    void setResonance(SampleType resonance)
+    {
+        m_coeffs.setResonance(std::max(SampleType(0), std::min(SampleType(1), resonance)));
+    }
+
+    // Q of the band, bell, shelf and all-pass sections, and the resonance
+    // of the state variable filter (kMinQ to kMaxQ). Applied from the next
+    // block, without a ramp.
+    void setQ(double q)
+    {
+        m_coeffs.setQ(std::max(kMinQ, std::min(kMaxQ, q)));
+        requestLinearPhaseDesign();
+    }
+
+    // Bell and shelf gain in dB (±kMaxGainDb), applied like setQ
+    void setGain(double gainDb)
+    {
+        m_coeffs.setGain(std::max(-kMaxGainDb, std::min(kMaxGainDb, gainDb)));
+        requestLinearPhaseDesign();
+    }
+
+    // Graphic EQ band gain in dB (±kMaxBankGainDb). Bands at 0 dB cost
+    // nothing; the bank is redesigned at the start of the next block.
+    void setBandGain(int band, double gainDb) { m_bank.setBandGain(band, gainDb); }
+
+    // Graphic EQ band count (1 to kMaxBankBands, spread over 20 Hz - 20 kHz)
+    // and BankLayout. Both move the bands, so the bank memory is cleared.
+    void setNumBands(int numBands) { m_bank.setNumBands(numBands); }
+    void setBankLayout(int layout) { m_bank.setLayout(layout); }
+
+    // Crossover band count (kMinCrossoverBands to kMaxCrossoverBands), which
+    // clears the crossover memory, and the frequency of each split in Hz,
+    // applied from the next block without a ramp
+    void setCrossoverBands(int numBands) { m_crossover.setNumBands(numBands); }
+    void setCrossoverFrequency(int split, double frequency) { m_crossover.setFrequency(split, frequency); }
+
+    // Cutoff ramp duration in seconds (0 = no smoothing)
+    void setSmoothingTime(SampleType seconds)
+    {
+        m_smoothingTime = seconds;
+        updateRampLength();
+    }
+
+    SampleType getSampleRate() const { return m_coeffs.getSampleRate() / SampleType(getOversamplingRatio()); }
+    SampleType getCutoff() const { return m_cutoffSmoother.getTarget(); }
+    int getFilterType() const { return m_coeffs.getFilterType(); }
+    int getSlope() const { return m_coeffs.getSlope(); }
+    int getAlignment() const { return m_coeffs.getAlignment(); }
+    int getMode() const { return m_mode; }
+    SampleType getResonance() const { return m_coeffs.getResonance(); }
+    double getQ() const { return m_coeffs.getQ(); }
+    double getGain() const { return m_coeffs.getGain(); }
+    double getBandGain(int band) const { return m_bank.getBandGain(band); }
+    int getNumBands() const { return m_bank.getNumBands(); }
+    int getBankLayout() const { return m_bank.getLayout(); }
+    int getCrossoverBands() const { return m_crossover.getNumBands(); }
+    double getCrossoverFrequency(int split) const { return m_crossover.getFrequency(split); }
+    int getOversampling() const { return m_oversampling; }
+    int getOversamplingRatio() const { return 1 << m_oversampling; }
+    bool isSmoothing() const { return m_cutoffSmoother.isSmoothing(); }
+    bool isLinearPhase() const { return m_coeffs.getStructure() == kStructureLinearPhase; }
+    bool isCrossover() const { return m_coeffs.getStructure() == kStructureCrossover; }
+
+    // Outputs processBlock writes: the crossover bands, or the one filter
+    // output
+    int getNumOutputs() const { return isCrossover() ? m_crossover.getNumBands() : 1; }
+
+    // True while the linear-phase convolution waits for prepare(), or its
+    // kernel is being designed or faded in
+    bool isDesignPending() const
+    {
+        return m_mode == kFilterModeLinearPhase && (!isLinearPhase() || m_linearPhase.isDesignPending());
+    }
+
+    // Clear filter memory on every channel
+    void reset()
+    {
+        m_state.clear();
+        m_bank.reset();
+        m_crossover.reset();
+        m_oversampler.reset();
+        m_linearPhase.reset();
+    }
+
+    // True once the memory of every channel is below kSilenceThreshold, i.e.
+    // silent input would produce silent output from here on
+    bool isDecayed() const
+    {
+        if (isLinearPhase())
+            return m_linearPhase.isDecayed(SampleType(kSilenceThreshold));
+        if (isCrossover())
+            return m_crossover.getPeak() < SampleType(kSilenceThreshold);
+        if (m_oversampling != kOversampling1x && m_oversampler.getPeak() >= SampleType(kSilenceThreshold))
+            return false;
+        if (m_coeffs.getStructure() == kStructureFilterBank)
+            return m_bank.getPeak() < SampleType(kSilenceThreshold);
+        return m_state.getPeak() < SampleType(kSilenceThreshold);
+    }
+
+    // Delay added by the oversampling filters or the linear-phase FIR, in
+    // samples at the host rate. The crossover runs at the host rate and
+    // adds none. Linear phase reports its latency as soon as it is
+    // selected, for the host to apply when it prepares again.
+    int getLatencySamples() const
+    {
+        if (m_mode == kFilterModeLinearPhase)
+            return m_linearPhase.getLatency();
+        if (isCrossover())
+            return 0;
+        return Oversampler<SampleType>::getLatency(m_oversampling);
+    }
+
+    // Largest latency any mode can report with the current preparation;
+    // sizes the bypass dry delay (BypassFader::prepare)
+    int getMaxLatencySamples() const
+    {
+        return std::max(m_linearPhase.getLatency(), Oversampler<SampleType>::getLatency(kOversampling8x));
+    }
+
+    // Samples until the impulse response of the current settings falls below
+    // kSilenceThreshold, from the slowest pole radius r: ln(threshold)/ln(r).
+    // Cascades get twice that: repeated or nearby poles (Q = 0.5 sections,
+    // Linkwitz-Riley) decay more slowly than a single pole. Counted at the
+    // host rate, including the oversampling latency. The linear-phase FIR
+    // ends after its latency plus the second half of the kernel.
+    int getTailSamples() const
+    {
+        if (isLinearPhase())
+            return m_linearPhase.getTailSamples();
+        if (isCrossover())
+            return getFilterTailSamples();
+        const int ratio = getOversamplingRatio();
+        return (getFilterTailSamples() + ratio - 1) / ratio + getLatencySamples();
+    }
+
+    // Single-sample path; cutoff smoothing is only applied by processBlock.
+    // When oversampled, the sample goes through the up/down sampling filters
+    // and the filter runs getOversamplingRatio() times in between.
+    SampleType processSample(SampleType input, int channel)
+    {
+        if (isLinearPhase())
+            return m_linearPhase.processSample(input, channel);
+        if (isCrossover())
+            return m_crossover.processSample(input, channel);
+        if (m_oversampling == kOversampling1x)
+            return tick(input, channel);
+
+        SampleType* high = m_oversampler.upsample(channel, &input, 1, m_oversampling);
+        for (int sample = 0; sample < getOversamplingRatio(); ++sample)
+            high[sample] = tick(high[sample], channel);
+        SampleType output;
+        m_oversampler.downsample(channel, &output, 1, m_oversampling);
+        return output;
+    }
+
+    // Process non-interleaved buffers; inputs and outputs may alias (in-place).
+    // The kernel for the current filter type is selected once per block.
+    // Channels beyond the prepared channel count are left untouched. The
+    // crossover writes its lowest band.
+    void processBlock(const SampleType* const* inputs, SampleType* const* outputs,
+                      int numChannels, int numSamples)
+    {
+        if (numChannels > m_state.getNumChannels())
+            numChannels = m_state.getNumChannels();
+
+        if (isCrossover()) {
+            processCrossover(inputs, &outputs, 1, numChannels, numSamples);
+            return;
+        }
+
+        if (isLinearPhase()) {
+            m_linearPhase.process(inputs, outputs, numChannels, numSamples);
+            return;
+        }
+
+        if (m_oversampling == kOversampling1x) {
+            processAtRate(inputs, outputs, numChannels, numSamples);
+            return;
+        }
+
+        // Every channel is upsampled before any output is written, so
+        // in-place processing is safe
+        SampleType* high[kMaxChannels];
+        for (int offset = 0; offset < numSamples; offset += kOversamplingChunk) {
+            const int chunk = std::min(kOversamplingChunk, numSamples - offset);
+            for (int channel = 0; channel < numChannels; ++channel)
+                high[channel] = m_oversampler.upsample(channel, inputs[channel] + offset, chunk, m_oversampling);
+            processAtRate(high, high, numChannels, chunk << m_oversampling);
+            for (int channel = 0; channel < numChannels; ++channel)
+                m_oversampler.downsample(channel, outputs[channel] + offset, chunk, m_oversampling);
+        }
+    }
+
+    // Several outputs, each numChannels buffers: the crossover writes band k
+    // to outputs[k], the lowest band first; the other modes write
+    // outputs[0]. Outputs past getNumOutputs() are cleared and null outputs
+    // skipped, so every output given ends up defined. All of them are
+    // produced in one pass over the input.
+    void processBlock(const SampleType* const* inputs, SampleType* const* const* outputs, int numOutputs,
+                      int numChannels, int numSamples)
+    {
+        if (numChannels > m_state.getNumChannels())
+            numChannels = m_state.getNumChannels();
+
+        if (isCrossover())
+            processCrossover(inputs, outputs, numOutputs, numChannels, numSamples);
+        else if (outputs[0])
+            processBlock(inputs, outputs[0], numChannels, numSamples);
+
+        for (int output = getNumOutputs(); output < numOutputs; ++output) {
+            if (!outputs[output])
+                continue;
+            for (int channel = 0; channel < numChannels; ++channel)
+                std::fill(outputs[output][channel], outputs[output][channel] + numSamples, SampleType(0));
+        }
+    }
+
+    // Process numSamples samples starting at startSample, e.g. one segment of
+    // a block that is split at parameter change offsets.
+    void processRange(const SampleType* const* inputs, SampleType* const* outputs,
+                      int numChannels, int startSample, int numSamples)
+    {
+        processRange(inputs, &outputs, 1, numChannels, startSample, numSamples);
+    }
+
+    void processRange(const SampleType* const* inputs, SampleType* const* const* outputs, int numOutputs,
+                      int numChannels, int startSample, int numSamples)
+    {
+        if (numChannels > m_state.getNumChannels())
+            numChannels = m_state.getNumChannels();
+        numOutputs = std::min(numOutputs, kMaxCrossoverBands);
+
+        const SampleType* in[kMaxChannels];
+        SampleType* out[kMaxCrossoverBands][kMaxChannels];
+        SampleType* const* outs[kMaxCrossoverBands];
+        for (int channel = 0; channel < numChannels; ++channel)
+            in[channel] = inputs[channel] + startSample;
+        for (int output = 0; output < numOutputs; ++output) {
+            outs[output] = outputs[output] ? out[output] : nullptr;
+            for (int channel = 0; outputs[output] && channel < numChannels; ++channel)
+                out[output][channel] = outputs[output][channel] + startSample;
+        }
+        processBlock(in, outs, numOutputs, numChannels, numSamples);
+    }
+
+private:
+    // Bands past numOutputs are computed but not stored
+    void processCrossover(const SampleType* const* inputs, SampleType* const* const* outputs, int numOutputs,
+                          int numChannels, int numSamples)
+    {
+        SampleType* const* bands[kMaxCrossoverBands];
+        for (int band = 0; band < kMaxCrossoverBands; ++band)
+            bands[band] = band < numOutputs ? outputs[band] : nullptr;
+        m_crossover.process(inputs, bands, numChannels, numSamples);
+        m_crossover.flush(SampleType(kDenormalThreshold));
+    }
+
+    // Tail at the filter's own (possibly oversampled) rate
+    int getFilterTailSamples() const
+    {
+        double radius = 0.0;
+        int multiplicity = 1;
+        switch (m_coeffs.getStructure())
+        {
+            case kStructureOnePole:
+                radius = std::fabs(double(m_coeffs.get().a1));
+                break;
+            case kStructureBiquad: {
+                const BiquadCascadeCoefficients<SampleType>& c = m_coeffs.getBiquads();
+                for (int k = 0; k < c.numSections; ++k)
+                    radius = std::max(radius, std::sqrt(std::fabs(double(c.sections[k].a2))));
+                multiplicity = 2;
+                break;
+            }
+            case kStructureStateVariable: {
+                // Pole radius² of the equivalent biquad: (1 - g·k + g²) / (1 + g·k + g²)
+                const SvfCoefficients<SampleType>& c = m_coeffs.getSvf();
+                const double g = double(c.a2) / double(c.a1);
+                radius = std::sqrt(std::fabs((1.0 - g * double(c.k) + g * g) * double(c.a1)));
+                break;
+            }
+            case kStructureLadder: {
+                // Slowest poles of the linear ladder, s = -1 + k^¼·e^(±jπ/4) at
+                // unit cutoff, mapped through the stage's bilinear transform
+                // (t = tan(w) = G/(1 - G)); at k = 4 they reach the unit circle
+                const LadderCoefficients<SampleType>& c = m_coeffs.getLadder();
+                const double t = double(c.g) / double(c.h);
+                const double sigma = 1.0 - std::sqrt(0.5) * std::pow(double(c.k), 0.25);
+                radius = sigma <= 0.0 ? 1.0 : std::exp(-2.0 * t * sigma);
+                multiplicity = 2;
+                break;
+            }
+            case kStructureFilterBank:
+                // Neighbouring bells in series have nearby poles
+                radius = m_bank.getPoleRadius();
+                multiplicity = 2;
+                break;
+            case kStructureCrossover:
+                // The LR4 low pass repeats the Butterworth poles, at the
+                // host rate
+                radius = m_crossover.getPoleRadius();
+                multiplicity = 2;
+                break;
+        }
+
+        const double rate = isCrossover() ? double(getSampleRate()) : double(m_coeffs.getSampleRate());
+        const double maxTail = kMaxTailTime * rate;
+        if (radius >= 1.0)
+            return int(maxTail);
+        if (radius <= 0.0)
+            return 1;
+        const double tail = std::ceil(multiplicity * std::log(kSilenceThreshold) / std::log(radius));
+        return int(std::min(tail, maxTail));
+    }
+
+    // One sample at the filter rate
+    SampleType tick(SampleType input, int channel)
+    {
+        switch (m_coeffs.getStructure())
+        {
+            case kStructureBiquad: {
+                const BiquadCascadeCoefficients<SampleType>& c = m_coeffs.getBiquads();
+                const int stride = m_state.getNumChannels();
+                SampleType* state = m_state.biquadState() + channel;
+                for (int k = 0; k < c.numSections; ++k)
+                    input = BiquadStep::tick(c.sections[k], input, state[2 * k * stride], state[(2 * k + 1) * stride]);
+                return input;
+            }
+            case kStructureStateVariable: {
+                SampleType* state = m_state.biquadState() + channel;
+                const SvfOutputs<SampleType> out = SvfStep::tickAll(m_coeffs.getSvf(), input, state[0], state[m_state.getNumChannels()]);
+                switch (m_coeffs.getFilterType())
+                {
+                    case kFilterTypeLowPass: return out.lowPass;
+                    case kFilterTypeHighPass: return out.highPass;
+                    case kFilterTypeBandPass: return out.bandPass;
+                    default: return out.notch;
+                }
+            }
+            case kStructureLadder: {
+                const int stride = m_state.getNumChannels();
+                SampleType* state = m_state.biquadState() + channel;
+                return LadderStep::tick(m_coeffs.getFilterType(), m_coeffs.getLadder(), input,
+                                        state[0], state[stride], state[2 * stride], state[3 * stride]);
+            }
+            case kStructureFilterBank:
+                return m_bank.processSample(input, channel);
+        }
+        if (m_coeffs.getFilterType() == kFilterTypeLowPass)
+            return OnePoleStep<kFilterTypeLowPass>::tick(m_coeffs.get(), input, m_state.lastInput()[channel], m_state.lastOutput()[channel]);
+        return OnePoleStep<kFilterTypeHighPass>::tick(m_coeffs.get(), input, m_state.lastInput()[channel], m_state.lastOutput()[channel]);
+    }
+
+    // Block processing at the filter rate
+    void processAtRate(const SampleType* const* inputs, SampleType* const* outputs,
+                       int numChannels, int numSamples)
+    {
+        // The bank has no cutoff to ramp and runs on its own memory
+        if (m_coeffs.getStructure() == kStructureFilterBank) {
+            m_bank.process(inputs, outputs, numChannels, numSamples);
+            m_bank.flush(SampleType(kDenormalThreshold));
+            return;
+        }
+
+        if (m_cutoffSmoother.isSmoothing()) {
+            // Interpolate the coefficients linearly between their values at
+            // the start and end of the ramped part of the block
+            const int numRamped = processRamp(inputs, outputs, numChannels, numSamples);
+            if (numRamped == numSamples) {
+                flushState();
+                return;
+            }
+
+            const SampleType* in[kMaxChannels];
+            SampleType* out[kMaxChannels];
+            for (int channel = 0; channel < numChannels; ++channel) {
+                in[channel] = inputs[channel] + numRamped;
+                out[channel] = outputs[channel] + numRamped;
+            }
+            processAtRate(in, out, numChannels, numSamples - numRamped);
+            return;
+        }
+
+        // Steady state: fixed coefficients, no smoothing work
+        const FilterKernelTable<SampleType>& kernels = getFilterKernels<SampleType>();
+        if (numSamples >= kMinParallelBlockSize && m_parallel.isPrepared()
+            && processParallel(kernels, inputs, outputs, numChannels, numSamples)) {
+            flushState();
+            return;
+        }
+
+        switch (m_coeffs.getStructure())
+        {
+            case kStructureOnePole:
+                kernels.onePoleBlock(m_coeffs.getFilterType(), m_coeffs.get(), inputs, outputs,
+                                     numChannels, numSamples, m_state.lastInput(), m_state.lastOutput());
+                break;
+            case kStructureBiquad:
+                kernels.biquadBlock(m_coeffs.getBiquads(), inputs, outputs,
+                                    numChannels, numSamples, m_state.biquadState(), m_state.getNumChannels());
+                break;
+            case kStructureStateVariable:
+                kernels.svfBlock(m_coeffs.getFilterType(), false, &m_coeffs.getSvf(), inputs, outputs,
+                                 numChannels, numSamples, m_state.biquadState(), m_state.getNumChannels());
+                break;
+            case kStructureLadder:
+                kernels.ladderBlock(m_coeffs.getFilterType(), false, &m_coeffs.getLadder(), inputs, outputs,
+                                    numChannels, numSamples, m_state.biquadState(), m_state.getNumChannels());
+                break;
+        }
+
+        flushState();
+    }
+
+    // The steady-state kernel over parallel chunks; false if the block ran
+    // nowhere (the workers are busy with another filter, or the filter is
+    // the ladder, whose saturation makes it nonlinear)
+    bool processParallel(const FilterKernelTable<SampleType>& kernels, const SampleType* const* inputs,
+                         SampleType* const* outputs, int numChannels, int numSamples)
+    {
+        const int filterType = m_coeffs.getFilterType();
+        const int structure = m_coeffs.getStructure();
+        if (structure == kStructureLadder)
+            return false;
+        const int variant = structure * kNumFilterTypes + filterType;
+        SampleType* memory = m_state.data();
+        const int stride = m_state.getNumChannels();
+
+        if (structure == kStructureOnePole) {
+            const OnePoleCoefficients<SampleType>& c = m_coeffs.get();
+            const auto run = [&](const SampleType* const* in, SampleType* const* out, int channels, int samples,
+                                 SampleType* rows, int rowStride) {
+                kernels.onePoleBlock(filterType, c, in, out, channels, samples, rows, rows + rowStride);
+            };
+            return m_parallel.process(run, variant, &c, sizeof(c), 0, 2, inputs, outputs, numChannels, numSamples,
+                                      memory, stride);
+        }
+        if (structure == kStructureBiquad) {
+            const BiquadCascadeCoefficients<SampleType>& c = m_coeffs.getBiquads();
+            const auto run = [&](const SampleType* const* in, SampleType* const* out, int channels, int samples,
+                                 SampleType* rows, int rowStride) {
+                kernels.biquadBlock(c, in, out, channels, samples, rows + 2 * rowStride, rowStride);
+            };
+            return m_parallel.process(run, variant, &c, sizeof(c), 2, 2 * c.numSections, inputs, outputs,
+                                      numChannels, numSamples, memory, stride);
+        }
+        const SvfCoefficients<SampleType>& c = m_coeffs.getSvf();
+        const auto run = [&](const SampleType* const* in, SampleType* const* out, int channels, int samples,
+                             SampleType* rows, int rowStride) {
+            kernels.svfBlock(filterType, false, &c, in, out, channels, samples, rows + 2 * rowStride, rowStride);
+        };
+        return m_parallel.process(run, variant, &c, sizeof(c), 2, 2, inputs, outputs, numChannels, numSamples,
+                                  memory, stride);
+    }
+
+    // Runs the ramped part of a block and returns its length
+    int processRamp(const SampleType* const* inputs, SampleType* const* outputs,
+                    int numChannels, int numSamples)
+    {
+        if (m_coeffs.getStructure() == kStructureStateVariable || m_coeffs.getStructure() == kStructureLadder)
+            return processWarpedRamp(inputs, outputs, numChannels, numSamples);
+
+        if (m_coeffs.getStructure() == kStructureBiquad) {
+            const BiquadCascadeCoefficients<SampleType> start = m_coeffs.getBiquads();
+            const int numRamped = m_cutoffSmoother.advance(numSamples);
+            m_coeffs.setCutoff(m_cutoffSmoother.getCurrent());
+
+            const BiquadCascadeCoefficients<SampleType>& end = m_coeffs.getBiquads();
+            const SampleType scale = SampleType(1) / SampleType(numRamped);
+            BiquadCascadeCoefficients<SampleType> delta;
+            delta.numSections = start.numSections;
+            for (int k = 0; k < start.numSections; ++k) {
+                delta.sections[k].b0 = (end.sections[k].b0 - start.sections[k].b0) * scale;
+                delta.sections[k].b1 = (end.sections[k].b1 - start.sections[k].b1) * scale;
+                delta.sections[k].b2 = (end.sections[k].b2 - start.sections[k].b2) * scale;
+                delta.sections[k].a1 = (end.sections[k].a1 - start.sections[k].a1) * scale;
+                delta.sections[k].a2 = (end.sections[k].a2 - start.sections[k].a2) * scale;
+            }
+
+            getFilterKernels<SampleType>().biquadRamp(start, delta, inputs, outputs, numChannels, numRamped,
+                                                      m_state.biquadState(), m_state.getNumChannels());
+            return numRamped;
+        }
+
+        const OnePoleCoefficients<SampleType> start = m_coeffs.get();
+        const int numRamped = m_cutoffSmoother.advance(numSamples);
+        m_coeffs.setCutoff(m_cutoffSmoother.getCurrent());
+
+        const OnePoleCoefficients<SampleType>& end = m_coeffs.get();
+        const SampleType scale = SampleType(1) / SampleType(numRamped);
+        OnePoleCoefficients<SampleType> delta;
+        delta.b0 = (end.b0 - start.b0) * scale;
+        delta.b1 = (end.b1 - start.b1) * scale;
+        delta.a1 = (end.a1 - start.a1) * scale;
+
+        getFilterKernels<SampleType>().onePoleRamp(m_coeffs.getFilterType(), start, delta, inputs, outputs,
+                                                   numChannels, numRamped, m_state.lastInput(), m_state.lastOutput());
+        return numRamped;
+    }
+
+    // The state variable and ladder filters are retuned every sample: the
+    // warped cutoff moves linearly and each sample gets its own coefficient
+    // set, designed kSvfRampChunk samples at a time.
+    int processWarpedRamp(const SampleType* const* inputs, SampleType* const* outputs,
+                          int numChannels, int numSamples)
+    {
+        const SampleType sampleRate = m_coeffs.getSampleRate();
+        const SampleType maxCutoff = SampleType(kMaxCutoffRatio) * sampleRate;
+        const SampleType warp = SampleType(3.14159265358979323846) / sampleRate;
+
+        const SampleType start = warp * std::min(m_cutoffSmoother.getCurrent(), maxCutoff);
+        const int numRamped = m_cutoffSmoother.advance(numSamples);
+        m_coeffs.setCutoff(m_cutoffSmoother.getCurrent());
+        const SampleType end = warp * std::min(m_cutoffSmoother.getCurrent(), maxCutoff);
+        const SampleType step = (end - start) / SampleType(numRamped);
+
+        const FilterKernelTable<SampleType>& kernels = getFilterKernels<SampleType>();
+        const bool ladder = m_coeffs.getStructure() == kStructureLadder;
+        const SampleType resonance = m_coeffs.getResonance();
+        const SampleType damping = SampleType(1.0 / m_coeffs.getQ());
+        const SampleType* in[kMaxChannels];
+        SampleType* out[kMaxChannels];
+        for (int offset = 0; offset < numRamped; offset += kSvfRampChunk) {
+            const int chunk = std::min(kSvfRampChunk, numRamped - offset);
+            for (int channel = 0; channel < numChannels; ++channel) {
+                in[channel] = inputs[channel] + offset;
+                out[channel] = outputs[channel] + offset;
+            }
+            if (ladder) {
+                for (int sample = 0; sample < chunk; ++sample)
+                    m_ladderRamp[sample] = LadderCoefficients<SampleType>::designWarped(start + step * SampleType(offset + sample + 1), resonance);
+                kernels.ladderBlock(m_coeffs.getFilterType(), true, m_ladderRamp, in, out,
+                                    numChannels, chunk, m_state.biquadState(), m_state.getNumChannels());
+                continue;
+            }
+            for (int sample = 0; sample < chunk; ++sample)
+                m_svfRamp[sample] = SvfCoefficients<SampleType>::designWarped(start + step * SampleType(offset + sample + 1), damping);
+            kernels.svfBlock(m_coeffs.getFilterType(), true, m_svfRamp, in, out,
+                             numChannels, chunk, m_state.biquadState(), m_state.getNumChannels());
+        }
+        return numRamped;
+    }
+
+    // Decaying memory must not reach the subnormal range (see DenormalGuard.h).
+    // Only the rows of the active structure are scanned.
+    void flushState()
+    {
+        int numRows = 2;
+        if (m_coeffs.getStructure() == kStructureBiquad)
+            numRows = 2 + 2 * m_coeffs.getBiquads().numSections;
+        else if (m_coeffs.getStructure() == kStructureStateVariable)
+            numRows = 4;
+        else if (m_coeffs.getStructure() == kStructureLadder)
+            numRows = 6;
+        m_state.flush(numRows, SampleType(kDenormalThreshold));
+    }
+
+    LinearPhaseDesign getLinearPhaseDesign() const
+    {
+        LinearPhaseDesign design;
+        design.filterType = m_coeffs.getFilterType();
+        design.slope = m_coeffs.getSlope();
+        design.alignment = m_coeffs.getAlignment();
+        design.q = m_coeffs.getQ();
+        design.gainDb = m_coeffs.getGain();
+        design.cutoffFreq = double(m_cutoffSmoother.getTarget());
+        design.sampleRate = double(getSampleRate());
+        return design;
+    }
+
+    // Lock-free; the kernel follows in the background
+    void requestLinearPhaseDesign()
+    {
+        if (isLinearPhase())
+            m_linearPhase.requestDesign(getLinearPhaseDesign());
+    }
+
+    // Plays the selected mode
+    void playMode()
+    {
+        const int structure = m_coeffs.getStructure();
+        m_coeffs.setMode(m_mode);
+        resetIfStructureChanged(structure);
+        requestLinearPhaseDesign();
+    }
+
+    void resetIfStructureChanged(int previousStructure)
+    {
+        if (m_coeffs.getStructure() != previousStructure)
+            reset();
+    }
+
+    void updateRampLength()
+    {
+        m_cutoffSmoother.setRampLength(static_cast<int>(m_smoothingTime * m_coeffs.getSampleRate()));
+        if (!m_cutoffSmoother.isSmoothing())
+            m_coeffs.setCutoff(m_cutoffSmoother.getTarget());
+    }
+
+    // Filter parameters and cached coefficients
+    FilterCoefficientCache<SampleType> m_coeffs;
+
+    // Selected FilterMode; the coefficient cache holds the one playing
+    int m_mode;
+
+    // Cutoff smoothing (the coefficient cache follows the smoothed value)
+    LinearSmoother<SampleType> m_cutoffSmoother;
+    SampleType m_smoothingTime;
+
+    // Per-sample state variable and ladder filter coefficients of a ramp
+    static const int kSvfRampChunk = 64;
+    SvfCoefficients<SampleType> m_svfRamp[kSvfRampChunk];
+    LadderCoefficients<SampleType> m_ladderRamp[kSvfRampChunk];
+
+    // Filter memory (lastInput is only used by the one-pole HPF)
+    FilterState<SampleType> m_state;
+
+    // Band gains, design and memory of kFilterModeGraphicEq
+    FilterBank<SampleType> m_bank;
+
+    // Band count, splits and memory of kFilterModeCrossover
+    Crossover<SampleType> m_crossover;
+
+    // Up/down sampling around the filter (OversamplingFactor)
+    int m_oversampling;
+    Oversampler<SampleType> m_oversampler;
+
+    // FIR convolution for kFilterModeLinearPhase, partitioned for the
+    // host's largest block
+    int m_maxBlockSize;
+    LinearPhaseFilter<SampleType> m_linearPhase;
+
+    // Chunked steady-state processing for offline rendering
+    bool m_parallelEnabled;
+    ParallelScan<SampleType> m_parallel;
+};
+
+} // namespace FilterDSP
@@ -0,0 +1,219 @@
+#pragma once
+
+// Block kernels for the first-order filters.
+// Each kernel is specialized on the filter type and channel count so the
+// sample loop has no type branch. Filter memory is loaded into
+// locals at the start of the block and written back once at the end.
+
+#include "FilterCoefficients.h"
+#include "SimdOps.h"
+
+namespace FilterDSP {
+FILTERDSP_ISA_NAMESPACE_BEGIN
+
+template <int Type>
+struct OnePoleStep;
+
+template <>
+struct OnePoleStep<kFilterTypeLowPass>
+{
+    // y[n] = b0·x[n] + a1·y[n-1]
+    template <typename SampleType>
+    static SampleType tick(const OnePoleCoefficients<SampleType>& c, SampleType x, SampleType& x1, SampleType& y1)
+    {
+        (void)x1;
+        y1 = c.b0 * x + c.a1 * y1;
+        return y1;
+    }
+};
+
+template <>
+struct OnePoleStep<kFilterTypeHighPass>
+{
+    // y[n] = b0·x[n] + b1·x[n-1] + a1·y[n-1]
+    template <typename SampleType>
+    static SampleType tick(const OnePoleCoefficients<SampleType>& c, SampleType x, SampleType& x1, SampleType& y1)
+    {
+        y1 = c.b0 * x + c.b1 * x1 + c.a1 * y1;
+        x1 = x;
+        return y1;
+    }
+};
+
+// c += delta, for scalar and vector coefficient sets
+template <typename T>
+inline void advanceCoefficients(OnePoleCoefficients<T>& c, const OnePoleCoefficients<T>& delta)
+{
+    c.b0 = c.b0 + delta.b0;
+    c.b1 = c.b1 + delta.b1;
+    c.a1 = c.a1 + delta.a1;
+}
+
+template <int Type, bool Ramped, int NumChannels, typename SampleType>
+struct OnePoleKernel
+{
+    // Fixed channel count: all channels advance together each sample so their
+    // independent recurrences overlap in the pipeline.
+    static void process(const OnePoleCoefficients<SampleType>& c, const OnePoleCoefficients<SampleType>& delta,
+                        const SampleType* const* inputs, SampleType* const* outputs,
+                        int numChannels, int numSamples,
+                        SampleType* lastInput, SampleType* lastOutput)
+    {
+        (void)numChannels;
+        OnePoleCoefficients<SampleType> coeffs = c;
+        const SampleType* in[NumChannels];
+        SampleType* out[NumChannels];
+        SampleType x1[NumChannels];
+        SampleType y1[NumChannels];
+        for (int channel = 0; channel < NumChannels; ++channel) {
+            in[channel] = inputs[channel];
+            out[channel] = outputs[channel];
+            x1[channel] = lastInput[channel];
+            y1[channel] = lastOutput[channel];
+        }
+
+        for (int sample = 0; sample < numSamples; ++sample) {
+            for (int channel = 0; channel < NumChannels; ++channel)
+                out[channel][sample] = OnePoleStep<Type>::tick(coeffs, in[channel][sample], x1[channel], y1[channel]);
+            if (Ramped)
+                advanceCoefficients(coeffs, delta);
+        }
+
+        for (int channel = 0; channel < NumChannels; ++channel) {
+            lastInput[channel] = x1[channel];
+            lastOutput[channel] = y1[channel];
+        }
+    }
+};
+
+template <int Type, bool Ramped, typename Vector>
+struct SimdOnePoleKernel
+{
+    typedef typename Vector::Scalar SampleType;
+    static const int kWidth = Vector::kWidth;
+
+    // Channels are processed in groups of kWidth lanes. Lanes past the last
+    // channel re-read channel 0 of the group and their results are dropped.
+    static void process(const OnePoleCoefficients<SampleType>& c, const OnePoleCoefficients<SampleType>& delta,
+                        const SampleType* const* inputs, SampleType* const* outputs,
+                        int numChannels, int numSamples,
+                        SampleType* lastInput, SampleType* lastOutput)
+    {
+        OnePoleCoefficients<Vector> steps;
+        steps.b0 = Vector::broadcast(delta.b0);
+        steps.b1 = Vector::broadcast(delta.b1);
+        steps.a1 = Vector::broadcast(delta.a1);
+
+        for (int first = 0; first < numChannels; first += kWidth) {
+            OnePoleCoefficients<Vector> coeffs;
+            coeffs.b0 = Vector::broadcast(c.b0);
+            coeffs.b1 = Vector::broadcast(c.b1);
+            coeffs.a1 = Vector::broadcast(c.a1);
+
+            const int active = numChannels - first < kWidth ? numChannels - first : kWidth;
+
+            const SampleType* in[kWidth];
+            SampleType* out[kWidth];
+            SampleType lanes[kWidth];
+            for (int lane = 0; lane < kWidth; ++lane)
+                in[lane] = inputs[first + (lane < active ? lane : 0)];
+            for (int lane = 0; lane < active; ++lane)
+                out[lane] = outputs[first + lane];
+
+            for (int lane = 0; lane < kWidth; ++lane)
+                lanes[lane] = lane < active ? lastInput[first + lane] : SampleType(0);
+            Vector x1 = Vector::loadu(lanes);
+            for (int lane = 0; lane < kWidth; ++lane)
+                lanes[lane] = lane < active ? lastOutput[first + lane] : SampleType(0);
+            Vector y1 = Vector::loadu(lanes);
+
+            int sample = 0;
+            for (; sample + kWidth <= numSamples; sample += kWidth) {
+                // rows = channels -> rows = time steps
+                Vector tile[kWidth];
+                for (int lane = 0; lane < kWidth; ++lane)
+                    tile[lane] = Vector::loadu(in[lane] + sample);
+                Vector::transpose(tile);
+
+                for (int step = 0; step < kWidth; ++step) {
+                    tile[step] = OnePoleStep<Type>::tick(coeffs, tile[step], x1, y1);
+                    if (Ramped)
+                        advanceCoefficients(coeffs, steps);
+                }
+
+                Vector::transpose(tile);
+                for (int lane = 0; lane < active; ++lane)
+                    tile[lane].storeu(out[lane] + sample);
+            }
+
+            // Remaining samples, one time step at a time
+            for (; sample < numSamples; ++sample) {
+                for (int lane = 0; lane < kWidth; ++lane)
+                    lanes[lane] = in[lane][sample];
+                OnePoleStep<Type>::tick(coeffs, Vector::loadu(lanes), x1, y1).storeu(lanes);
+                for (int lane = 0; lane < active; ++lane)
+                    out[lane][sample] = lanes[lane];
+                if (Ramped)
+                    advanceCoefficients(coeffs, steps);
+            }
+
+            x1.storeu(lanes);
+            for (int lane = 0; lane < active; ++lane)
+                lastInput[first + lane] = lanes[lane];
+            y1.storeu(lanes);
+            for (int lane = 0; lane < active; ++lane)
+                lastOutput[first + lane] = lanes[lane];
+        }
+    }
+};
+
+// Picks the kernel for the block once; called outside the sample loop
+template <int Type, bool Ramped, typename SampleType>
+inline void processOnePoleBlock(const OnePoleCoefficients<SampleType>& c, const OnePoleCoefficients<SampleType>& delta,
+                                const SampleType* const* inputs, SampleType* const* outputs,
+                                int numChannels, int numSamples,
+                                SampleType* lastInput, SampleType* lastOutput)
+{
+    typedef typename SimdTraits<SampleType>::Narrow Narrow;
+    typedef typename SimdTraits<SampleType>::Wide Wide;
+    typedef typename SimdTraits<SampleType>::Widest Widest;
+
+    if (numChannels == 1)
+        OnePoleKernel<Type, Ramped, 1, SampleType>::process(c, delta, inputs, outputs, numChannels, numSamples, lastInput, lastOutput);
+    else if (numChannels <= Narrow::kWidth)
+        SimdOnePoleKernel<Type, Ramped, Narrow>::process(c, delta, inputs, outputs, numChannels, numSamples, lastInput, lastOutput);
+    else if (numChannels <= Wide::kWidth)
+        SimdOnePoleKernel<Type, Ramped, Wide>::process(c, delta, inputs, outputs, numChannels, numSamples, lastInput, lastOutput);
+    else
+        SimdOnePoleKernel<Type, Ramped, Widest>::process(c, delta, inputs, outputs, numChannels, numSamples, lastInput, lastOutput);
+}
+
+// Fixed coefficients for the whole block
+template <typename SampleType>
+inline void processOnePoleBlock(int filterType, const OnePoleCoefficients<SampleType>& c,
+                                const SampleType* const* inputs, SampleType* const* outputs,
+                                int numChannels, int numSamples,
+                                SampleType* lastInput, SampleType* lastOutput)
+{
+    if (filterType == kFilterTypeLowPass)
+        processOnePoleBlock<kFilterTypeLowPass, false>(c, c, inputs, outputs, numChannels, numSamples, lastInput, lastOutput);
+    else
+        processOnePoleBlock<kFilterTypeHighPass, false>(c, c, inputs, outputs, numChannels, numSamples, lastInput, lastOutput);
+}
+
+// Coefficients start at c and move by delta after every sample
+template <typename SampleType>
+inline void processOnePoleRamp(int filterType, const OnePoleCoefficients<SampleType>& c,
+                               const OnePoleCoefficients<SampleType>& delta,
+                               const SampleType* const* inputs, SampleType* const* outputs,
+                               int numChannels, int numSamples,
+                               SampleType* lastInput, SampleType* lastOutput)
+{
+    if (filterType == kFilterTypeLowPass)
+        processOnePoleBlock<kFilterTypeLowPass, true>(c, delta, inputs, outputs, numChannels, numSamples, lastInput, lastOutput);
+    else
+        processOnePoleBlock<kFilterTypeHighPass, true>(c, delta, inputs, outputs, numChannels, numSamples, lastInput, lastOutput);
+}
+
+FILTERDSP_ISA_NAMESPACE_END
+} // namespace FilterDSP
@@ -0,0 +1,147 @@
+#pragma once
+
+// Filter kernel table and its runtime instruction-set dispatch.
+//
+// FilterEngine calls the block kernels through a FilterKernelTable. In the
+// header-only build that is the table of the kernels compiled into the
+// including file, so the instruction set follows its compile flags.
+//
+// Targets linking FilterDSPDispatch (FILTERDSP_RUNTIME_DISPATCH) get the
+// kernels compiled once per instruction set instead, from
+// dispatch/KernelVariant.cpp with each variant's target flags:
+//   x86/x64 - SSE2, AVX2 (with FMA), AVX-512
+//   ARM64   - NEON
+// selectKernelIsa() picks the best variant this CPU runs (cpuid, and the
+// register state the OS saves) once, at plugin initialization. The
+// FILTERDSP_KERNELS environment variable ("sse2", "avx2", "avx512",
+// "neon") overrides the choice for testing; a variant the CPU cannot run
+// is ignored. All variants share the state layout, so the variant may
+// also change between blocks (setKernelIsa, for tests and benchmarks).
+
+#include "BiquadKernels.h"
+#include "CrossoverKernels.h"
+#include "FilterBankKernels.h"
+#include "FilterKernels.h"
+#include "LadderKernels.h"
+#include "SvfKernels.h"
+
+namespace FilterDSP {
+
+template <typename SampleType>
+struct FilterKernelTable
+{
+    // processOnePoleBlock, processOnePoleRamp
+    void (*onePoleBlock)(int filterType, const OnePoleCoefficients<SampleType>& c,
+                         const SampleType* const* inputs, SampleType* const* outputs,
+                         int numChannels, int numSamples,
+                         SampleType* lastInput, SampleType* lastOutput);
+    void (*onePoleRamp)(int filterType, const OnePoleCoefficients<SampleType>& c,
+                        const OnePoleCoefficients<SampleType>& delta,
+                        const SampleType* const* inputs, SampleType* const* outputs,
+                        int numChannels, int numSamples,
+                        SampleType* lastInput, SampleType* lastOutput);
+
+    // processBiquadBlock, processBiquadRamp
+    void (*biquadBlock)(const BiquadCascadeCoefficients<SampleType>& c,
+                        const SampleType* const* inputs, SampleType* const* outputs,
+                        int numChannels, int numSamples,
+                        SampleType* state, int stateStride);
+    void (*biquadRamp)(const BiquadCascadeCoefficients<SampleType>& c,
+                       const BiquadCascadeCoefficients<SampleType>& delta,
+                       const SampleType* const* inputs, SampleType* const* outputs,
+                       int numChannels, int numSamples,
+                       SampleType* state, int stateStride);
+
+    // processSvfBlock
+    void (*svfBlock)(int filterType, bool perSample, const SvfCoefficients<SampleType>* coeffs,
+                     const SampleType* const* inputs, SampleType* const* outputs,
+                     int numChannels, int numSamples,
+                     SampleType* state, int stateStride);
+
+    // processLadderBlock
+    void (*ladderBlock)(int filterType, bool perSample, const LadderCoefficients<SampleType>* coeffs,
+                        const SampleType* const* inputs, SampleType* const* outputs,
+                        int numChannels, int numSamples,
+                        SampleType* state, int stateStride);
+
+    // processFilterBankBlock
+    void (*bankBlock)(const FilterBankCoefficients<SampleType>& bank,
+                      const SampleType* const* inputs, SampleType* const* outputs,
+                      int numChannels, int numSamples, SampleType* state);
+
+    // processCrossoverBlock
+    void (*crossoverBlock)(const CrossoverCoefficients<SampleType>& coeffs,
+                           const SampleType* const* inputs, SampleType* const* const* bandOutputs,
+                           int numChannels, int numSamples,
+                           SampleType* state, int stateStride);
+};
+
+FILTERDSP_ISA_NAMESPACE_BEGIN
+
+// The kernels compiled into this file
+template <typename SampleType>
+constexpr FilterKernelTable<SampleType> makeFilterKernelTable()
+{
+    return {
+        &processOnePoleBlock<SampleType>,
+        &processOnePoleRamp<SampleType>,
+        &processBiquadBlock<SampleType>,
+        &processBiquadRamp<SampleType>,
+        &processSvfBlock<SampleType>,
+        &processLadderBlock<SampleType>,
+        &processFilterBankBlock<SampleType>,
+        &processCrossoverBlock<SampleType>
+    };
+}
+
+#if !defined(FILTERDSP_RUNTIME_DISPATCH)
+template <typename SampleType>
+inline constexpr FilterKernelTable<SampleType> kInlineFilterKernels = makeFilterKernelTable<SampleType>();
+
+template <typename SampleType>
+inline const FilterKernelTable<SampleType>& getFilterKernels()
+{
+    return kInlineFilterKernels<SampleType>;
+}
+#endif
+
+FILTERDSP_ISA_NAMESPACE_END
+
+#if defined(FILTERDSP_RUNTIME_DISPATCH)
+enum KernelIsa
+{
+    kKernelIsaSse2 = 0,
+    kKernelIsaAvx2,
+    kKernelIsaAvx512,
+    kKernelIsaNeon,
+    kNumKernelIsas
+};
+
+// Lower-case name, as given to FILTERDSP_KERNELS
+const char* getKernelIsaName(int isa);
+
+// True when the variant is compiled in and this CPU runs it
+bool isKernelIsaAvailable(int isa);
+
+// Picks the variant on the first call; later calls return the same one
+int selectKernelIsa();
+
+// The variant in use (selected first if nothing has been yet)
+int getKernelIsa();
+
+// Every engine uses the variant from its next block. False (and no
+// change) when the variant is not available.
+bool setKernelIsa(int isa);
+
+// The kernels of the variant in use; cheap enough to call per block
+template <typename SampleType>
+const FilterKernelTable<SampleType>& getFilterKernels();
+
+template <>
+const FilterKernelTable<float>& getFilterKernels<float>();
+
+template <>
+const FilterKernelTable<double>& getFilterKernels<double>();
+#endif
+
+} // namespace FilterDSP
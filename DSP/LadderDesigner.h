@@ -0,0 +1,66 @@
+#pragma once
+
+// Coefficients of the four-pole transistor ladder (Moog-style) filter:
+// four identical zero-delay-feedback one-pole stages in series, with the
+// last stage fed back to the input through a saturator. The linear part of
+// the loop is solved exactly each sample; the saturation (a rational tanh,
+// see LadderKernels.h) is applied to the solved input of the first stage,
+// so the filter cannot blow up at any resonance.
+//
+// Resonance 0..1 sets the feedback gain k = 4·resonance; the linear filter
+// self-oscillates at k = 4. The input is scaled by 1 + k so the pass band
+// keeps its level as the resonance rises, which also drives the saturator
+// harder, as on the analog filter.
+
+#include "BiquadDesigner.h"
+#include "SvfDesigner.h"
+
+namespace FilterDSP {
+
+// Feedback gain at resonance 1 (self-oscillation)
+static const double kLadderMaxFeedback = 4.0;
+
+template <typename SampleType>
+struct LadderCoefficients
+{
+    SampleType g;       // stage gain G = tan(w) / (1 + tan(w))
+    SampleType h;       // 1 - G, the share of each stage's memory
+    SampleType k;       // feedback gain
+    SampleType gain;    // input gain, 1 + k
+    SampleType a;       // 1 / (1 + k·G⁴), solves the feedback loop
+
+    // Block-rate design; tan() comes from the cutoff tables
+    static LadderCoefficients design(SampleType cutoffFreq, SampleType sampleRate, SampleType resonance)
+    {
+        const double maxCutoff = kMaxCutoffRatio * double(sampleRate);
+        const double fc = double(cutoffFreq) < maxCutoff ? double(cutoffFreq) : maxCutoff;
+        const CutoffSineCosine half = halfWarpedCutoff(fc, double(sampleRate));
+        return fromStageGain(half.sine / (half.sine + half.cosine), resonance);
+    }
+
+    // From w = π·fc/sample_rate (at most kMaxCutoffRatio·π); used per
+    // sample by the cutoff ramps, like SvfCoefficients::designWarped
+    static LadderCoefficients designWarped(SampleType w, SampleType resonance)
+    {
+        const SampleType t = fastTan(w);
+        return fromStageGain(t / (SampleType(1) + t), resonance);
+    }
+
+    template <typename T>
+    static LadderCoefficients fromStageGain(T stageGain, SampleType resonance)
+    {
+        const SampleType r = resonance < SampleType(0) ? SampleType(0) : (resonance > SampleType(1) ? SampleType(1) : resonance);
+        const SampleType g = SampleType(stageGain);
+        const SampleType g2 = g * g;
+
+        LadderCoefficients c;
+        c.g = g;
+        c.h = SampleType(1) - g;
+        c.k = SampleType(kLadderMaxFeedback) * r;
+        c.gain = SampleType(1) + c.k;
+        c.a = SampleType(1) / (SampleType(1) + c.k * g2 * g2);
+        return c;
+    }
+};
+
+} // namespace FilterDSP
@@ -0,0 +1,234 @@
+#pragma once
+
+// Block kernels for the four-pole ladder filter (LadderDesigner.h). The
+// four stage outputs are mixed into the low pass (24 dB/oct), high pass
+// (24 dB/oct), band pass (12 dB/oct each side) and notch responses; the
+// kernels are specialized on the response so the unused mixes compile
+// away.
+//
+// Like the other kernels, one channel occupies one SIMD lane, and the
+// saturator is vectorized with it: fastTanh is a rational function
+// (multiplies, one divide and a clamp), so all channels saturate in the
+// same few instructions. The coefficients are either fixed for the block
+// or given for every sample (PerSample), for cutoff ramps.
+//
+// State is four rows of numChannels values, one per stage.
+
+#include "LadderDesigner.h"
+#include "SimdOps.h"
+
+namespace FilterDSP {
+FILTERDSP_ISA_NAMESPACE_BEGIN
+
+// tanh(x) as x·(27 + x²)/(27 + 9·x²) on [-3, 3], clamped to ±1 outside.
+// Within 0.024 (2.6%) of tanh, worst near x = 1.57; odd, monotonic, and
+// flat where it meets the clamp (its derivative is 0 at ±3), so the
+// saturation has no corner. Works on scalars and on every vector in
+// SimdOps.h.
+template <typename T>
+inline T fastTanh(T x)
+{
+    x = vmin(vmax(x, splat<T>(-3.0)), splat<T>(3.0));
+    const T x2 = x * x;
+    return x * (splat<T>(27.0) + x2) / (splat<T>(27.0) + splat<T>(9.0) * x2);
+}
+
+template <typename Vector>
+inline LadderCoefficients<Vector> broadcastCoefficients(const LadderCoefficients<typename Vector::Scalar>& c)
+{
+    LadderCoefficients<Vector> v;
+    v.g = Vector::broadcast(c.g);
+    v.h = Vector::broadcast(c.h);
+    v.k = Vector::broadcast(c.k);
+    v.gain = Vector::broadcast(c.gain);
+    v.a = Vector::broadcast(c.a);
+    return v;
+}
+
+struct LadderStep
+{
+    // One zero-delay-feedback one-pole stage: v = G·(x - s), y = v + s,
+    // s = y + v
+    template <typename T>
+    static T stage(const T& g, T x, T& s)
+    {
+        const T v = g * (x - s);
+        const T y = v + s;
+        s = y + v;
+        return y;
+    }
+
+    // The stage memories' share of the last output, (1 - G)·Σ G^(3-i)·s_i,
+    // sets the feedback; the low pass gets the input gain that keeps its
+    // pass band level
+    template <int Type, typename T>
+    static T tick(const LadderCoefficients<T>& c, T x, T& s1, T& s2, T& s3, T& s4)
+    {
+        const T memory = c.h * (((s1 * c.g + s2) * c.g + s3) * c.g + s4);
+        const T input = Type == kFilterTypeLowPass ? c.gain * x : x;
+        const T u = fastTanh((input - c.k * memory) * c.a);
+
+        const T y1 = stage(c.g, u, s1);
+        const T y2 = stage(c.g, y1, s2);
+        const T y3 = stage(c.g, y2, s3);
+        const T y4 = stage(c.g, y3, s4);
+        switch (Type)
+        {
+            case kFilterTypeLowPass: return y4;
+            case kFilterTypeHighPass: return u - splat<T>(4.0) * (y1 + y3) + splat<T>(6.0) * y2 + y4;
+            case kFilterTypeBandPass: return splat<T>(4.0) * (y2 + y4) - splat<T>(8.0) * y3;
+            default: return u + splat<T>(2.0) * (y2 - y1);
+        }
+    }
+
+    // Response picked at run time, for the single-sample path
+    template <typename T>
+    static T tick(int filterType, const LadderCoefficients<T>& c, T x, T& s1, T& s2, T& s3, T& s4)
+    {
+        switch (filterType)
+        {
+            case kFilterTypeLowPass: return tick<kFilterTypeLowPass>(c, x, s1, s2, s3, s4);
+            case kFilterTypeHighPass: return tick<kFilterTypeHighPass>(c, x, s1, s2, s3, s4);
+            case kFilterTypeBandPass: return tick<kFilterTypeBandPass>(c, x, s1, s2, s3, s4);
+            default: return tick<kFilterTypeNotch>(c, x, s1, s2, s3, s4);
+        }
+    }
+};
+
+template <int Type, bool PerSample, typename Vector>
+struct SimdLadderKernel
+{
+    typedef typename Vector::Scalar SampleType;
+    static const int kWidth = Vector::kWidth;
+
+    static void process(const LadderCoefficients<SampleType>* coeffs,
+                        const SampleType* const* inputs, SampleType* const* outputs,
+                        int numChannels, int numSamples,
+                        SampleType* state, int stateStride)
+    {
+        const LadderCoefficients<Vector> fixed = broadcastCoefficients<Vector>(coeffs[0]);
+
+        for (int first = 0; first < numChannels; first += kWidth) {
+            const int active = numChannels - first < kWidth ? numChannels - first : kWidth;
+
+            const SampleType* in[kWidth];
+            SampleType* out[kWidth];
+            SampleType lanes[kWidth];
+            for (int lane = 0; lane < kWidth; ++lane)
+                in[lane] = inputs[first + (lane < active ? lane : 0)];
+            for (int lane = 0; lane < active; ++lane)
+                out[lane] = outputs[first + lane];
+
+            Vector s1 = loadState(state + first, active, lanes);
+            Vector s2 = loadState(state + stateStride + first, active, lanes);
+            Vector s3 = loadState(state + 2 * stateStride + first, active, lanes);
+            Vector s4 = loadState(state + 3 * stateStride + first, active, lanes);
+
+            int sample = 0;
+            for (; sample + kWidth <= numSamples; sample += kWidth) {
+                Vector tile[kWidth];
+                for (int lane = 0; lane < kWidth; ++lane)
+                    tile[lane] = Vector::loadu(in[lane] + sample);
+                Vector::transpose(tile);
+
+                for (int step = 0; step < kWidth; ++step) {
+                    const LadderCoefficients<Vector> c = PerSample ? broadcastCoefficients<Vector>(coeffs[sample + step]) : fixed;
+                    tile[step] = LadderStep::tick<Type>(c, tile[step], s1, s2, s3, s4);
+                }
+
+                Vector::transpose(tile);
+                for (int lane = 0; lane < active; ++lane)
+                    tile[lane].storeu(out[lane] + sample);
+            }
+
+            // Remaining samples, one time step at a time
+            for (; sample < numSamples; ++sample) {
+                for (int lane = 0; lane < kWidth; ++lane)
+                    lanes[lane] = in[lane][sample];
+                const LadderCoefficients<Vector> c = PerSample ? broadcastCoefficients<Vector>(coeffs[sample]) : fixed;
+                Vector x = LadderStep::tick<Type>(c, Vector::loadu(lanes), s1, s2, s3, s4);
+                x.storeu(lanes);
+                for (int lane = 0; lane < active; ++lane)
+                    out[lane][sample] = lanes[lane];
+            }
+
+            storeState(s1, state + first, active, lanes);
+            storeState(s2, state + stateStride + first, active, lanes);
+            storeState(s3, state + 2 * stateStride + first, active, lanes);
+            storeState(s4, state + 3 * stateStride + first, active, lanes);
+        }
+    }
+
+private:
+    static Vector loadState(const SampleType* src, int active, SampleType* lanes)
+    {
+        for (int lane = 0; lane < kWidth; ++lane)
+            lanes[lane] = lane < active ? src[lane] : SampleType(0);
+        return Vector::loadu(lanes);
+    }
+
+    static void storeState(Vector v, SampleType* dst, int active, SampleType* lanes)
+    {
+        v.storeu(lanes);
+        for (int lane = 0; lane < active; ++lane)
+            dst[lane] = lanes[lane];
+    }
+};
+
+template <int Type, bool PerSample, typename SampleType>
+inline void processLadderBlock(const LadderCoefficients<SampleType>* coeffs,
+                               const SampleType* const* inputs, SampleType* const* outputs,
+                               int numChannels, int numSamples,
+                               SampleType* state, int stateStride)
+{
+    typedef typename SimdTraits<SampleType>::Narrow Narrow;
+    typedef typename SimdTraits<SampleType>::Wide Wide;
+    typedef typename SimdTraits<SampleType>::Widest Widest;
+
+    if (numChannels <= Narrow::kWidth)
+        SimdLadderKernel<Type, PerSample, Narrow>::process(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+    else if (numChannels <= Wide::kWidth)
+        SimdLadderKernel<Type, PerSample, Wide>::process(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+    else
+        SimdLadderKernel<Type, PerSample, Widest>::process(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+}
+
+// Picks the kernel for the response once per block. With perSample set,
+// coeffs holds one coefficient set for every sample; otherwise one set.
+template <typename SampleType>
+inline void processLadderBlock(int filterType, bool perSample, const LadderCoefficients<SampleType>* coeffs,
+                               const SampleType* const* inputs, SampleType* const* outputs,
+                               int numChannels, int numSamples,
+                               SampleType* state, int stateStride)
+{
+    switch (filterType * 2 + (perSample ? 1 : 0))
+    {
+        case kFilterTypeLowPass * 2:
+            processLadderBlock<kFilterTypeLowPass, false>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeLowPass * 2 + 1:
+            processLadderBlock<kFilterTypeLowPass, true>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeHighPass * 2:
+            processLadderBlock<kFilterTypeHighPass, false>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeHighPass * 2 + 1:
+            processLadderBlock<kFilterTypeHighPass, true>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeBandPass * 2:
+            processLadderBlock<kFilterTypeBandPass, false>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeBandPass * 2 + 1:
+            processLadderBlock<kFilterTypeBandPass, true>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeNotch * 2:
+            processLadderBlock<kFilterTypeNotch, false>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeNotch * 2 + 1:
+            processLadderBlock<kFilterTypeNotch, true>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+    }
+}
+
+FILTERDSP_ISA_NAMESPACE_END
+} // namespace FilterDSP
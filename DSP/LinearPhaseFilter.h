@@ -0,0 +1,1484 @@
+#pragma once
+
+// Linear-phase mode: an FIR with the magnitude response of the filter the
+// standard mode runs (one-pole, biquad cascade or single section for the
+// same type, slope, cutoff, Q and gain) and a constant group delay, run as
+// partitioned overlap-save FFT convolution.
+//
+// The kernel is cut into partitions that grow along it. The first level
+// uses the host's maximum block size B rounded up to a power of two
+// (kMinPartitionSize..kMaxPartitionSize) and runs on the audio thread: each
+// block of B input samples is transformed once into a frequency-domain
+// delay line and multiplied with the spectra of the level's partitions.
+// Every later level has four times larger partitions and starts at twice
+// its partition size T, so its result for T input samples is only needed
+// T + B samples after they are complete. Those levels run on the shared
+// background thread (LinearPhaseWorker), earliest deadline first; the audio
+// thread adds the finished results, and only computes a block itself when
+// the worker has not started it in time. The latency is B plus half the
+// kernel, as with uniform partitions.
+//
+// Kernels are immutable and shared through a process-wide cache
+// (DesignCache.h), so instances playing the same design hold one copy of
+// its spectra, and only the first one designs it. On a parameter change the
+// audio thread looks the kernel up (wait-free) and publishes it at once
+// when it is cached; otherwise it only posts the parameters, and the worker
+// designs the kernel. Once a new kernel is published, every level of every
+// channel crossfades to it over its next block. Nothing is allocated on the
+// audio thread.
+
+#include "CoefficientCache.h"
+#include "DesignCache.h"
+#include "Fft.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <complex>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FilterDSP {
+
+// Block size assumed until the host reports one
+static const int kDefaultMaxBlockSize = 1024;
+
+// Audio-thread partition size limits (the FFT is twice as long)
+static const int kMinPartitionSize = 64;
+static const int kMaxPartitionSize = 4096;
+
+// Smallest background partition in seconds (rounded up to a power of two,
+// and at least four blocks), so the worker has time to spare between
+// polls, and the largest one in samples
+static const double kMinBackgroundPartitionTime = 0.02;
+static const int kMaxBackgroundPartitionSize = 16384;
+
+// Half the kernel length in seconds, rounded up to a power of two in
+// samples (4096 at 44.1/48 kHz); sets the low-frequency resolution
+static const double kLinearPhaseHalfTime = 0.08;
+
+// How often the worker looks for design requests, and for background
+// convolution while the audio thread has submitted blocks within the last
+// kConvolutionActiveTime seconds
+static const int kDesignPollMilliseconds = 5;
+static const int kConvolutionPollMicroseconds = 500;
+static const double kConvolutionActiveTime = 0.5;
+
+enum LinearPhasePartitioning
+{
+    kPartitioningUniform = 0,       // every partition on the audio thread
+    kPartitioningNonUniform = 1     // growing partitions on the worker
+};
+
+// Parameters a kernel is designed from
+struct LinearPhaseDesign
+{
+    int filterType;
+    int slope;
+    int alignment;
+    double cutoffFreq;
+    double sampleRate;
+    double q;
+    double gainDb;
+};
+
+// A run of equal partitions of the kernel
+struct PartitionLevel
+{
+    int size;               // partition size (the FFT is twice as long)
+    int offset;             // first kernel tap
+    int numPartitions;
+    int spectrumOffset;     // first bin of the level in the kernel spectra
+};
+
+inline int nextPowerOfTwo(int value)
+{
+    int power = 1;
+    while (power < value)
+        power *= 2;
+    return power;
+}
+
+// Level 0 has headSize partitions. With non-uniform partitioning the next
+// levels start at firstBackgroundSize (at least 4·headSize) and grow by 4
+// up to kMaxBackgroundPartitionSize; a level of size T starts at tap 2T.
+// The last level covers the rest of the kernel.
+inline std::vector<PartitionLevel> planPartitions(int kernelLength, int headSize, int firstBackgroundSize, int partitioning)
+{
+    std::vector<PartitionLevel> levels;
+    PartitionLevel level;
+    level.size = headSize;
+    level.offset = 0;
+    level.spectrumOffset = 0;
+    int next = std::max(4 * headSize, firstBackgroundSize);
+    for (;;) {
+        if (partitioning == kPartitioningUniform || next > kMaxBackgroundPartitionSize || 2 * next >= kernelLength) {
+            level.numPartitions = (kernelLength - level.offset + level.size - 1) / level.size;
+            levels.push_back(level);
+            return levels;
+        }
+        level.numPartitions = (2 * next - level.offset) / level.size;
+        levels.push_back(level);
+
+        level.spectrumOffset += level.numPartitions * (level.size + 1);
+        level.offset = 2 * next;
+        level.size = next;
+        next *= 4;
+    }
+}
+
+// |H(e^jw)| of the minimum-phase filter for the cached parameters, a
+// one-pole filter or a biquad cascade in the standard mode
+inline double prototypeMagnitude(const FilterCoefficientCache<double>& c, double w)
+{
+    const std::complex<double> z1 = std::polar(1.0, -w);
+    if (c.getStructure() == kStructureOnePole) {
+        const OnePoleCoefficients<double>& p = c.get();
+        return std::abs((p.b0 + p.b1 * z1) / (1.0 - p.a1 * z1));
+    }
+
+    const BiquadCascadeCoefficients<double>& cascade = c.getBiquads();
+    std::complex<double> h = 1.0;
+    for (int k = 0; k < cascade.numSections; ++k) {
+        const BiquadCoefficients<double>& s = cascade.sections[k];
+        h *= (s.b0 + z1 * (s.b1 + z1 * s.b2)) / (1.0 + z1 * (s.a1 + z1 * s.a2));
+    }
+    return std::abs(h);
+}
+
+// acc += X·H over numBins bins
+template <typename SampleType>
+inline void multiplyAccumulateSpectrum(const SampleType* xr, const SampleType* xi, const SampleType* hr,
+                                       const SampleType* hi, int numBins, SampleType* accRe, SampleType* accIm)
+{
+    typedef typename SimdTraits<SampleType>::Wide Vector;
+    const int width = Vector::kWidth;
+    int k = 0;
+    for (; k + width <= numBins; k += width) {
+        const Vector ar = Vector::loadu(xr + k), ai = Vector::loadu(xi + k);
+        const Vector br = Vector::loadu(hr + k), bi = Vector::loadu(hi + k);
+        (Vector::loadu(accRe + k) + ar * br - ai * bi).storeu(accRe + k);
+        (Vector::loadu(accIm + k) + ar * bi + ai * br).storeu(accIm + k);
+    }
+    for (; k < numBins; ++k) {
+        accRe[k] += xr[k] * hr[k] - xi[k] * hi[k];
+        accIm[k] += xr[k] * hi[k] + xi[k] * hr[k];
+    }
+}
+
+// acc = Σ_p X[newest + p]·H_p over a frequency-domain delay line of
+// numPartitions spectra (indices wrap) and the matching kernel partitions
+template <typename SampleType>
+inline void multiplyAccumulateSpectra(const SampleType* delayRe, const SampleType* delayIm, int newest,
+                                      const SampleType* kernelRe, const SampleType* kernelIm,
+                                      int numPartitions, int numBins, SampleType* accRe, SampleType* accIm)
+{
+    std::fill(accRe, accRe + numBins, SampleType(0));
+    std::fill(accIm, accIm + numBins, SampleType(0));
+
+    for (int p = 0; p < numPartitions; ++p) {
+        int index = newest + p;
+        if (index >= numPartitions)
+            index -= numPartitions;
+        const size_t offset = static_cast<size_t>(p) * numBins;
+        multiplyAccumulateSpectrum(delayRe + static_cast<size_t>(index) * numBins, delayIm + static_cast<size_t>(index) * numBins,
+                                   kernelRe + offset, kernelIm + offset, numBins, accRe, accIm);
+    }
+}
+
+inline long long steadyNanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Work item of the background thread
+class LinearPhaseJob
+{
+public:
+    virtual ~LinearPhaseJob() {}
+
+    // Design a pending kernel request, if any
+    virtual void serviceDesign() {}
+
+    // Deadline (steady clock, ns) of the most urgent background
+    // convolution; false if none is waiting
+    virtual bool getDeadline(long long& deadline) const
+    {
+        (void)deadline;
+        return false;
+    }
+
+    // Run the most urgent background convolution; false if none was run
+    virtual bool serviceConvolution() { return false; }
+
+    // When the audio thread last submitted background convolution
+    virtual long long getLastSubmission() const { return 0; }
+};
+
+// One thread per process serves every linear-phase filter. It runs while
+// at least one filter is prepared. add/remove lock and must not be called
+// from the audio thread.
+class LinearPhaseWorker
+{
+public:
+    static LinearPhaseWorker& get()
+    {
+        static LinearPhaseWorker worker;
+        return worker;
+    }
+
+    void add(LinearPhaseJob* job)
+    {
+        std::lock_guard<std::mutex> lifecycle(m_lifecycleMutex);
+        {
+            std::lock_guard<std::mutex> lock(m_jobsMutex);
+            m_jobs.push_back(job);
+        }
+        if (!m_thread.joinable()) {
+            m_stop.store(false);
+            m_thread = std::thread(&LinearPhaseWorker::run, this);
+        }
+    }
+
+    // Waits for work on this job that is in progress
+    void remove(LinearPhaseJob* job)
+    {
+        std::lock_guard<std::mutex> lifecycle(m_lifecycleMutex);
+        bool empty = false;
+        {
+            std::lock_guard<std::mutex> lock(m_jobsMutex);
+            m_jobs.erase(std::remove(m_jobs.begin(), m_jobs.end(), job), m_jobs.end());
+            empty = m_jobs.empty();
+        }
+        if (empty && m_thread.joinable()) {
+            m_stop.store(true);
+            m_thread.join();
+        }
+    }
+
+private:
+    // Convolutions run before design requests are looked at again
+    static const int kMaxConvolutionsPerPass = 64;
+
+    LinearPhaseWorker() : m_stop(false) {}
+
+    ~LinearPhaseWorker()
+    {
+        if (m_thread.joinable()) {
+            m_stop.store(true);
+            m_thread.join();
+        }
+    }
+
+    void run()
+    {
+        const long long activeTime = static_cast<long long>(kConvolutionActiveTime * 1e9);
+        while (!m_stop.load()) {
+            bool worked = false;
+            bool convolving = false;
+            {
+                std::lock_guard<std::mutex> lock(m_jobsMutex);
+                for (size_t i = 0; i < m_jobs.size(); ++i)
+                    m_jobs[i]->serviceDesign();
+
+                // Earliest deadline first, across all filters
+                for (int pass = 0; pass < kMaxConvolutionsPerPass; ++pass) {
+                    LinearPhaseJob* next = nullptr;
+                    long long earliest = 0;
+                    for (size_t i = 0; i < m_jobs.size(); ++i) {
+                        long long deadline = 0;
+                        if (m_jobs[i]->getDeadline(deadline) && (!next || deadline < earliest)) {
+                            next = m_jobs[i];
+                            earliest = deadline;
+                        }
+                    }
+                    if (!next || !next->serviceConvolution())
+                        break;
+                    worked = true;
+                }
+
+                const long long now = steadyNanoseconds();
+                for (size_t i = 0; i < m_jobs.size() && !convolving; ++i)
+                    convolving = now - m_jobs[i]->getLastSubmission() < activeTime;
+            }
+            if (worked)
+                continue;
+            if (convolving)
+                std::this_thread::sleep_for(std::chrono::microseconds(kConvolutionPollMicroseconds));
+            else
+                std::this_thread::sleep_for(std::chrono::milliseconds(kDesignPollMilliseconds));
+        }
+    }
+
+    std::mutex m_lifecycleMutex;
+    std::mutex m_jobsMutex;
+    std::vector<LinearPhaseJob*> m_jobs;
+    std::thread m_thread;
+    std::atomic<bool> m_stop;
+};
+
+// filterType of the silent kernel a filter plays until its first design
+static const int kSilentKernel = -1;
+
+// What a kernel's partition spectra depend on: the design, and the
+// partition layout of the filter playing it. The key of the shared cache.
+struct LinearPhaseKey
+{
+    LinearPhaseDesign design;
+    int kernelLength;
+    int headSize;               // level 0 partition size
+    int firstBackgroundSize;
+    int partitioning;
+
+    bool operator==(const LinearPhaseKey& other) const
+    {
+        return design.filterType == other.design.filterType && design.slope == other.design.slope
+            && design.alignment == other.design.alignment && design.cutoffFreq == other.design.cutoffFreq
+            && design.sampleRate == other.design.sampleRate && design.q == other.design.q
+            && design.gainDb == other.design.gainDb && kernelLength == other.kernelLength
+            && headSize == other.headSize && firstBackgroundSize == other.firstBackgroundSize
+            && partitioning == other.partitioning;
+    }
+
+    size_t hash() const
+    {
+        unsigned long long h = 14695981039346656037ull;
+        const auto mix = [&h](unsigned long long value) {
+            h = (h ^ value) * 1099511628211ull;
+            h ^= h >> 32;
+        };
+        unsigned long long bits = 0;
+        std::memcpy(&bits, &design.cutoffFreq, sizeof(bits));
+        mix(bits);
+        std::memcpy(&bits, &design.sampleRate, sizeof(bits));
+        mix(bits);
+        std::memcpy(&bits, &design.q, sizeof(bits));
+        mix(bits);
+        std::memcpy(&bits, &design.gainDb, sizeof(bits));
+        mix(bits);
+        mix(static_cast<unsigned long long>(design.filterType + 1));
+        mix(static_cast<unsigned long long>(design.slope));
+        mix(static_cast<unsigned long long>(design.alignment));
+        mix(static_cast<unsigned long long>(kernelLength));
+        mix(static_cast<unsigned long long>(headSize));
+        mix(static_cast<unsigned long long>(firstBackgroundSize));
+        mix(static_cast<unsigned long long>(partitioning));
+        return static_cast<size_t>(h);
+    }
+};
+
+// Partition spectra of one kernel, laid out by
+// PartitionLevel::spectrumOffset. Immutable once designed.
+template <typename SampleType>
+struct LinearPhaseKernelSet
+{
+    std::vector<SampleType> re;
+    std::vector<SampleType> im;
+};
+
+// Frequency sampling: the zero-phase impulse of the prototype magnitude,
+// delayed to the middle tap and windowed, then cut into the partitions of
+// each level and transformed. Allocates; runs on the worker, or in
+// prepare.
+template <typename SampleType>
+LinearPhaseKernelSet<SampleType> designLinearPhaseKernel(const LinearPhaseKey& key)
+{
+    const int kernelLength = key.kernelLength;
+    const std::vector<PartitionLevel> levels = planPartitions(kernelLength, key.headSize, key.firstBackgroundSize,
+                                                              key.partitioning);
+    const PartitionLevel& last = levels.back();
+    const size_t size = static_cast<size_t>(last.spectrumOffset) + static_cast<size_t>(last.numPartitions) * (last.size + 1);
+    LinearPhaseKernelSet<SampleType> kernel;
+    kernel.re.assign(size, SampleType(0));
+    kernel.im.assign(size, SampleType(0));
+    if (key.design.filterType == kSilentKernel)
+        return kernel;
+
+    FilterCoefficientCache<double> cache;
+    cache.setSampleRate(key.design.sampleRate);
+    cache.setCutoff(key.design.cutoffFreq);
+    cache.setFilterType(key.design.filterType);
+    cache.setSlope(key.design.slope);
+    cache.setAlignment(key.design.alignment);
+    cache.setQ(key.design.q);
+    cache.setGain(key.design.gainDb);
+
+    const double pi = 3.14159265358979323846;
+    const int designSize = 2 * (kernelLength + 1);
+    RealFft<double> designFft;
+    designFft.prepare(designSize);
+    std::vector<double> magnitude(designSize / 2 + 1);
+    std::vector<double> phase(designSize / 2 + 1, 0.0);
+    std::vector<double> impulse(designSize);
+    for (int k = 0; k <= designSize / 2; ++k)
+        magnitude[k] = prototypeMagnitude(cache, 2.0 * pi * k / designSize);
+    designFft.inverse(magnitude.data(), phase.data(), impulse.data());
+
+    // 4-term Blackman-Harris window over the kernel
+    std::vector<double> window(kernelLength);
+    for (int n = 0; n < kernelLength; ++n) {
+        const double x = 2.0 * pi * n / (kernelLength - 1);
+        window[n] = 0.35875 - 0.48829 * std::cos(x) + 0.14128 * std::cos(2.0 * x) - 0.01168 * std::cos(3.0 * x);
+    }
+
+    const int center = (kernelLength - 1) / 2;
+    std::vector<SampleType> partition(2 * static_cast<size_t>(last.size), SampleType(0));
+    for (size_t l = 0; l < levels.size(); ++l) {
+        const PartitionLevel& level = levels[l];
+        const int numBins = level.size + 1;
+        RealFft<SampleType> fft;
+        fft.prepare(2 * level.size);
+        for (int p = 0; p < level.numPartitions; ++p) {
+            for (int i = 0; i < level.size; ++i) {
+                const int n = level.offset + p * level.size + i;
+                partition[i] = n < kernelLength
+                    ? SampleType(impulse[(n - center + designSize) % designSize] * window[n])
+                    : SampleType(0);
+            }
+            std::fill(partition.begin() + level.size, partition.begin() + 2 * level.size, SampleType(0));
+            const size_t bin = static_cast<size_t>(level.spectrumOffset) + static_cast<size_t>(p) * numBins;
+            fft.forward(partition.data(), &kernel.re[bin], &kernel.im[bin]);
+        }
+    }
+    return kernel;
+}
+
+// Kernels shared by every linear-phase filter in the process
+template <typename SampleType>
+using LinearPhaseKernelCache = SharedDesignCache<LinearPhaseKey, LinearPhaseKernelSet<SampleType>>;
+
+// The two kernels a filter switches between, as references into the
+// shared cache. The audio thread plays the active slot. The other slot is
+// only filled while it is free (no kernel published or being switched to):
+// on a request the audio thread fills it straight from the cache when the
+// kernel is there, otherwise the worker looks the kernel up or designs it.
+// The audio thread then makes the published slot active, every user (each
+// level of each channel) adopts it with a crossfade, and the last one
+// releases the old kernel.
+template <typename SampleType>
+class LinearPhaseKernels : public LinearPhaseJob
+{
+public:
+    typedef LinearPhaseKernelCache<SampleType> Cache;
+    typedef typename Cache::Entry Entry;
+
+    // Takes over the reference to the initial kernel; the design in layout
+    // is ignored
+    LinearPhaseKernels(const LinearPhaseKey& layout, const Entry* initial)
+    : m_layout(layout)
+    , m_active(0)
+    , m_state(kSlotFree)
+    , m_pendingUsers(0)
+    , m_requestId(0)
+    , m_designedId(0)
+    , m_filterType(kFilterTypeLowPass)
+    , m_slope(kSlope6dB)
+    , m_alignment(kAlignmentButterworth)
+    , m_cutoffFreq(1000.0)
+    , m_sampleRate(44100.0)
+    , m_q(kDefaultQ)
+    , m_gainDb(0.0)
+    {
+        m_slots[0] = initial;
+        m_slots[1] = nullptr;
+    }
+
+    ~LinearPhaseKernels()
+    {
+        Cache::release(m_slots[0]);
+        Cache::release(m_slots[1]);
+    }
+
+    // Partition spectra of a slot, laid out by PartitionLevel::spectrumOffset
+    const SampleType* getRe(int slot) const { return m_slots[slot]->value.re.data(); }
+    const SampleType* getIm(int slot) const { return m_slots[slot]->value.im.data(); }
+
+    // Not the audio thread: play the kernel other plays (same layout)
+    void copyActive(const LinearPhaseKernels& other)
+    {
+        const int active = m_active.load();
+        Cache::release(m_slots[active]);
+        m_slots[active] = Cache::retain(other.m_slots[other.getActive()]);
+    }
+
+    int getActive() const { return m_active.load(); }
+    bool isSwitching() const { return m_state.load() == kSlotSwitching; }
+
+    // Audio thread: post new parameters (lock-free, latest request wins).
+    // A cached kernel is published at once.
+    void request(const LinearPhaseDesign& design)
+    {
+        m_filterType.store(design.filterType, std::memory_order_relaxed);
+        m_slope.store(design.slope, std::memory_order_relaxed);
+        m_alignment.store(design.alignment, std::memory_order_relaxed);
+        m_cutoffFreq.store(design.cutoffFreq, std::memory_order_relaxed);
+        m_sampleRate.store(design.sampleRate, std::memory_order_relaxed);
+        m_q.store(design.q, std::memory_order_relaxed);
+        m_gainDb.store(design.gainDb, std::memory_order_relaxed);
+        const unsigned id = m_requestId.fetch_add(1, std::memory_order_release) + 1;
+
+        LinearPhaseKey key = m_layout;
+        key.design = design;
+        const Entry* entry = Cache::get().find(key);
+        if (!entry)
+            return;
+        int expected = kSlotFree;
+        if (m_state.compare_exchange_strong(expected, kSlotFilling))
+            fill(entry, id);
+        else
+            Cache::release(entry);
+    }
+
+    bool isPending() const
+    {
+        return m_requestId.load(std::memory_order_acquire) != m_designedId.load(std::memory_order_acquire)
+            || m_state.load() != kSlotFree;
+    }
+
+    // Audio thread: play a published kernel; numUsers calls to adopt()
+    // complete the switch
+    void switchIfPublished(int numUsers)
+    {
+        if (m_state.load() != kSlotPublished)
+            return;
+        m_pendingUsers.store(numUsers);
+        m_state.store(kSlotSwitching);
+        m_active.store(1 - m_active.load());
+    }
+
+    // A user no longer plays the previous slot
+    void adopt()
+    {
+        if (m_pendingUsers.fetch_sub(1) == 1) {
+            const int previous = 1 - m_active.load();
+            Cache::release(m_slots[previous]);
+            m_slots[previous] = nullptr;
+            m_state.store(kSlotFree);
+        }
+    }
+
+    void serviceDesign() override
+    {
+        const unsigned id = m_requestId.load(std::memory_order_acquire);
+        if (id == m_designedId.load(std::memory_order_acquire) || m_state.load() != kSlotFree)
+            return;
+
+        // A request posted while reading is picked up on the next poll,
+        // because its id differs from the one recorded here
+        LinearPhaseKey key = m_layout;
+        key.design.filterType = m_filterType.load(std::memory_order_relaxed);
+        key.design.slope = m_slope.load(std::memory_order_relaxed);
+        key.design.alignment = m_alignment.load(std::memory_order_relaxed);
+        key.design.cutoffFreq = m_cutoffFreq.load(std::memory_order_relaxed);
+        key.design.sampleRate = m_sampleRate.load(std::memory_order_relaxed);
+        key.design.q = m_q.load(std::memory_order_relaxed);
+        key.design.gainDb = m_gainDb.load(std::memory_order_relaxed);
+        const Entry* entry = Cache::get().acquire(key, &designLinearPhaseKernel<SampleType>);
+
+        // The audio thread may have published a later request meanwhile
+        int expected = kSlotFree;
+        if (!m_state.compare_exchange_strong(expected, kSlotFilling)) {
+            Cache::release(entry);
+            return;
+        }
+        if (static_cast<int>(id - m_designedId.load(std::memory_order_relaxed)) <= 0) {
+            m_state.store(kSlotFree);
+            Cache::release(entry);
+            return;
+        }
+        fill(entry, id);
+    }
+
+private:
+    enum SlotState
+    {
+        kSlotFree,          // users play the active slot only
+        kSlotFilling,       // one thread is filling the inactive slot
+        kSlotPublished,     // the inactive slot holds a new kernel
+        kSlotSwitching      // users are still adopting the active slot
+    };
+
+    // The caller holds kSlotFilling
+    void fill(const Entry* entry, unsigned id)
+    {
+        m_designedId.store(id, std::memory_order_release);
+        const int active = m_active.load();
+        if (entry == m_slots[active]) {
+            Cache::release(entry);
+            m_state.store(kSlotFree);
+            return;
+        }
+        m_slots[1 - active] = entry;
+        m_state.store(kSlotPublished);
+    }
+
+    const LinearPhaseKey m_layout;
+
+    // Written only by the thread holding kSlotFilling (or completing a
+    // switch), while no user plays the slot
+    const Entry* m_slots[2];
+
+    std::atomic<int> m_active;          // written by the audio thread only
+    std::atomic<int> m_state;           // SlotState of the inactive slot
+    std::atomic<int> m_pendingUsers;
+
+    std::atomic<unsigned> m_requestId;
+    std::atomic<unsigned> m_designedId;
+
+    // Latest request
+    std::atomic<int> m_filterType;
+    std::atomic<int> m_slope;
+    std::atomic<int> m_alignment;
+    std::atomic<double> m_cutoffFreq;
+    std::atomic<double> m_sampleRate;
+    std::atomic<double> m_q;
+    std::atomic<double> m_gainDb;
+};
+
+// The background levels (1 and up) of every channel. The audio thread
+// writes each input block into a history ring and submits the blocks that
+// complete a partition of a level. A segment (one level of one channel)
+// commits its blocks in order. The worker computes them ahead of time; a
+// block that is due before the worker has committed it is computed by the
+// audio thread as well, which never waits for the worker. Each thread
+// computes into its own buffers and claims the block with a
+// compare-and-swap on the segment state, so the slower result is dropped.
+template <typename SampleType>
+class LinearPhaseTails : public LinearPhaseJob
+{
+public:
+    LinearPhaseTails(LinearPhaseKernels<SampleType>& kernels, const std::vector<PartitionLevel>& levels,
+                     int numChannels, double sampleRate)
+    : m_kernels(kernels)
+    , m_levels(levels)
+    , m_numChannels(numChannels)
+    , m_numLevels(static_cast<int>(levels.size()) - 1)
+    , m_blockSize(levels[0].size)
+    , m_epoch(0)
+    , m_lastSubmission(0)
+    , m_deadlineMisses(0)
+    {
+        m_historySize = nextPowerOfTwo(3 * m_levels.back().size + 2 * m_blockSize);
+        m_history.assign(static_cast<size_t>(numChannels) * m_historySize, SampleType(0));
+
+        m_segments.reset(new Segment[static_cast<size_t>(numChannels) * m_numLevels]);
+        for (int channel = 0; channel < numChannels; ++channel) {
+            for (int l = 1; l <= m_numLevels; ++l) {
+                const PartitionLevel& level = m_levels[l];
+                const size_t numBins = static_cast<size_t>(level.size) + 1;
+                Segment& segment = getSegment(channel, l);
+                segment.channel = channel;
+                segment.level = l;
+                segment.delayRe.assign(level.numPartitions * numBins, SampleType(0));
+                segment.delayIm.assign(level.numPartitions * numBins, SampleType(0));
+                segment.delayTags.reset(new std::atomic<unsigned long long>[level.numPartitions]);
+                for (int p = 0; p < level.numPartitions; ++p)
+                    segment.delayTags[p].store(kNoSpectrum);
+                for (int owner = 0; owner < kNumOwners; ++owner)
+                    segment.results[owner].assign(static_cast<size_t>(kResultSlots) * level.size, SampleType(0));
+            }
+        }
+
+        // From submitting a block to the first sample of its result
+        m_slack.assign(m_levels.size(), 0);
+        for (int l = 1; l <= m_numLevels; ++l)
+            m_slack[l] = static_cast<long long>(1e9 * (m_levels[l].offset - m_levels[l].size + m_blockSize) / sampleRate);
+
+        m_workerScratch.resize(m_levels.size());
+        m_audioScratch.resize(m_levels.size());
+        for (int l = 1; l <= m_numLevels; ++l) {
+            m_workerScratch[l].prepare(m_levels[l].size);
+            m_audioScratch[l].prepare(m_levels[l].size);
+        }
+    }
+
+    // Blocks the audio thread computed itself
+    unsigned getDeadlineMisses() const { return m_deadlineMisses; }
+
+    // True when every submitted block has been committed
+    bool isIdle() const
+    {
+        for (int i = 0; i < m_numChannels * m_numLevels; ++i) {
+            if (getCount(m_segments[i].state.load()) != m_segments[i].submitted.load())
+                return false;
+        }
+        return true;
+    }
+
+    // Audio thread: the input block starting at sample blockStart
+    void write(int channel, const SampleType* block, long long blockStart)
+    {
+        SampleType* history = &m_history[static_cast<size_t>(channel) * m_historySize];
+        std::memcpy(history + (blockStart & (m_historySize - 1)), block, sizeof(SampleType) * static_cast<size_t>(m_blockSize));
+
+        const long long end = blockStart + m_blockSize;
+        for (int l = 1; l <= m_numLevels; ++l) {
+            const int size = m_levels[l].size;
+            if (end % size != 0)
+                continue;
+            const long long now = steadyNanoseconds();
+            const long long task = end / size - 1;
+            Segment& segment = getSegment(channel, l);
+            segment.submitTime[task % kResultSlots].store(now, std::memory_order_relaxed);
+            segment.submitted.store(task + 1, std::memory_order_release);
+            m_lastSubmission.store(now, std::memory_order_relaxed);
+        }
+    }
+
+    // Audio thread: add the background levels' output for the block
+    // starting at sample blockStart
+    void mix(int channel, SampleType* output, long long blockStart)
+    {
+        for (int l = 1; l <= m_numLevels; ++l) {
+            const PartitionLevel& level = m_levels[l];
+            Segment& segment = getSegment(channel, l);
+            if (blockStart < level.offset) {
+                adoptActive(segment);
+                continue;
+            }
+            const long long task = (blockStart - level.offset) / level.size;
+            const int position = static_cast<int>(blockStart - level.offset - task * level.size);
+            const unsigned long long state = finish(segment, task);
+            adoptActive(segment);
+
+            const int owner = getOwner(state, task);
+            const SampleType* result = &segment.results[owner][static_cast<size_t>(task % kResultSlots) * level.size + position];
+            for (int i = 0; i < m_blockSize; ++i)
+                output[i] += result[i];
+        }
+    }
+
+    // Audio thread: start every segment over from silence. Nothing the
+    // worker reads is written here: blocks before the start read as
+    // silence, and a block the worker is still computing belongs to the
+    // previous epoch, so it can no longer be committed.
+    void reset()
+    {
+        m_epoch = (m_epoch + 1) & kEpochMask;
+        const int active = m_kernels.getActive();
+        for (int i = 0; i < m_numChannels * m_numLevels; ++i) {
+            Segment& segment = m_segments[i];
+            segment.submitted.store(0);
+            segment.state.store(makeState(m_epoch, 0, active, 0));
+            adoptActive(segment);
+        }
+    }
+
+    // Audio thread: adopt the active kernel without processing, for a
+    // channel the host does not process. A segment the worker is computing
+    // adopts on a later call.
+    void adopt(int channel)
+    {
+        const int active = m_kernels.getActive();
+        for (int l = 1; l <= m_numLevels; ++l) {
+            Segment& segment = getSegment(channel, l);
+            unsigned long long state = segment.state.load();
+            while (getSlot(state) != active && !segment.state.compare_exchange_weak(state, withSlot(state, active))) {
+            }
+            adoptActive(segment);
+        }
+    }
+
+    bool getDeadline(long long& deadline) const override
+    {
+        return findEarliest(deadline) >= 0;
+    }
+
+    bool serviceConvolution() override
+    {
+        long long deadline = 0;
+        const int index = findEarliest(deadline);
+        if (index < 0)
+            return false;
+
+        // busy is raised before the state is read, so the audio thread
+        // never releases a kernel this block may still read
+        Segment& segment = m_segments[index];
+        segment.busy.store(true);
+        const unsigned long long state = segment.state.load();
+        if (getCount(state) < segment.submitted.load(std::memory_order_acquire)) {
+            const int active = m_kernels.getActive();
+            compute(segment, m_workerScratch[segment.level], state, kWorker, active);
+            commit(segment, m_workerScratch[segment.level], state, kWorker, active);
+        }
+        segment.busy.store(false);
+        return true;
+    }
+
+    long long getLastSubmission() const override { return m_lastSubmission.load(std::memory_order_relaxed); }
+
+private:
+    // A block's result is first used T + B samples after it is submitted
+    // and then for T samples, so at most three are live at once
+    static const int kResultSlots = 4;
+
+    // Each thread writes its results to its own slots
+    enum Owner
+    {
+        kWorker,
+        kAudio,
+        kNumOwners
+    };
+
+    // Segment state: the owners of the last kResultSlots blocks (bit i for
+    // block count - 1 - i), the kernel slot of the last block, the number of
+    // blocks committed, and the epoch (bumped by reset)
+    static const int kSlotShift = kResultSlots;
+    static const int kCountShift = kSlotShift + 1;
+    static const int kEpochShift = 48;
+    static const unsigned long long kOwnerMask = (1ull << kResultSlots) - 1;
+    static const unsigned long long kCountMask = (1ull << (kEpochShift - kCountShift)) - 1;
+    static const unsigned kEpochMask = 0xffff;
+    static const unsigned long long kNoSpectrum = ~0ull;
+
+    struct Segment
+    {
+        Segment() : channel(0), level(0), adopted(0), state(0), submitted(0), busy(false)
+        {
+            for (int i = 0; i < kResultSlots; ++i)
+                submitTime[i].store(0);
+        }
+
+        int channel;
+        int level;
+        int adopted;                        // kernel slot adopted, audio thread
+
+        // Frequency-domain delay line: block k goes to partition
+        // P - 1 - k mod P, written by the thread that committed it, and is
+        // valid once delayTags names it
+        std::vector<SampleType> delayRe;
+        std::vector<SampleType> delayIm;
+        std::unique_ptr<std::atomic<unsigned long long>[]> delayTags;
+
+        std::vector<SampleType> results[kNumOwners];    // kResultSlots blocks each
+
+        std::atomic<unsigned long long> state;
+        std::atomic<long long> submitted;   // blocks available
+        std::atomic<bool> busy;             // the worker is computing a block
+        std::atomic<long long> submitTime[kResultSlots];
+    };
+
+    // Work buffers of a level for one thread
+    struct Scratch
+    {
+        void prepare(int size)
+        {
+            const size_t numBins = static_cast<size_t>(size) + 1;
+            fft.prepare(2 * size);
+            frame.assign(2 * static_cast<size_t>(size), SampleType(0));
+            time.assign(2 * static_cast<size_t>(size), SampleType(0));
+            fadeTime.assign(2 * static_cast<size_t>(size), SampleType(0));
+            spectrumRe.assign(numBins, SampleType(0));
+            spectrumIm.assign(numBins, SampleType(0));
+            missingRe.assign(numBins, SampleType(0));
+            missingIm.assign(numBins, SampleType(0));
+            accRe.assign(numBins, SampleType(0));
+            accIm.assign(numBins, SampleType(0));
+            fadeRe.assign(numBins, SampleType(0));
+            fadeIm.assign(numBins, SampleType(0));
+        }
+
+        RealFft<SampleType> fft;
+        std::vector<SampleType> frame;
+        std::vector<SampleType> time;
+        std::vector<SampleType> fadeTime;
+        std::vector<SampleType> spectrumRe;     // the block being computed
+        std::vector<SampleType> spectrumIm;
+        std::vector<SampleType> missingRe;      // an earlier block not yet in the delay line
+        std::vector<SampleType> missingIm;
+        std::vector<SampleType> accRe;
+        std::vector<SampleType> accIm;
+        std::vector<SampleType> fadeRe;         // the previous kernel while crossfading
+        std::vector<SampleType> fadeIm;
+    };
+
+    static unsigned long long makeState(unsigned epoch, long long count, int slot, unsigned long long owners)
+    {
+        return (static_cast<unsigned long long>(epoch) << kEpochShift)
+             | ((static_cast<unsigned long long>(count) & kCountMask) << kCountShift)
+             | (static_cast<unsigned long long>(slot) << kSlotShift) | (owners & kOwnerMask);
+    }
+
+    static unsigned getEpoch(unsigned long long state) { return static_cast<unsigned>(state >> kEpochShift); }
+    static long long getCount(unsigned long long state) { return static_cast<long long>((state >> kCountShift) & kCountMask); }
+    static int getSlot(unsigned long long state) { return static_cast<int>((state >> kSlotShift) & 1); }
+
+    static unsigned long long withSlot(unsigned long long state, int slot)
+    {
+        return makeState(getEpoch(state), getCount(state), slot, state);
+    }
+
+    // Owner of a committed block that is still live
+    static int getOwner(unsigned long long state, long long task)
+    {
+        return static_cast<int>((state >> (getCount(state) - 1 - task)) & 1);
+    }
+
+    static unsigned long long makeTag(unsigned epoch, long long task)
+    {
+        return (static_cast<unsigned long long>(epoch) << kEpochShift) | static_cast<unsigned long long>(task);
+    }
+
+    Segment& getSegment(int channel, int level)
+    {
+        return m_segments[static_cast<size_t>(channel) * m_numLevels + level - 1];
+    }
+
+    // Index of the segment whose next block is due first, or -1
+    int findEarliest(long long& deadline) const
+    {
+        int earliest = -1;
+        for (int i = 0; i < m_numChannels * m_numLevels; ++i) {
+            const Segment& segment = m_segments[i];
+            const long long next = getCount(segment.state.load(std::memory_order_relaxed));
+            if (next >= segment.submitted.load(std::memory_order_acquire))
+                continue;
+            const long long due = segment.submitTime[next % kResultSlots].load(std::memory_order_relaxed) + m_slack[segment.level];
+            if (earliest < 0 || due < deadline) {
+                earliest = i;
+                deadline = due;
+            }
+        }
+        return earliest;
+    }
+
+    // Audio thread: block `task` is due. Compute every block up to it that
+    // is not committed yet, even one the worker is on; returns the state
+    // that holds it.
+    unsigned long long finish(Segment& segment, long long task)
+    {
+        Scratch& scratch = m_audioScratch[segment.level];
+        unsigned long long state = segment.state.load(std::memory_order_acquire);
+        while (getCount(state) <= task) {
+            ++m_deadlineMisses;
+            const int active = m_kernels.getActive();
+            compute(segment, scratch, state, kAudio, active);
+            commit(segment, scratch, state, kAudio, active);
+            state = segment.state.load(std::memory_order_acquire);
+        }
+        return state;
+    }
+
+    // Audio thread: release the previous kernel once the segment has
+    // committed a block with the active one and the worker is not
+    // computing a block that may still read it
+    void adoptActive(Segment& segment)
+    {
+        const int active = m_kernels.getActive();
+        if (segment.adopted == active || getSlot(segment.state.load()) != active || segment.busy.load())
+            return;
+        segment.adopted = active;
+        m_kernels.adopt();
+    }
+
+    // Block getCount(state) into the owner's result slot, reading only what
+    // no other thread writes while the block is pending. A block of the
+    // worker that the audio thread overtakes may read a delay partition or
+    // history being rewritten; its commit then fails and the result is
+    // dropped.
+    void compute(Segment& segment, Scratch& scratch, unsigned long long state, int owner, int active)
+    {
+        const PartitionLevel& level = m_levels[segment.level];
+        const int size = level.size;
+        const int numBins = size + 1;
+        const long long task = getCount(state);
+        const unsigned epoch = getEpoch(state);
+        const int previous = getSlot(state);
+
+        transform(segment, scratch, task, scratch.spectrumRe.data(), scratch.spectrumIm.data());
+
+        std::fill(scratch.accRe.begin(), scratch.accRe.end(), SampleType(0));
+        std::fill(scratch.accIm.begin(), scratch.accIm.end(), SampleType(0));
+        std::fill(scratch.fadeRe.begin(), scratch.fadeRe.end(), SampleType(0));
+        std::fill(scratch.fadeIm.begin(), scratch.fadeIm.end(), SampleType(0));
+        for (int p = 0; p < level.numPartitions && p <= task; ++p) {
+            // Block task - p: this one, the delay line, or (when the thread
+            // that committed it has not copied it there yet) its own transform
+            const SampleType* xr = scratch.spectrumRe.data();
+            const SampleType* xi = scratch.spectrumIm.data();
+            if (p > 0) {
+                const int index = getDelayIndex(level, task - p);
+                if (segment.delayTags[index].load(std::memory_order_acquire) == makeTag(epoch, task - p)) {
+                    xr = &segment.delayRe[static_cast<size_t>(index) * numBins];
+                    xi = &segment.delayIm[static_cast<size_t>(index) * numBins];
+                }
+                else {
+                    transform(segment, scratch, task - p, scratch.missingRe.data(), scratch.missingIm.data());
+                    xr = scratch.missingRe.data();
+                    xi = scratch.missingIm.data();
+                }
+            }
+            const size_t offset = level.spectrumOffset + static_cast<size_t>(p) * numBins;
+            multiplyAccumulateSpectrum(xr, xi, m_kernels.getRe(active) + offset, m_kernels.getIm(active) + offset,
+                                       numBins, scratch.accRe.data(), scratch.accIm.data());
+            if (previous != active)
+                multiplyAccumulateSpectrum(xr, xi, m_kernels.getRe(previous) + offset, m_kernels.getIm(previous) + offset,
+                                           numBins, scratch.fadeRe.data(), scratch.fadeIm.data());
+        }
+
+        SampleType* result = &segment.results[owner][static_cast<size_t>(task % kResultSlots) * size];
+        scratch.fft.inverse(scratch.accRe.data(), scratch.accIm.data(), scratch.time.data());
+        if (previous != active) {
+            // Crossfade from the previous kernel over this block
+            scratch.fft.inverse(scratch.fadeRe.data(), scratch.fadeIm.data(), scratch.fadeTime.data());
+            const SampleType step = SampleType(1) / SampleType(size);
+            for (int i = 0; i < size; ++i) {
+                const SampleType from = scratch.fadeTime[size + i];
+                result[i] = from + SampleType(i + 1) * step * (scratch.time[size + i] - from);
+            }
+        }
+        else {
+            std::memcpy(result, scratch.time.data() + size, sizeof(SampleType) * static_cast<size_t>(size));
+        }
+    }
+
+    // Claims the block computed from state for owner. The winner copies its
+    // spectrum into the delay line; the loser's work is dropped.
+    void commit(Segment& segment, Scratch& scratch, unsigned long long state, int owner, int active)
+    {
+        const long long task = getCount(state);
+        const unsigned long long next = makeState(getEpoch(state), task + 1, active, (state << 1) | static_cast<unsigned>(owner));
+        if (!segment.state.compare_exchange_strong(state, next))
+            return;
+
+        const PartitionLevel& level = m_levels[segment.level];
+        const size_t numBins = static_cast<size_t>(level.size) + 1;
+        const int index = getDelayIndex(level, task);
+        std::memcpy(&segment.delayRe[index * numBins], scratch.spectrumRe.data(), sizeof(SampleType) * numBins);
+        std::memcpy(&segment.delayIm[index * numBins], scratch.spectrumIm.data(), sizeof(SampleType) * numBins);
+        segment.delayTags[index].store(makeTag(getEpoch(state), task), std::memory_order_release);
+    }
+
+    // Partition of the delay line that holds block task
+    static int getDelayIndex(const PartitionLevel& level, long long task)
+    {
+        return level.numPartitions - 1 - static_cast<int>(task % level.numPartitions);
+    }
+
+    // Spectrum of [previous block | block task] from the history ring;
+    // samples before the start are silent
+    void transform(const Segment& segment, Scratch& scratch, long long task, SampleType* re, SampleType* im)
+    {
+        const int size = m_levels[segment.level].size;
+        const SampleType* history = &m_history[static_cast<size_t>(segment.channel) * m_historySize];
+        const long long start = (task - 1) * size;
+        for (int i = 0; i < 2 * size; ++i)
+            scratch.frame[i] = start + i < 0 ? SampleType(0) : history[(start + i) & (m_historySize - 1)];
+        scratch.fft.forward(scratch.frame.data(), re, im);
+    }
+
+    LinearPhaseKernels<SampleType>& m_kernels;
+    const std::vector<PartitionLevel> m_levels;
+    const int m_numChannels;
+    const int m_numLevels;
+    const int m_blockSize;
+
+    // Input history per channel; a power of two that still holds the
+    // oldest block a due segment reads
+    int m_historySize;
+    std::vector<SampleType> m_history;
+
+    std::unique_ptr<Segment[]> m_segments;      // channel-major
+    std::vector<long long> m_slack;             // per level, ns
+    std::vector<Scratch> m_workerScratch;
+    std::vector<Scratch> m_audioScratch;
+
+    unsigned m_epoch;                           // audio thread
+    std::atomic<long long> m_lastSubmission;
+    unsigned m_deadlineMisses;                  // audio thread
+};
+
+template <typename SampleType>
+class LinearPhaseFilter
+{
+public:
+    LinearPhaseFilter()
+    : m_numChannels(0)
+    , m_maxBlockSize(0)
+    , m_sampleRate(0.0)
+    , m_partitioning(kPartitioningNonUniform)
+    , m_kernelLength(0)
+    , m_partitionSize(0)
+    , m_numPartitions(0)
+    , m_firstBackgroundSize(0)
+    , m_numPeaks(0)
+    {
+    }
+
+    // Copies are planned or prepared the same way and start from the same
+    // kernel
+    LinearPhaseFilter(const LinearPhaseFilter& other)
+    : LinearPhaseFilter()
+    {
+        if (other.m_kernels) {
+            prepare(other.m_numChannels, other.m_maxBlockSize, other.m_sampleRate, nullptr, other.m_partitioning);
+            m_kernels->copyActive(*other.m_kernels);
+        }
+        else if (other.m_numChannels > 0) {
+            plan(other.m_numChannels, other.m_maxBlockSize, other.m_sampleRate, other.m_partitioning);
+        }
+    }
+
+    LinearPhaseFilter(LinearPhaseFilter&&) = default;
+    LinearPhaseFilter& operator=(LinearPhaseFilter&&) = default;
+
+    LinearPhaseFilter& operator=(const LinearPhaseFilter& other)
+    {
+        if (this != &other) {
+            LinearPhaseFilter copy(other);
+            *this = std::move(copy);
+        }
+        return *this;
+    }
+
+    // Only the layout for numChannels and the host's block size, so the
+    // latency is known; frees everything prepare() allocated. Not from the
+    // audio thread.
+    void plan(int numChannels, int maxBlockSize, double sampleRate, int partitioning = kPartitioningNonUniform)
+    {
+        release();
+
+        m_numChannels = numChannels;
+        m_maxBlockSize = maxBlockSize;
+        m_sampleRate = sampleRate;
+        m_partitioning = partitioning;
+
+        // An odd length of whole partitions around the middle tap
+        m_kernelLength = 2 * nextPowerOfTwo(int(sampleRate * kLinearPhaseHalfTime)) - 1;
+        m_partitionSize = kMinPartitionSize;
+        while (m_partitionSize < maxBlockSize && m_partitionSize < kMaxPartitionSize)
+            m_partitionSize *= 2;
+        m_firstBackgroundSize = nextPowerOfTwo(int(sampleRate * kMinBackgroundPartitionTime));
+        m_levels = planPartitions(m_kernelLength, m_partitionSize, m_firstBackgroundSize, partitioning);
+        m_numPartitions = m_levels[0].numPartitions;
+        m_numPeaks = (m_kernelLength + m_partitionSize - 1) / m_partitionSize + 2;
+    }
+
+    // Plans the layout, allocates everything for it and registers with the
+    // background thread, and designs the initial kernel when one is given
+    // (the kernel is silent otherwise). Call it from setupProcessing/
+    // Initialize, never from the audio thread.
+    void prepare(int numChannels, int maxBlockSize, double sampleRate, const LinearPhaseDesign* initialDesign,
+                 int partitioning = kPartitioningNonUniform)
+    {
+        plan(numChannels, maxBlockSize, sampleRate, partitioning);
+
+        // Every filter with this layout shares the silent kernel
+        const LinearPhaseDesign silent = { kSilentKernel, 0, 0, 0.0, 0.0, kDefaultQ, 0.0 };
+        const LinearPhaseKey key = getKernelKey(initialDesign ? *initialDesign : silent);
+        LinearPhaseKernels<SampleType>* kernels = new LinearPhaseKernels<SampleType>(
+            key, LinearPhaseKernelCache<SampleType>::get().acquire(key, &designLinearPhaseKernel<SampleType>));
+
+        const size_t numBins = static_cast<size_t>(m_partitionSize) + 1;
+        m_input.assign(static_cast<size_t>(numChannels) * 2 * m_partitionSize, SampleType(0));
+        m_output.assign(static_cast<size_t>(numChannels) * m_partitionSize, SampleType(0));
+        m_delayRe.assign(static_cast<size_t>(numChannels) * m_numPartitions * numBins, SampleType(0));
+        m_delayIm.assign(static_cast<size_t>(numChannels) * m_numPartitions * numBins, SampleType(0));
+        m_peaks.assign(static_cast<size_t>(numChannels) * m_numPeaks, SampleType(0));
+        m_position.assign(numChannels, 0);
+        m_delayIndex.assign(numChannels, 0);
+        m_blockStart.assign(numChannels, 0);
+        m_peakIndex.assign(numChannels, 0);
+        m_pendingPeak.assign(numChannels, SampleType(0));
+        m_channelSlot.assign(numChannels, 0);
+
+        m_fft.prepare(2 * m_partitionSize);
+        m_accRe.assign(numBins, SampleType(0));
+        m_accIm.assign(numBins, SampleType(0));
+        m_time.assign(2 * static_cast<size_t>(m_partitionSize), SampleType(0));
+        m_fadeTime.assign(2 * static_cast<size_t>(m_partitionSize), SampleType(0));
+
+        LinearPhaseWorker::get().add(kernels);
+        m_kernels.reset(kernels);
+        if (m_levels.size() > 1) {
+            LinearPhaseTails<SampleType>* tails = new LinearPhaseTails<SampleType>(*kernels, m_levels, numChannels, sampleRate);
+            LinearPhaseWorker::get().add(tails);
+            m_tails.reset(tails);
+        }
+    }
+
+    // Unregisters from the background thread and frees the buffers and the
+    // kernel; the layout stays planned. Not from the audio thread.
+    void release()
+    {
+        m_tails.reset();
+        m_kernels.reset();
+        std::vector<SampleType>().swap(m_input);
+        std::vector<SampleType>().swap(m_output);
+        std::vector<SampleType>().swap(m_delayRe);
+        std::vector<SampleType>().swap(m_delayIm);
+        std::vector<SampleType>().swap(m_peaks);
+        std::vector<int>().swap(m_position);
+        std::vector<int>().swap(m_delayIndex);
+        std::vector<long long>().swap(m_blockStart);
+        std::vector<int>().swap(m_peakIndex);
+        std::vector<SampleType>().swap(m_pendingPeak);
+        std::vector<int>().swap(m_channelSlot);
+        m_fft = RealFft<SampleType>();
+        std::vector<SampleType>().swap(m_accRe);
+        std::vector<SampleType>().swap(m_accIm);
+        std::vector<SampleType>().swap(m_time);
+        std::vector<SampleType>().swap(m_fadeTime);
+    }
+
+    bool isPrepared() const { return m_kernels != nullptr; }
+
+    // Audio thread: redesign the kernel for new parameters in the background
+    void requestDesign(const LinearPhaseDesign& design)
+    {
+        if (m_kernels)
+            m_kernels->request(design);
+    }
+
+    // True until the last requested kernel is playing on every channel
+    bool isDesignPending() const { return m_kernels && m_kernels->isPending(); }
+
+    int getLatency() const { return (m_kernelLength - 1) / 2 + m_partitionSize; }
+    int getTailSamples() const { return getLatency() + (m_kernelLength + 1) / 2; }
+    int getKernelLength() const { return m_kernelLength; }
+
+    // The shared-cache key of the kernel for design at this filter's layout
+    LinearPhaseKey getKernelKey(const LinearPhaseDesign& design) const
+    {
+        LinearPhaseKey key;
+        key.design = design;
+        key.kernelLength = m_kernelLength;
+        key.headSize = m_partitionSize;
+        key.firstBackgroundSize = m_firstBackgroundSize;
+        key.partitioning = m_partitioning;
+        return key;
+    }
+    int getPartitionSize() const { return m_partitionSize; }
+    const std::vector<PartitionLevel>& getPartitionLevels() const { return m_levels; }
+
+    // Background blocks the audio thread computed itself
+    unsigned getDeadlineMisses() const { return m_tails ? m_tails->getDeadlineMisses() : 0; }
+
+    // True when the worker has no submitted blocks left
+    bool isBackgroundIdle() const { return !m_tails || m_tails->isIdle(); }
+
+    void reset()
+    {
+        if (!m_kernels)
+            return;
+        std::fill(m_input.begin(), m_input.end(), SampleType(0));
+        std::fill(m_output.begin(), m_output.end(), SampleType(0));
+        std::fill(m_delayRe.begin(), m_delayRe.end(), SampleType(0));
+        std::fill(m_delayIm.begin(), m_delayIm.end(), SampleType(0));
+        std::fill(m_peaks.begin(), m_peaks.end(), SampleType(0));
+        std::fill(m_pendingPeak.begin(), m_pendingPeak.end(), SampleType(0));
+        std::fill(m_position.begin(), m_position.end(), 0);
+        std::fill(m_blockStart.begin(), m_blockStart.end(), 0);
+        for (int channel = 0; channel < m_numChannels; ++channel)
+            adoptKernel(channel);
+        if (m_tails)
+            m_tails->reset();
+    }
+
+    // True when every input sample that can still reach the output is
+    // below threshold
+    bool isDecayed(SampleType threshold) const
+    {
+        for (size_t channel = 0; channel < m_pendingPeak.size(); ++channel) {
+            if (m_pendingPeak[channel] >= threshold)
+                return false;
+        }
+        for (size_t i = 0; i < m_peaks.size(); ++i) {
+            if (m_peaks[i] >= threshold)
+                return false;
+        }
+        return true;
+    }
+
+    SampleType processSample(SampleType input, int channel)
+    {
+        SampleType* frame = &m_input[static_cast<size_t>(channel) * 2 * m_partitionSize];
+        const int position = m_position[channel];
+        const SampleType output = m_output[static_cast<size_t>(channel) * m_partitionSize + position];
+        frame[m_partitionSize + position] = input;
+        m_pendingPeak[channel] = std::max(m_pendingPeak[channel], std::fabs(input));
+        if (++m_position[channel] == m_partitionSize) {
+            m_position[channel] = 0;
+            processPartition(channel);
+        }
+        return output;
+    }
+
+    // Inputs and outputs may alias
+    void process(const SampleType* const* inputs, SampleType* const* outputs, int numChannels, int numSamples)
+    {
+        for (int channel = 0; channel < numChannels; ++channel) {
+            SampleType* frame = &m_input[static_cast<size_t>(channel) * 2 * m_partitionSize];
+            const SampleType* fifo = &m_output[static_cast<size_t>(channel) * m_partitionSize];
+            const SampleType* in = inputs[channel];
+            SampleType* out = outputs[channel];
+
+            int sample = 0;
+            while (sample < numSamples) {
+                const int position = m_position[channel];
+                const int chunk = std::min(m_partitionSize - position, numSamples - sample);
+
+                SampleType peak = m_pendingPeak[channel];
+                for (int i = 0; i < chunk; ++i)
+                    peak = std::max(peak, std::fabs(in[sample + i]));
+                m_pendingPeak[channel] = peak;
+
+                // Read the input before the output overwrites it
+                std::memcpy(frame + m_partitionSize + position, in + sample, sizeof(SampleType) * static_cast<size_t>(chunk));
+                std::memcpy(out + sample, fifo + position, sizeof(SampleType) * static_cast<size_t>(chunk));
+
+                sample += chunk;
+                m_position[channel] = position + chunk;
+                if (m_position[channel] == m_partitionSize) {
+                    m_position[channel] = 0;
+                    processPartition(channel);
+                }
+            }
+        }
+
+        // Channels that are not processed must not hold back a kernel switch
+        if (m_kernels->isSwitching()) {
+            for (int channel = numChannels; channel < m_numChannels; ++channel) {
+                adoptKernel(channel);
+                if (m_tails)
+                    m_tails->adopt(channel);
+            }
+        }
+    }
+
+private:
+    struct JobDeleter
+    {
+        void operator()(LinearPhaseJob* job) const
+        {
+            LinearPhaseWorker::get().remove(job);
+            delete job;
+        }
+    };
+
+    // One full block of a channel: transform it into the delay line,
+    // multiply-accumulate with the first level's partitions and transform
+    // back, then hand the block to the background levels and add their
+    // finished output
+    void processPartition(int channel)
+    {
+        LinearPhaseKernels<SampleType>& kernels = *m_kernels;
+        kernels.switchIfPublished(m_numChannels * static_cast<int>(m_levels.size()));
+
+        SampleType* frame = &m_input[static_cast<size_t>(channel) * 2 * m_partitionSize];
+        int& index = m_delayIndex[channel];
+        index = index == 0 ? m_numPartitions - 1 : index - 1;
+        m_fft.forward(frame, delayRe(channel, index), delayIm(channel, index));
+
+        // Peak of this block, for isDecayed()
+        int& peakIndex = m_peakIndex[channel];
+        m_peaks[static_cast<size_t>(channel) * m_numPeaks + peakIndex] = m_pendingPeak[channel];
+        peakIndex = peakIndex + 1 == m_numPeaks ? 0 : peakIndex + 1;
+        m_pendingPeak[channel] = SampleType(0);
+
+        const int active = kernels.getActive();
+        const int previous = m_channelSlot[channel];
+        SampleType* out = &m_output[static_cast<size_t>(channel) * m_partitionSize];
+
+        convolve(channel, index, active);
+        if (previous != active) {
+            // Crossfade from the previous kernel over this block
+            std::memcpy(m_fadeTime.data(), m_time.data(), sizeof(SampleType) * m_time.size());
+            convolve(channel, index, previous);
+            const SampleType step = SampleType(1) / SampleType(m_partitionSize);
+            for (int i = 0; i < m_partitionSize; ++i) {
+                const SampleType from = m_time[m_partitionSize + i];
+                out[i] = from + SampleType(i + 1) * step * (m_fadeTime[m_partitionSize + i] - from);
+            }
+            adoptKernel(channel);
+        }
+        else {
+            std::memcpy(out, m_time.data() + m_partitionSize, sizeof(SampleType) * static_cast<size_t>(m_partitionSize));
+        }
+
+        if (m_tails) {
+            const long long blockStart = m_blockStart[channel];
+            m_tails->write(channel, frame + m_partitionSize, blockStart);
+            m_tails->mix(channel, out, blockStart);
+            m_blockStart[channel] = blockStart + m_partitionSize;
+        }
+
+        // This block is the first half of the next frame
+        std::memcpy(frame, frame + m_partitionSize, sizeof(SampleType) * static_cast<size_t>(m_partitionSize));
+    }
+
+    // m_time = IFFT of the first level for the kernel in slot
+    void convolve(int channel, int newest, int slot)
+    {
+        multiplyAccumulateSpectra(delayRe(channel, 0), delayIm(channel, 0), newest,
+                                  m_kernels->getRe(slot), m_kernels->getIm(slot), m_numPartitions,
+                                  m_partitionSize + 1, m_accRe.data(), m_accIm.data());
+        m_fft.inverse(m_accRe.data(), m_accIm.data(), m_time.data());
+    }
+
+    void adoptKernel(int channel)
+    {
+        const int active = m_kernels->getActive();
+        if (m_channelSlot[channel] != active) {
+            m_channelSlot[channel] = active;
+            m_kernels->adopt();
+        }
+    }
+
+    SampleType* delayRe(int channel, int index)
+    {
+        return &m_delayRe[(static_cast<size_t>(channel) * m_numPartitions + index) * (m_partitionSize + 1)];
+    }
+
+    SampleType* delayIm(int channel, int index)
+    {
+        return &m_delayIm[(static_cast<size_t>(channel) * m_numPartitions + index) * (m_partitionSize + 1)];
+    }
+
+    int m_numChannels;
+    int m_maxBlockSize;
+    double m_sampleRate;
+    int m_partitioning;
+    int m_kernelLength;
+    int m_partitionSize;    // first level
+    int m_numPartitions;    // first level
+    int m_firstBackgroundSize;
+    int m_numPeaks;
+    std::vector<PartitionLevel> m_levels;
+
+    // Per channel: [previous block | block being filled], the output of the
+    // last block, and the first level's frequency-domain delay line (newest
+    // at m_delayIndex)
+    std::vector<SampleType> m_input;
+    std::vector<SampleType> m_output;
+    std::vector<SampleType> m_delayRe;
+    std::vector<SampleType> m_delayIm;
+    std::vector<int> m_position;
+    std::vector<int> m_delayIndex;
+    std::vector<long long> m_blockStart;    // input sample of the block being filled
+
+    // Input peaks of the blocks that still reach the output
+    std::vector<SampleType> m_peaks;
+    std::vector<int> m_peakIndex;
+    std::vector<SampleType> m_pendingPeak;
+
+    // Kernel slot each channel's first level plays; differs from the
+    // active slot until the channel has crossfaded
+    std::vector<int> m_channelSlot;
+
+    RealFft<SampleType> m_fft;
+    std::vector<SampleType> m_accRe;
+    std::vector<SampleType> m_accIm;
+    std::vector<SampleType> m_time;
+    std::vector<SampleType> m_fadeTime;
+
+    // The tails refer to the kernels; declared after them so they are
+    // destroyed first
+    std::unique_ptr<LinearPhaseKernels<SampleType>, JobDeleter> m_kernels;
+    std::unique_ptr<LinearPhaseTails<SampleType>, JobDeleter> m_tails;
+};
+
+} // namespace FilterDSP
@@ -0,0 +1,336 @@
+#pragma once
+
+// 2x/4x/8x oversampling as a cascade of polyphase half-band FIR stages.
+// A half-band filter has every other tap zero apart from the centre, so per
+// 2x stage each output needs only the symmetric side taps:
+//
+//   up:   y[2n]   = 2·Σ g_j·(x[n-(m-1-j)] + x[n-(m+j)])
+//         y[2n+1] = x[n-(m-1)]
+//   down: w[n]    = Σ g_j·(e[n-(m-1-j)] + e[n-(m+j)]) + ½·o[n-m]
+//                   (e, o = even and odd samples of the high-rate signal)
+//
+// The sums are evaluated for several consecutive samples at once in SIMD
+// lanes (along time, so mono signals use every lane too). The first stage
+// has the narrowest transition band; later stages only have to reject
+// images above the original band and use fewer taps.
+//
+// A stage's round trip is 2m - 1 samples at its input rate, an odd number,
+// so on its own each later stage would delay by a fraction of a base-rate
+// sample. Those stages also delay their input by a few samples, so every
+// factor has a whole-sample latency that the dry signal can match exactly.
+//
+// Buffers are sized for 8x and one channel layout in prepare(); changing
+// the factor afterwards does not allocate.
+
+#include "SimdOps.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace FilterDSP {
+
+// Largest factor, as a power of two (8x)
+static const int kMaxOversamplingStages = 3;
+
+// Base-rate samples processed per pass through the stages
+static const int kOversamplingChunk = 256;
+
+// Symmetric side-tap pairs (m) and Kaiser β of the half-band stages
+static const int kFirstStagePairs = 16;     // 63 taps, ~90 dB, flat to 0.8·Nyquist
+static const int kLaterStagePairs = 8;      // 31 taps
+static const double kHalfbandKaiserBeta = 9.0;
+
+constexpr int getStagePairs(int stage) { return stage == 0 ? kFirstStagePairs : kLaterStagePairs; }
+
+// Input-rate samples of pure delay that round stage's 2m - 1 sample round
+// trip up to a multiple of its 2^stage samples per base-rate sample
+constexpr int getStagePadding(int stage)
+{
+    return ((1 << stage) - (2 * getStagePairs(stage) - 1) % (1 << stage)) % (1 << stage);
+}
+
+// Round trip of a stage, padding included, in base-rate samples
+constexpr int getStageLatency(int stage) { return (2 * getStagePairs(stage) - 1 + getStagePadding(stage)) >> stage; }
+
+static_assert((2 * getStagePairs(1) - 1 + getStagePadding(1)) % 2 == 0
+              && (2 * getStagePairs(2) - 1 + getStagePadding(2)) % 4 == 0,
+              "oversampling stages must delay by whole base-rate samples");
+
+// Oversampling factors (kOversamplingId / kParam_Oversampling)
+enum OversamplingFactor
+{
+    kOversampling1x = 0,
+    kOversampling2x = 1,
+    kOversampling4x = 2,
+    kOversampling8x = 3,
+    kNumOversamplingFactors = 4
+};
+
+// Zeroth-order modified Bessel function (Kaiser window)
+inline double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// y[i] = Σ_j c[j]·(x[i-(m-1-j)] + x[i-(m+j)]) for 0 <= i < n; x must be
+// readable from x - (2m-1). The tap count is a template parameter so the
+// inner loop is fully unrolled.
+template <int NumPairs, typename SampleType>
+inline void processSymmetricFir(const SampleType* c, const SampleType* x, SampleType* y, int n)
+{
+    const int numPairs = NumPairs;
+    typedef typename SimdTraits<SampleType>::Wide Vector;
+    const int width = Vector::kWidth;
+
+    int i = 0;
+    for (; i + width <= n; i += width) {
+        Vector acc = Vector::broadcast(SampleType(0));
+        for (int j = 0; j < numPairs; ++j)
+            acc = acc + Vector::broadcast(c[j]) * (Vector::loadu(x + i - (numPairs - 1 - j)) + Vector::loadu(x + i - (numPairs + j)));
+        acc.storeu(y + i);
+    }
+    for (; i < n; ++i) {
+        SampleType acc = SampleType(0);
+        for (int j = 0; j < numPairs; ++j)
+            acc += c[j] * (x[i - (numPairs - 1 - j)] + x[i - (numPairs + j)]);
+        y[i] = acc;
+    }
+}
+
+// Stages are designed with kFirstStagePairs or kLaterStagePairs
+template <typename SampleType>
+inline void processSymmetricFir(const SampleType* c, int numPairs, const SampleType* x, SampleType* y, int n)
+{
+    if (numPairs == kFirstStagePairs)
+        processSymmetricFir<kFirstStagePairs>(c, x, y, n);
+    else
+        processSymmetricFir<kLaterStagePairs>(c, x, y, n);
+}
+
+// One 2x up/down stage for every channel
+template <typename SampleType>
+class HalfbandStage
+{
+public:
+    HalfbandStage() : m_numPairs(0), m_padding(0), m_numChannels(0) {}
+
+    // Kaiser-windowed half-band design with numPairs side-tap pairs
+    // (4·numPairs - 1 taps), normalized to unity gain at DC, after padding
+    // samples of pure delay on the input
+    void design(int numPairs, int padding)
+    {
+        m_numPairs = numPairs;
+        m_padding = padding;
+        m_coeffs.assign(numPairs, SampleType(0));
+        m_upCoeffs.assign(numPairs, SampleType(0));
+
+        const double pi = 3.14159265358979323846;
+        const double centre = 2.0 * numPairs - 1.0;
+        std::vector<double> taps(numPairs);
+        double sum = 0.0;
+        for (int j = 0; j < numPairs; ++j) {
+            const double offset = 2.0 * (numPairs - 1 - j) + 1.0;    // j = numPairs-1 is next to the centre
+            const double ratio = offset / centre;
+            const double window = besselI0(kHalfbandKaiserBeta * std::sqrt(std::max(0.0, 1.0 - ratio * ratio)))
+                                / besselI0(kHalfbandKaiserBeta);
+            const double sign = ((numPairs - 1 - j) % 2 == 0) ? 1.0 : -1.0;
+            taps[j] = sign * window / (pi * offset);
+            sum += taps[j];
+        }
+        for (int j = 0; j < numPairs; ++j) {
+            // Side taps sum to ¼ (the centre tap is ½)
+            m_coeffs[numPairs - 1 - j] = SampleType(0.25 * taps[j] / sum);
+            m_upCoeffs[numPairs - 1 - j] = SampleType(0.5 * taps[j] / sum);
+        }
+    }
+
+    void prepare(int numChannels, int maxInputSamples)
+    {
+        m_numChannels = numChannels;
+        m_upHistory.assign(static_cast<size_t>(numChannels) * getInputHistory(), SampleType(0));
+        m_evenHistory.assign(static_cast<size_t>(numChannels) * getUpHistory(), SampleType(0));
+        m_oddHistory.assign(static_cast<size_t>(numChannels) * m_numPairs, SampleType(0));
+        m_scratch.assign(2 * (static_cast<size_t>(getInputHistory()) + maxInputSamples), SampleType(0));
+        m_scratchOut.assign(maxInputSamples, SampleType(0));
+    }
+
+    void reset()
+    {
+        std::fill(m_upHistory.begin(), m_upHistory.end(), SampleType(0));
+        std::fill(m_evenHistory.begin(), m_evenHistory.end(), SampleType(0));
+        std::fill(m_oddHistory.begin(), m_oddHistory.end(), SampleType(0));
+    }
+
+    // Largest magnitude held in the channel histories
+    SampleType getPeak() const
+    {
+        SampleType peak = SampleType(0);
+        for (size_t i = 0; i < m_upHistory.size(); ++i)
+            peak = std::max(peak, std::fabs(m_upHistory[i]));
+        for (size_t i = 0; i < m_evenHistory.size(); ++i)
+            peak = std::max(peak, std::fabs(m_evenHistory[i]));
+        for (size_t i = 0; i < m_oddHistory.size(); ++i)
+            peak = std::max(peak, std::fabs(m_oddHistory[i]));
+        return peak;
+    }
+
+    // Round-trip delay in samples at this stage's output (high) rate
+    int getDelay() const { return 2 * (2 * m_numPairs - 1 + m_padding); }
+
+    // n input samples -> 2n output samples
+    void upsample(int channel, const SampleType* input, SampleType* output, int n)
+    {
+        const int history = getInputHistory();
+        SampleType* stored = &m_upHistory[static_cast<size_t>(channel) * history];
+        SampleType* x = m_scratch.data() + history;
+        std::memcpy(m_scratch.data(), stored, sizeof(SampleType) * history);
+        std::memcpy(x, input, sizeof(SampleType) * n);
+
+        // The padding delays the input before the filter
+        const SampleType* delayed = x - m_padding;
+        SampleType* even = m_scratchOut.data();
+        processSymmetricFir(m_upCoeffs.data(), m_numPairs, delayed, even, n);
+        const SampleType* odd = delayed - (m_numPairs - 1);
+        for (int i = 0; i < n; ++i) {
+            output[2 * i] = even[i];
+            output[2 * i + 1] = odd[i];
+        }
+
+        std::memcpy(stored, m_scratch.data() + n, sizeof(SampleType) * history);
+    }
+
+    // 2n input samples -> n output samples
+    void downsample(int channel, const SampleType* input, SampleType* output, int n)
+    {
+        const int evenHistory = getUpHistory();
+        const int oddHistory = m_numPairs;
+        SampleType* storedEven = &m_evenHistory[static_cast<size_t>(channel) * evenHistory];
+        SampleType* storedOdd = &m_oddHistory[static_cast<size_t>(channel) * oddHistory];
+
+        SampleType* even = m_scratch.data() + evenHistory;
+        SampleType* odd = even + n + oddHistory;
+        std::memcpy(even - evenHistory, storedEven, sizeof(SampleType) * evenHistory);
+        std::memcpy(odd - oddHistory, storedOdd, sizeof(SampleType) * oddHistory);
+        for (int i = 0; i < n; ++i) {
+            even[i] = input[2 * i];
+            odd[i] = input[2 * i + 1];
+        }
+
+        processSymmetricFir(m_coeffs.data(), m_numPairs, even, output, n);
+        const SampleType half = SampleType(0.5);
+        for (int i = 0; i < n; ++i)
+            output[i] += half * odd[i - m_numPairs];
+
+        std::memcpy(storedEven, even + n - evenHistory, sizeof(SampleType) * evenHistory);
+        std::memcpy(storedOdd, odd + n - oddHistory, sizeof(SampleType) * oddHistory);
+    }
+
+private:
+    int getUpHistory() const { return 2 * m_numPairs - 1; }
+    int getInputHistory() const { return getUpHistory() + m_padding; }
+
+    int m_numPairs;
+    int m_padding;          // input samples of pure delay
+    int m_numChannels;
+    std::vector<SampleType> m_coeffs;       // g_j
+    std::vector<SampleType> m_upCoeffs;     // 2·g_j (upsampling gain)
+
+    // Per-channel filter histories
+    std::vector<SampleType> m_upHistory;
+    std::vector<SampleType> m_evenHistory;
+    std::vector<SampleType> m_oddHistory;
+
+    // [history | input] work areas shared by all channels
+    std::vector<SampleType> m_scratch;
+    std::vector<SampleType> m_scratchOut;
+};
+
+template <typename SampleType>
+class Oversampler
+{
+public:
+    Oversampler()
+    : m_numChannels(0)
+    {
+        for (int stage = 0; stage < kMaxOversamplingStages; ++stage)
+            m_stages[stage].design(getStagePairs(stage), getStagePadding(stage));
+    }
+
+    // Allocates the stage buffers for numChannels at up to 8x
+    void prepare(int numChannels)
+    {
+        m_numChannels = numChannels;
+        for (int stage = 0; stage < kMaxOversamplingStages; ++stage) {
+            m_stages[stage].prepare(numChannels, kOversamplingChunk << (stage + 1));
+            m_buffers[stage].assign(static_cast<size_t>(numChannels) * (kOversamplingChunk << (stage + 1)), SampleType(0));
+        }
+    }
+
+    void reset()
+    {
+        for (int stage = 0; stage < kMaxOversamplingStages; ++stage)
+            m_stages[stage].reset();
+    }
+
+    SampleType getPeak() const
+    {
+        SampleType peak = SampleType(0);
+        for (int stage = 0; stage < kMaxOversamplingStages; ++stage)
+            peak = std::max(peak, m_stages[stage].getPeak());
+        return peak;
+    }
+
+    // Round-trip latency at the base rate for 2^numStages oversampling;
+    // exact, the stages are padded to whole samples
+    static int getLatency(int numStages)
+    {
+        int latency = 0;
+        for (int stage = 0; stage < numStages; ++stage)
+            latency += getStageLatency(stage);
+        return latency;
+    }
+
+    // Upsample up to kOversamplingChunk samples of one channel by
+    // 2^numStages and return the high-rate buffer of that channel
+    SampleType* upsample(int channel, const SampleType* input, int numSamples, int numStages)
+    {
+        const SampleType* source = input;
+        for (int stage = 0; stage < numStages; ++stage) {
+            SampleType* target = getBuffer(stage, channel);
+            m_stages[stage].upsample(channel, source, target, numSamples << stage);
+            source = target;
+        }
+        return getBuffer(numStages - 1, channel);
+    }
+
+    // Inverse of upsample: the channel's high-rate buffer back to output
+    void downsample(int channel, SampleType* output, int numSamples, int numStages)
+    {
+        for (int stage = numStages - 1; stage >= 0; --stage) {
+            SampleType* target = stage == 0 ? output : getBuffer(stage - 1, channel);
+            m_stages[stage].downsample(channel, getBuffer(stage, channel), target, numSamples << stage);
+        }
+    }
+
+private:
+    SampleType* getBuffer(int stage, int channel)
+    {
+        return m_buffers[stage].data() + static_cast<size_t>(channel) * (kOversamplingChunk << (stage + 1));
+    }
+
+    int m_numChannels;
+    HalfbandStage<SampleType> m_stages[kMaxOversamplingStages];
+
+    // Per-channel signal at 2x, 4x and 8x
+    std::vector<SampleType> m_buffers[kMaxOversamplingStages];
+};
+
+} // namespace FilterDSP
@@ -0,0 +1,494 @@
+#pragma once
+
+// Parallel evaluation of the recursive filters over long blocks, for
+// offline rendering.
+//
+// With fixed coefficients every filter structure is linear in its input
+// and its state, so a block can be cut into chunks that run at the same
+// time. Chunk 0 starts from the real filter memory; every later chunk
+// runs the same serial kernel from zero state. The missing part of each
+// chunk's output is the filter's response to the state the chunk really
+// starts from, Σ_j s_j·r_j[n], where r_j is the response to a unit value in
+// state row j with no input. The start states are carried from chunk to
+// chunk on the calling thread (s' = z + F·s, with z the chunk's own final
+// state and F the final states of the r_j). A fix-up pass then adds the
+// responses to each chunk, SIMD along time.
+//
+// The basis responses depend only on the coefficients and the chunk
+// length, so they are kept while both stay the same (offline renders of
+// static settings compute them once). The chunks and the basis responses
+// run on ScanWorkers, a process-wide pool with one thread per extra core,
+// and on the calling thread. The result matches the serial kernel to
+// rounding (see tests/ParallelScanTests.cpp).
+
+#include "DenormalGuard.h"
+#include "SimdOps.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace FilterDSP {
+
+// Shortest block worth splitting, and shortest chunk
+static const int kMinParallelBlockSize = 16384;
+static const int kMinScanChunk = 4096;
+
+// Most chunks per block
+static const int kMaxScanChunks = 16;
+
+// Threads for the parallel chunks: the caller plus one worker per extra
+// core. The workers run while at least one filter is prepared for
+// parallel processing; addUser/removeUser lock and must not be called from
+// the audio thread.
+class ScanWorkers
+{
+public:
+    static ScanWorkers& get()
+    {
+        static ScanWorkers workers;
+        return workers;
+    }
+
+    void addUser()
+    {
+        std::lock_guard<std::mutex> lifecycle(m_lifecycleMutex);
+        if (m_numUsers++ == 0)
+            start();
+    }
+
+    void removeUser()
+    {
+        std::lock_guard<std::mutex> lifecycle(m_lifecycleMutex);
+        if (--m_numUsers == 0)
+            stop();
+    }
+
+    // Threads a run uses, the caller included
+    int getNumThreads() const { return m_numThreads.load(); }
+
+    // 1 for serial processing; 0 for one per core. Restarts the workers,
+    // for tests and benchmarks.
+    void setNumThreads(int numThreads)
+    {
+        std::lock_guard<std::mutex> lifecycle(m_lifecycleMutex);
+        std::lock_guard<std::mutex> reservation(m_runMutex);
+        m_requestedThreads = numThreads;
+        if (m_numUsers > 0) {
+            stop();
+            start();
+        }
+    }
+
+    // The workers for a sequence of run() calls; the lock is not owned
+    // while another filter has them
+    std::unique_lock<std::mutex> tryReserve() { return std::unique_lock<std::mutex>(m_runMutex, std::try_to_lock); }
+
+    // Runs task(context, i) for every i in [0, numTasks) on the workers and
+    // the calling thread, and returns when all are done. The caller holds
+    // a reservation.
+    void run(int numTasks, void (*task)(void*, int), void* context)
+    {
+        {
+            // A worker still leaving the previous run must not take a
+            // task of this one
+            std::lock_guard<std::mutex> lock(m_mutex);
+            while (m_busyWorkers.load() != 0)
+                std::this_thread::yield();
+            m_task = task;
+            m_context = context;
+            m_numTasks = numTasks;
+            m_next.store(0);
+            m_done.store(0);
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        execute(task, context, numTasks);
+        while (m_done.load(std::memory_order_acquire) < numTasks)
+            std::this_thread::yield();
+    }
+
+private:
+    ScanWorkers()
+    : m_numUsers(0)
+    , m_requestedThreads(0)
+    , m_numThreads(1)
+    , m_stop(false)
+    , m_generation(0)
+    , m_task(nullptr)
+    , m_context(nullptr)
+    , m_numTasks(0)
+    , m_next(0)
+    , m_done(0)
+    , m_busyWorkers(0)
+    {
+    }
+
+    ~ScanWorkers() { stop(); }
+
+    void start()
+    {
+        int numThreads = m_requestedThreads > 0 ? m_requestedThreads : static_cast<int>(std::thread::hardware_concurrency());
+        numThreads = std::max(1, std::min(numThreads, kMaxScanChunks));
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = false;
+        }
+        for (int i = 1; i < numThreads; ++i)
+            m_threads.emplace_back(&ScanWorkers::work, this);
+        m_numThreads.store(numThreads);
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (size_t i = 0; i < m_threads.size(); ++i)
+            m_threads[i].join();
+        m_threads.clear();
+        m_numThreads.store(1);
+    }
+
+    void execute(void (*task)(void*, int), void* context, int numTasks)
+    {
+        for (;;) {
+            const int index = m_next.fetch_add(1);
+            if (index >= numTasks)
+                return;
+            task(context, index);
+            m_done.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    void work()
+    {
+        // The kernels expect the audio callback's floating-point mode
+        ScopedNoDenormals noDenormals;
+        unsigned seen = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            seen = m_generation;
+        }
+        for (;;) {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop)
+                return;
+            seen = m_generation;
+            void (*task)(void*, int) = m_task;
+            void* context = m_context;
+            const int numTasks = m_numTasks;
+            m_busyWorkers.fetch_add(1);
+            lock.unlock();
+
+            execute(task, context, numTasks);
+            m_busyWorkers.fetch_sub(1);
+        }
+    }
+
+    std::mutex m_lifecycleMutex;
+    int m_numUsers;
+    int m_requestedThreads;
+    std::atomic<int> m_numThreads;
+    std::vector<std::thread> m_threads;
+
+    std::mutex m_runMutex;              // one run at a time
+    std::mutex m_mutex;                 // the fields below, for the workers
+    std::condition_variable m_wake;
+    bool m_stop;
+    unsigned m_generation;
+    void (*m_task)(void*, int);
+    void* m_context;
+    int m_numTasks;
+
+    std::atomic<int> m_next;
+    std::atomic<int> m_done;
+    std::atomic<int> m_busyWorkers;
+};
+
+// Chunked processing for one engine. The filter memory is laid out like
+// FilterState: rows of stride values, one per channel.
+template <typename SampleType>
+class ParallelScan
+{
+public:
+    ParallelScan()
+    : m_numChannels(0)
+    , m_maxBlockSize(0)
+    , m_numRows(0)
+    , m_registered(false)
+    , m_basisVariant(-1)
+    , m_basisLength(0)
+    {
+    }
+
+    ParallelScan(const ParallelScan& other)
+    : ParallelScan()
+    {
+        prepare(other.m_numChannels, other.m_maxBlockSize, other.m_numRows);
+    }
+
+    ParallelScan(ParallelScan&& other)
+    : ParallelScan()
+    {
+        swap(other);
+    }
+
+    ParallelScan& operator=(ParallelScan other)
+    {
+        swap(other);
+        return *this;
+    }
+
+    ~ParallelScan() { prepare(0, 0, 0); }
+
+    // Allocates for blocks of up to maxBlockSize samples on a filter memory
+    // of numRows rows of numChannels; numChannels 0 releases everything.
+    // Not on the audio thread.
+    void prepare(int numChannels, int maxBlockSize, int numRows)
+    {
+        const bool enable = numChannels > 0 && maxBlockSize >= kMinParallelBlockSize;
+        if (enable && !m_registered)
+            ScanWorkers::get().addUser();
+        else if (!enable && m_registered)
+            ScanWorkers::get().removeUser();
+        m_registered = enable;
+
+        m_numChannels = enable ? numChannels : 0;
+        m_maxBlockSize = enable ? maxBlockSize : 0;
+        m_numRows = enable ? numRows : 0;
+        const size_t memorySize = static_cast<size_t>(m_numRows) * m_numChannels;
+        const size_t maxChunk = static_cast<size_t>(m_maxBlockSize) / 2;
+        m_chunkMemory.assign(kMaxScanChunks * memorySize, SampleType(0));
+        m_carry.assign(kMaxScanChunks * memorySize, SampleType(0));
+        m_basis.assign(static_cast<size_t>(m_numRows) * maxChunk, SampleType(0));
+        m_basisMemory.assign(static_cast<size_t>(m_numRows) * m_numRows, SampleType(0));
+        m_zeros.assign(maxChunk, SampleType(0));
+        m_chunkInputs.assign(kMaxScanChunks * static_cast<size_t>(m_numChannels), nullptr);
+        m_chunkOutputs.assign(kMaxScanChunks * static_cast<size_t>(m_numChannels), nullptr);
+        m_basisVariant = -1;
+        m_basisLength = 0;
+    }
+
+    bool isPrepared() const { return m_numChannels > 0; }
+
+    // Processes a block with run(inputs, outputs, numChannels, numSamples,
+    // memory, stride), the serial kernel on a filter memory that uses rows
+    // [firstRow, firstRow + numRows). variant and the coefficient bytes
+    // identify the filter, for the cached basis responses. False, with
+    // nothing processed, when the block is too short or the workers are
+    // busy with another filter.
+    template <typename Run>
+    bool process(const Run& run, int variant, const void* coefficients, size_t coefficientBytes,
+                 int firstRow, int numRows, const SampleType* const* inputs, SampleType* const* outputs,
+                 int numChannels, int numSamples, SampleType* memory, int stride)
+    {
+        const int numChunks = std::min(std::min(kMaxScanChunks, ScanWorkers::get().getNumThreads()),
+                                       numSamples / kMinScanChunk);
+        if (numChunks < 2 || numSamples > m_maxBlockSize || stride > m_numChannels
+            || firstRow + numRows > m_numRows)
+            return false;
+
+        Job<Run> job;
+        job.scan = this;
+        job.run = &run;
+        job.firstRow = firstRow;
+        job.numRows = numRows;
+        job.inputs = inputs;
+        job.outputs = outputs;
+        job.numChannels = numChannels;
+        job.memory = memory;
+        job.stride = stride;
+        job.numChunks = numChunks;
+        job.chunkLength = numSamples / numChunks;
+        job.firstLength = numSamples - (numChunks - 1) * job.chunkLength;
+
+        // The basis responses are kept while the filter and chunk length stay
+        job.numBasis = 0;
+        const unsigned char* bytes = static_cast<const unsigned char*>(coefficients);
+        if (variant != m_basisVariant || job.chunkLength != m_basisLength
+            || m_basisKey.size() != coefficientBytes || !std::equal(bytes, bytes + coefficientBytes, m_basisKey.begin())) {
+            job.numBasis = numRows;
+            m_basisVariant = -1;
+        }
+
+        ScanWorkers& workers = ScanWorkers::get();
+        const std::unique_lock<std::mutex> reservation = workers.tryReserve();
+        if (!reservation.owns_lock())
+            return false;
+        workers.run(numChunks + job.numBasis, &runChunkOrBasis<Run>, &job);
+        if (job.numBasis > 0) {
+            m_basisVariant = variant;
+            m_basisLength = job.chunkLength;
+            m_basisKey.assign(bytes, bytes + coefficientBytes);
+        }
+
+        carry(job);
+        workers.run(numChunks - 1, &fixUp<Run>, &job);
+        return true;
+    }
+
+private:
+    template <typename Run>
+    struct Job
+    {
+        ParallelScan* scan;
+        const Run* run;
+        int firstRow;
+        int numRows;
+        const SampleType* const* inputs;
+        SampleType* const* outputs;
+        int numChannels;
+        SampleType* memory;
+        int stride;
+        int numChunks;
+        int chunkLength;
+        int firstLength;        // chunk 0 also takes the remainder
+        int numBasis;
+
+        int getStart(int chunk) const { return chunk == 0 ? 0 : firstLength + (chunk - 1) * chunkLength; }
+    };
+
+    SampleType* chunkMemory(int chunk) { return &m_chunkMemory[static_cast<size_t>(chunk) * m_numRows * m_numChannels]; }
+    SampleType* carryState(int chunk) { return &m_carry[static_cast<size_t>(chunk) * m_numRows * m_numChannels]; }
+    SampleType* basisResponse(int row) { return &m_basis[static_cast<size_t>(row) * m_zeros.size()]; }
+
+    // Phase 1: chunk c from zero state (chunk 0 from the filter memory), or
+    // the basis response of one state row
+    template <typename Run>
+    static void runChunkOrBasis(void* context, int index)
+    {
+        Job<Run>& job = *static_cast<Job<Run>*>(context);
+        ParallelScan& scan = *job.scan;
+        if (index >= job.numChunks) {
+            const int row = job.firstRow + index - job.numChunks;
+            SampleType* memory = &scan.m_basisMemory[static_cast<size_t>(row) * scan.m_numRows];
+            std::fill(memory, memory + scan.m_numRows, SampleType(0));
+            memory[row] = SampleType(1);
+            const SampleType* in = scan.m_zeros.data();
+            SampleType* out = scan.basisResponse(row);
+            (*job.run)(&in, &out, 1, job.chunkLength, memory, 1);
+            return;
+        }
+
+        const int chunk = index;
+        const int stride = job.stride;
+        SampleType* memory = scan.chunkMemory(chunk);
+        SampleType* rows = memory + static_cast<size_t>(job.firstRow) * stride;
+        const size_t used = static_cast<size_t>(job.numRows) * stride;
+        if (chunk == 0)
+            std::memcpy(rows, job.memory + static_cast<size_t>(job.firstRow) * stride, sizeof(SampleType) * used);
+        else
+            std::fill(rows, rows + used, SampleType(0));
+
+        const int start = job.getStart(chunk);
+        const SampleType** in = &scan.m_chunkInputs[static_cast<size_t>(chunk) * scan.m_numChannels];
+        SampleType** out = &scan.m_chunkOutputs[static_cast<size_t>(chunk) * scan.m_numChannels];
+        for (int channel = 0; channel < job.numChannels; ++channel) {
+            in[channel] = job.inputs[channel] + start;
+            out[channel] = job.outputs[channel] + start;
+        }
+        (*job.run)(in, out, job.numChannels, chunk == 0 ? job.firstLength : job.chunkLength, memory, stride);
+    }
+
+    // Phase 2, on the calling thread: the state each chunk really starts
+    // from, and the filter memory after the block
+    template <typename Run>
+    void carry(const Job<Run>& job)
+    {
+        const int stride = job.stride;
+        const size_t offset = static_cast<size_t>(job.firstRow) * stride;
+        const size_t used = static_cast<size_t>(job.numRows) * stride;
+        std::memcpy(carryState(1) + offset, chunkMemory(0) + offset, sizeof(SampleType) * used);
+
+        for (int chunk = 1; chunk < job.numChunks; ++chunk) {
+            const SampleType* start = carryState(chunk) + offset;
+            SampleType* next = chunk + 1 < job.numChunks ? carryState(chunk + 1) + offset : job.memory + offset;
+            const SampleType* own = chunkMemory(chunk) + offset;
+            for (int i = 0; i < job.numRows; ++i) {
+                for (int channel = 0; channel < job.numChannels; ++channel) {
+                    SampleType value = own[static_cast<size_t>(i) * stride + channel];
+                    for (int j = 0; j < job.numRows; ++j) {
+                        const SampleType* final = &m_basisMemory[static_cast<size_t>(job.firstRow + j) * m_numRows + job.firstRow];
+                        value += start[static_cast<size_t>(j) * stride + channel] * final[i];
+                    }
+                    next[static_cast<size_t>(i) * stride + channel] = value;
+                }
+            }
+        }
+    }
+
+    // Phase 3: adds the response to the carried state to chunk index + 1
+    template <typename Run>
+    static void fixUp(void* context, int index)
+    {
+        typedef typename SimdTraits<SampleType>::Wide Vector;
+        const int width = Vector::kWidth;
+        Job<Run>& job = *static_cast<Job<Run>*>(context);
+        ParallelScan& scan = *job.scan;
+        const int chunk = index + 1;
+        const int start = job.getStart(chunk);
+        const SampleType* state = scan.carryState(chunk) + static_cast<size_t>(job.firstRow) * job.stride;
+
+        for (int channel = 0; channel < job.numChannels; ++channel) {
+            SampleType* out = job.outputs[channel] + start;
+            for (int j = 0; j < job.numRows; ++j) {
+                const SampleType s = state[static_cast<size_t>(j) * job.stride + channel];
+                if (s == SampleType(0))
+                    continue;
+                const SampleType* response = scan.basisResponse(job.firstRow + j);
+                const Vector scale = Vector::broadcast(s);
+                int n = 0;
+                for (; n + width <= job.chunkLength; n += width)
+                    (Vector::loadu(out + n) + scale * Vector::loadu(response + n)).storeu(out + n);
+                for (; n < job.chunkLength; ++n)
+                    out[n] += s * response[n];
+            }
+        }
+    }
+
+    void swap(ParallelScan& other)
+    {
+        std::swap(m_numChannels, other.m_numChannels);
+        std::swap(m_maxBlockSize, other.m_maxBlockSize);
+        std::swap(m_numRows, other.m_numRows);
+        std::swap(m_registered, other.m_registered);
+        m_chunkMemory.swap(other.m_chunkMemory);
+        m_carry.swap(other.m_carry);
+        m_basis.swap(other.m_basis);
+        m_basisMemory.swap(other.m_basisMemory);
+        m_zeros.swap(other.m_zeros);
+        m_chunkInputs.swap(other.m_chunkInputs);
+        m_chunkOutputs.swap(other.m_chunkOutputs);
+        std::swap(m_basisVariant, other.m_basisVariant);
+        std::swap(m_basisLength, other.m_basisLength);
+        m_basisKey.swap(other.m_basisKey);
+    }
+
+    int m_numChannels;                      // filter memory stride
+    int m_maxBlockSize;
+    int m_numRows;
+    bool m_registered;                      // a ScanWorkers user
+
+    std::vector<SampleType> m_chunkMemory;  // per chunk: rows × channels
+    std::vector<SampleType> m_carry;        // per chunk: true start state
+    std::vector<SampleType> m_basis;        // per row: response to a unit state
+    std::vector<SampleType> m_basisMemory;  // per row: final state of the response
+    std::vector<SampleType> m_zeros;
+    std::vector<const SampleType*> m_chunkInputs;   // per chunk: channel pointers
+    std::vector<SampleType*> m_chunkOutputs;
+
+    int m_basisVariant;                     // -1 while the basis is not valid
+    int m_basisLength;
+    std::vector<unsigned char> m_basisKey;
+};
+
+} // namespace FilterDSP
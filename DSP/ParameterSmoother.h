@@ -0,0 +1,81 @@
+#pragma once
+
+// Linear ramp for control values (cutoff, gain, ...).
+// The increment is computed once when a new target arrives; processing code
+// asks how many samples of the current block are still ramping and skips all
+// smoothing work once the target has been reached.
+
+namespace FilterDSP {
+
+// Cutoff ramp time used by the plugin wrappers, in seconds
+static const double kDefaultSmoothingTime = 0.02;
+
+template <typename ValueType>
+class LinearSmoother
+{
+public:
+    LinearSmoother()
+    : m_current(ValueType(0))
+    , m_target(ValueType(0))
+    , m_step(ValueType(0))
+    , m_rampLength(0)
+    , m_remaining(0)
+    {
+    }
+
+    // Ramp duration in samples for subsequent targets (0 = jump immediately)
+    void setRampLength(int numSamples)
+    {
+        m_rampLength = numSamples > 0 ? numSamples : 0;
+        if (m_rampLength == 0)
+            reset(m_target);
+    }
+
+    int getRampLength() const { return m_rampLength; }
+
+    // Jump to value without ramping
+    void reset(ValueType value)
+    {
+        m_current = m_target = value;
+        m_step = ValueType(0);
+        m_remaining = 0;
+    }
+
+    void setTarget(ValueType target)
+    {
+        if (target == m_target)
+            return;
+
+        m_target = target;
+        if (m_rampLength == 0) {
+            reset(target);
+            return;
+        }
+        m_remaining = m_rampLength;
+        m_step = (m_target - m_current) / ValueType(m_remaining);
+    }
+
+    bool isSmoothing() const { return m_remaining > 0; }
+
+    ValueType getCurrent() const { return m_current; }
+    ValueType getTarget() const { return m_target; }
+
+    // Move up to numSamples along the ramp and return how many samples were
+    // actually ramped (0 when already at the target)
+    int advance(int numSamples)
+    {
+        const int n = numSamples < m_remaining ? numSamples : m_remaining;
+        m_remaining -= n;
+        m_current = m_remaining == 0 ? m_target : m_current + m_step * ValueType(n);
+        return n;
+    }
+
+private:
+    ValueType m_current;
+    ValueType m_target;
+    ValueType m_step;
+    int m_rampLength;
+    int m_remaining;
+};
+
+} // namespace FilterDSP
@@ -0,0 +1,539 @@
+#pragma once
+
+// Thin SIMD vector wrappers used by the cross-channel filter kernels.
+// One lane holds one channel, so a recursive filter that cannot be
+// vectorized along time still runs 2-16 channels per instruction.
+//
+// Available vectors depend on the compile target:
+//   Float4 / Double2  - SSE2, NEON (Double2 on AArch64 only) or scalar fallback
+//   Float8 / Double4  - AVX only (FILTERDSP_HAS_AVX)
+//   Float16 / Double8 - AVX-512 only (FILTERDSP_HAS_AVX512)
+//
+// Everything here, and the kernels built on it, lives in an inline
+// namespace named after the instruction set (FILTERDSP_ISA), so kernel
+// variants compiled with different target flags can be linked into one
+// binary without sharing a symbol (see KernelDispatch.h).
+
+#include <cstddef>
+
+#if defined(__AVX__)
+    #define FILTERDSP_HAS_AVX 1
+#endif
+
+#if defined(__AVX512F__)
+    #define FILTERDSP_HAS_AVX512 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define FILTERDSP_HAS_SSE2 1
+    #include <emmintrin.h>
+    #if defined(FILTERDSP_HAS_AVX)
+        // GCC 12's AVX-512 intrinsics initialize their undefined operands
+        // from themselves, which -Wmaybe-uninitialized flags wherever they
+        // are inlined (fixed in GCC 13)
+        #if defined(__GNUC__) && !defined(__clang__)
+            #pragma GCC diagnostic push
+            #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+        #endif
+        #include <immintrin.h>
+        #if defined(__GNUC__) && !defined(__clang__)
+            #pragma GCC diagnostic pop
+        #endif
+    #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define FILTERDSP_HAS_NEON 1
+    #include <arm_neon.h>
+    #if defined(__aarch64__) || defined(_M_ARM64)
+        #define FILTERDSP_HAS_NEON64 1
+    #endif
+#endif
+
+#if defined(_MSC_VER)
+    #define FILTERDSP_ALIGN(n) __declspec(align(n))
+#else
+    #define FILTERDSP_ALIGN(n) __attribute__((aligned(n)))
+#endif
+
+// The dispatch build names each variant explicitly; otherwise the name
+// follows the compile target
+#if !defined(FILTERDSP_ISA)
+    #if defined(FILTERDSP_HAS_AVX512)
+        #define FILTERDSP_ISA Avx512
+    #elif defined(__AVX2__)
+        #define FILTERDSP_ISA Avx2
+    #elif defined(FILTERDSP_HAS_AVX)
+        #define FILTERDSP_ISA Avx
+    #elif defined(FILTERDSP_HAS_SSE2)
+        #define FILTERDSP_ISA Sse2
+    #elif defined(FILTERDSP_HAS_NEON)
+        #define FILTERDSP_ISA Neon
+    #else
+        #define FILTERDSP_ISA Scalar
+    #endif
+#endif
+
+#define FILTERDSP_ISA_NAMESPACE_BEGIN inline namespace FILTERDSP_ISA {
+#define FILTERDSP_ISA_NAMESPACE_END }
+
+namespace FilterDSP {
+FILTERDSP_ISA_NAMESPACE_BEGIN
+
+//------------------------------------------------------------------------
+// Float4
+//------------------------------------------------------------------------
+struct Float4
+{
+    typedef float Scalar;
+    static const int kWidth = 4;
+
+#if defined(FILTERDSP_HAS_SSE2)
+    __m128 v;
+
+    static Float4 broadcast(float x) { Float4 r; r.v = _mm_set1_ps(x); return r; }
+    static Float4 loadu(const float* p) { Float4 r; r.v = _mm_loadu_ps(p); return r; }
+    void storeu(float* p) const { _mm_storeu_ps(p, v); }
+
+    friend Float4 operator+(Float4 a, Float4 b) { a.v = _mm_add_ps(a.v, b.v); return a; }
+    friend Float4 operator-(Float4 a, Float4 b) { a.v = _mm_sub_ps(a.v, b.v); return a; }
+    friend Float4 operator*(Float4 a, Float4 b) { a.v = _mm_mul_ps(a.v, b.v); return a; }
+    friend Float4 operator/(Float4 a, Float4 b) { a.v = _mm_div_ps(a.v, b.v); return a; }
+    friend Float4 vmin(Float4 a, Float4 b) { a.v = _mm_min_ps(a.v, b.v); return a; }
+    friend Float4 vmax(Float4 a, Float4 b) { a.v = _mm_max_ps(a.v, b.v); return a; }
+
+    // Lanes moved up by one, carry's last lane into lane 0
+    static Float4 shiftUp(Float4 v, Float4 carry)
+    {
+        const __m128 t = _mm_shuffle_ps(carry.v, v.v, _MM_SHUFFLE(0, 0, 3, 3));
+        v.v = _mm_shuffle_ps(t, v.v, _MM_SHUFFLE(2, 1, 2, 0));
+        return v;
+    }
+
+    // rows[i] lane j <-> rows[j] lane i
+    static void transpose(Float4* rows)
+    {
+        _MM_TRANSPOSE4_PS(rows[0].v, rows[1].v, rows[2].v, rows[3].v);
+    }
+#elif defined(FILTERDSP_HAS_NEON)
+    float32x4_t v;
+
+    static Float4 broadcast(float x) { Float4 r; r.v = vdupq_n_f32(x); return r; }
+    static Float4 loadu(const float* p) { Float4 r; r.v = vld1q_f32(p); return r; }
+    void storeu(float* p) const { vst1q_f32(p, v); }
+
+    friend Float4 operator+(Float4 a, Float4 b) { a.v = vaddq_f32(a.v, b.v); return a; }
+    friend Float4 operator-(Float4 a, Float4 b) { a.v = vsubq_f32(a.v, b.v); return a; }
+    friend Float4 operator*(Float4 a, Float4 b) { a.v = vmulq_f32(a.v, b.v); return a; }
+#if defined(FILTERDSP_HAS_NEON64)
+    friend Float4 operator/(Float4 a, Float4 b) { a.v = vdivq_f32(a.v, b.v); return a; }
+#else
+    // ARMv7 has no vector divide: reciprocal estimate and two Newton steps
+    friend Float4 operator/(Float4 a, Float4 b)
+    {
+        float32x4_t r = vrecpeq_f32(b.v);
+        r = vmulq_f32(r, vrecpsq_f32(b.v, r));
+        r = vmulq_f32(r, vrecpsq_f32(b.v, r));
+        a.v = vmulq_f32(a.v, r);
+        return a;
+    }
+#endif
+    friend Float4 vmin(Float4 a, Float4 b) { a.v = vminq_f32(a.v, b.v); return a; }
+    friend Float4 vmax(Float4 a, Float4 b) { a.v = vmaxq_f32(a.v, b.v); return a; }
+
+    static Float4 shiftUp(Float4 v, Float4 carry) { v.v = vextq_f32(carry.v, v.v, 3); return v; }
+
+    static void transpose(Float4* rows)
+    {
+        float32x4x2_t t01 = vtrnq_f32(rows[0].v, rows[1].v);
+        float32x4x2_t t23 = vtrnq_f32(rows[2].v, rows[3].v);
+        rows[0].v = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+        rows[1].v = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+        rows[2].v = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+        rows[3].v = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+    }
+#else
+    float v[4];
+
+    static Float4 broadcast(float x) { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = x; return r; }
+    static Float4 loadu(const float* p) { Float4 r; for (int i = 0; i < 4; ++i) r.v[i] = p[i]; return r; }
+    void storeu(float* p) const { for (int i = 0; i < 4; ++i) p[i] = v[i]; }
+
+    friend Float4 operator+(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] += b.v[i]; return a; }
+    friend Float4 operator-(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] -= b.v[i]; return a; }
+    friend Float4 operator*(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] *= b.v[i]; return a; }
+    friend Float4 operator/(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] /= b.v[i]; return a; }
+    friend Float4 vmin(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] = b.v[i] < a.v[i] ? b.v[i] : a.v[i]; return a; }
+    friend Float4 vmax(Float4 a, Float4 b) { for (int i = 0; i < 4; ++i) a.v[i] = a.v[i] < b.v[i] ? b.v[i] : a.v[i]; return a; }
+
+    static Float4 shiftUp(Float4 v, Float4 carry)
+    {
+        Float4 r;
+        r.v[0] = carry.v[3];
+        for (int i = 1; i < 4; ++i)
+            r.v[i] = v.v[i - 1];
+        return r;
+    }
+
+    static void transpose(Float4* rows)
+    {
+        for (int i = 0; i < 4; ++i)
+            for (int j = i + 1; j < 4; ++j) {
+                float t = rows[i].v[j];
+                rows[i].v[j] = rows[j].v[i];
+                rows[j].v[i] = t;
+            }
+    }
+#endif
+};
+
+//------------------------------------------------------------------------
+// Double2
+//------------------------------------------------------------------------
+struct Double2
+{
+    typedef double Scalar;
+    static const int kWidth = 2;
+
+#if defined(FILTERDSP_HAS_SSE2)
+    __m128d v;
+
+    static Double2 broadcast(double x) { Double2 r; r.v = _mm_set1_pd(x); return r; }
+    static Double2 loadu(const double* p) { Double2 r; r.v = _mm_loadu_pd(p); return r; }
+    void storeu(double* p) const { _mm_storeu_pd(p, v); }
+
+    friend Double2 operator+(Double2 a, Double2 b) { a.v = _mm_add_pd(a.v, b.v); return a; }
+    friend Double2 operator-(Double2 a, Double2 b) { a.v = _mm_sub_pd(a.v, b.v); return a; }
+    friend Double2 operator*(Double2 a, Double2 b) { a.v = _mm_mul_pd(a.v, b.v); return a; }
+    friend Double2 operator/(Double2 a, Double2 b) { a.v = _mm_div_pd(a.v, b.v); return a; }
+    friend Double2 vmin(Double2 a, Double2 b) { a.v = _mm_min_pd(a.v, b.v); return a; }
+    friend Double2 vmax(Double2 a, Double2 b) { a.v = _mm_max_pd(a.v, b.v); return a; }
+
+    static Double2 shiftUp(Double2 v, Double2 carry) { v.v = _mm_shuffle_pd(carry.v, v.v, 1); return v; }
+
+    static void transpose(Double2* rows)
+    {
+        __m128d lo = _mm_unpacklo_pd(rows[0].v, rows[1].v);
+        __m128d hi = _mm_unpackhi_pd(rows[0].v, rows[1].v);
+        rows[0].v = lo;
+        rows[1].v = hi;
+    }
+#elif defined(FILTERDSP_HAS_NEON64)
+    float64x2_t v;
+
+    static Double2 broadcast(double x) { Double2 r; r.v = vdupq_n_f64(x); return r; }
+    static Double2 loadu(const double* p) { Double2 r; r.v = vld1q_f64(p); return r; }
+    void storeu(double* p) const { vst1q_f64(p, v); }
+
+    friend Double2 operator+(Double2 a, Double2 b) { a.v = vaddq_f64(a.v, b.v); return a; }
+    friend Double2 operator-(Double2 a, Double2 b) { a.v = vsubq_f64(a.v, b.v); return a; }
+    friend Double2 operator*(Double2 a, Double2 b) { a.v = vmulq_f64(a.v, b.v); return a; }
+    friend Double2 operator/(Double2 a, Double2 b) { a.v = vdivq_f64(a.v, b.v); return a; }
+    friend Double2 vmin(Double2 a, Double2 b) { a.v = vminq_f64(a.v, b.v); return a; }
+    friend Double2 vmax(Double2 a, Double2 b) { a.v = vmaxq_f64(a.v, b.v); return a; }
+
+    static Double2 shiftUp(Double2 v, Double2 carry) { v.v = vextq_f64(carry.v, v.v, 1); return v; }
+
+    static void transpose(Double2* rows)
+    {
+        float64x2_t lo = vzip1q_f64(rows[0].v, rows[1].v);
+        float64x2_t hi = vzip2q_f64(rows[0].v, rows[1].v);
+        rows[0].v = lo;
+        rows[1].v = hi;
+    }
+#else
+    double v[2];
+
+    static Double2 broadcast(double x) { Double2 r; r.v[0] = r.v[1] = x; return r; }
+    static Double2 loadu(const double* p) { Double2 r; r.v[0] = p[0]; r.v[1] = p[1]; return r; }
+    void storeu(double* p) const { p[0] = v[0]; p[1] = v[1]; }
+
+    friend Double2 operator+(Double2 a, Double2 b) { a.v[0] += b.v[0]; a.v[1] += b.v[1]; return a; }
+    friend Double2 operator-(Double2 a, Double2 b) { a.v[0] -= b.v[0]; a.v[1] -= b.v[1]; return a; }
+    friend Double2 operator*(Double2 a, Double2 b) { a.v[0] *= b.v[0]; a.v[1] *= b.v[1]; return a; }
+    friend Double2 operator/(Double2 a, Double2 b) { a.v[0] /= b.v[0]; a.v[1] /= b.v[1]; return a; }
+    friend Double2 vmin(Double2 a, Double2 b) { for (int i = 0; i < 2; ++i) a.v[i] = b.v[i] < a.v[i] ? b.v[i] : a.v[i]; return a; }
+    friend Double2 vmax(Double2 a, Double2 b) { for (int i = 0; i < 2; ++i) a.v[i] = a.v[i] < b.v[i] ? b.v[i] : a.v[i]; return a; }
+
+    static Double2 shiftUp(Double2 v, Double2 carry) { v.v[1] = v.v[0]; v.v[0] = carry.v[1]; return v; }
+
+    static void transpose(Double2* rows)
+    {
+        double t = rows[0].v[1];
+        rows[0].v[1] = rows[1].v[0];
+        rows[1].v[0] = t;
+    }
+#endif
+};
+
+#if defined(FILTERDSP_HAS_AVX)
+//------------------------------------------------------------------------
+// Float8 (AVX)
+//------------------------------------------------------------------------
+struct Float8
+{
+    typedef float Scalar;
+    static const int kWidth = 8;
+
+    __m256 v;
+
+    static Float8 broadcast(float x) { Float8 r; r.v = _mm256_set1_ps(x); return r; }
+    static Float8 loadu(const float* p) { Float8 r; r.v = _mm256_loadu_ps(p); return r; }
+    void storeu(float* p) const { _mm256_storeu_ps(p, v); }
+
+    friend Float8 operator+(Float8 a, Float8 b) { a.v = _mm256_add_ps(a.v, b.v); return a; }
+    friend Float8 operator-(Float8 a, Float8 b) { a.v = _mm256_sub_ps(a.v, b.v); return a; }
+    friend Float8 operator*(Float8 a, Float8 b) { a.v = _mm256_mul_ps(a.v, b.v); return a; }
+    friend Float8 operator/(Float8 a, Float8 b) { a.v = _mm256_div_ps(a.v, b.v); return a; }
+    friend Float8 vmin(Float8 a, Float8 b) { a.v = _mm256_min_ps(a.v, b.v); return a; }
+    friend Float8 vmax(Float8 a, Float8 b) { a.v = _mm256_max_ps(a.v, b.v); return a; }
+
+    // Lane 0 of each 128-bit half takes the last lane below it
+    static Float8 shiftUp(Float8 v, Float8 carry)
+    {
+        const __m256 below = _mm256_permute2f128_ps(carry.v, v.v, 0x21);
+        const __m256 t = _mm256_shuffle_ps(below, v.v, _MM_SHUFFLE(0, 0, 3, 3));
+        v.v = _mm256_shuffle_ps(t, v.v, _MM_SHUFFLE(2, 1, 2, 0));
+        return v;
+    }
+
+    static void transpose(Float8* rows)
+    {
+        __m256 t0 = _mm256_unpacklo_ps(rows[0].v, rows[1].v);
+        __m256 t1 = _mm256_unpackhi_ps(rows[0].v, rows[1].v);
+        __m256 t2 = _mm256_unpacklo_ps(rows[2].v, rows[3].v);
+        __m256 t3 = _mm256_unpackhi_ps(rows[2].v, rows[3].v);
+        __m256 t4 = _mm256_unpacklo_ps(rows[4].v, rows[5].v);
+        __m256 t5 = _mm256_unpackhi_ps(rows[4].v, rows[5].v);
+        __m256 t6 = _mm256_unpacklo_ps(rows[6].v, rows[7].v);
+        __m256 t7 = _mm256_unpackhi_ps(rows[6].v, rows[7].v);
+
+        __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+        rows[0].v = _mm256_permute2f128_ps(s0, s4, 0x20);
+        rows[1].v = _mm256_permute2f128_ps(s1, s5, 0x20);
+        rows[2].v = _mm256_permute2f128_ps(s2, s6, 0x20);
+        rows[3].v = _mm256_permute2f128_ps(s3, s7, 0x20);
+        rows[4].v = _mm256_permute2f128_ps(s0, s4, 0x31);
+        rows[5].v = _mm256_permute2f128_ps(s1, s5, 0x31);
+        rows[6].v = _mm256_permute2f128_ps(s2, s6, 0x31);
+        rows[7].v = _mm256_permute2f128_ps(s3, s7, 0x31);
+    }
+};
+
+//------------------------------------------------------------------------
+// Double4 (AVX)
+//------------------------------------------------------------------------
+struct Double4
+{
+    typedef double Scalar;
+    static const int kWidth = 4;
+
+    __m256d v;
+
+    static Double4 broadcast(double x) { Double4 r; r.v = _mm256_set1_pd(x); return r; }
+    static Double4 loadu(const double* p) { Double4 r; r.v = _mm256_loadu_pd(p); return r; }
+    void storeu(double* p) const { _mm256_storeu_pd(p, v); }
+
+    friend Double4 operator+(Double4 a, Double4 b) { a.v = _mm256_add_pd(a.v, b.v); return a; }
+    friend Double4 operator-(Double4 a, Double4 b) { a.v = _mm256_sub_pd(a.v, b.v); return a; }
+    friend Double4 operator*(Double4 a, Double4 b) { a.v = _mm256_mul_pd(a.v, b.v); return a; }
+    friend Double4 operator/(Double4 a, Double4 b) { a.v = _mm256_div_pd(a.v, b.v); return a; }
+    friend Double4 vmin(Double4 a, Double4 b) { a.v = _mm256_min_pd(a.v, b.v); return a; }
+    friend Double4 vmax(Double4 a, Double4 b) { a.v = _mm256_max_pd(a.v, b.v); return a; }
+
+    static Double4 shiftUp(Double4 v, Double4 carry)
+    {
+        const __m256d below = _mm256_permute2f128_pd(carry.v, v.v, 0x21);
+        v.v = _mm256_shuffle_pd(below, v.v, 0x5);
+        return v;
+    }
+
+    static void transpose(Double4* rows)
+    {
+        __m256d t0 = _mm256_unpacklo_pd(rows[0].v, rows[1].v);
+        __m256d t1 = _mm256_unpackhi_pd(rows[0].v, rows[1].v);
+        __m256d t2 = _mm256_unpacklo_pd(rows[2].v, rows[3].v);
+        __m256d t3 = _mm256_unpackhi_pd(rows[2].v, rows[3].v);
+        rows[0].v = _mm256_permute2f128_pd(t0, t2, 0x20);
+        rows[1].v = _mm256_permute2f128_pd(t1, t3, 0x20);
+        rows[2].v = _mm256_permute2f128_pd(t0, t2, 0x31);
+        rows[3].v = _mm256_permute2f128_pd(t1, t3, 0x31);
+    }
+};
+#endif
+
+#if defined(FILTERDSP_HAS_AVX512)
+//------------------------------------------------------------------------
+// Float16 (AVX-512)
+//------------------------------------------------------------------------
+struct Float16
+{
+    typedef float Scalar;
+    static const int kWidth = 16;
+
+    __m512 v;
+
+    static Float16 broadcast(float x) { Float16 r; r.v = _mm512_set1_ps(x); return r; }
+    static Float16 loadu(const float* p) { Float16 r; r.v = _mm512_loadu_ps(p); return r; }
+    void storeu(float* p) const { _mm512_storeu_ps(p, v); }
+
+    friend Float16 operator+(Float16 a, Float16 b) { a.v = _mm512_add_ps(a.v, b.v); return a; }
+    friend Float16 operator-(Float16 a, Float16 b) { a.v = _mm512_sub_ps(a.v, b.v); return a; }
+    friend Float16 operator*(Float16 a, Float16 b) { a.v = _mm512_mul_ps(a.v, b.v); return a; }
+    friend Float16 operator/(Float16 a, Float16 b) { a.v = _mm512_div_ps(a.v, b.v); return a; }
+    friend Float16 vmin(Float16 a, Float16 b) { a.v = _mm512_min_ps(a.v, b.v); return a; }
+    friend Float16 vmax(Float16 a, Float16 b) { a.v = _mm512_max_ps(a.v, b.v); return a; }
+
+    static Float16 shiftUp(Float16 v, Float16 carry)
+    {
+        v.v = _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(v.v), _mm512_castps_si512(carry.v), 15));
+        return v;
+    }
+
+    static void transpose(Float16* rows)
+    {
+        // 4x4 transposes within each 128-bit lane...
+        __m512 t[16];
+        for (int i = 0; i < 16; i += 2) {
+            t[i] = _mm512_unpacklo_ps(rows[i].v, rows[i + 1].v);
+            t[i + 1] = _mm512_unpackhi_ps(rows[i].v, rows[i + 1].v);
+        }
+        __m512 s[16];
+        for (int i = 0; i < 16; i += 4) {
+            s[i] = _mm512_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(1, 0, 1, 0));
+            s[i + 1] = _mm512_shuffle_ps(t[i], t[i + 2], _MM_SHUFFLE(3, 2, 3, 2));
+            s[i + 2] = _mm512_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(1, 0, 1, 0));
+            s[i + 3] = _mm512_shuffle_ps(t[i + 1], t[i + 3], _MM_SHUFFLE(3, 2, 3, 2));
+        }
+
+        // ...then the 4x4 transpose of the 128-bit lanes
+        for (int i = 0; i < 16; i += 8)
+            for (int j = 0; j < 4; ++j) {
+                t[i + j] = _mm512_shuffle_f32x4(s[i + j], s[i + j + 4], 0x88);
+                t[i + j + 4] = _mm512_shuffle_f32x4(s[i + j], s[i + j + 4], 0xdd);
+            }
+        for (int j = 0; j < 8; ++j) {
+            rows[j].v = _mm512_shuffle_f32x4(t[j], t[j + 8], 0x88);
+            rows[j + 8].v = _mm512_shuffle_f32x4(t[j], t[j + 8], 0xdd);
+        }
+    }
+};
+
+//------------------------------------------------------------------------
+// Double8 (AVX-512)
+//------------------------------------------------------------------------
+struct Double8
+{
+    typedef double Scalar;
+    static const int kWidth = 8;
+
+    __m512d v;
+
+    static Double8 broadcast(double x) { Double8 r; r.v = _mm512_set1_pd(x); return r; }
+    static Double8 loadu(const double* p) { Double8 r; r.v = _mm512_loadu_pd(p); return r; }
+    void storeu(double* p) const { _mm512_storeu_pd(p, v); }
+
+    friend Double8 operator+(Double8 a, Double8 b) { a.v = _mm512_add_pd(a.v, b.v); return a; }
+    friend Double8 operator-(Double8 a, Double8 b) { a.v = _mm512_sub_pd(a.v, b.v); return a; }
+    friend Double8 operator*(Double8 a, Double8 b) { a.v = _mm512_mul_pd(a.v, b.v); return a; }
+    friend Double8 operator/(Double8 a, Double8 b) { a.v = _mm512_div_pd(a.v, b.v); return a; }
+    friend Double8 vmin(Double8 a, Double8 b) { a.v = _mm512_min_pd(a.v, b.v); return a; }
+    friend Double8 vmax(Double8 a, Double8 b) { a.v = _mm512_max_pd(a.v, b.v); return a; }
+
+    static Double8 shiftUp(Double8 v, Double8 carry)
+    {
+        v.v = _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(v.v), _mm512_castpd_si512(carry.v), 7));
+        return v;
+    }
+
+    static void transpose(Double8* rows)
+    {
+        // 2x2 transposes within each 128-bit lane, then the 4x4 transpose
+        // of the lanes
+        __m512d t[8];
+        for (int i = 0; i < 8; i += 2) {
+            t[i] = _mm512_unpacklo_pd(rows[i].v, rows[i + 1].v);
+            t[i + 1] = _mm512_unpackhi_pd(rows[i].v, rows[i + 1].v);
+        }
+        __m512d s[8];
+        for (int i = 0; i < 8; i += 4) {
+            s[i] = _mm512_shuffle_f64x2(t[i], t[i + 2], 0x88);
+            s[i + 1] = _mm512_shuffle_f64x2(t[i + 1], t[i + 3], 0x88);
+            s[i + 2] = _mm512_shuffle_f64x2(t[i], t[i + 2], 0xdd);
+            s[i + 3] = _mm512_shuffle_f64x2(t[i + 1], t[i + 3], 0xdd);
+        }
+        for (int j = 0; j < 4; ++j) {
+            rows[j].v = _mm512_shuffle_f64x2(s[j], s[j + 4], 0x88);
+            rows[j + 4].v = _mm512_shuffle_f64x2(s[j], s[j + 4], 0xdd);
+        }
+    }
+};
+#endif
+
+//------------------------------------------------------------------------
+// Vectors per sample type for the current compile target. The recursive
+// filter kernels pick the narrowest one that holds every channel; Wide is
+// the vector for work along time (FIR, FFT).
+//------------------------------------------------------------------------
+template <typename SampleType>
+struct SimdTraits;
+
+template <>
+struct SimdTraits<float>
+{
+    typedef Float4 Narrow;
+#if defined(FILTERDSP_HAS_AVX)
+    typedef Float8 Wide;
+#else
+    typedef Float4 Wide;
+#endif
+#if defined(FILTERDSP_HAS_AVX512)
+    typedef Float16 Widest;
+#else
+    typedef Wide Widest;
+#endif
+};
+
+template <>
+struct SimdTraits<double>
+{
+    typedef Double2 Narrow;
+#if defined(FILTERDSP_HAS_AVX)
+    typedef Double4 Wide;
+#else
+    typedef Double2 Wide;
+#endif
+#if defined(FILTERDSP_HAS_AVX512)
+    typedef Double8 Widest;
+#else
+    typedef Wide Widest;
+#endif
+};
+
+//------------------------------------------------------------------------
+// Scalar counterparts, so one template serves a sample and a vector of
+// channels
+//------------------------------------------------------------------------
+inline float vmin(float a, float b) { return b < a ? b : a; }
+inline float vmax(float a, float b) { return a < b ? b : a; }
+inline double vmin(double a, double b) { return b < a ? b : a; }
+inline double vmax(double a, double b) { return a < b ? b : a; }
+
+// A constant as T, broadcast to every lane for vectors
+template <typename T>
+inline T splat(double x) { return T::broadcast(typename T::Scalar(x)); }
+
+template <>
+inline float splat<float>(double x) { return float(x); }
+
+template <>
+inline double splat<double>(double x) { return x; }
+
+FILTERDSP_ISA_NAMESPACE_END
+} // namespace FilterDSP
@@ -0,0 +1,96 @@
+#pragma once
+
+// Coefficients of the topology-preserving (zero-delay feedback) state
+// variable filter. One structure produces the low pass, band pass, high
+// pass and notch responses; the cutoff is prewarped with tan() so it maps
+// correctly right up to the top of the band.
+//
+// The design is cheap enough to run for every sample (one rational tan
+// approximation and one division), which is what the cutoff ramps do.
+// Block-rate designs take tan() from the cutoff tables instead.
+
+#include "BiquadDesigner.h"
+
+namespace FilterDSP {
+
+// Filter modes (kModeId / kParam_Mode). The state variable filter is
+// second order (12 dB/oct) and ignores the slope. Linear phase runs an FIR
+// with the magnitude response of the standard mode (see
+// LinearPhaseFilter.h). The ladder is the resonant, saturating four-pole
+// filter of LadderDesigner.h, and also ignores the slope. The graphic EQ
+// replaces the filter with the band bank of FilterBank.h and ignores the
+// cutoff, type, slope, Q and gain. The crossover splits the input into 2 to
+// 5 Linkwitz-Riley bands, one per output (Crossover.h), and likewise
+// ignores the filter parameters.
+enum FilterMode
+{
+    kFilterModeStandard = 0,
+    kFilterModeStateVariable = 1,
+    kFilterModeLinearPhase = 2,
+    kFilterModeLadder = 3,
+    kFilterModeGraphicEq = 4,
+    kFilterModeCrossover = 5,
+    kNumFilterModes = 6
+};
+
+// tan(x) for 0 <= x <= kMaxCutoffRatio·π, as the [7/6] Padé approximant.
+// Relative error stays below 1e-7 over that range, so no range reduction
+// is needed.
+template <typename T>
+inline T fastTan(T x)
+{
+    const T x2 = x * x;
+    const T num = x * (T(135135) - x2 * (T(17325) - x2 * (T(378) - x2)));
+    const T den = T(135135) - x2 * (T(62370) - x2 * (T(3150) - T(28) * x2));
+    return num / den;
+}
+
+// Butterworth damping (Q = 1/√2); the Q parameter sets k = 1/Q
+static const double kSvfDamping = 1.41421356237309504880;
+
+template <typename SampleType>
+struct SvfCoefficients
+{
+    SampleType a1;      // 1 / (1 + g·(g + k))
+    SampleType a2;      // g·a1
+    SampleType a3;      // g·a2
+    SampleType k;       // damping (1/Q)
+
+    // Block-rate design; tan() comes from the cutoff tables
+    static SvfCoefficients design(SampleType cutoffFreq, SampleType sampleRate, double q = kDefaultQ)
+    {
+        const SampleType maxCutoff = SampleType(kMaxCutoffRatio) * sampleRate;
+        const SampleType fc = cutoffFreq < maxCutoff ? cutoffFreq : maxCutoff;
+
+        // g = sin/cos, so a1 = cos²/(1 + k·sin·cos)
+        CutoffSineCosine half;
+        if (lookupCutoff(double(fc) / double(sampleRate), half)) {
+            const double k = 1.0 / q;
+            const double scale = 1.0 / (1.0 + k * half.sine * half.cosine);
+            SvfCoefficients c;
+            c.k = SampleType(k);
+            c.a1 = SampleType(half.cosine * half.cosine * scale);
+            c.a2 = SampleType(half.sine * half.cosine * scale);
+            c.a3 = SampleType(half.sine * half.sine * scale);
+            return c;
+        }
+        return designWarped(SampleType(3.14159265358979323846) * fc / sampleRate, SampleType(1.0 / q));
+    }
+
+    // From w = π·fc/sample_rate (at most kMaxCutoffRatio·π); used per
+    // sample by the cutoff ramps, where w moves linearly. The rational tan
+    // vectorizes across the ramp, which a table lookup does not.
+    static SvfCoefficients designWarped(SampleType w, SampleType damping = SampleType(kSvfDamping))
+    {
+        const SampleType g = fastTan(w);
+
+        SvfCoefficients c;
+        c.k = damping;
+        c.a1 = SampleType(1) / (SampleType(1) + g * (g + c.k));
+        c.a2 = g * c.a1;
+        c.a3 = g * c.a2;
+        return c;
+    }
+};
+
+} // namespace FilterDSP
@@ -0,0 +1,208 @@
+#pragma once
+
+// Block kernels for the state variable filter. One pass of the recurrence
+// yields every response (SvfStep::tickAll); the kernels are specialized on
+// the response so the unused outputs compile away.
+//
+// Like the other kernels, one channel occupies one SIMD lane. The
+// coefficients are either fixed for the block or given for every sample
+// (PerSample), which is how cutoff ramps retune the filter each sample.
+//
+// State is two rows of numChannels values: [ic1eq | ic2eq].
+
+#include "SvfDesigner.h"
+#include "SimdOps.h"
+
+namespace FilterDSP {
+FILTERDSP_ISA_NAMESPACE_BEGIN
+
+template <typename T>
+struct SvfOutputs
+{
+    T lowPass;
+    T bandPass;
+    T highPass;
+    T notch;
+};
+
+template <typename Vector>
+inline SvfCoefficients<Vector> broadcastCoefficients(const SvfCoefficients<typename Vector::Scalar>& c)
+{
+    SvfCoefficients<Vector> v;
+    v.a1 = Vector::broadcast(c.a1);
+    v.a2 = Vector::broadcast(c.a2);
+    v.a3 = Vector::broadcast(c.a3);
+    v.k = Vector::broadcast(c.k);
+    return v;
+}
+
+struct SvfStep
+{
+    // v3 = x - ic2eq
+    // v1 = a1·ic1eq + a2·v3        (band)
+    // v2 = ic2eq + a2·ic1eq + a3·v3 (low)
+    // ic1eq = 2·v1 - ic1eq, ic2eq = 2·v2 - ic2eq
+    template <typename T>
+    static SvfOutputs<T> tickAll(const SvfCoefficients<T>& c, T x, T& ic1eq, T& ic2eq)
+    {
+        const T v3 = x - ic2eq;
+        const T v1 = c.a1 * ic1eq + c.a2 * v3;
+        const T v2 = ic2eq + c.a2 * ic1eq + c.a3 * v3;
+        ic1eq = v1 + v1 - ic1eq;
+        ic2eq = v2 + v2 - ic2eq;
+
+        SvfOutputs<T> out;
+        out.lowPass = v2;
+        out.bandPass = c.k * v1;     // unity gain at the centre frequency
+        out.notch = x - c.k * v1;
+        out.highPass = out.notch - v2;
+        return out;
+    }
+
+    template <int Type, typename T>
+    static T tick(const SvfCoefficients<T>& c, T x, T& ic1eq, T& ic2eq)
+    {
+        const SvfOutputs<T> out = tickAll(c, x, ic1eq, ic2eq);
+        switch (Type)
+        {
+            case kFilterTypeLowPass: return out.lowPass;
+            case kFilterTypeHighPass: return out.highPass;
+            case kFilterTypeBandPass: return out.bandPass;
+            default: return out.notch;
+        }
+    }
+};
+
+template <int Type, bool PerSample, typename Vector>
+struct SimdSvfKernel
+{
+    typedef typename Vector::Scalar SampleType;
+    static const int kWidth = Vector::kWidth;
+
+    static void process(const SvfCoefficients<SampleType>* coeffs,
+                        const SampleType* const* inputs, SampleType* const* outputs,
+                        int numChannels, int numSamples,
+                        SampleType* state, int stateStride)
+    {
+        const SvfCoefficients<Vector> fixed = broadcastCoefficients<Vector>(coeffs[0]);
+
+        for (int first = 0; first < numChannels; first += kWidth) {
+            const int active = numChannels - first < kWidth ? numChannels - first : kWidth;
+
+            const SampleType* in[kWidth];
+            SampleType* out[kWidth];
+            SampleType lanes[kWidth];
+            for (int lane = 0; lane < kWidth; ++lane)
+                in[lane] = inputs[first + (lane < active ? lane : 0)];
+            for (int lane = 0; lane < active; ++lane)
+                out[lane] = outputs[first + lane];
+
+            Vector ic1eq = loadState(state + first, active, lanes);
+            Vector ic2eq = loadState(state + stateStride + first, active, lanes);
+
+            int sample = 0;
+            for (; sample + kWidth <= numSamples; sample += kWidth) {
+                Vector tile[kWidth];
+                for (int lane = 0; lane < kWidth; ++lane)
+                    tile[lane] = Vector::loadu(in[lane] + sample);
+                Vector::transpose(tile);
+
+                for (int step = 0; step < kWidth; ++step) {
+                    const SvfCoefficients<Vector> c = PerSample ? broadcastCoefficients<Vector>(coeffs[sample + step]) : fixed;
+                    tile[step] = SvfStep::tick<Type>(c, tile[step], ic1eq, ic2eq);
+                }
+
+                Vector::transpose(tile);
+                for (int lane = 0; lane < active; ++lane)
+                    tile[lane].storeu(out[lane] + sample);
+            }
+
+            // Remaining samples, one time step at a time
+            for (; sample < numSamples; ++sample) {
+                for (int lane = 0; lane < kWidth; ++lane)
+                    lanes[lane] = in[lane][sample];
+                const SvfCoefficients<Vector> c = PerSample ? broadcastCoefficients<Vector>(coeffs[sample]) : fixed;
+                Vector x = SvfStep::tick<Type>(c, Vector::loadu(lanes), ic1eq, ic2eq);
+                x.storeu(lanes);
+                for (int lane = 0; lane < active; ++lane)
+                    out[lane][sample] = lanes[lane];
+            }
+
+            storeState(ic1eq, state + first, active, lanes);
+            storeState(ic2eq, state + stateStride + first, active, lanes);
+        }
+    }
+
+private:
+    static Vector loadState(const SampleType* src, int active, SampleType* lanes)
+    {
+        for (int lane = 0; lane < kWidth; ++lane)
+            lanes[lane] = lane < active ? src[lane] : SampleType(0);
+        return Vector::loadu(lanes);
+    }
+
+    static void storeState(Vector v, SampleType* dst, int active, SampleType* lanes)
+    {
+        v.storeu(lanes);
+        for (int lane = 0; lane < active; ++lane)
+            dst[lane] = lanes[lane];
+    }
+};
+
+template <int Type, bool PerSample, typename SampleType>
+inline void processSvfBlock(const SvfCoefficients<SampleType>* coeffs,
+                            const SampleType* const* inputs, SampleType* const* outputs,
+                            int numChannels, int numSamples,
+                            SampleType* state, int stateStride)
+{
+    typedef typename SimdTraits<SampleType>::Narrow Narrow;
+    typedef typename SimdTraits<SampleType>::Wide Wide;
+    typedef typename SimdTraits<SampleType>::Widest Widest;
+
+    if (numChannels <= Narrow::kWidth)
+        SimdSvfKernel<Type, PerSample, Narrow>::process(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+    else if (numChannels <= Wide::kWidth)
+        SimdSvfKernel<Type, PerSample, Wide>::process(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+    else
+        SimdSvfKernel<Type, PerSample, Widest>::process(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+}
+
+// Picks the kernel for the response once per block. With perSample set,
+// coeffs holds one coefficient set for every sample; otherwise one set.
+template <typename SampleType>
+inline void processSvfBlock(int filterType, bool perSample, const SvfCoefficients<SampleType>* coeffs,
+                            const SampleType* const* inputs, SampleType* const* outputs,
+                            int numChannels, int numSamples,
+                            SampleType* state, int stateStride)
+{
+    switch (filterType * 2 + (perSample ? 1 : 0))
+    {
+        case kFilterTypeLowPass * 2:
+            processSvfBlock<kFilterTypeLowPass, false>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeLowPass * 2 + 1:
+            processSvfBlock<kFilterTypeLowPass, true>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeHighPass * 2:
+            processSvfBlock<kFilterTypeHighPass, false>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeHighPass * 2 + 1:
+            processSvfBlock<kFilterTypeHighPass, true>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeBandPass * 2:
+            processSvfBlock<kFilterTypeBandPass, false>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeBandPass * 2 + 1:
+            processSvfBlock<kFilterTypeBandPass, true>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeNotch * 2:
+            processSvfBlock<kFilterTypeNotch, false>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+        case kFilterTypeNotch * 2 + 1:
+            processSvfBlock<kFilterTypeNotch, true>(coeffs, inputs, outputs, numChannels, numSamples, state, stateStride);
+            break;
+    }
+}
+
+FILTERDSP_ISA_NAMESPACE_END
+} // namespace FilterDSP
@@ -0,0 +1,73 @@
+#pragma once
+
+// Minimal timing helpers shared by the filter engine benchmarks.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <vector>
+
+namespace FilterBench {
+
+// Deterministic white noise in [-1, 1)
+template <typename SampleType>
+inline void fillNoise(std::vector<SampleType>& buffer, uint32_t seed)
+{
+    for (SampleType& sample : buffer) {
+        seed = seed * 1664525u + 1013904223u;
+        sample = SampleType(int32_t(seed) >> 8) / SampleType(1 << 23);
+    }
+}
+
+// Non-interleaved multichannel buffer with stable channel pointers
+template <typename SampleType>
+struct ChannelBuffers
+{
+    ChannelBuffers(int numChannels, int numSamples)
+    : data(numChannels, std::vector<SampleType>(numSamples))
+    {
+        for (int channel = 0; channel < numChannels; ++channel) {
+            fillNoise(data[channel], 0x1234u + channel);
+            pointers.push_back(data[channel].data());
+        }
+    }
+
+    SampleType* const* get() { return pointers.data(); }
+
+    std::vector<std::vector<SampleType>> data;
+    std::vector<SampleType*> pointers;
+};
+
+// Runs `process` (one block per call) until roughly minSamples samples have
+// been processed and returns the best-of-`repeats` cost in ns per sample
+// per channel.
+template <typename Process>
+inline double measureNsPerSample(Process&& process, int numChannels, int numSamples,
+                                 long long minSamples = 1 << 21, int repeats = 5)
+{
+    const long long blocks = std::max<long long>(1, minSamples / numSamples);
+    double best = 1e30;
+
+    for (int r = 0; r < repeats; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        for (long long b = 0; b < blocks; ++b)
+            process();
+        auto end = std::chrono::steady_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(end - start).count();
+        best = std::min(best, ns / (double(blocks) * numSamples * numChannels));
+    }
+    return best;
+}
+
+// Prevents the optimizer from discarding benchmark output
+template <typename SampleType>
+inline void consume(const SampleType* data)
+{
+    static volatile SampleType sink;
+    sink = data[0];
+    (void)sink;
+}
+
+} // namespace FilterBench
@@ -0,0 +1,1004 @@
+// Filter engine benchmark: reports the per-sample cost of the shared engine
+// for the block sizes hosts typically use, next to the original per-sample
+// implementation (alpha recomputed for every sample) and the engine's own
+// per-sample entry point, so the gain of the block kernels is visible.
+
+#include "BenchmarkHarness.h"
+#include "BypassFader.h"
+#include "DenormalGuard.h"
+#include "FilterEngine.h"
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace FilterBench;
+
+namespace {
+
+const int kBlockSizes[] = { 32, 64, 128, 256, 512, 1024 };
+
+// The pre-engine FilterVST3 implementation, kept as the reference
+struct LegacyFilter
+{
+    float sampleRate = 48000.0f;
+    float cutoffFreq = 1000.0f;
+    int filterType = FilterDSP::kFilterTypeLowPass;
+    float lastOutput[FilterDSP::kMaxChannels] = {};
+    float lastInput[FilterDSP::kMaxChannels] = {};
+
+    float processSample(float input, int channel)
+    {
+        if (filterType == FilterDSP::kFilterTypeLowPass) {
+            float alpha = 1.0f / (1.0f + cutoffFreq / sampleRate);
+            float output = (1.0f - alpha) * input + alpha * lastOutput[channel];
+            lastOutput[channel] = output;
+            return output;
+        }
+        float alpha = cutoffFreq / (cutoffFreq + sampleRate);
+        float output = alpha * (lastOutput[channel] + input - lastInput[channel]);
+        lastInput[channel] = input;
+        lastOutput[channel] = output;
+        return output;
+    }
+
+    void processBlock(float* const* inputs, float* const* outputs, int numChannels, int numSamples)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int sample = 0; sample < numSamples; ++sample)
+                outputs[channel][sample] = processSample(inputs[channel][sample], channel);
+    }
+};
+
+float maxDifference(const ChannelBuffers<float>& a, const ChannelBuffers<float>& b)
+{
+    float diff = 0.0f;
+    for (size_t channel = 0; channel < a.data.size(); ++channel)
+        for (size_t sample = 0; sample < a.data[channel].size(); ++sample)
+            diff = std::max(diff, std::fabs(a.data[channel][sample] - b.data[channel][sample]));
+    return diff;
+}
+
+typedef FilterDSP::FilterEngine<float> BenchEngine;
+
+const int kMaxBenchChannels = 8;
+
+template <typename SampleType = float>
+FilterDSP::FilterEngine<SampleType> makeEngine(int filterType)
+{
+    FilterDSP::FilterEngine<SampleType> engine;
+    engine.prepare(kMaxBenchChannels);
+    engine.setSampleRate(SampleType(48000));
+    engine.setCutoff(SampleType(1000));
+    engine.setFilterType(filterType);
+    return engine;
+}
+
+void processPerSample(BenchEngine& engine, float* const* inputs, float* const* outputs,
+                      int numChannels, int numSamples)
+{
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int sample = 0; sample < numSamples; ++sample)
+            outputs[channel][sample] = engine.processSample(inputs[channel][sample], channel);
+}
+
+void benchmarkFilterEngine(int filterType, int numChannels)
+{
+    std::printf("\nFilterEngine %s, %d channels\n",
+                filterType == FilterDSP::kFilterTypeLowPass ? "LPF" : "HPF", numChannels);
+    std::printf("%8s %14s %14s %14s %10s %12s\n",
+                "block", "legacy ns/smp", "per-smp ns/smp", "kernel ns/smp", "speedup", "max diff");
+
+    for (int blockSize : kBlockSizes) {
+        ChannelBuffers<float> input(numChannels, blockSize);
+        ChannelBuffers<float> legacyOutput(numChannels, blockSize);
+        ChannelBuffers<float> perSampleOutput(numChannels, blockSize);
+        ChannelBuffers<float> output(numChannels, blockSize);
+
+        LegacyFilter legacy;
+        legacy.filterType = filterType;
+        BenchEngine perSample = makeEngine(filterType);
+        BenchEngine engine = makeEngine(filterType);
+
+        // Verify against the reference on one block from a cleared state
+        legacy.processBlock(input.get(), legacyOutput.get(), numChannels, blockSize);
+        engine.processBlock(input.get(), output.get(), numChannels, blockSize);
+        const float diff = maxDifference(legacyOutput, output);
+
+        double legacyNs = measureNsPerSample([&] {
+            legacy.processBlock(input.get(), legacyOutput.get(), numChannels, blockSize);
+            consume(legacyOutput.data[0].data());
+        }, numChannels, blockSize);
+
+        double perSampleNs = measureNsPerSample([&] {
+            processPerSample(perSample, input.get(), perSampleOutput.get(), numChannels, blockSize);
+            consume(perSampleOutput.data[0].data());
+        }, numChannels, blockSize);
+
+        double ns = measureNsPerSample([&] {
+            engine.processBlock(input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        std::printf("%8d %14.3f %14.3f %14.3f %9.2fx %12.2e\n",
+                    blockSize, legacyNs, perSampleNs, ns, perSampleNs / ns, diff);
+    }
+}
+
+// Cost per sample frame (all channels) as the bus widens; with the
+// cross-channel SIMD kernels this should stay nearly flat from 2 to 8.
+void benchmarkChannelScaling(int filterType)
+{
+    const int blockSize = 128;
+
+    std::printf("\nChannel scaling %s, block %d\n",
+                filterType == FilterDSP::kFilterTypeLowPass ? "LPF" : "HPF", blockSize);
+    std::printf("%8s %16s %16s %12s\n", "channels", "legacy ns/frame", "kernel ns/frame", "max diff");
+
+    for (int numChannels = 1; numChannels <= kMaxBenchChannels; ++numChannels) {
+        ChannelBuffers<float> input(numChannels, blockSize);
+        ChannelBuffers<float> legacyOutput(numChannels, blockSize);
+        ChannelBuffers<float> output(numChannels, blockSize);
+
+        LegacyFilter legacy;
+        legacy.filterType = filterType;
+        BenchEngine engine = makeEngine(filterType);
+
+        legacy.processBlock(input.get(), legacyOutput.get(), numChannels, blockSize);
+        engine.processBlock(input.get(), output.get(), numChannels, blockSize);
+        const float diff = maxDifference(legacyOutput, output);
+
+        double legacyNs = measureNsPerSample([&] {
+            legacy.processBlock(input.get(), legacyOutput.get(), numChannels, blockSize);
+            consume(legacyOutput.data[0].data());
+        }, numChannels, blockSize);
+
+        double ns = measureNsPerSample([&] {
+            engine.processBlock(input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        std::printf("%8d %16.3f %16.3f %12.2e\n", numChannels, legacyNs * numChannels, ns * numChannels, diff);
+    }
+}
+
+// Smoothed cutoff: the ramp path (a new target every block) against the
+// steady state once the target is reached and the unsmoothed engine.
+void benchmarkSmoothing()
+{
+    const int numChannels = 2;
+
+    std::printf("\nCutoff smoothing LPF, %d channels, %.0f ms ramp\n", numChannels,
+                FilterDSP::kDefaultSmoothingTime * 1000.0);
+    std::printf("%8s %16s %16s %16s\n", "block", "off ns/smp", "steady ns/smp", "ramping ns/smp");
+
+    for (int blockSize : kBlockSizes) {
+        ChannelBuffers<float> input(numChannels, blockSize);
+        ChannelBuffers<float> output(numChannels, blockSize);
+
+        BenchEngine unsmoothed = makeEngine(FilterDSP::kFilterTypeLowPass);
+        BenchEngine steady = makeEngine(FilterDSP::kFilterTypeLowPass);
+        BenchEngine ramping = makeEngine(FilterDSP::kFilterTypeLowPass);
+        steady.setSmoothingTime(float(FilterDSP::kDefaultSmoothingTime));
+        ramping.setSmoothingTime(float(FilterDSP::kDefaultSmoothingTime));
+
+        double offNs = measureNsPerSample([&] {
+            unsmoothed.processBlock(input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        steady.setCutoff(2000.0f);
+        double steadyNs = measureNsPerSample([&] {
+            steady.processBlock(input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        float cutoff = 1000.0f;
+        double rampNs = measureNsPerSample([&] {
+            cutoff = cutoff > 4000.0f ? 1000.0f : cutoff * 1.01f;
+            ramping.setCutoff(cutoff);
+            ramping.processBlock(input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        std::printf("%8d %16.3f %16.3f %16.3f\n", blockSize, offNs, steadyNs, rampNs);
+    }
+}
+
+// Steeper slopes: the biquad cascade against the same order built the way a
+// user would without it, by chaining first-order engines in series.
+void benchmarkSlopes()
+{
+    const int numChannels = 2;
+    const int slopes[] = { FilterDSP::kSlope12dB, FilterDSP::kSlope24dB,
+                           FilterDSP::kSlope36dB, FilterDSP::kSlope48dB };
+
+    std::printf("\nSlopes LPF, %d channels (stacked = first-order engines in series)\n", numChannels);
+    std::printf("%8s %8s %16s %16s %10s\n", "dB/oct", "block", "stacked ns/smp", "cascade ns/smp", "speedup");
+
+    for (int slope : slopes) {
+        const int order = FilterDSP::getSlopeOrder(slope);
+        for (int blockSize : kBlockSizes) {
+            ChannelBuffers<float> input(numChannels, blockSize);
+            ChannelBuffers<float> output(numChannels, blockSize);
+
+            std::vector<BenchEngine> stacked(order, makeEngine(FilterDSP::kFilterTypeLowPass));
+            BenchEngine cascade = makeEngine(FilterDSP::kFilterTypeLowPass);
+            cascade.setSlope(slope);
+
+            double stackedNs = measureNsPerSample([&] {
+                stacked[0].processBlock(input.get(), output.get(), numChannels, blockSize);
+                for (int stage = 1; stage < order; ++stage)
+                    stacked[stage].processBlock(output.get(), output.get(), numChannels, blockSize);
+                consume(output.data[0].data());
+            }, numChannels, blockSize);
+
+            double cascadeNs = measureNsPerSample([&] {
+                cascade.processBlock(input.get(), output.get(), numChannels, blockSize);
+                consume(output.data[0].data());
+            }, numChannels, blockSize);
+
+            std::printf("%8d %8d %16.3f %16.3f %9.2fx\n", 6 * order, blockSize,
+                        stackedNs, cascadeNs, stackedNs / cascadeNs);
+        }
+    }
+}
+
+// Graphic EQ: the band bank, one band per SIMD lane, against the same
+// bells built as one peak engine per band in series. Bands beyond the
+// active count are at 0 dB and cost the bank nothing.
+void benchmarkGraphicEq()
+{
+    const int numChannels = 2;
+    const int activeCounts[] = { 1, 8, 16, 31 };
+    const int blockSizes[] = { 64, 512 };
+    const char* const layouts[] = { "serial", "parallel" };
+
+    std::printf("\nGraphic EQ %d bands, %d channels (engines = one peak engine per band in series)\n",
+                FilterDSP::kMaxBankBands, numChannels);
+    std::printf("%8s %10s %8s %16s %16s %10s\n", "active", "layout", "block", "engines ns/smp", "bank ns/smp", "speedup");
+
+    for (int numActive : activeCounts) {
+        for (int layout = 0; layout < FilterDSP::kNumBankLayouts; ++layout) {
+            for (int blockSize : blockSizes) {
+                ChannelBuffers<float> input(numChannels, blockSize);
+                ChannelBuffers<float> output(numChannels, blockSize);
+
+                std::vector<BenchEngine> engines;
+                BenchEngine bank = makeEngine(FilterDSP::kFilterTypeLowPass);
+                bank.setMode(FilterDSP::kFilterModeGraphicEq);
+                bank.setBankLayout(layout);
+                for (int band = 0; band < numActive; ++band) {
+                    const double gainDb = band % 2 == 0 ? 6.0 : -4.0;
+                    bank.setBandGain(band, gainDb);
+
+                    engines.push_back(makeEngine(FilterDSP::kFilterTypePeak));
+                    engines.back().setCutoff(float(FilterDSP::getBankBandFrequency(band, FilterDSP::kMaxBankBands)));
+                    engines.back().setQ(FilterDSP::getBankQ(FilterDSP::kMaxBankBands));
+                    engines.back().setGain(gainDb);
+                }
+
+                double enginesNs = measureNsPerSample([&] {
+                    engines[0].processBlock(input.get(), output.get(), numChannels, blockSize);
+                    for (int band = 1; band < numActive; ++band)
+                        engines[band].processBlock(output.get(), output.get(), numChannels, blockSize);
+                    consume(output.data[0].data());
+                }, numChannels, blockSize);
+
+                double bankNs = measureNsPerSample([&] {
+                    bank.processBlock(input.get(), output.get(), numChannels, blockSize);
+                    consume(output.data[0].data());
+                }, numChannels, blockSize);
+
+                std::printf("%8d %10s %8d %16.3f %16.3f %9.2fx\n", numActive, layouts[layout], blockSize,
+                            enginesNs, bankNs, enginesNs / bankNs);
+            }
+        }
+    }
+}
+
+// Crossover mode, all bands from one pass, against the usual multiband
+// setup of one LR4 low pass and one LR4 high pass instance per split, each
+// split taking the next band off the previous high pass
+void benchmarkCrossover()
+{
+    const int numChannels = 2;
+    const int blockSizes[] = { 64, 512 };
+
+    std::printf("\nCrossover LR4, %d channels (instances = LPF + HPF engine per split)\n", numChannels);
+    std::printf("%8s %8s %18s %18s %10s\n", "bands", "block", "instances ns/smp", "crossover ns/smp", "speedup");
+
+    for (int numBands = FilterDSP::kMinCrossoverBands; numBands <= FilterDSP::kMaxCrossoverBands; ++numBands) {
+        for (int blockSize : blockSizes) {
+            ChannelBuffers<float> input(numChannels, blockSize);
+            ChannelBuffers<float> rest(numChannels, blockSize);
+            // Built in place: a copy would keep the channel pointers of the original
+            std::vector<ChannelBuffers<float>> bands;
+            bands.reserve(numBands);
+            for (int band = 0; band < numBands; ++band)
+                bands.emplace_back(numChannels, blockSize);
+
+            BenchEngine crossover = makeEngine(FilterDSP::kFilterTypeLowPass);
+            crossover.setMode(FilterDSP::kFilterModeCrossover);
+            crossover.setCrossoverBands(numBands);
+
+            std::vector<BenchEngine> lowPasses;
+            std::vector<BenchEngine> highPasses;
+            for (int split = 0; split < numBands - 1; ++split) {
+                const float frequency = float(FilterDSP::kDefaultCrossoverFrequencies[split]);
+                lowPasses.push_back(makeEngine(FilterDSP::kFilterTypeLowPass));
+                highPasses.push_back(makeEngine(FilterDSP::kFilterTypeHighPass));
+                for (BenchEngine* engine : { &lowPasses.back(), &highPasses.back() }) {
+                    engine->setSlope(FilterDSP::kSlope24dB);
+                    engine->setAlignment(FilterDSP::kAlignmentLinkwitzRiley);
+                    engine->setCutoff(frequency);
+                }
+            }
+
+            float* const* outputs[FilterDSP::kMaxCrossoverBands];
+            for (int band = 0; band < numBands; ++band)
+                outputs[band] = bands[band].get();
+
+            double instancesNs = measureNsPerSample([&] {
+                float* const* in = input.get();
+                for (int split = 0; split < numBands - 1; ++split) {
+                    lowPasses[split].processBlock(in, outputs[split], numChannels, blockSize);
+                    float* const* high = split == numBands - 2 ? outputs[numBands - 1] : rest.get();
+                    highPasses[split].processBlock(in, high, numChannels, blockSize);
+                    in = high;
+                }
+                consume(bands[numBands - 1].data[0].data());
+            }, numChannels, blockSize);
+
+            double crossoverNs = measureNsPerSample([&] {
+                crossover.processBlock(input.get(), outputs, numBands, numChannels, blockSize);
+                consume(bands[numBands - 1].data[0].data());
+            }, numChannels, blockSize);
+
+            std::printf("%8d %8d %18.3f %18.3f %9.2fx\n", numBands, blockSize,
+                        instancesNs, crossoverNs, instancesNs / crossoverNs);
+        }
+    }
+}
+
+// State variable filter: fixed cutoff against a cutoff that is retuned
+// every sample (a new target each block), next to the 12 dB/oct biquad.
+void benchmarkStateVariable()
+{
+    const int numChannels = 2;
+
+    std::printf("\nState variable LPF, %d channels, %.0f ms ramp\n", numChannels,
+                FilterDSP::kDefaultSmoothingTime * 1000.0);
+    std::printf("%8s %16s %16s %18s\n", "block", "biquad ns/smp", "svf ns/smp", "svf ramp ns/smp");
+
+    for (int blockSize : kBlockSizes) {
+        ChannelBuffers<float> input(numChannels, blockSize);
+        ChannelBuffers<float> output(numChannels, blockSize);
+
+        BenchEngine biquad = makeEngine(FilterDSP::kFilterTypeLowPass);
+        BenchEngine svf = makeEngine(FilterDSP::kFilterTypeLowPass);
+        BenchEngine modulated = makeEngine(FilterDSP::kFilterTypeLowPass);
+        biquad.setSlope(FilterDSP::kSlope12dB);
+        svf.setMode(FilterDSP::kFilterModeStateVariable);
+        modulated.setMode(FilterDSP::kFilterModeStateVariable);
+        modulated.setSmoothingTime(float(FilterDSP::kDefaultSmoothingTime));
+
+        double biquadNs = measureNsPerSample([&] {
+            biquad.processBlock(input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        double svfNs = measureNsPerSample([&] {
+            svf.processBlock(input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        float cutoff = 1000.0f;
+        double rampNs = measureNsPerSample([&] {
+            cutoff = cutoff > 16000.0f ? 100.0f : cutoff * 1.05f;
+            modulated.setCutoff(cutoff);
+            modulated.processBlock(input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        std::printf("%8d %16.3f %16.3f %18.3f\n", blockSize, biquadNs, svfNs, rampNs);
+    }
+}
+
+// 32- against 64-bit processing, and the 64-bit buffers converted to float
+// and back around the 32-bit engine (what a double-precision host does for
+// a plugin without kSample64 support).
+void benchmarkSampleWidths()
+{
+    const int numChannels = 2;
+    const char* const names[] = { "6 dB", "24 dB", "svf" };
+
+    std::printf("\nSample width LPF, %d channels\n", numChannels);
+    std::printf("%8s %8s %16s %16s %18s\n", "filter", "block", "float ns/smp", "double ns/smp", "converted ns/smp");
+
+    for (int structure = 0; structure < 3; ++structure) {
+        for (int blockSize : kBlockSizes) {
+            ChannelBuffers<float> input(numChannels, blockSize);
+            ChannelBuffers<float> output(numChannels, blockSize);
+            ChannelBuffers<double> input64(numChannels, blockSize);
+            ChannelBuffers<double> output64(numChannels, blockSize);
+
+            BenchEngine engine = makeEngine(FilterDSP::kFilterTypeLowPass);
+            FilterDSP::FilterEngine<double> engine64 = makeEngine<double>(FilterDSP::kFilterTypeLowPass);
+            if (structure == 1) {
+                engine.setSlope(FilterDSP::kSlope24dB);
+                engine64.setSlope(FilterDSP::kSlope24dB);
+            }
+            else if (structure == 2) {
+                engine.setMode(FilterDSP::kFilterModeStateVariable);
+                engine64.setMode(FilterDSP::kFilterModeStateVariable);
+            }
+
+            double floatNs = measureNsPerSample([&] {
+                engine.processBlock(input.get(), output.get(), numChannels, blockSize);
+                consume(output.data[0].data());
+            }, numChannels, blockSize);
+
+            double doubleNs = measureNsPerSample([&] {
+                engine64.processBlock(input64.get(), output64.get(), numChannels, blockSize);
+                consume(output64.data[0].data());
+            }, numChannels, blockSize);
+
+            double convertedNs = measureNsPerSample([&] {
+                for (int channel = 0; channel < numChannels; ++channel)
+                    for (int sample = 0; sample < blockSize; ++sample)
+                        input.data[channel][sample] = float(input64.data[channel][sample]);
+                engine.processBlock(input.get(), output.get(), numChannels, blockSize);
+                for (int channel = 0; channel < numChannels; ++channel)
+                    for (int sample = 0; sample < blockSize; ++sample)
+                        output64.data[channel][sample] = output.data[channel][sample];
+                consume(output64.data[0].data());
+            }, numChannels, blockSize);
+
+            std::printf("%8s %8d %16.3f %16.3f %18.3f\n", names[structure], blockSize,
+                        floatNs, doubleNs, convertedNs);
+        }
+    }
+}
+
+// Bypass: the active filter, a bypass toggle every block (always fading),
+// and a settled bypass processed in place and out of place.
+void benchmarkBypass()
+{
+    const int numChannels = 2;
+    const int fadeLength = int(FilterDSP::kDefaultBypassFadeTime * 48000.0);
+
+    std::printf("\nBypass LPF, %d channels, %d-sample fade\n", numChannels, fadeLength);
+    std::printf("%8s %14s %14s %16s %16s\n", "block", "active ns/smp", "fading ns/smp", "in-place ns/smp", "copy ns/smp");
+
+    for (int blockSize : kBlockSizes) {
+        ChannelBuffers<float> input(numChannels, blockSize);
+        ChannelBuffers<float> output(numChannels, blockSize);
+
+        BenchEngine engine = makeEngine(FilterDSP::kFilterTypeLowPass);
+        FilterDSP::BypassFader<float> bypass;
+        bypass.setFadeLength(fadeLength);
+
+        double activeNs = measureNsPerSample([&] {
+            bypass.process(engine, input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        double fadingNs = measureNsPerSample([&] {
+            bypass.setBypassed(!bypass.isBypassed());
+            bypass.process(engine, input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        bypass.reset(true);
+        double inPlaceNs = measureNsPerSample([&] {
+            bypass.process(engine, output.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        double copyNs = measureNsPerSample([&] {
+            bypass.process(engine, input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        std::printf("%8d %14.3f %14.3f %16.3f %16.3f\n", blockSize, activeNs, fadingNs, inPlaceNs, copyNs);
+    }
+}
+
+// Cost per oversampling factor: up/down sampling plus the filter running
+// at the higher rate, per host-rate sample
+void benchmarkOversampling()
+{
+    const int numChannels = 2;
+    const int blockSizes[] = { 64, 512 };
+    const char* const factors[] = { "1x", "2x", "4x", "8x" };
+
+    std::printf("\nOversampling LPF, %d channels (ns per host-rate sample)\n", numChannels);
+    std::printf("%8s %8s %8s %12s %12s %12s %12s\n", "block", "factor", "latency", "6 dB", "24 dB", "svf", "ladder");
+
+    for (int blockSize : blockSizes) {
+        ChannelBuffers<float> input(numChannels, blockSize);
+        ChannelBuffers<float> output(numChannels, blockSize);
+
+        for (int factor = 0; factor < FilterDSP::kNumOversamplingFactors; ++factor) {
+            double ns[4];
+            int latency = 0;
+            for (int structure = 0; structure < 4; ++structure) {
+                BenchEngine engine = makeEngine(FilterDSP::kFilterTypeLowPass);
+                engine.setOversampling(factor);
+                if (structure == 1)
+                    engine.setSlope(FilterDSP::kSlope24dB);
+                else if (structure == 2)
+                    engine.setMode(FilterDSP::kFilterModeStateVariable);
+                else if (structure == 3) {
+                    engine.setMode(FilterDSP::kFilterModeLadder);
+                    engine.setResonance(0.7f);
+                }
+                latency = engine.getLatencySamples();
+
+                ns[structure] = measureNsPerSample([&] {
+                    engine.processBlock(input.get(), output.get(), numChannels, blockSize);
+                    consume(output.data[0].data());
+                }, numChannels, blockSize);
+            }
+            std::printf("%8d %8s %8d %12.3f %12.3f %12.3f %12.3f\n", blockSize, factors[factor], latency, ns[0], ns[1], ns[2], ns[3]);
+        }
+    }
+}
+
+// Linear-phase mode for the host block sizes: partition size, latency,
+// the cost of a kernel redesign on the worker thread and the convolution
+// cost, next to the minimum-phase 24 dB cascade
+void benchmarkLinearPhase()
+{
+    const int numChannels = 2;
+    const int blockSizes[] = { 64, 256, 1024, 4096 };
+
+    std::printf("\nLinear phase LPF 24 dB, %d channels, 48 kHz (ns per sample)\n", numChannels);
+    std::printf("%8s %10s %8s %10s %12s %12s\n", "block", "partition", "latency", "design ms", "linear", "min phase");
+
+    for (int blockSize : blockSizes) {
+        ChannelBuffers<float> input(numChannels, blockSize);
+        ChannelBuffers<float> output(numChannels, blockSize);
+
+        BenchEngine engine = makeEngine(FilterDSP::kFilterTypeLowPass);
+        engine.setSlope(FilterDSP::kSlope24dB);
+        const double minPhase = measureNsPerSample([&] {
+            engine.processBlock(input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        engine.setMode(FilterDSP::kFilterModeLinearPhase);
+        engine.prepare(numChannels, blockSize);
+        const double linear = measureNsPerSample([&] {
+            engine.processBlock(input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        // One kernel design as the worker runs it
+        FilterDSP::LinearPhaseFilter<float> filter;
+        filter.prepare(numChannels, blockSize, 48000.0, nullptr);
+        const int partitionSize = filter.getPartitionSize();
+        const FilterDSP::LinearPhaseDesign design = { FilterDSP::kFilterTypeLowPass, FilterDSP::kSlope24dB,
+                                                      FilterDSP::kAlignmentButterworth, 1000.0, 48000.0,
+                                                      FilterDSP::kDefaultQ, 0.0 };
+        const auto start = std::chrono::steady_clock::now();
+        consume(FilterDSP::designLinearPhaseKernel<float>(filter.getKernelKey(design)).re.data());
+        const double designMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        std::printf("%8d %10d %8d %10.2f %12.3f %12.3f\n", blockSize, partitionSize,
+                    engine.getLatencySamples(), designMs, linear, minPhase);
+    }
+}
+
+// Uniform against non-uniform partitioning of the linear-phase kernel at
+// small host blocks. "total" is all of the convolution work on the audio
+// thread (the benchmark outruns real time, so the audio thread computes the
+// background blocks itself); "audio" waits for the worker after every block
+// and only times the audio thread, as in a real-time stream.
+void benchmarkPartitioning()
+{
+    const int numChannels = 2;
+    const int blockSizes[] = { 64, 128, 256 };
+    const FilterDSP::LinearPhaseDesign design = { FilterDSP::kFilterTypeLowPass, FilterDSP::kSlope24dB,
+                                                  FilterDSP::kAlignmentButterworth, 1000.0, 48000.0,
+                                                  FilterDSP::kDefaultQ, 0.0 };
+
+    std::printf("\nLinear phase partitioning, %d channels, 48 kHz (ns per sample)\n", numChannels);
+    std::printf("%8s %8s %10s %16s %16s %8s\n", "block", "levels", "uniform", "non-uni total", "non-uni audio", "misses");
+
+    for (int blockSize : blockSizes) {
+        ChannelBuffers<float> input(numChannels, blockSize);
+        ChannelBuffers<float> output(numChannels, blockSize);
+
+        FilterDSP::LinearPhaseFilter<float> uniform;
+        uniform.prepare(numChannels, blockSize, 48000.0, &design, FilterDSP::kPartitioningUniform);
+        const double uniformNs = measureNsPerSample([&] {
+            uniform.process(input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        FilterDSP::LinearPhaseFilter<float> nonUniform;
+        nonUniform.prepare(numChannels, blockSize, 48000.0, &design);
+        const double totalNs = measureNsPerSample([&] {
+            nonUniform.process(input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+
+        const unsigned missesBefore = nonUniform.getDeadlineMisses();
+        const int numBlocks = (1 << 18) / blockSize;
+        double audioNs = 0.0;
+        for (int block = 0; block < numBlocks; ++block) {
+            const auto start = std::chrono::steady_clock::now();
+            nonUniform.process(input.get(), output.get(), numChannels, blockSize);
+            audioNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            consume(output.data[0].data());
+            while (!nonUniform.isBackgroundIdle())
+                std::this_thread::yield();
+        }
+        audioNs /= double(numBlocks) * blockSize * numChannels;
+
+        std::printf("%8d %8d %10.3f %16.3f %16.3f %8u\n", blockSize, int(nonUniform.getPartitionLevels().size()),
+                    uniformNs, totalNs, audioNs, nonUniform.getDeadlineMisses() - missesBefore);
+    }
+}
+
+// Instances loading the same linear-phase preset: the first prepare
+// designs the kernel, the others take it from the shared cache. "retune"
+// is one audio-thread request for a kernel that is already cached.
+void benchmarkSharedDesigns()
+{
+    const int numInstances = 16;
+    const int numChannels = 2;
+    const int blockSize = 256;
+    typedef FilterDSP::LinearPhaseKernelCache<float> Cache;
+
+    std::printf("\nLinear phase shared designs, %d instances, block %d, 48 kHz\n", numInstances, blockSize);
+    std::printf("%14s %14s %10s %12s %14s\n", "first ms", "others ms", "designs", "kernel KB", "retune ns");
+
+    // A cutoff no other benchmark designed
+    const FilterDSP::LinearPhaseDesign design = { FilterDSP::kFilterTypeLowPass, FilterDSP::kSlope24dB,
+                                                  FilterDSP::kAlignmentButterworth, 1234.5, 48000.0,
+                                                  FilterDSP::kDefaultQ, 0.0 };
+    std::vector<FilterDSP::LinearPhaseFilter<float>> filters(numInstances);
+    const int entriesBefore = Cache::get().getNumEntries();
+    double firstMs = 0.0;
+    double othersMs = 0.0;
+    for (int i = 0; i < numInstances; ++i) {
+        const auto start = std::chrono::steady_clock::now();
+        filters[i].prepare(numChannels, blockSize, 48000.0, &design);
+        const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (i == 0)
+            firstMs = ms;
+        else
+            othersMs += ms / (numInstances - 1);
+    }
+    const int designs = Cache::get().getNumEntries() - entriesBefore;
+
+    const FilterDSP::LinearPhaseKey key = filters[0].getKernelKey(design);
+    const Cache::Entry* entry = Cache::get().find(key);
+    const double kernelKb = entry ? double(entry->value.re.size() * 2 * sizeof(float)) / 1024.0 : 0.0;
+    Cache::release(entry);
+
+    const int numLookups = 1 << 16;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < numLookups; ++i) {
+        const Cache::Entry* found = Cache::get().find(key);
+        consume(&found);
+        Cache::release(found);
+    }
+    const double retuneNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / numLookups;
+
+    std::printf("%14.2f %14.3f %10d %12.0f %14.1f\n", firstMs, othersMs, designs, kernelKb, retuneNs);
+}
+
+// One plugin instance of the scaling benchmark, allocated the way
+// FilterVST3 allocates its process state
+struct ScalingInstance
+{
+    ScalingInstance(int numChannels, int blockSize)
+    : engine(makeEngine(FilterDSP::kFilterTypeLowPass))
+    , input(numChannels, blockSize)
+    , output(numChannels, blockSize)
+    {
+        engine.setSlope(FilterDSP::kSlope24dB);
+        engine.prepare(numChannels, blockSize);
+    }
+
+    BenchEngine engine;
+    ChannelBuffers<float> input;
+    ChannelBuffers<float> output;
+};
+
+// N instances on N threads, as hosts process tracks: each thread runs its
+// own 24 dB engine and retunes the cutoff every block. With no state
+// shared between instances the throughput grows with the threads up to the
+// number of cores; "scaling" is the throughput relative to one thread.
+void benchmarkInstanceScaling()
+{
+    const int numChannels = 2;
+    const int blockSize = 128;
+    const int numBlocks = 1 << 14;
+    const int numCores = std::max(1, int(std::thread::hardware_concurrency()));
+
+    std::printf("\nInstance scaling, 24 dB LPF, %d channels, block %d, %d hardware threads\n",
+                numChannels, blockSize, numCores);
+    std::printf("%8s %14s %16s %10s\n", "threads", "ns/sample", "Msamples/s", "scaling");
+
+    double baseline = 0.0;
+    for (int numThreads = 1; numThreads <= std::min(numCores, 64); numThreads *= 2) {
+        std::vector<FilterDSP::CacheAlignedPtr<ScalingInstance>> instances;
+        for (int i = 0; i < numThreads; ++i)
+            instances.push_back(FilterDSP::CacheAlignedPtr<ScalingInstance>::make(numChannels, blockSize));
+
+        std::atomic<bool> go(false);
+        std::vector<double> threadNs(numThreads, 0.0);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; ++t) {
+            threads.emplace_back([&, t] {
+                ScalingInstance& instance = *instances[t];
+                while (!go.load())
+                    std::this_thread::yield();
+                const auto start = std::chrono::steady_clock::now();
+                for (int block = 0; block < numBlocks; ++block) {
+                    instance.engine.setCutoff(float(1000 + (block & 63) * 50));
+                    instance.engine.processBlock(instance.input.get(), instance.output.get(), numChannels, blockSize);
+                    consume(instance.output.data[0].data());
+                }
+                threadNs[t] = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            });
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        go.store(true);
+        for (std::thread& thread : threads)
+            thread.join();
+        const double wallNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        const double samplesPerThread = double(numBlocks) * blockSize * numChannels;
+        double nsPerSample = 0.0;
+        for (int t = 0; t < numThreads; ++t)
+            nsPerSample += threadNs[t] / samplesPerThread / numThreads;
+        const double throughput = samplesPerThread * numThreads / wallNs * 1e3;
+        if (numThreads == 1)
+            baseline = throughput;
+        std::printf("%8d %14.3f %16.1f %10.2f\n", numThreads, nsPerSample, throughput, throughput / baseline);
+    }
+}
+
+// Offline rendering of one long block: the serial kernels against the
+// parallel chunks (ParallelScan.h) on 2 up to the number of hardware
+// threads. "speedup" is relative to the serial engine; with one hardware
+// thread the chunks share it and only the extra work shows.
+void benchmarkParallelScan()
+{
+    struct Case
+    {
+        const char* name;
+        int mode;
+        int slope;
+    };
+    const Case cases[] = {
+        { "6 dB", FilterDSP::kFilterModeStandard, FilterDSP::kSlope6dB },
+        { "24 dB", FilterDSP::kFilterModeStandard, FilterDSP::kSlope24dB },
+        { "svf", FilterDSP::kFilterModeStateVariable, FilterDSP::kSlope12dB }
+    };
+    const int numChannels = 2;
+    const int blockSize = 1 << 16;
+    const int numCores = std::max(1, int(std::thread::hardware_concurrency()));
+    const int maxThreads = std::max(2, std::min(numCores, FilterDSP::kMaxScanChunks));
+    FilterDSP::ScopedNoDenormals noDenormals;  // as in the render callback
+
+    std::printf("\nOffline parallel LPF, %d channels, block %d, %d hardware threads\n",
+                numChannels, blockSize, numCores);
+    std::printf("%8s %8s %14s %10s\n", "filter", "threads", "ns/sample", "speedup");
+
+    ChannelBuffers<float> input(numChannels, blockSize);
+    ChannelBuffers<float> output(numChannels, blockSize);
+    for (const Case& c : cases) {
+        BenchEngine engine = makeEngine(FilterDSP::kFilterTypeLowPass);
+        engine.setMode(c.mode);
+        engine.setSlope(c.slope);
+        engine.prepare(numChannels, blockSize);
+        const double serialNs = measureNsPerSample([&] {
+            engine.processBlock(input.get(), output.get(), numChannels, blockSize);
+            consume(output.data[0].data());
+        }, numChannels, blockSize);
+        std::printf("%8s %8d %14.3f %10.2f\n", c.name, 1, serialNs, 1.0);
+
+        engine.setParallelProcessing(true);
+        for (int numThreads = 2; numThreads <= maxThreads; numThreads *= 2) {
+            FilterDSP::ScanWorkers::get().setNumThreads(numThreads);
+            engine.prepare(numChannels, blockSize);
+            const double ns = measureNsPerSample([&] {
+                engine.processBlock(input.get(), output.get(), numChannels, blockSize);
+                consume(output.data[0].data());
+            }, numChannels, blockSize);
+            std::printf("%8s %8d %14.3f %10.2f\n", c.name, numThreads, ns, serialNs / ns);
+        }
+        engine.setParallelProcessing(false);
+        engine.prepare(numChannels, blockSize);
+    }
+    FilterDSP::ScanWorkers::get().setNumThreads(0);
+}
+
+#if defined(FILTERDSP_RUNTIME_DISPATCH)
+// Every runtime-dispatched kernel variant this CPU runs, on the same
+// engines: fixed and retuned-every-block cutoffs for each structure, at
+// bus widths that fill the 4-, 8- and 16-lane vectors.
+void benchmarkKernelVariants()
+{
+    struct Case
+    {
+        const char* name;
+        int mode;
+        int slope;
+        bool ramp;
+    };
+    const Case cases[] = {
+        { "6 dB", FilterDSP::kFilterModeStandard, FilterDSP::kSlope6dB, false },
+        { "6 dB ramp", FilterDSP::kFilterModeStandard, FilterDSP::kSlope6dB, true },
+        { "24 dB", FilterDSP::kFilterModeStandard, FilterDSP::kSlope24dB, false },
+        { "24 dB ramp", FilterDSP::kFilterModeStandard, FilterDSP::kSlope24dB, true },
+        { "svf", FilterDSP::kFilterModeStateVariable, FilterDSP::kSlope12dB, false },
+        { "svf ramp", FilterDSP::kFilterModeStateVariable, FilterDSP::kSlope12dB, true },
+        { "ladder", FilterDSP::kFilterModeLadder, FilterDSP::kSlope24dB, false },
+        { "ladder ramp", FilterDSP::kFilterModeLadder, FilterDSP::kSlope24dB, true }
+    };
+    const int channelCounts[] = { 2, 8, 16 };
+    const int blockSize = 128;
+    const int selected = FilterDSP::getKernelIsa();
+
+    std::printf("\nKernel variants LPF, block %d, ns/smp (selected: %s)\n", blockSize,
+                FilterDSP::getKernelIsaName(selected));
+    std::printf("%12s %8s", "kernel", "channels");
+    for (int isa = 0; isa < FilterDSP::kNumKernelIsas; ++isa)
+        if (FilterDSP::isKernelIsaAvailable(isa))
+            std::printf(" %10s", FilterDSP::getKernelIsaName(isa));
+    std::printf("\n");
+
+    for (const Case& c : cases) {
+        for (int numChannels : channelCounts) {
+            ChannelBuffers<float> input(numChannels, blockSize);
+            ChannelBuffers<float> output(numChannels, blockSize);
+
+            BenchEngine engine = makeEngine(FilterDSP::kFilterTypeLowPass);
+            engine.prepare(numChannels);
+            engine.setMode(c.mode);
+            engine.setSlope(c.slope);
+            if (c.ramp)
+                engine.setSmoothingTime(float(FilterDSP::kDefaultSmoothingTime));
+
+            std::printf("%12s %8d", c.name, numChannels);
+            for (int isa = 0; isa < FilterDSP::kNumKernelIsas; ++isa) {
+                if (!FilterDSP::setKernelIsa(isa))
+                    continue;
+                float cutoff = 1000.0f;
+                double ns = measureNsPerSample([&] {
+                    if (c.ramp) {
+                        cutoff = cutoff > 4000.0f ? 1000.0f : cutoff * 1.01f;
+                        engine.setCutoff(cutoff);
+                    }
+                    engine.processBlock(input.get(), output.get(), numChannels, blockSize);
+                    consume(output.data[0].data());
+                }, numChannels, blockSize);
+                std::printf(" %10.3f", ns);
+            }
+            std::printf("\n");
+        }
+    }
+
+    FilterDSP::setKernelIsa(selected);
+}
+#endif
+
+// Denormal regression: a unit impulse followed by silence (the filter
+// memory decays through the subnormal range) and subnormal noise as input,
+// with and without ScopedNoDenormals. The legacy filter has neither the
+// guard nor the engine's state flushing and shows the spike.
+void benchmarkDenormals()
+{
+    const int numChannels = 2;
+    const int blockSize = 256;
+    const int numBlocks = 600;
+    const float cutoff = 50.0f;
+    const char* const names[] = { "6 dB", "24 dB", "svf" };
+
+    ChannelBuffers<float> impulse(numChannels, blockSize);
+    ChannelBuffers<float> silence(numChannels, blockSize);
+    ChannelBuffers<float> subnormal(numChannels, blockSize);
+    ChannelBuffers<float> output(numChannels, blockSize);
+    for (int channel = 0; channel < numChannels; ++channel) {
+        for (int sample = 0; sample < blockSize; ++sample) {
+            impulse.data[channel][sample] = sample == 0 ? 1.0f : 0.0f;
+            silence.data[channel][sample] = 0.0f;
+            subnormal.data[channel][sample] *= 1e-39f;
+        }
+    }
+
+    std::printf("\nDenormals LPF %.0f Hz, %d channels, %d blocks of %d\n", cutoff, numChannels, numBlocks, blockSize);
+    std::printf("%8s %10s %16s %16s\n", "filter", "input", "no guard ns/smp", "guarded ns/smp");
+
+    for (int input = 0; input < 2; ++input) {
+        const char* inputName = input == 0 ? "decay" : "subnormal";
+        float* const* firstBlock = input == 0 ? impulse.get() : subnormal.get();
+        float* const* otherBlocks = input == 0 ? silence.get() : subnormal.get();
+
+        auto runLegacy = [&] {
+            LegacyFilter legacy;
+            legacy.sampleRate = 48000.0f;
+            legacy.cutoffFreq = cutoff;
+            for (int block = 0; block < numBlocks; ++block) {
+                legacy.processBlock(block == 0 ? firstBlock : otherBlocks, output.get(), numChannels, blockSize);
+                consume(output.data[0].data());
+            }
+        };
+        double legacyNs[2];
+        legacyNs[0] = measureNsPerSample(runLegacy, numChannels, numBlocks * blockSize, 1 << 22);
+        {
+            FilterDSP::ScopedNoDenormals noDenormals;
+            legacyNs[1] = measureNsPerSample(runLegacy, numChannels, numBlocks * blockSize, 1 << 22);
+        }
+        std::printf("%8s %10s %16.3f %16.3f\n", "legacy", inputName, legacyNs[0], legacyNs[1]);
+
+        for (int structure = 0; structure < 3; ++structure) {
+            BenchEngine engine = makeEngine(FilterDSP::kFilterTypeLowPass);
+            engine.setCutoff(cutoff);
+            if (structure == 1)
+                engine.setSlope(FilterDSP::kSlope24dB);
+            else if (structure == 2)
+                engine.setMode(FilterDSP::kFilterModeStateVariable);
+
+            auto runEngine = [&] {
+                engine.reset();
+                for (int block = 0; block < numBlocks; ++block) {
+                    engine.processBlock(block == 0 ? firstBlock : otherBlocks, output.get(), numChannels, blockSize);
+                    consume(output.data[0].data());
+                }
+            };
+            double ns[2];
+            ns[0] = measureNsPerSample(runEngine, numChannels, numBlocks * blockSize, 1 << 22);
+            {
+                FilterDSP::ScopedNoDenormals noDenormals;
+                ns[1] = measureNsPerSample(runEngine, numChannels, numBlocks * blockSize, 1 << 22);
+            }
+            std::printf("%8s %10s %16.3f %16.3f\n", names[structure], inputName, ns[0], ns[1]);
+        }
+    }
+}
+
+} // namespace
+
+int main()
+{
+    const int channelCounts[] = { 1, 2, 4 };
+
+    for (int numChannels : channelCounts) {
+        benchmarkFilterEngine(FilterDSP::kFilterTypeLowPass, numChannels);
+        benchmarkFilterEngine(FilterDSP::kFilterTypeHighPass, numChannels);
+    }
+
+    benchmarkChannelScaling(FilterDSP::kFilterTypeLowPass);
+    benchmarkChannelScaling(FilterDSP::kFilterTypeHighPass);
+
+    benchmarkSmoothing();
+    benchmarkSlopes();
+    benchmarkStateVariable();
+    benchmarkGraphicEq();
+    benchmarkCrossover();
+    benchmarkSampleWidths();
+    benchmarkBypass();
+    benchmarkDenormals();
+    benchmarkOversampling();
+    benchmarkLinearPhase();
+    benchmarkPartitioning();
+    benchmarkSharedDesigns();
+    benchmarkInstanceScaling();
+    benchmarkParallelScan();
+#if defined(FILTERDSP_RUNTIME_DISPATCH)
+    benchmarkKernelVariants();
+#endif
+    return 0;
+}
@@ -0,0 +1,185 @@
+// Runtime selection of the filter kernel variants (see KernelDispatch.h).
+// Built with the baseline flags of the target, like the code calling it.
+
+#include "KernelVariants.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define FILTERDSP_DISPATCH_X86 1
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+        #include <immintrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    #define FILTERDSP_DISPATCH_ARM64 1
+#endif
+
+namespace FilterDSP {
+
+namespace {
+
+const char* const kIsaNames[kNumKernelIsas] = { "sse2", "avx2", "avx512", "neon" };
+
+const KernelVariant* const kVariants[kNumKernelIsas] = {
+#if defined(FILTERDSP_KERNELS_SSE2)
+    &kKernelVariantSse2,
+#else
+    nullptr,
+#endif
+#if defined(FILTERDSP_KERNELS_AVX2)
+    &kKernelVariantAvx2,
+#else
+    nullptr,
+#endif
+#if defined(FILTERDSP_KERNELS_AVX512)
+    &kKernelVariantAvx512,
+#else
+    nullptr,
+#endif
+#if defined(FILTERDSP_KERNELS_NEON)
+    &kKernelVariantNeon,
+#else
+    nullptr,
+#endif
+};
+
+#if defined(FILTERDSP_DISPATCH_X86)
+void cpuid(unsigned leaf, unsigned subleaf, unsigned* regs)
+{
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, int(leaf), int(subleaf));
+    for (int i = 0; i < 4; ++i)
+        regs[i] = unsigned(r[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// XCR0: the register state the OS saves on a context switch
+unsigned long long readXcr0()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned lo = 0, hi = 0;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<unsigned long long>(hi) << 32) | lo;
+#endif
+}
+
+bool cpuRuns(int isa)
+{
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    const unsigned maxLeaf = regs[0];
+    cpuid(1, 0, regs);
+    const unsigned features1 = regs[2];
+    const bool sse2 = (regs[3] & (1u << 26)) != 0;
+    if (isa == kKernelIsaSse2)
+        return sse2;
+
+    // AVX needs OSXSAVE and the YMM state enabled (XCR0 bits 1-2);
+    // AVX-512 also needs the opmask and ZMM state (bits 5-7)
+    if ((features1 & (1u << 27)) == 0 || maxLeaf < 7)
+        return false;
+    const unsigned long long xcr0 = readXcr0();
+    cpuid(7, 0, regs);
+    const unsigned features7 = regs[1];
+
+    const bool avx2 = (features1 & (1u << 28)) != 0      // AVX
+                   && (features1 & (1u << 12)) != 0      // FMA
+                   && (features7 & (1u << 5)) != 0       // AVX2
+                   && (xcr0 & 0x06) == 0x06;
+    if (isa == kKernelIsaAvx2)
+        return avx2;
+    if (isa == kKernelIsaAvx512)
+        return avx2 && (features7 & (1u << 16)) != 0    // AVX-512F
+                    && (xcr0 & 0xe0) == 0xe0;
+    return false;
+}
+#elif defined(FILTERDSP_DISPATCH_ARM64)
+// NEON is part of the ARMv8-A base architecture
+bool cpuRuns(int isa)
+{
+    return isa == kKernelIsaNeon;
+}
+#else
+bool cpuRuns(int)
+{
+    return false;
+}
+#endif
+
+// Index of the variant in use, -1 until selected
+std::atomic<int> g_kernelIsa(-1);
+
+} // namespace
+
+const char* getKernelIsaName(int isa)
+{
+    return isa >= 0 && isa < kNumKernelIsas ? kIsaNames[isa] : "none";
+}
+
+bool isKernelIsaAvailable(int isa)
+{
+    return isa >= 0 && isa < kNumKernelIsas && kVariants[isa] != nullptr && cpuRuns(isa);
+}
+
+int selectKernelIsa()
+{
+    int selected = g_kernelIsa.load(std::memory_order_acquire);
+    if (selected >= 0)
+        return selected;
+
+    // Variants are listed from the oldest instruction set up
+    int isa = -1;
+    for (int candidate = kNumKernelIsas - 1; candidate >= 0 && isa < 0; --candidate)
+        if (isKernelIsaAvailable(candidate))
+            isa = candidate;
+
+    if (const char* name = std::getenv("FILTERDSP_KERNELS")) {
+        for (int candidate = 0; candidate < kNumKernelIsas; ++candidate)
+            if (std::strcmp(name, kIsaNames[candidate]) == 0 && isKernelIsaAvailable(candidate))
+                isa = candidate;
+    }
+
+    // Another thread may have selected first; both picked the same variant
+    // unless setKernelIsa() got in between, and that choice stands
+    if (g_kernelIsa.compare_exchange_strong(selected, isa, std::memory_order_acq_rel))
+        return isa;
+    return selected;
+}
+
+int getKernelIsa()
+{
+    const int isa = g_kernelIsa.load(std::memory_order_acquire);
+    return isa >= 0 ? isa : selectKernelIsa();
+}
+
+bool setKernelIsa(int isa)
+{
+    if (!isKernelIsaAvailable(isa))
+        return false;
+    g_kernelIsa.store(isa, std::memory_order_release);
+    return true;
+}
+
+template <>
+const FilterKernelTable<float>& getFilterKernels<float>()
+{
+    return kVariants[getKernelIsa()]->floatKernels;
+}
+
+template <>
+const FilterKernelTable<double>& getFilterKernels<double>()
+{
+    return kVariants[getKernelIsa()]->doubleKernels;
+}
+
+} // namespace FilterDSP
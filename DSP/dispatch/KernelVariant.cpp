@@ -0,0 +1,22 @@
+// One instruction-set variant of the filter kernels (see KernelDispatch.h).
+// CMake compiles this file once per variant, with the variant's target
+// flags and FILTERDSP_ISA set to its name (e.g. -mavx2 -mfma
+// -DFILTERDSP_ISA=Avx2). The kernels land in the FilterDSP::<name> inline
+// namespace, so no inline function is shared with another variant or with
+// code built for the baseline target.
+
+#include "KernelVariants.h"
+
+#define FILTERDSP_CONCAT_IMPL(a, b) a##b
+#define FILTERDSP_CONCAT(a, b) FILTERDSP_CONCAT_IMPL(a, b)
+
+namespace FilterDSP {
+
+// Declared extern in KernelVariants.h. Constant-initialized, so the table
+// is valid before any static constructor runs.
+const KernelVariant FILTERDSP_CONCAT(kKernelVariant, FILTERDSP_ISA) = {
+    makeFilterKernelTable<float>(),
+    makeFilterKernelTable<double>()
+};
+
+} // namespace FilterDSP
@@ -0,0 +1,23 @@
+#pragma once
+
+// Kernel variants linked into FilterDSPDispatch. Each one is
+// KernelVariant.cpp compiled with one instruction set's flags, exporting
+// kKernelVariant<name>; CMake defines FILTERDSP_KERNELS_<NAME> for every
+// variant it builds.
+
+#include "KernelDispatch.h"
+
+namespace FilterDSP {
+
+struct KernelVariant
+{
+    FilterKernelTable<float> floatKernels;
+    FilterKernelTable<double> doubleKernels;
+};
+
+extern const KernelVariant kKernelVariantSse2;
+extern const KernelVariant kKernelVariantAvx2;
+extern const KernelVariant kKernelVariantAvx512;
+extern const KernelVariant kKernelVariantNeon;
+
+} // namespace FilterDSP
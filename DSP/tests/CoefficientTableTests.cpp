@@ -0,0 +1,250 @@
+// Accuracy of the compile-time cutoff tables (CoefficientTables.h) and of
+// the biquad, single-section and state variable designs built on them,
+// against the direct std::sin/std::cos/std::tan designs, for both sample
+// rate families.
+
+#include "BiquadDesigner.h"
+#include "SvfDesigner.h"
+
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace {
+
+// The tables are constant expressions
+static_assert(FilterDSP::kCutoffTable.sine[1] > 0.0, "table generated at compile time");
+static_assert(FilterDSP::butterworthQ(2, 0) > 0.70710678 && FilterDSP::butterworthQ(2, 0) < 0.70710679,
+              "Butterworth Q at compile time");
+
+// Accuracy bounds
+const double kMaxSineCosineError = 1e-9;    // absolute, sin(π·r) and cos(π·r)
+const double kMaxTanError = 1e-9;           // relative, g = tan(π·r) up to kMaxCutoffRatio
+const double kMaxCoefficientError = 5e-9;   // absolute, biquad and SVF coefficients
+const double kMaxGainError = 1e-8;          // relative, biquad b0 (sets the passband gain)
+
+const double kPi = 3.14159265358979323846;
+const double kSampleRates[] = { 44100.0, 88200.0, 176400.0, 48000.0, 96000.0, 192000.0 };
+
+int g_failures = 0;
+
+void check(bool condition, const char* what, double value, double bound)
+{
+    if (!condition) {
+        std::printf("FAIL %s: %.3g (bound %.3g)\n", what, value, bound);
+        ++g_failures;
+    }
+}
+
+// Log-spaced ratios over the table, plus the grid points themselves
+template <typename Test>
+void sweepRatios(Test&& test)
+{
+    const double minRatio = std::ldexp(1.0, FilterDSP::kCutoffTableMinOctave);
+    const int numSteps = 200000;
+    for (int step = 0; step <= numSteps; ++step)
+        test(minRatio * std::pow(FilterDSP::kMaxCutoffRatio / minRatio, double(step) / numSteps));
+    for (int octave = FilterDSP::kCutoffTableMinOctave; octave <= FilterDSP::kCutoffTableMaxOctave; ++octave)
+        for (int point = 0; point < FilterDSP::kCutoffTablePointsPerOctave; ++point)
+            test(std::ldexp(1.0 + double(point) / FilterDSP::kCutoffTablePointsPerOctave, octave));
+}
+
+void testSineCosine()
+{
+    double sineError = 0.0, cosineError = 0.0, tanError = 0.0;
+    bool found = true;
+    sweepRatios([&](double ratio) {
+        FilterDSP::CutoffSineCosine half = {};
+        found = found && FilterDSP::lookupCutoff(ratio, half);
+        sineError = std::fmax(sineError, std::fabs(half.sine - std::sin(kPi * ratio)));
+        cosineError = std::fmax(cosineError, std::fabs(half.cosine - std::cos(kPi * ratio)));
+        if (ratio <= FilterDSP::kMaxCutoffRatio) {
+            const double g = std::tan(kPi * ratio);
+            tanError = std::fmax(tanError, std::fabs(half.sine / half.cosine - g) / g);
+        }
+    });
+    std::printf("sin(pi r) error %.3g, cos(pi r) error %.3g, tan(pi r) relative error %.3g\n",
+                sineError, cosineError, tanError);
+    check(found, "lookup inside the table", 0.0, 0.0);
+    check(sineError < kMaxSineCosineError, "sin(pi r)", sineError, kMaxSineCosineError);
+    check(cosineError < kMaxSineCosineError, "cos(pi r)", cosineError, kMaxSineCosineError);
+    check(tanError < kMaxTanError, "tan(pi r)", tanError, kMaxTanError);
+}
+
+void testOutOfRange()
+{
+    const double outside[] = { 0.0, -0.1, 0.5, 1.0, std::ldexp(1.0, FilterDSP::kCutoffTableMinOctave - 1),
+                               std::numeric_limits<double>::infinity(), std::numeric_limits<double>::quiet_NaN() };
+    for (double ratio : outside) {
+        FilterDSP::CutoffSineCosine half = {};
+        check(!FilterDSP::lookupCutoff(ratio, half), "lookup outside the table", ratio, 0.0);
+    }
+}
+
+// The designs before the tables, with std::sin/std::cos/std::tan
+FilterDSP::BiquadCoefficients<double> referenceBiquad(int filterType, double cutoffFreq, double sampleRate, double q)
+{
+    const double fc = std::fmin(cutoffFreq, FilterDSP::kMaxCutoffRatio * sampleRate);
+    const double w0 = 2.0 * kPi * fc / sampleRate;
+    const double cosw = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * q);
+    const double a0 = 1.0 + alpha;
+    const double b0 = filterType == FilterDSP::kFilterTypeLowPass ? 0.5 * (1.0 - cosw) : 0.5 * (1.0 + cosw);
+    const double b1 = filterType == FilterDSP::kFilterTypeLowPass ? 1.0 - cosw : -(1.0 + cosw);
+
+    FilterDSP::BiquadCoefficients<double> c;
+    c.b0 = b0 / a0;
+    c.b1 = b1 / a0;
+    c.b2 = b0 / a0;
+    c.a1 = -2.0 * cosw / a0;
+    c.a2 = (1.0 - alpha) / a0;
+    return c;
+}
+
+// The Audio EQ Cookbook sections as published, with std::sin/std::cos
+FilterDSP::BiquadCoefficients<double> referenceSection(int filterType, double cutoffFreq, double sampleRate,
+                                                       double q, double gainDb)
+{
+    const double fc = std::fmin(cutoffFreq, FilterDSP::kMaxCutoffRatio * sampleRate);
+    const double w0 = 2.0 * kPi * fc / sampleRate;
+    const double cosw = std::cos(w0);
+    const double alpha = std::sin(w0) / (2.0 * q);
+    const double a = std::pow(10.0, gainDb / 40.0);
+    const double root = 2.0 * std::sqrt(a) * alpha;
+
+    double b[3], den[3];
+    switch (filterType)
+    {
+        case FilterDSP::kFilterTypeBandPass:
+            b[0] = alpha; b[1] = 0.0; b[2] = -alpha;
+            den[0] = 1.0 + alpha; den[1] = -2.0 * cosw; den[2] = 1.0 - alpha;
+            break;
+        case FilterDSP::kFilterTypeNotch:
+            b[0] = 1.0; b[1] = -2.0 * cosw; b[2] = 1.0;
+            den[0] = 1.0 + alpha; den[1] = -2.0 * cosw; den[2] = 1.0 - alpha;
+            break;
+        case FilterDSP::kFilterTypePeak:
+            b[0] = 1.0 + alpha * a; b[1] = -2.0 * cosw; b[2] = 1.0 - alpha * a;
+            den[0] = 1.0 + alpha / a; den[1] = -2.0 * cosw; den[2] = 1.0 - alpha / a;
+            break;
+        case FilterDSP::kFilterTypeLowShelf:
+            b[0] = a * ((a + 1.0) - (a - 1.0) * cosw + root);
+            b[1] = 2.0 * a * ((a - 1.0) - (a + 1.0) * cosw);
+            b[2] = a * ((a + 1.0) - (a - 1.0) * cosw - root);
+            den[0] = (a + 1.0) + (a - 1.0) * cosw + root;
+            den[1] = -2.0 * ((a - 1.0) + (a + 1.0) * cosw);
+            den[2] = (a + 1.0) + (a - 1.0) * cosw - root;
+            break;
+        case FilterDSP::kFilterTypeHighShelf:
+            b[0] = a * ((a + 1.0) + (a - 1.0) * cosw + root);
+            b[1] = -2.0 * a * ((a - 1.0) + (a + 1.0) * cosw);
+            b[2] = a * ((a + 1.0) + (a - 1.0) * cosw - root);
+            den[0] = (a + 1.0) - (a - 1.0) * cosw + root;
+            den[1] = 2.0 * ((a - 1.0) - (a + 1.0) * cosw);
+            den[2] = (a + 1.0) - (a - 1.0) * cosw - root;
+            break;
+        default:
+            b[0] = 1.0 - alpha; b[1] = -2.0 * cosw; b[2] = 1.0 + alpha;
+            den[0] = 1.0 + alpha; den[1] = -2.0 * cosw; den[2] = 1.0 - alpha;
+            break;
+    }
+
+    FilterDSP::BiquadCoefficients<double> c;
+    c.b0 = b[0] / den[0];
+    c.b1 = b[1] / den[0];
+    c.b2 = b[2] / den[0];
+    c.a1 = den[1] / den[0];
+    c.a2 = den[2] / den[0];
+    return c;
+}
+
+double biquadError(const FilterDSP::BiquadCoefficients<double>& a, const FilterDSP::BiquadCoefficients<double>& b)
+{
+    return std::fmax(std::fmax(std::fmax(std::fabs(a.b0 - b.b0), std::fabs(a.b1 - b.b1)),
+                               std::fmax(std::fabs(a.b2 - b.b2), std::fabs(a.a1 - b.a1))),
+                     std::fabs(a.a2 - b.a2));
+}
+
+void testDesigns()
+{
+    const double qs[] = { 0.5, 0.5411961001, 0.7071067812, 1.3065629649, 2.5629154477 };
+    double biquadMax = 0.0, gainMax = 0.0, svfMax = 0.0, warpedMax = 0.0;
+
+    for (double sampleRate : kSampleRates) {
+        for (double cutoff = 20.0; cutoff <= 0.5 * sampleRate; cutoff *= 1.0137) {
+            for (int filterType = FilterDSP::kFilterTypeLowPass; filterType <= FilterDSP::kFilterTypeHighPass; ++filterType) {
+                for (double q : qs) {
+                    const FilterDSP::BiquadCoefficients<double> table = FilterDSP::designBiquad<double>(filterType, cutoff, sampleRate, q);
+                    const FilterDSP::BiquadCoefficients<double> reference = referenceBiquad(filterType, cutoff, sampleRate, q);
+                    biquadMax = std::fmax(biquadMax, biquadError(table, reference));
+                    gainMax = std::fmax(gainMax, std::fabs(table.b0 - reference.b0) / reference.b0);
+                }
+            }
+
+            const double fc = std::fmin(cutoff, FilterDSP::kMaxCutoffRatio * sampleRate);
+            const double g = std::tan(kPi * fc / sampleRate);
+            const double a1 = 1.0 / (1.0 + g * (g + FilterDSP::kSvfDamping));
+            const FilterDSP::SvfCoefficients<double> svf = FilterDSP::SvfCoefficients<double>::design(cutoff, sampleRate);
+            svfMax = std::fmax(svfMax, std::fmax(std::fabs(svf.a1 - a1),
+                                                 std::fmax(std::fabs(svf.a2 - g * a1), std::fabs(svf.a3 - g * g * a1))));
+
+            // The per-sample ramps use the rational tan; they must meet the
+            // table design where a ramp ends
+            const FilterDSP::SvfCoefficients<double> warped = FilterDSP::SvfCoefficients<double>::designWarped(kPi * fc / sampleRate);
+            warpedMax = std::fmax(warpedMax, std::fabs(warped.a1 - svf.a1));
+        }
+    }
+
+    std::printf("biquad coefficient error %.3g, b0 relative error %.3g, svf coefficient error %.3g, svf ramp/table mismatch %.3g\n",
+                biquadMax, gainMax, svfMax, warpedMax);
+    check(biquadMax < kMaxCoefficientError, "biquad coefficients", biquadMax, kMaxCoefficientError);
+    check(gainMax < kMaxGainError, "biquad b0", gainMax, kMaxGainError);
+    check(svfMax < kMaxCoefficientError, "svf coefficients", svfMax, kMaxCoefficientError);
+    check(warpedMax < 1e-6, "svf ramp against table design", warpedMax, 1e-6);
+}
+
+// Band pass, notch, bell, shelves and all-pass, relative to the largest
+// coefficient (the shelf numerators grow with the gain)
+void testSections()
+{
+    const double qs[] = { FilterDSP::kMinQ, 0.5, FilterDSP::kDefaultQ, 2.0, FilterDSP::kMaxQ };
+    const double gains[] = { -FilterDSP::kMaxGainDb, -6.0, 0.0, 3.0, FilterDSP::kMaxGainDb };
+    double sectionMax = 0.0;
+
+    for (double sampleRate : kSampleRates) {
+        for (double cutoff = 20.0; cutoff <= 0.5 * sampleRate; cutoff *= 1.0731) {
+            for (int filterType = FilterDSP::kFilterTypeBandPass; filterType < FilterDSP::kNumFilterTypes; ++filterType) {
+                for (double q : qs) {
+                    for (double gainDb : gains) {
+                        const FilterDSP::BiquadCoefficients<double> table =
+                            FilterDSP::designSection<double>(filterType, cutoff, sampleRate, q, gainDb);
+                        const FilterDSP::BiquadCoefficients<double> reference =
+                            referenceSection(filterType, cutoff, sampleRate, q, gainDb);
+                        const double scale = std::fmax(1.0, std::fmax(std::fabs(reference.b0), std::fabs(reference.b1)));
+                        sectionMax = std::fmax(sectionMax, biquadError(table, reference) / scale);
+                    }
+                }
+            }
+        }
+    }
+
+    std::printf("section coefficient error %.3g\n", sectionMax);
+    check(sectionMax < kMaxCoefficientError, "section coefficients", sectionMax, kMaxCoefficientError);
+}
+
+} // namespace
+
+int main()
+{
+    testSineCosine();
+    testOutOfRange();
+    testDesigns();
+    testSections();
+
+    if (g_failures != 0) {
+        std::printf("%d check(s) failed\n", g_failures);
+        return 1;
+    }
+    std::printf("all checks passed\n");
+    return 0;
+}
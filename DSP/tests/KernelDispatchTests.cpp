@@ -0,0 +1,692 @@
+// Golden outputs for every runtime-dispatched kernel variant this machine
+// runs (KernelDispatch.h). Each variant's kernel table, and the engine on
+// top of it, must match a plain double-precision implementation of the
+// same recurrences: all filter structures and responses, the graphic EQ
+// bank in both layouts, the crossover at every band count, fixed and
+// ramped coefficients, channel counts that fill every vector width and leave
+// partial groups, and blocks that leave partial tiles.
+
+#include "FilterEngine.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+// Largest difference from the reference, relative to the unit input
+const double kMaxFloatError = 2e-5;
+const double kMaxDoubleError = 1e-11;
+
+// The lowest graphic EQ bells (about 22 Hz at 48 kHz) have their poles
+// within 0.3% of the unit circle, which amplifies float rounding in the
+// recurrence; the float banks get a looser bound
+const double kMaxBankFloatError = 2e-3;
+
+const int kNumSamples = 1021;
+const int kBlockSizes[] = { 1, 7, 64, 333, 616 };   // sums to kNumSamples
+const int kChannelCounts[] = { 1, 2, 3, 4, 5, 8, 11, 16 };
+const double kSampleRate = 48000.0;
+
+int g_failures = 0;
+
+void check(bool condition, const char* variant, const char* what, int numChannels, double value, double bound)
+{
+    if (!condition) {
+        std::printf("FAIL %s %s, %d channels: %.3g (bound %.3g)\n", variant, what, numChannels, value, bound);
+        ++g_failures;
+    }
+}
+
+double maxError(double) { return kMaxDoubleError; }
+double maxError(float) { return kMaxFloatError; }
+double maxBankError(double) { return kMaxDoubleError; }
+double maxBankError(float) { return kMaxBankFloatError; }
+
+// Noise and a sweep, different on every channel
+template <typename SampleType>
+std::vector<std::vector<SampleType>> makeInput(int numChannels)
+{
+    std::vector<std::vector<SampleType>> input(numChannels, std::vector<SampleType>(kNumSamples));
+    unsigned seed = 12345;
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int n = 0; n < kNumSamples; ++n) {
+            seed = seed * 1664525u + 1013904223u;
+            const double noise = double(seed >> 8) / double(1u << 24) - 0.5;
+            const double sweep = std::sin(0.001 * n * n / (channel + 1));
+            input[channel][n] = SampleType(0.5 * noise + 0.4 * sweep);
+        }
+    return input;
+}
+
+template <typename SampleType>
+double largestDifference(const std::vector<std::vector<SampleType>>& output,
+                         const std::vector<std::vector<double>>& reference)
+{
+    double error = 0.0;
+    for (size_t channel = 0; channel < output.size(); ++channel)
+        for (int n = 0; n < kNumSamples; ++n)
+            error = std::fmax(error, std::fabs(double(output[channel][n]) - reference[channel][n]));
+    return error;
+}
+
+// Runs a kernel call over kBlockSizes; process(in, out, offset, blockSize)
+template <typename SampleType, typename Process>
+std::vector<std::vector<SampleType>> runBlocks(const std::vector<std::vector<SampleType>>& input, Process&& process)
+{
+    const int numChannels = int(input.size());
+    std::vector<std::vector<SampleType>> output(numChannels, std::vector<SampleType>(kNumSamples));
+    const SampleType* in[FilterDSP::kMaxChannels];
+    SampleType* out[FilterDSP::kMaxChannels];
+    int offset = 0;
+    for (int blockSize : kBlockSizes) {
+        for (int channel = 0; channel < numChannels; ++channel) {
+            in[channel] = input[channel].data() + offset;
+            out[channel] = output[channel].data() + offset;
+        }
+        process(in, out, offset, blockSize);
+        offset += blockSize;
+    }
+    return output;
+}
+
+//------------------------------------------------------------------------
+// Reference recurrences, one channel at a time in double precision. Ramped
+// coefficients are accumulated in the sample type, as the kernels do, so
+// only the signal path is compared.
+//------------------------------------------------------------------------
+template <typename SampleType>
+std::vector<double> referenceOnePole(int filterType, const FilterDSP::OnePoleCoefficients<SampleType>& start,
+                                     const FilterDSP::OnePoleCoefficients<SampleType>& delta, bool ramped,
+                                     const std::vector<SampleType>& input)
+{
+    SampleType b0 = start.b0, b1 = start.b1, a1 = start.a1;
+    double x1 = 0.0, y1 = 0.0;
+    std::vector<double> output(kNumSamples);
+    for (int n = 0; n < kNumSamples; ++n) {
+        const double x = input[n];
+        y1 = double(b0) * x + (filterType == FilterDSP::kFilterTypeHighPass ? double(b1) * x1 : 0.0) + double(a1) * y1;
+        x1 = x;
+        output[n] = y1;
+        if (ramped) {
+            b0 += delta.b0;
+            b1 += delta.b1;
+            a1 += delta.a1;
+        }
+    }
+    return output;
+}
+
+template <typename SampleType>
+std::vector<double> referenceBiquads(const FilterDSP::BiquadCascadeCoefficients<SampleType>& start,
+                                     const FilterDSP::BiquadCascadeCoefficients<SampleType>& delta, bool ramped,
+                                     const std::vector<SampleType>& input)
+{
+    SampleType c[4][5];
+    double s1[4] = {}, s2[4] = {};
+    for (int k = 0; k < start.numSections; ++k) {
+        c[k][0] = start.sections[k].b0;
+        c[k][1] = start.sections[k].b1;
+        c[k][2] = start.sections[k].b2;
+        c[k][3] = start.sections[k].a1;
+        c[k][4] = start.sections[k].a2;
+    }
+    std::vector<double> output(kNumSamples);
+    for (int n = 0; n < kNumSamples; ++n) {
+        double x = input[n];
+        for (int k = 0; k < start.numSections; ++k) {
+            const double y = double(c[k][0]) * x + s1[k];
+            s1[k] = double(c[k][1]) * x - double(c[k][3]) * y + s2[k];
+            s2[k] = double(c[k][2]) * x - double(c[k][4]) * y;
+            x = y;
+            if (ramped) {
+                c[k][0] += delta.sections[k].b0;
+                c[k][1] += delta.sections[k].b1;
+                c[k][2] += delta.sections[k].b2;
+                c[k][3] += delta.sections[k].a1;
+                c[k][4] += delta.sections[k].a2;
+            }
+        }
+        output[n] = x;
+    }
+    return output;
+}
+
+// coeffs holds one set, or one per sample when perSample is set
+template <typename SampleType>
+std::vector<double> referenceSvf(int filterType, const FilterDSP::SvfCoefficients<SampleType>* coeffs, bool perSample,
+                                 const std::vector<SampleType>& input)
+{
+    double ic1eq = 0.0, ic2eq = 0.0;
+    std::vector<double> output(kNumSamples);
+    for (int n = 0; n < kNumSamples; ++n) {
+        const FilterDSP::SvfCoefficients<SampleType>& c = coeffs[perSample ? n : 0];
+        const double x = input[n];
+        const double v3 = x - ic2eq;
+        const double v1 = double(c.a1) * ic1eq + double(c.a2) * v3;
+        const double v2 = ic2eq + double(c.a2) * ic1eq + double(c.a3) * v3;
+        ic1eq = 2.0 * v1 - ic1eq;
+        ic2eq = 2.0 * v2 - ic2eq;
+
+        const double band = double(c.k) * v1;
+        const double notch = x - band;
+        switch (filterType)
+        {
+            case FilterDSP::kFilterTypeLowPass: output[n] = v2; break;
+            case FilterDSP::kFilterTypeHighPass: output[n] = notch - v2; break;
+            case FilterDSP::kFilterTypeBandPass: output[n] = band; break;
+            default: output[n] = notch; break;
+        }
+    }
+    return output;
+}
+
+// The ladder with the rational tanh, in double precision
+template <typename SampleType>
+std::vector<double> referenceLadder(int filterType, const FilterDSP::LadderCoefficients<SampleType>* coeffs, bool perSample,
+                                    const std::vector<SampleType>& input)
+{
+    double s[4] = {};
+    std::vector<double> output(kNumSamples);
+    for (int n = 0; n < kNumSamples; ++n) {
+        const FilterDSP::LadderCoefficients<SampleType>& c = coeffs[perSample ? n : 0];
+        const double g = double(c.g);
+        const double x = filterType == FilterDSP::kFilterTypeLowPass ? double(c.gain) * input[n] : double(input[n]);
+        const double memory = double(c.h) * (((s[0] * g + s[1]) * g + s[2]) * g + s[3]);
+        const double v = std::fmax(-3.0, std::fmin(3.0, (x - double(c.k) * memory) * double(c.a)));
+        const double u = v * (27.0 + v * v) / (27.0 + 9.0 * v * v);
+
+        double y[4];
+        double stageInput = u;
+        for (int i = 0; i < 4; ++i) {
+            const double step = g * (stageInput - s[i]);
+            y[i] = step + s[i];
+            s[i] = y[i] + step;
+            stageInput = y[i];
+        }
+        switch (filterType)
+        {
+            case FilterDSP::kFilterTypeLowPass: output[n] = y[3]; break;
+            case FilterDSP::kFilterTypeHighPass: output[n] = u - 4.0 * y[0] + 6.0 * y[1] - 4.0 * y[2] + y[3]; break;
+            case FilterDSP::kFilterTypeBandPass: output[n] = 4.0 * (y[1] - 2.0 * y[2] + y[3]); break;
+            default: output[n] = u - 2.0 * y[0] + 2.0 * y[1]; break;
+        }
+    }
+    return output;
+}
+
+// The active bands of a graphic EQ bank, one section after another
+// (serial) or summed onto the input (parallel)
+template <typename SampleType>
+std::vector<double> referenceBank(const FilterDSP::FilterBankCoefficients<SampleType>& bank,
+                                  const std::vector<SampleType>& input)
+{
+    double s1[FilterDSP::kMaxBankLanes] = {}, s2[FilterDSP::kMaxBankLanes] = {};
+    std::vector<double> output(kNumSamples);
+    for (int n = 0; n < kNumSamples; ++n) {
+        double x = input[n];
+        double sum = x;
+        for (int lane = 0; lane < bank.numActive; ++lane) {
+            const double y = double(bank.b0[lane]) * x + s1[lane];
+            s1[lane] = double(bank.b1[lane]) * x - double(bank.a1[lane]) * y + s2[lane];
+            s2[lane] = double(bank.b2[lane]) * x - double(bank.a2[lane]) * y;
+            if (bank.layout == FilterDSP::kBankLayoutSerial)
+                x = y;
+            else
+                sum += y;
+        }
+        output[n] = bank.layout == FilterDSP::kBankLayoutSerial ? x : sum;
+    }
+    return output;
+}
+
+// Gains that leave every second or third band at 0 dB, with numActive
+// bands away from it
+void makeBankGains(int numActive, double* gainsDb)
+{
+    int active = 0;
+    for (int band = 0; band < FilterDSP::kMaxBankBands; ++band) {
+        const bool on = active < numActive && (band % 3 != 1 || FilterDSP::kMaxBankBands - band <= numActive - active);
+        gainsDb[band] = on ? (band % 2 == 0 ? 9.0 : -7.5) * (1.0 - 0.02 * band) : 0.0;
+        active += on ? 1 : 0;
+    }
+}
+
+// One state variable filter tick in double: low pass and band pass
+struct ReferenceSvf
+{
+    double s1 = 0.0, s2 = 0.0;
+
+    template <typename SampleType>
+    void tick(const FilterDSP::SvfCoefficients<SampleType>& c, double x, double& lowPass, double& bandPass)
+    {
+        const double v3 = x - s2;
+        const double v1 = double(c.a1) * s1 + double(c.a2) * v3;
+        const double v2 = s2 + double(c.a2) * s1 + double(c.a3) * v3;
+        s1 = 2.0 * v1 - s1;
+        s2 = 2.0 * v2 - s2;
+        lowPass = v2;
+        bandPass = double(c.k) * v1;
+    }
+
+    template <typename SampleType>
+    double allPass(const FilterDSP::SvfCoefficients<SampleType>& c, double x)
+    {
+        double lowPass, bandPass;
+        tick(c, x, lowPass, bandPass);
+        return x - 2.0 * bandPass;
+    }
+};
+
+// Crossover bands from the bottom up: each split takes the lowest band off
+// the rest, and that band then passes the all passes of the splits above.
+// The last entry is the input through every all pass, which the bands
+// must sum to.
+template <typename SampleType>
+std::vector<std::vector<double>> referenceCrossover(const FilterDSP::CrossoverCoefficients<SampleType>& c,
+                                                    const std::vector<SampleType>& input)
+{
+    const int numSplits = c.numBands - 1;
+    ReferenceSvf first[FilterDSP::kMaxCrossoverSplits], second[FilterDSP::kMaxCrossoverSplits];
+    ReferenceSvf phase[FilterDSP::kMaxCrossoverSplits][FilterDSP::kMaxCrossoverSplits];
+    ReferenceSvf sum[FilterDSP::kMaxCrossoverSplits];
+    std::vector<std::vector<double>> output(c.numBands + 1, std::vector<double>(kNumSamples));
+    for (int n = 0; n < kNumSamples; ++n) {
+        double rest = input[n];
+        for (int split = 0; split < numSplits; ++split) {
+            double lowPass, bandPass, low, unused;
+            first[split].tick(c.splits[split], rest, lowPass, bandPass);
+            second[split].tick(c.splits[split], lowPass, low, unused);
+            rest = rest - 2.0 * bandPass - low;
+            for (int above = split + 1; above < numSplits; ++above)
+                low = phase[split][above].allPass(c.splits[above], low);
+            output[split][n] = low;
+        }
+        output[numSplits][n] = rest;
+
+        double allPassed = input[n];
+        for (int split = 0; split < numSplits; ++split)
+            allPassed = sum[split].allPass(c.splits[split], allPassed);
+        output[c.numBands][n] = allPassed;
+    }
+    return output;
+}
+
+//------------------------------------------------------------------------
+// Kernel tables
+//------------------------------------------------------------------------
+template <typename SampleType>
+void testOnePole(const char* variant, int numChannels)
+{
+    const FilterDSP::FilterKernelTable<SampleType>& kernels = FilterDSP::getFilterKernels<SampleType>();
+    const auto input = makeInput<SampleType>(numChannels);
+
+    for (int filterType = FilterDSP::kFilterTypeLowPass; filterType <= FilterDSP::kFilterTypeHighPass; ++filterType) {
+        for (int ramped = 0; ramped < 2; ++ramped) {
+            typedef FilterDSP::OnePoleCoefficients<SampleType> Coefficients;
+            const Coefficients start = Coefficients::design(filterType, SampleType(800), SampleType(kSampleRate));
+            const Coefficients end = Coefficients::design(filterType, SampleType(5000), SampleType(kSampleRate));
+            Coefficients delta = {};
+            if (ramped) {
+                delta.b0 = (end.b0 - start.b0) / SampleType(kNumSamples);
+                delta.b1 = (end.b1 - start.b1) / SampleType(kNumSamples);
+                delta.a1 = (end.a1 - start.a1) / SampleType(kNumSamples);
+            }
+
+            std::vector<SampleType> lastInput(numChannels, SampleType(0));
+            std::vector<SampleType> lastOutput(numChannels, SampleType(0));
+            Coefficients c = start;
+            const auto output = runBlocks(input, [&](const SampleType* const* in, SampleType* const* out, int, int blockSize) {
+                if (ramped) {
+                    kernels.onePoleRamp(filterType, c, delta, in, out, numChannels, blockSize, lastInput.data(), lastOutput.data());
+                    for (int n = 0; n < blockSize; ++n)
+                        FilterDSP::advanceCoefficients(c, delta);
+                }
+                else
+                    kernels.onePoleBlock(filterType, c, in, out, numChannels, blockSize, lastInput.data(), lastOutput.data());
+            });
+
+            std::vector<std::vector<double>> reference;
+            for (int channel = 0; channel < numChannels; ++channel)
+                reference.push_back(referenceOnePole(filterType, start, delta, ramped != 0, input[channel]));
+            const double error = largestDifference(output, reference);
+            check(error < maxError(SampleType()), variant, ramped ? "one-pole ramp" : "one-pole block",
+                  numChannels, error, maxError(SampleType()));
+        }
+    }
+}
+
+template <typename SampleType>
+void testBiquads(const char* variant, int numChannels)
+{
+    const FilterDSP::FilterKernelTable<SampleType>& kernels = FilterDSP::getFilterKernels<SampleType>();
+    const auto input = makeInput<SampleType>(numChannels);
+
+    for (int slope = FilterDSP::kSlope12dB; slope <= FilterDSP::kSlope48dB; ++slope) {
+        for (int ramped = 0; ramped < 2; ++ramped) {
+            const int filterType = slope % 2 == 0 ? FilterDSP::kFilterTypeLowPass : FilterDSP::kFilterTypeHighPass;
+            typedef FilterDSP::BiquadCascadeCoefficients<SampleType> Cascade;
+            const Cascade start = FilterDSP::designCascade<SampleType>(filterType, slope, FilterDSP::kAlignmentButterworth,
+                                                                       1000.0, kSampleRate);
+            const Cascade end = FilterDSP::designCascade<SampleType>(filterType, slope, FilterDSP::kAlignmentButterworth,
+                                                                     4000.0, kSampleRate);
+            Cascade delta = start;
+            for (int k = 0; k < start.numSections; ++k) {
+                const SampleType scale = ramped ? SampleType(1) / SampleType(kNumSamples) : SampleType(0);
+                delta.sections[k].b0 = (end.sections[k].b0 - start.sections[k].b0) * scale;
+                delta.sections[k].b1 = (end.sections[k].b1 - start.sections[k].b1) * scale;
+                delta.sections[k].b2 = (end.sections[k].b2 - start.sections[k].b2) * scale;
+                delta.sections[k].a1 = (end.sections[k].a1 - start.sections[k].a1) * scale;
+                delta.sections[k].a2 = (end.sections[k].a2 - start.sections[k].a2) * scale;
+            }
+
+            std::vector<SampleType> state(2 * start.numSections * numChannels, SampleType(0));
+            Cascade c = start;
+            const auto output = runBlocks(input, [&](const SampleType* const* in, SampleType* const* out, int, int blockSize) {
+                if (ramped) {
+                    kernels.biquadRamp(c, delta, in, out, numChannels, blockSize, state.data(), numChannels);
+                    for (int k = 0; k < c.numSections; ++k)
+                        for (int n = 0; n < blockSize; ++n)
+                            FilterDSP::advanceCoefficients(c.sections[k], delta.sections[k]);
+                }
+                else
+                    kernels.biquadBlock(c, in, out, numChannels, blockSize, state.data(), numChannels);
+            });
+
+            std::vector<std::vector<double>> reference;
+            for (int channel = 0; channel < numChannels; ++channel)
+                reference.push_back(referenceBiquads(start, delta, ramped != 0, input[channel]));
+            const double error = largestDifference(output, reference);
+            check(error < maxError(SampleType()), variant, ramped ? "biquad ramp" : "biquad block",
+                  numChannels, error, maxError(SampleType()));
+        }
+    }
+}
+
+template <typename SampleType>
+void testSvf(const char* variant, int numChannels)
+{
+    const FilterDSP::FilterKernelTable<SampleType>& kernels = FilterDSP::getFilterKernels<SampleType>();
+    const auto input = makeInput<SampleType>(numChannels);
+
+    // A cutoff sweep, one coefficient set per sample
+    typedef FilterDSP::SvfCoefficients<SampleType> Coefficients;
+    std::vector<Coefficients> sweep(kNumSamples);
+    for (int n = 0; n < kNumSamples; ++n)
+        sweep[n] = Coefficients::designWarped(SampleType(0.05 + 0.2 * n / kNumSamples));
+    const Coefficients fixed = Coefficients::design(SampleType(2000), SampleType(kSampleRate));
+
+    for (int filterType = FilterDSP::kFilterTypeLowPass; filterType <= FilterDSP::kFilterTypeNotch; ++filterType) {
+        for (int perSample = 0; perSample < 2; ++perSample) {
+            std::vector<SampleType> state(2 * numChannels, SampleType(0));
+            const auto output = runBlocks(input, [&](const SampleType* const* in, SampleType* const* out, int offset, int blockSize) {
+                const Coefficients* coeffs = perSample ? sweep.data() + offset : &fixed;
+                kernels.svfBlock(filterType, perSample != 0, coeffs, in, out, numChannels, blockSize, state.data(), numChannels);
+            });
+
+            std::vector<std::vector<double>> reference;
+            for (int channel = 0; channel < numChannels; ++channel)
+                reference.push_back(referenceSvf(filterType, perSample ? sweep.data() : &fixed, perSample != 0, input[channel]));
+            const double error = largestDifference(output, reference);
+            check(error < maxError(SampleType()), variant, perSample ? "SVF per-sample" : "SVF block",
+                  numChannels, error, maxError(SampleType()));
+        }
+    }
+}
+
+template <typename SampleType>
+void testLadder(const char* variant, int numChannels)
+{
+    const FilterDSP::FilterKernelTable<SampleType>& kernels = FilterDSP::getFilterKernels<SampleType>();
+    const auto input = makeInput<SampleType>(numChannels);
+
+    // A cutoff sweep, one coefficient set per sample; resonant enough to
+    // saturate
+    typedef FilterDSP::LadderCoefficients<SampleType> Coefficients;
+    const SampleType resonance = SampleType(0.7);
+    std::vector<Coefficients> sweep(kNumSamples);
+    for (int n = 0; n < kNumSamples; ++n)
+        sweep[n] = Coefficients::designWarped(SampleType(0.05 + 0.2 * n / kNumSamples), resonance);
+    const Coefficients fixed = Coefficients::design(SampleType(2000), SampleType(kSampleRate), resonance);
+
+    for (int filterType = FilterDSP::kFilterTypeLowPass; filterType <= FilterDSP::kFilterTypeNotch; ++filterType) {
+        for (int perSample = 0; perSample < 2; ++perSample) {
+            std::vector<SampleType> state(4 * numChannels, SampleType(0));
+            const auto output = runBlocks(input, [&](const SampleType* const* in, SampleType* const* out, int offset, int blockSize) {
+                const Coefficients* coeffs = perSample ? sweep.data() + offset : &fixed;
+                kernels.ladderBlock(filterType, perSample != 0, coeffs, in, out, numChannels, blockSize, state.data(), numChannels);
+            });
+
+            std::vector<std::vector<double>> reference;
+            for (int channel = 0; channel < numChannels; ++channel)
+                reference.push_back(referenceLadder(filterType, perSample ? sweep.data() : &fixed, perSample != 0, input[channel]));
+            const double error = largestDifference(output, reference);
+            check(error < maxError(SampleType()), variant, perSample ? "ladder per-sample" : "ladder block",
+                  numChannels, error, maxError(SampleType()));
+        }
+    }
+}
+
+// Active band counts that fill and overflow every vector width
+template <typename SampleType>
+void testBank(const char* variant, int numChannels)
+{
+    const FilterDSP::FilterKernelTable<SampleType>& kernels = FilterDSP::getFilterKernels<SampleType>();
+    const auto input = makeInput<SampleType>(numChannels);
+    const int activeCounts[] = { 0, 1, 3, 5, 9, 17, 31 };
+
+    for (int layout = 0; layout < FilterDSP::kNumBankLayouts; ++layout) {
+        for (int numActive : activeCounts) {
+            double gainsDb[FilterDSP::kMaxBankBands];
+            makeBankGains(numActive, gainsDb);
+            const FilterDSP::FilterBankCoefficients<SampleType> bank =
+                FilterDSP::designFilterBank<SampleType>(layout, FilterDSP::kMaxBankBands, gainsDb, kSampleRate);
+            check(bank.numActive == numActive, variant, "bank active bands", numChannels, double(bank.numActive), double(numActive));
+
+            std::vector<SampleType> state(FilterDSP::kBankStateSize * numChannels, SampleType(0));
+            const auto output = runBlocks(input, [&](const SampleType* const* in, SampleType* const* out, int, int blockSize) {
+                kernels.bankBlock(bank, in, out, numChannels, blockSize, state.data());
+            });
+
+            std::vector<std::vector<double>> reference;
+            for (int channel = 0; channel < numChannels; ++channel)
+                reference.push_back(referenceBank(bank, input[channel]));
+            const double error = largestDifference(output, reference);
+            check(error < maxBankError(SampleType()), variant, layout == FilterDSP::kBankLayoutSerial ? "serial bank" : "parallel bank",
+                  numChannels, error, maxBankError(SampleType()));
+        }
+    }
+}
+
+// Every band count, against the reference bands and their sum against the
+// all passes; frequencies given out of order. The band above the lowest is
+// left unstored on odd channel counts.
+template <typename SampleType>
+void testCrossover(const char* variant, int numChannels)
+{
+    const FilterDSP::FilterKernelTable<SampleType>& kernels = FilterDSP::getFilterKernels<SampleType>();
+    const auto input = makeInput<SampleType>(numChannels);
+    const double frequencies[FilterDSP::kMaxCrossoverSplits] = { 3100.0, 150.0, 11000.0, 900.0 };
+
+    for (int numBands = FilterDSP::kMinCrossoverBands; numBands <= FilterDSP::kMaxCrossoverBands; ++numBands) {
+        const FilterDSP::CrossoverCoefficients<SampleType> coeffs =
+            FilterDSP::designCrossover<SampleType>(numBands, frequencies, kSampleRate);
+        const int skipped = numChannels % 2 == 1 ? 1 : -1;
+
+        std::vector<SampleType> state(FilterDSP::kCrossoverStateRows * numChannels, SampleType(0));
+        std::vector<std::vector<std::vector<SampleType>>> bands(numBands,
+            std::vector<std::vector<SampleType>>(numChannels, std::vector<SampleType>(kNumSamples)));
+        const SampleType* in[FilterDSP::kMaxChannels];
+        SampleType* out[FilterDSP::kMaxCrossoverBands][FilterDSP::kMaxChannels];
+        SampleType* const* bandOutputs[FilterDSP::kMaxCrossoverBands];
+        int offset = 0;
+        for (int blockSize : kBlockSizes) {
+            for (int band = 0; band < numBands; ++band) {
+                for (int channel = 0; channel < numChannels; ++channel) {
+                    in[channel] = input[channel].data() + offset;
+                    out[band][channel] = bands[band][channel].data() + offset;
+                }
+                bandOutputs[band] = band == skipped ? nullptr : out[band];
+            }
+            kernels.crossoverBlock(coeffs, in, bandOutputs, numChannels, blockSize, state.data(), numChannels);
+            offset += blockSize;
+        }
+
+        std::vector<std::vector<std::vector<double>>> reference(numBands + 1);
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const std::vector<std::vector<double>> channelBands = referenceCrossover(coeffs, input[channel]);
+            for (int band = 0; band <= numBands; ++band)
+                reference[band].push_back(channelBands[band]);
+        }
+
+        std::vector<std::vector<double>> sum(numChannels, std::vector<double>(kNumSamples, 0.0));
+        for (int band = 0; band < numBands; ++band) {
+            if (band == skipped) {
+                for (int channel = 0; channel < numChannels; ++channel)
+                    for (int n = 0; n < kNumSamples; ++n)
+                        sum[channel][n] += reference[band][channel][n];
+                continue;
+            }
+            const double error = largestDifference(bands[band], reference[band]);
+            check(error < maxError(SampleType()), variant, "crossover band", numChannels, error, maxError(SampleType()));
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int n = 0; n < kNumSamples; ++n)
+                    sum[channel][n] += double(bands[band][channel][n]);
+        }
+
+        double error = 0.0;
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int n = 0; n < kNumSamples; ++n)
+                error = std::fmax(error, std::fabs(sum[channel][n] - reference[numBands][channel][n]));
+        check(error < maxError(SampleType()) * numBands, variant, "crossover sum", numChannels, error,
+              maxError(SampleType()) * numBands);
+    }
+}
+
+//------------------------------------------------------------------------
+// The engine on each variant against the engine on the first one
+//------------------------------------------------------------------------
+struct EngineSetup
+{
+    int mode;
+    int slope;
+    int filterType;
+};
+
+const EngineSetup kEngineSetups[] = {
+    { FilterDSP::kFilterModeStandard, FilterDSP::kSlope6dB, FilterDSP::kFilterTypeHighPass },
+    { FilterDSP::kFilterModeStandard, FilterDSP::kSlope36dB, FilterDSP::kFilterTypeLowPass },
+    { FilterDSP::kFilterModeStateVariable, FilterDSP::kSlope12dB, FilterDSP::kFilterTypeBandPass },
+    { FilterDSP::kFilterModeLadder, FilterDSP::kSlope24dB, FilterDSP::kFilterTypeLowPass },
+    { FilterDSP::kFilterModeStandard, FilterDSP::kSlope12dB, FilterDSP::kFilterTypeAllPass },
+    { FilterDSP::kFilterModeGraphicEq, FilterDSP::kSlope12dB, FilterDSP::kFilterTypeLowPass },
+    { FilterDSP::kFilterModeCrossover, FilterDSP::kSlope12dB, FilterDSP::kFilterTypeLowPass }
+};
+
+// Cutoff ramps in the middle of the run, then steady state
+std::vector<std::vector<float>> runEngine(const EngineSetup& setup, int numChannels)
+{
+    FilterDSP::FilterEngine<float> engine;
+    engine.setSampleRate(float(kSampleRate));
+    engine.setMode(setup.mode);
+    engine.setSlope(setup.slope);
+    engine.setFilterType(setup.filterType);
+    engine.setCutoff(700.0f);
+    double gainsDb[FilterDSP::kMaxBankBands];
+    makeBankGains(20, gainsDb);
+    for (int band = 0; band < FilterDSP::kMaxBankBands; ++band)
+        engine.setBandGain(band, gainsDb[band]);
+    engine.setCrossoverBands(4);
+    engine.prepare(numChannels, 1024);
+
+    const auto input = makeInput<float>(numChannels);
+    return runBlocks(input, [&](const float* const* in, float* const* out, int offset, int blockSize) {
+        if (offset == 7)
+            engine.setCutoff(6000.0f);
+        engine.processBlock(in, out, numChannels, blockSize);
+    });
+}
+
+std::vector<std::vector<double>> toDouble(const std::vector<std::vector<float>>& signal)
+{
+    std::vector<std::vector<double>> result;
+    for (const auto& channel : signal)
+        result.push_back(std::vector<double>(channel.begin(), channel.end()));
+    return result;
+}
+
+// FILTERDSP_KERNELS is read by the first selection only
+void testOverride()
+{
+#if defined(_WIN32)
+    _putenv_s("FILTERDSP_KERNELS", "sse2");
+#else
+    setenv("FILTERDSP_KERNELS", "sse2", 1);
+#endif
+    const int selected = FilterDSP::selectKernelIsa();
+    if (FilterDSP::isKernelIsaAvailable(FilterDSP::kKernelIsaSse2))
+        check(selected == FilterDSP::kKernelIsaSse2, FilterDSP::getKernelIsaName(selected),
+              "FILTERDSP_KERNELS=sse2 selected", 1, double(selected), double(FilterDSP::kKernelIsaSse2));
+    check(FilterDSP::selectKernelIsa() == selected, FilterDSP::getKernelIsaName(selected),
+          "selection stays", 1, double(FilterDSP::selectKernelIsa()), double(selected));
+}
+
+} // namespace
+
+int main()
+{
+    testOverride();
+
+    std::vector<std::vector<std::vector<float>>> baseline;
+    int numTested = 0;
+    for (int isa = 0; isa < FilterDSP::kNumKernelIsas; ++isa) {
+        const char* variant = FilterDSP::getKernelIsaName(isa);
+        if (!FilterDSP::setKernelIsa(isa)) {
+            std::printf("%-7s not available\n", variant);
+            continue;
+        }
+        const int failuresBefore = g_failures;
+
+        for (int numChannels : kChannelCounts) {
+            testOnePole<float>(variant, numChannels);
+            testOnePole<double>(variant, numChannels);
+            testBiquads<float>(variant, numChannels);
+            testBiquads<double>(variant, numChannels);
+            testSvf<float>(variant, numChannels);
+            testSvf<double>(variant, numChannels);
+            testLadder<float>(variant, numChannels);
+            testLadder<double>(variant, numChannels);
+            testBank<float>(variant, numChannels);
+            testBank<double>(variant, numChannels);
+            testCrossover<float>(variant, numChannels);
+            testCrossover<double>(variant, numChannels);
+        }
+
+        // Engines are compared at the widest bus
+        const int numChannels = FilterDSP::kMaxChannels;
+        std::vector<std::vector<std::vector<float>>> outputs;
+        for (const EngineSetup& setup : kEngineSetups)
+            outputs.push_back(runEngine(setup, numChannels));
+        if (baseline.empty())
+            baseline = outputs;
+        for (size_t i = 0; i < outputs.size(); ++i) {
+            const double error = largestDifference(outputs[i], toDouble(baseline[i]));
+            const double bound = kEngineSetups[i].mode == FilterDSP::kFilterModeGraphicEq ? kMaxBankFloatError : kMaxFloatError;
+            check(error < bound, variant, "engine output", numChannels, error, bound);
+        }
+
+        std::printf("%-7s %s\n", variant, g_failures == failuresBefore ? "passed" : "FAILED");
+        ++numTested;
+    }
+
+    if (numTested == 0) {
+        std::printf("FAIL no kernel variant available\n");
+        return 1;
+    }
+    if (g_failures != 0) {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,391 @@
+// The partitioned linear-phase convolution (LinearPhaseFilter.h) against a
+// direct convolution with the taps of its kernel, recovered from the
+// partition spectra designLinearPhaseKernel returns. Covers the uniform
+// and non-uniform layouts at several host block sizes, with the worker
+// keeping up and with the audio thread outrunning it; the background
+// levels alone with every due block computed on the audio thread, some
+// by a stand-in worker, and across a reset with blocks still pending; the
+// reported latency against the measured impulse delay; and the sharing of
+// kernels between filters through the design cache.
+
+#include "FilterEngine.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Largest difference from the direct convolution, relative to the unit
+// input
+const double kMaxFloatError = 1e-4;
+const double kMaxDoubleError = 1e-9;
+
+const double kSampleRate = 48000.0;
+const int kNumChannels = 2;
+
+// Host blocks: the first levels' partition sizes, one that is not a power
+// of two, and one that leaves no background levels
+const int kBlockSizes[] = { 64, 100, 256, 1024 };
+
+// How long a test waits for the background thread
+const double kTimeoutSeconds = 10.0;
+
+int g_failures = 0;
+
+double maxError(double) { return kMaxDoubleError; }
+double maxError(float) { return kMaxFloatError; }
+
+const char* typeName(double) { return "double"; }
+const char* typeName(float) { return "float"; }
+
+void check(bool passed, const char* what, double value, double bound)
+{
+    if (!passed) {
+        std::printf("FAIL %s: %.3g (bound %.3g)\n", what, value, bound);
+        ++g_failures;
+    }
+}
+
+FilterDSP::LinearPhaseDesign makeDesign(double cutoffFreq)
+{
+    const FilterDSP::LinearPhaseDesign design = { FilterDSP::kFilterTypeLowPass, FilterDSP::kSlope24dB,
+                                                  FilterDSP::kAlignmentButterworth, cutoffFreq, kSampleRate,
+                                                  FilterDSP::kDefaultQ, 0.0 };
+    return design;
+}
+
+// Noise and a sweep, different on every channel
+std::vector<std::vector<double>> makeInput(int numSamples, unsigned seed)
+{
+    std::vector<std::vector<double>> input(kNumChannels, std::vector<double>(numSamples));
+    for (int channel = 0; channel < kNumChannels; ++channel)
+        for (int n = 0; n < numSamples; ++n) {
+            seed = seed * 1664525u + 1013904223u;
+            const double noise = double(seed >> 8) / double(1u << 24) - 0.5;
+            const double sweep = std::sin(1e-6 * double(n) * n / (channel + 1));
+            input[channel][n] = 0.5 * noise + 0.4 * sweep;
+        }
+    return input;
+}
+
+// The kernel taps: the first half of the inverse of every partition
+template <typename SampleType>
+std::vector<double> getTaps(const FilterDSP::LinearPhaseKey& key)
+{
+    const FilterDSP::LinearPhaseKernelSet<SampleType> kernel = FilterDSP::designLinearPhaseKernel<SampleType>(key);
+    const std::vector<FilterDSP::PartitionLevel> levels =
+        FilterDSP::planPartitions(key.kernelLength, key.headSize, key.firstBackgroundSize, key.partitioning);
+    std::vector<double> taps(key.kernelLength, 0.0);
+    for (const FilterDSP::PartitionLevel& level : levels) {
+        const int numBins = level.size + 1;
+        FilterDSP::RealFft<double> fft;
+        fft.prepare(2 * level.size);
+        std::vector<double> re(numBins), im(numBins), time(2 * static_cast<size_t>(level.size));
+        for (int p = 0; p < level.numPartitions; ++p) {
+            const size_t bin = static_cast<size_t>(level.spectrumOffset) + static_cast<size_t>(p) * numBins;
+            for (int k = 0; k < numBins; ++k) {
+                re[k] = double(kernel.re[bin + k]);
+                im[k] = double(kernel.im[bin + k]);
+            }
+            fft.inverse(re.data(), im.data(), time.data());
+            for (int i = 0; i < level.size; ++i) {
+                const int n = level.offset + p * level.size + i;
+                if (n < key.kernelLength)
+                    taps[n] = time[i];
+            }
+        }
+    }
+    return taps;
+}
+
+// y[n] = Σ taps[k]·x[n - k] over taps [first, end)
+std::vector<double> convolve(const std::vector<double>& x, const std::vector<double>& taps, int first = 0)
+{
+    std::vector<double> y(x.size(), 0.0);
+    for (size_t n = 0; n < x.size(); ++n) {
+        double sum = 0.0;
+        for (size_t k = first; k < taps.size() && k <= n; ++k)
+            sum += taps[k] * x[n - k];
+        y[n] = sum;
+    }
+    return y;
+}
+
+template <typename SampleType>
+double maxDifference(const std::vector<std::vector<SampleType>>& output, const std::vector<std::vector<double>>& expected,
+                     int delay)
+{
+    double error = 0.0;
+    for (int channel = 0; channel < kNumChannels; ++channel)
+        for (size_t n = 0; n < output[channel].size(); ++n) {
+            const double reference = n >= size_t(delay) ? expected[channel][n - delay] : 0.0;
+            error = std::fmax(error, std::fabs(double(output[channel][n]) - reference));
+        }
+    return error;
+}
+
+// The whole filter in host blocks of blockSize. waitForWorker lets the
+// background thread finish after every block, as in a real-time stream;
+// otherwise the audio thread outruns it and computes the late blocks.
+template <typename SampleType>
+void testFilter(int partitioning, int blockSize, bool waitForWorker)
+{
+    FilterDSP::LinearPhaseFilter<SampleType> filter;
+    const FilterDSP::LinearPhaseDesign design = makeDesign(900.0);
+    filter.prepare(kNumChannels, blockSize, kSampleRate, &design, partitioning);
+    const std::vector<double> taps = getTaps<SampleType>(filter.getKernelKey(design));
+
+    const int numSamples = filter.getTailSamples() + 8192;
+    const auto input = makeInput(numSamples, 12345);
+    std::vector<std::vector<double>> expected;
+    for (int channel = 0; channel < kNumChannels; ++channel)
+        expected.push_back(convolve(input[channel], taps));
+
+    std::vector<std::vector<SampleType>> in(kNumChannels, std::vector<SampleType>(numSamples));
+    for (int channel = 0; channel < kNumChannels; ++channel)
+        for (int n = 0; n < numSamples; ++n)
+            in[channel][n] = SampleType(input[channel][n]);
+    std::vector<std::vector<SampleType>> output = in;
+
+    const auto start = std::chrono::steady_clock::now();
+    SampleType* io[kNumChannels];
+    for (int offset = 0; offset < numSamples; offset += blockSize) {
+        const int chunk = std::min(blockSize, numSamples - offset);
+        for (int channel = 0; channel < kNumChannels; ++channel)
+            io[channel] = output[channel].data() + offset;
+        filter.process(io, io, kNumChannels, chunk);
+        while (waitForWorker && !filter.isBackgroundIdle()) {
+            if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > kTimeoutSeconds) {
+                std::printf("FAIL %s block %d: the worker did not finish\n", typeName(SampleType()), blockSize);
+                ++g_failures;
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    char what[128];
+    std::snprintf(what, sizeof(what), "%s %s partitions, block %d%s", typeName(SampleType()),
+                  partitioning == FilterDSP::kPartitioningUniform ? "uniform" : "non-uniform", blockSize,
+                  waitForWorker ? "" : ", worker late");
+    const double error = maxDifference(output, expected, filter.getPartitionSize());
+    check(error < maxError(SampleType()), what, error, maxError(SampleType()));
+}
+
+// The background levels without the worker: every due block is computed
+// on the audio thread, except on every other level block, where a
+// stand-in worker takes the next one first. Then a reset with blocks
+// submitted but not computed, after which only the new input may reach
+// the output.
+template <typename SampleType>
+void testTails()
+{
+    typedef FilterDSP::LinearPhaseKernelCache<SampleType> Cache;
+    const int blockSize = 64;
+    FilterDSP::LinearPhaseFilter<SampleType> layout;
+    layout.plan(kNumChannels, blockSize, kSampleRate);
+    const std::vector<FilterDSP::PartitionLevel>& levels = layout.getPartitionLevels();
+    if (levels.size() < 2) {
+        std::printf("FAIL %s: no background levels to test\n", typeName(SampleType()));
+        ++g_failures;
+        return;
+    }
+
+    const FilterDSP::LinearPhaseKey key = layout.getKernelKey(makeDesign(900.0));
+    const std::vector<double> taps = getTaps<SampleType>(key);
+    FilterDSP::LinearPhaseKernels<SampleType> kernels(key, Cache::get().acquire(key, &FilterDSP::designLinearPhaseKernel<SampleType>));
+    FilterDSP::LinearPhaseTails<SampleType> tails(kernels, levels, kNumChannels, kSampleRate);
+
+    const int firstOffset = levels[1].offset;
+    const int firstSize = levels[1].size;
+    std::vector<SampleType> block(blockSize);
+    const auto run = [&](const std::vector<std::vector<double>>& input, int numSamples, bool worker) {
+        std::vector<std::vector<SampleType>> output(kNumChannels, std::vector<SampleType>(numSamples, SampleType(0)));
+        for (long long blockStart = 0; blockStart + blockSize <= numSamples; blockStart += blockSize) {
+            for (int channel = 0; channel < kNumChannels; ++channel) {
+                for (int i = 0; i < blockSize; ++i)
+                    block[i] = SampleType(input[channel][blockStart + i]);
+                tails.write(channel, block.data(), blockStart);
+            }
+            for (int channel = 0; channel < kNumChannels; ++channel)
+                tails.mix(channel, output[channel].data() + blockStart, blockStart);
+            if (worker && blockStart % (2 * firstSize) == 0) {
+                while (tails.serviceConvolution()) {
+                }
+            }
+        }
+        return output;
+    };
+
+    const int numSamples = key.kernelLength + 1 + 8 * firstSize;
+    const auto input = makeInput(numSamples, 777);
+    std::vector<std::vector<double>> expected;
+    for (int channel = 0; channel < kNumChannels; ++channel)
+        expected.push_back(convolve(input[channel], taps, firstOffset));
+
+    char what[128];
+    const unsigned missesBefore = tails.getDeadlineMisses();
+    double error = maxDifference(run(input, numSamples, true), expected, 0);
+    std::snprintf(what, sizeof(what), "%s background levels, audio thread and stand-in worker", typeName(SampleType()));
+    check(error < maxError(SampleType()), what, error, maxError(SampleType()));
+    const unsigned misses = tails.getDeadlineMisses() - missesBefore;
+    std::snprintf(what, sizeof(what), "%s blocks computed on the audio thread", typeName(SampleType()));
+    check(misses > 0, what, misses, 1);
+    const int numDue = kNumChannels * (numSamples - firstOffset) / firstSize;
+    std::snprintf(what, sizeof(what), "%s blocks computed by the stand-in worker", typeName(SampleType()));
+    check(misses < unsigned(numDue), what, misses, numDue);
+
+    // The stream goes on with another signal, submitting blocks that are
+    // never computed, then starts over
+    const auto stale = makeInput(4 * firstSize, 999);
+    for (int offset = 0; offset < 4 * firstSize; offset += blockSize)
+        for (int channel = 0; channel < kNumChannels; ++channel) {
+            for (int i = 0; i < blockSize; ++i)
+                block[i] = SampleType(stale[channel][offset + i]);
+            tails.write(channel, block.data(), numSamples + offset);
+        }
+    std::snprintf(what, sizeof(what), "%s blocks pending before a reset", typeName(SampleType()));
+    check(!tails.isIdle(), what, 0, 1);
+    tails.reset();
+    std::snprintf(what, sizeof(what), "%s nothing pending after a reset", typeName(SampleType()));
+    check(tails.isIdle(), what, 0, 1);
+    error = maxDifference(run(input, numSamples, true), expected, 0);
+    std::snprintf(what, sizeof(what), "%s background levels after a reset", typeName(SampleType()));
+    check(error < maxError(SampleType()), what, error, maxError(SampleType()));
+}
+
+// An impulse through the engine peaks at the latency it reports
+template <typename SampleType>
+void testLatency(int blockSize)
+{
+    FilterDSP::FilterEngine<SampleType> engine;
+    engine.setSampleRate(SampleType(kSampleRate));
+    engine.setCutoff(SampleType(900));
+    engine.setSlope(FilterDSP::kSlope24dB);
+    engine.setMode(FilterDSP::kFilterModeLinearPhase);
+    engine.prepare(kNumChannels, blockSize);
+
+    const int latency = engine.getLatencySamples();
+    const int numSamples = engine.getTailSamples() + blockSize;
+    std::vector<std::vector<SampleType>> buffers(kNumChannels, std::vector<SampleType>(numSamples, SampleType(0)));
+    for (int channel = 0; channel < kNumChannels; ++channel)
+        buffers[channel][0] = SampleType(1);
+    SampleType* io[kNumChannels];
+    for (int offset = 0; offset < numSamples; offset += blockSize) {
+        const int chunk = std::min(blockSize, numSamples - offset);
+        for (int channel = 0; channel < kNumChannels; ++channel)
+            io[channel] = buffers[channel].data() + offset;
+        engine.processBlock(io, io, kNumChannels, chunk);
+    }
+
+    for (int channel = 0; channel < kNumChannels; ++channel) {
+        int peak = 0;
+        for (int n = 1; n < numSamples; ++n)
+            if (std::fabs(buffers[channel][n]) > std::fabs(buffers[channel][peak]))
+                peak = n;
+        char what[128];
+        std::snprintf(what, sizeof(what), "%s block %d impulse delay against reported latency %d",
+                      typeName(SampleType()), blockSize, latency);
+        check(peak == latency, what, peak, latency);
+    }
+}
+
+// Two engines with the same settings play one cached kernel; after a
+// cutoff change both play the new one, and the old one, no longer
+// referenced, is the first to go when the cache collects
+void testSharedKernels()
+{
+    typedef FilterDSP::LinearPhaseKernelCache<float> Cache;
+    typedef Cache::Entry Entry;
+    const int blockSize = 256;
+    const double oldCutoff = 1357.5;
+    const double newCutoff = 2468.0;
+
+    FilterDSP::LinearPhaseFilter<float> layout;
+    layout.plan(kNumChannels, blockSize, kSampleRate);
+    const FilterDSP::LinearPhaseKey oldKey = layout.getKernelKey(makeDesign(oldCutoff));
+    const FilterDSP::LinearPhaseKey newKey = layout.getKernelKey(makeDesign(newCutoff));
+
+    FilterDSP::FilterEngine<float> engines[2];
+    const int entriesBefore = Cache::get().getNumEntries();
+    for (FilterDSP::FilterEngine<float>& engine : engines) {
+        engine.setSampleRate(float(kSampleRate));
+        engine.setCutoff(float(oldCutoff));
+        engine.setSlope(FilterDSP::kSlope24dB);
+        engine.setMode(FilterDSP::kFilterModeLinearPhase);
+        engine.prepare(kNumChannels, blockSize);
+    }
+    check(Cache::get().getNumEntries() == entriesBefore + 1, "one kernel for two engines",
+          Cache::get().getNumEntries() - entriesBefore, 1);
+    const Entry* played = Cache::get().find(oldKey);
+    check(played != nullptr, "kernel cached under the engines' key", played != nullptr, 1);
+    Cache::release(played);
+
+    // The worker designs the new kernel; each engine adopts it as it runs
+    std::vector<std::vector<float>> buffers(kNumChannels, std::vector<float>(blockSize, 0.0f));
+    float* io[kNumChannels] = { buffers[0].data(), buffers[1].data() };
+    for (FilterDSP::FilterEngine<float>& engine : engines)
+        engine.setCutoff(float(newCutoff));
+    const auto start = std::chrono::steady_clock::now();
+    while (engines[0].isDesignPending() || engines[1].isDesignPending()) {
+        if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() > kTimeoutSeconds) {
+            std::printf("FAIL the new kernel was not adopted\n");
+            ++g_failures;
+            return;
+        }
+        for (FilterDSP::FilterEngine<float>& engine : engines)
+            engine.processBlock(io, io, kNumChannels, blockSize);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    check(Cache::get().getNumEntries() == entriesBefore + 2, "one new kernel for two engines",
+          Cache::get().getNumEntries() - entriesBefore, 2);
+
+    // More unreferenced designs than the cache keeps: the least recently
+    // used go, and the engines' kernel stays
+    const int numFillers = Cache::kMaxUnused + Cache::get().getNumEntries();
+    for (int i = 0; i < numFillers; ++i) {
+        FilterDSP::LinearPhaseKey filler = oldKey;
+        filler.design.cutoffFreq = 100.0 + i;
+        Cache::release(Cache::get().acquire(filler, [](const FilterDSP::LinearPhaseKey&) {
+            return FilterDSP::LinearPhaseKernelSet<float>();
+        }));
+    }
+    const Entry* oldEntry = Cache::get().find(oldKey);
+    const Entry* newEntry = Cache::get().find(newKey);
+    check(oldEntry == nullptr, "old kernel released after the change", oldEntry != nullptr, 0);
+    check(newEntry != nullptr, "new kernel kept while played", newEntry != nullptr, 1);
+    Cache::release(oldEntry);
+    Cache::release(newEntry);
+}
+
+template <typename SampleType>
+void testAll()
+{
+    for (int blockSize : kBlockSizes) {
+        testFilter<SampleType>(FilterDSP::kPartitioningUniform, blockSize, false);
+        testFilter<SampleType>(FilterDSP::kPartitioningNonUniform, blockSize, true);
+        testFilter<SampleType>(FilterDSP::kPartitioningNonUniform, blockSize, false);
+        testLatency<SampleType>(blockSize);
+    }
+    testTails<SampleType>();
+}
+
+} // namespace
+
+int main()
+{
+    testAll<float>();
+    testAll<double>();
+    testSharedKernels();
+
+    if (g_failures != 0) {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("linear phase passed\n");
+    return 0;
+}
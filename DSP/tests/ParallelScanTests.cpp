@@ -0,0 +1,156 @@
+// The parallel offline path (ParallelScan.h) against the serial kernels.
+// Two engines with the same settings process the same long blocks, one
+// prepared for parallel processing; their outputs must match to rounding
+// for every filter structure, response and slope, for channel counts that
+// fill every vector width and leave partial groups, across consecutive
+// blocks (the carried filter memory) and for in-place buffers.
+
+#include "FilterEngine.h"
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+// Largest difference from the serial output, relative to the unit input
+const double kMaxFloatError = 1e-4;
+const double kMaxDoubleError = 1e-10;
+
+// Long enough for several chunks, the last block shorter than the
+// threshold so it runs serially in both engines
+const int kBlockSizes[] = { 65536, 20000, 40011, 5000 };
+const int kMaxBlockSize = 65536;
+const int kChannelCounts[] = { 1, 2, 3, 5, 8 };
+const int kNumThreads = 4;
+const double kSampleRate = 48000.0;
+
+int g_failures = 0;
+
+double maxError(double) { return kMaxDoubleError; }
+double maxError(float) { return kMaxFloatError; }
+
+const char* typeName(double) { return "double"; }
+const char* typeName(float) { return "float"; }
+
+struct Setup
+{
+    int mode;
+    int filterType;
+    int slope;
+};
+
+// Noise and a sweep, different on every channel
+template <typename SampleType>
+std::vector<std::vector<SampleType>> makeInput(int numChannels, int numSamples)
+{
+    std::vector<std::vector<SampleType>> input(numChannels, std::vector<SampleType>(numSamples));
+    unsigned seed = 54321;
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int n = 0; n < numSamples; ++n) {
+            seed = seed * 1664525u + 1013904223u;
+            const double noise = double(seed >> 8) / double(1u << 24) - 0.5;
+            const double sweep = std::sin(1e-6 * double(n) * n / (channel + 1));
+            input[channel][n] = SampleType(0.5 * noise + 0.4 * sweep);
+        }
+    return input;
+}
+
+template <typename SampleType>
+void configure(FilterDSP::FilterEngine<SampleType>& engine, const Setup& setup, int numChannels, bool parallel)
+{
+    engine.setSampleRate(SampleType(kSampleRate));
+    engine.setMode(setup.mode);
+    engine.setFilterType(setup.filterType);
+    engine.setSlope(setup.slope);
+    engine.setCutoff(SampleType(900));
+    engine.setParallelProcessing(parallel);
+    engine.prepare(numChannels, kMaxBlockSize);
+}
+
+// Parallel and serial engines over kBlockSizes; inPlace runs the parallel
+// engine on a copy of the input
+template <typename SampleType>
+void testSetup(const Setup& setup, int numChannels, bool inPlace)
+{
+    FilterDSP::FilterEngine<SampleType> serial;
+    FilterDSP::FilterEngine<SampleType> parallel;
+    configure(serial, setup, numChannels, false);
+    configure(parallel, setup, numChannels, true);
+    if (!parallel.isParallelProcessing()) {
+        std::printf("FAIL %s: parallel processing not prepared\n", typeName(SampleType()));
+        ++g_failures;
+        return;
+    }
+
+    int numSamples = 0;
+    for (int blockSize : kBlockSizes)
+        numSamples += blockSize;
+    const auto input = makeInput<SampleType>(numChannels, numSamples);
+    std::vector<std::vector<SampleType>> expected(numChannels, std::vector<SampleType>(numSamples));
+    std::vector<std::vector<SampleType>> output = inPlace ? input : expected;
+
+    const SampleType* in[FilterDSP::kMaxChannels];
+    SampleType* out[FilterDSP::kMaxChannels];
+    const SampleType* parallelIn[FilterDSP::kMaxChannels];
+    SampleType* parallelOut[FilterDSP::kMaxChannels];
+    int offset = 0;
+    for (int blockSize : kBlockSizes) {
+        for (int channel = 0; channel < numChannels; ++channel) {
+            in[channel] = input[channel].data() + offset;
+            out[channel] = expected[channel].data() + offset;
+            parallelIn[channel] = (inPlace ? output[channel].data() : input[channel].data()) + offset;
+            parallelOut[channel] = output[channel].data() + offset;
+        }
+        serial.processBlock(in, out, numChannels, blockSize);
+        parallel.processBlock(parallelIn, parallelOut, numChannels, blockSize);
+        offset += blockSize;
+    }
+
+    double error = 0.0;
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int n = 0; n < numSamples; ++n)
+            error = std::fmax(error, std::fabs(double(output[channel][n]) - double(expected[channel][n])));
+    if (!(error < maxError(SampleType()))) {
+        std::printf("FAIL %s mode %d type %d slope %d, %d channels%s: %.3g (bound %.3g)\n",
+                    typeName(SampleType()), setup.mode, setup.filterType, setup.slope, numChannels,
+                    inPlace ? ", in place" : "", error, maxError(SampleType()));
+        ++g_failures;
+    }
+}
+
+template <typename SampleType>
+void testAll()
+{
+    std::vector<Setup> setups;
+    for (int filterType = 0; filterType < FilterDSP::kNumFilterTypes; ++filterType) {
+        for (int slope = 0; slope < FilterDSP::kNumSlopes; ++slope)
+            setups.push_back({ FilterDSP::kFilterModeStandard, filterType, slope });
+        setups.push_back({ FilterDSP::kFilterModeStateVariable, filterType, FilterDSP::kSlope12dB });
+    }
+
+    for (const Setup& setup : setups)
+        for (int numChannels : kChannelCounts)
+            testSetup<SampleType>(setup, numChannels, false);
+    for (const Setup& setup : setups)
+        testSetup<SampleType>(setup, 2, true);
+}
+
+} // namespace
+
+int main()
+{
+    // More chunks than this machine may have cores; the chunks then share
+    // them, with the same result
+    FilterDSP::ScanWorkers::get().setNumThreads(kNumThreads);
+
+    testAll<float>();
+    testAll<double>();
+
+    if (g_failures != 0) {
+        std::printf("%d failure(s)\n", g_failures);
+        return 1;
+    }
+    std::printf("parallel scan passed\n");
+    return 0;
+}
@@ -2,22 +2,34 @@
 #include "pluginterfaces/base/ibstream.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 #include "base/source/fstreamer.h"
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 
 // Plugin UIDs - Generate unique IDs for your plugin
 static const FUID FilterVST3ProcessorUID(0x12345678, 0x12345678, 0x12345678, 0x12345678);
 static const FUID FilterVST3ControllerUID(0x87654321, 0x87654321, 0x87654321, 0x87654321);
 
 FilterVST3::FilterVST3()
-: m_sampleRate(44100.0f)
-, m_cutoffFreq(1000.0f)
-, m_filterType(0)
-{
-    // Initialize filter memory
-    for (int i = 0; i < 2; ++i) {
-        m_lastOutput[i] = 0.0f;
-        m_lastInput[i] = 0.0f;
-    }
+: m_maxBlockSize(FilterDSP::kDefaultMaxBlockSize)
+, m_processState(FilterDSP::CacheAlignedPtr<ProcessState>::make())
+, m_filter(m_processState->filter)
+, m_filter64(m_processState->filter64)
+, m_bypass(m_processState->bypass)
+, m_bypass64(m_processState->bypass64)
+, m_processedBlocks(0)
+, m_silentBlocks(0)
+{
+    m_filter.setSampleRate(44100.0f);
+    m_filter.setCutoff(1000.0f);
+    m_filter.setFilterType(FilterDSP::kFilterTypeLowPass);
+    m_filter64.setSampleRate(44100.0);
+    m_filter64.setCutoff(1000.0);
+    m_filter64.setFilterType(FilterDSP::kFilterTypeLowPass);
+    
+    // Ramp cutoff changes instead of jumping (avoids clicks)
+    m_filter.setSmoothingTime(static_cast<float>(FilterDSP::kDefaultSmoothingTime));
+    m_filter64.setSmoothingTime(FilterDSP::kDefaultSmoothingTime);
     
     setControllerClass(FilterVST3ControllerUID);
 }
@@ -31,8 +43,20 @@ tresult FilterVST3::initialize(FUnknown* context)
     tresult result = AudioEffect::initialize(context);
     if (result == kResultTrue)
     {
+#if defined(FILTERDSP_RUNTIME_DISPATCH)
+        // Filter kernels for this CPU (FILTERDSP_KERNELS overrides)
+        FilterDSP::selectKernelIsa();
+#endif
         addAudioInput(STR16("AudioInput"), SpeakerArr::kStereo);
         addAudioOutput(STR16("AudioOutput"), SpeakerArr::kStereo);
+
+        // Crossover mode writes the lowest band to the main output and the
+        // bands above it to these, all from one pass over the input. They
+        // start inactive; the host enables the ones it routes.
+        addAudioOutput(STR16("Band 2"), SpeakerArr::kStereo, kAux, 0);
+        addAudioOutput(STR16("Band 3"), SpeakerArr::kStereo, kAux, 0);
+        addAudioOutput(STR16("Band 4"), SpeakerArr::kStereo, kAux, 0);
+        addAudioOutput(STR16("Band 5"), SpeakerArr::kStereo, kAux, 0);
     }
     return result;
 }
@@ -46,106 +70,344 @@ tresult FilterVST3::setActive(TBool state)
 {
     if (state)
     {
-        // Reset filter state when activated
-        for (int i = 0; i < 2; ++i) {
-            m_lastOutput[i] = 0.0f;
-            m_lastInput[i] = 0.0f;
-        }
+        // Resize and reset filter state when activated
+        prepareFilter();
+        m_processedBlocks.store(0, std::memory_order_relaxed);
+        m_silentBlocks.store(0, std::memory_order_relaxed);
     }
     return AudioEffect::setActive(state);
 }
 
 tresult FilterVST3::setupProcessing(ProcessSetup& newSetup)
 {
-    m_sampleRate = static_cast<float>(newSetup.sampleRate);
+    m_filter.setSampleRate(static_cast<float>(newSetup.sampleRate));
+    m_filter64.setSampleRate(newSetup.sampleRate);
+    
+    const int fadeLength = static_cast<int>(FilterDSP::kDefaultBypassFadeTime * newSetup.sampleRate);
+    m_bypass.setFadeLength(fadeLength);
+    m_bypass64.setFadeLength(fadeLength);
+    
+    // Offline renders may split long blocks across cores; realtime
+    // processing never waits on other threads
+    const bool offline = newSetup.processMode == kOffline;
+    m_filter.setParallelProcessing(offline);
+    m_filter64.setParallelProcessing(offline);
+
+    // The linear-phase partitions follow the largest block
+    m_maxBlockSize = newSetup.maxSamplesPerBlock;
+    prepareFilter();
     return AudioEffect::setupProcessing(newSetup);
 }
 
+uint32 FilterVST3::getTailSamples()
+{
+    // Time for the current settings to ring out; process() itself stops
+    // working as soon as the filter memory has actually decayed
+    return static_cast<uint32>(m_filter.getTailSamples());
+}
+
+uint32 FilterVST3::getLatencySamples()
+{
+    // Delay of the oversampling filters or the linear-phase FIR; the
+    // controller asks the host to query it again whenever the oversampling
+    // factor or the mode changes
+    return static_cast<uint32>(m_filter.getLatencySamples());
+}
+
+tresult FilterVST3::canProcessSampleSize(int32 symbolicSampleSize)
+{
+    // The filter engine is templated on the sample type, so 64-bit hosts
+    // are processed without converting to float
+    if (symbolicSampleSize == kSample32 || symbolicSampleSize == kSample64)
+        return kResultTrue;
+    return kResultFalse;
+}
+
+tresult FilterVST3::setBusArrangements(SpeakerArrangement* inputs, int32 numIns,
+                                       SpeakerArrangement* outputs, int32 numOuts)
+{
+    // One main bus in each direction with matching layouts, from mono up to
+    // 16 channels (e.g. 5.1, 7.1, 7.1.4); the crossover band buses have the
+    // same layout
+    if (numIns != 1 || numOuts < 1 || numOuts > kMaxOutputBuses)
+        return kResultFalse;
+    
+    int32 numChannels = SpeakerArr::getChannelCount(outputs[0]);
+    if (numChannels < 1 || numChannels > FilterDSP::kMaxChannels)
+        return kResultFalse;
+    for (int32 bus = 0; bus < numOuts; bus++)
+    {
+        if (outputs[bus] != inputs[0])
+            return kResultFalse;
+    }
+    
+    return AudioEffect::setBusArrangements(inputs, numIns, outputs, numOuts);
+}
+
+void FilterVST3::prepareFilter()
+{
+    SpeakerArrangement arrangement = SpeakerArr::kStereo;
+    getBusArrangement(kOutput, 0, arrangement);
+    const int numChannels = SpeakerArr::getChannelCount(arrangement);
+    m_filter.prepare(numChannels, m_maxBlockSize);
+    m_filter64.prepare(numChannels, m_maxBlockSize);
+    m_bypass.prepare(numChannels, m_filter.getMaxLatencySamples());
+    m_bypass64.prepare(numChannels, m_filter64.getMaxLatencySamples());
+    m_bypass.setDryDelay(m_filter.getLatencySamples());
+    m_bypass64.setDryDelay(m_filter64.getLatencySamples());
+}
+
 tresult FilterVST3::process(ProcessData& data)
 {
-    // Handle parameter changes
+    // Flush subnormals to zero for the whole callback
+    FilterDSP::ScopedNoDenormals noDenormals;
+    
+    // Collect the queues of the automatable DSP parameters; changes are
+    // applied at their sample offsets by splitting the block below.
+    ParamQueueCursor cursors[kNumAutomatedParams];
+    int32 numCursors = 0;
+    
     if (data.inputParameterChanges)
     {
         int32 numParamsChanged = data.inputParameterChanges->getParameterCount();
-        for (int32 i = 0; i < numParamsChanged; i++)
+        for (int32 i = 0; i < numParamsChanged && numCursors < kNumAutomatedParams; i++)
         {
             IParamValueQueue* paramQueue = data.inputParameterChanges->getParameterData(i);
             if (paramQueue)
             {
-                ParamValue value;
-                int32 sampleOffset;
-                int32 numPoints = paramQueue->getPointCount();
-                if (paramQueue->getPoint(numPoints - 1, sampleOffset, value) == kResultTrue)
+                switch (paramQueue->getParameterId())
                 {
-                    switch (paramQueue->getParameterId())
-                    {
-                        case kFilterTypeId:
-                            m_filterType = (int)value;
-                            break;
-                        case kCutoffFreqId:
-                            m_cutoffFreq = value;
-                            break;
-                    }
+                    case kFilterTypeId:
+                    case kCutoffFreqId:
+                    case kBypassId:
+                    case kSlopeId:
+                    case kAlignmentId:
+                    case kModeId:
+                    case kOversamplingId:
+                    case kResonanceId:
+                    case kQId:
+                    case kGainId:
+                    case kBankBandsId:
+                    case kBankLayoutId:
+                    case kCrossoverBandsId:
+                        cursors[numCursors++].init(paramQueue);
+                        break;
+                    default:
+                        // Band gains and crossover frequencies
+                        if (paramQueue->getParameterId() >= kBandGainId
+                            && paramQueue->getParameterId() < kNumAutomatedParams)
+                            cursors[numCursors++].init(paramQueue);
+                        break;
                 }
             }
         }
     }
 
-    // Process audio
-    if (data.numInputs > 0 && data.numOutputs > 0)
+    int32 numSamples = data.numSamples;
+    bool hasAudio = data.numInputs > 0 && data.numOutputs > 0;
+    int32 numChannels = 0;
+    if (hasAudio)
     {
-        AudioBusBuffers& input = data.inputs[0];
-        AudioBusBuffers& output = data.outputs[0];
-        
-        int32 numChannels = input.numChannels;
-        int32 numSamples = data.numSamples;
+        numChannels = data.inputs[0].numChannels < data.outputs[0].numChannels
+                    ? data.inputs[0].numChannels : data.outputs[0].numChannels;
+    }
+    
+    // Output buses the filter writes: the main bus, then the crossover band
+    // buses the host has enabled. A disabled bus (no channels) stays null
+    // and its band is not stored.
+    int32 numOutputs = hasAudio ? std::min(data.numOutputs, kMaxOutputBuses) : 0;
+    Sample32* const* outputs32[kMaxOutputBuses] = {};
+    Sample64* const* outputs64[kMaxOutputBuses] = {};
+    for (int32 bus = 0; bus < numOutputs; bus++)
+    {
+        if (bus > 0 && data.outputs[bus].numChannels < numChannels)
+            continue;
+        outputs32[bus] = data.outputs[bus].channelBuffers32;
+        outputs64[bus] = data.outputs[bus].channelBuffers64;
+    }
+    
+    // Silent input with decayed filter memory gives silent output, so no
+    // audio work is needed; parameter changes are still applied below. A
+    // bypass crossfade, or a delayed dry signal still playing out, keeps
+    // the block running.
+    bool skipAudio = false;
+    if (hasAudio && numChannels > 0)
+    {
+        const uint64 channelMask = numChannels < 64 ? (uint64(1) << numChannels) - 1 : ~uint64(0);
+        const bool inputSilent = (data.inputs[0].silenceFlags & channelMask) == channelMask;
+        if (inputSilent)
+        {
+            if (data.symbolicSampleSize == kSample64)
+                skipAudio = m_filter64.isDecayed() && m_bypass64.isSilent();
+            else
+                skipAudio = m_filter.isDecayed() && m_bypass.isSilent();
+        }
         
-        for (int32 channel = 0; channel < numChannels && channel < 2; ++channel)
+        if (skipAudio)
         {
-            float* inputBuffer = input.channelBuffers32[channel];
-            float* outputBuffer = output.channelBuffers32[channel];
-            
-            for (int32 sample = 0; sample < numSamples; ++sample)
+            // The dry delay line still takes the block's silence
+            if (data.symbolicSampleSize == kSample64)
+                m_bypass64.skipSilence(numChannels, numSamples);
+            else
+                m_bypass.skipSilence(numChannels, numSamples);
+
+            for (int32 bus = 0; bus < numOutputs; bus++)
             {
-                float inputSample = inputBuffer[sample];
-                float outputSample;
-                
-                if (m_filterType == 0) // Low Pass Filter
-                {
-                    outputSample = applyLowPassFilter(inputSample, channel);
-                }
-                else // High Pass Filter
+                if (!outputs32[bus])
+                    continue;
+                for (int32 channel = 0; channel < numChannels; channel++)
                 {
-                    outputSample = applyHighPassFilter(inputSample, channel);
+                    if (data.symbolicSampleSize == kSample64)
+                    {
+                        if (outputs64[bus][channel] != data.inputs[0].channelBuffers64[channel])
+                            memset(outputs64[bus][channel], 0, numSamples * sizeof(Sample64));
+                    }
+                    else if (outputs32[bus][channel] != data.inputs[0].channelBuffers32[channel])
+                    {
+                        memset(outputs32[bus][channel], 0, numSamples * sizeof(Sample32));
+                    }
                 }
-                
-                outputBuffer[sample] = outputSample;
+                data.outputs[bus].silenceFlags = channelMask;
             }
+            m_silentBlocks.fetch_add(1, std::memory_order_relaxed);
+        }
+        else
+        {
+            for (int32 bus = 0; bus < numOutputs; bus++)
+                data.outputs[bus].silenceFlags = 0;
+            m_processedBlocks.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    
+    // Process audio in segments between parameter points; the number of
+    // segments depends on the number of points, not on numSamples
+    int32 position = 0;
+    do
+    {
+        int32 segmentEnd = numSamples;
+        for (int32 i = 0; i < numCursors; i++)
+        {
+            ParamQueueCursor& cursor = cursors[i];
+            while (cursor.hasPoint() && cursor.offset <= position)
+            {
+                applyParameter(cursor.queue->getParameterId(), cursor.value);
+                cursor.next();
+            }
+            if (cursor.hasPoint() && cursor.offset < segmentEnd)
+                segmentEnd = cursor.offset;
+        }
+        
+        if (hasAudio && !skipAudio && segmentEnd > position)
+        {
+            // While bypassed the filter does not run; audio is copied through
+            // and the band buses are silent
+            if (data.symbolicSampleSize == kSample64)
+                m_bypass64.processRange(m_filter64, data.inputs[0].channelBuffers64, outputs64, numOutputs,
+                                        numChannels, position, segmentEnd - position);
+            else
+                m_bypass.processRange(m_filter, data.inputs[0].channelBuffers32, outputs32, numOutputs,
+                                      numChannels, position, segmentEnd - position);
         }
+        position = segmentEnd;
+    } while (position < numSamples);
+    
+    // Points at or past the end of the block
+    for (int32 i = 0; i < numCursors; i++)
+    {
+        for (ParamQueueCursor& cursor = cursors[i]; cursor.hasPoint(); cursor.next())
+            applyParameter(cursor.queue->getParameterId(), cursor.value);
     }
     
     return kResultTrue;
 }
 
-float FilterVST3::applyLowPassFilter(float input, int channel)
+void FilterVST3::applyParameter(ParamID id, ParamValue normalizedValue)
 {
-    // Low Pass Filter: y[n] = (1-α)·x[n] + α·y[n-1]
-    // where α = 1 / (1 + fc/sample_rate)
-    float alpha = 1.0f / (1.0f + m_cutoffFreq / m_sampleRate);
-    float output = (1.0f - alpha) * input + alpha * m_lastOutput[channel];
-    m_lastOutput[channel] = output;
-    return output;
+    if (id == kBypassId)
+    {
+        m_bypass.setBypassed(normalizedValue >= 0.5);
+        m_bypass64.setBypassed(normalizedValue >= 0.5);
+    }
+    
+    applyToFilter(m_filter, id, normalizedValue);
+    applyToFilter(m_filter64, id, normalizedValue);
+    
+    // Bypass keeps the latency of the oversampled or linear-phase filter
+    if (id == kOversamplingId || id == kModeId)
+    {
+        m_bypass.setDryDelay(m_filter.getLatencySamples());
+        m_bypass64.setDryDelay(m_filter64.getLatencySamples());
+    }
 }
 
-float FilterVST3::applyHighPassFilter(float input, int channel)
+template <typename SampleType>
+void FilterVST3::applyToFilter(FilterDSP::FilterEngine<SampleType>& filter, ParamID id, ParamValue normalizedValue)
 {
-    // High Pass Filter: y[n] = α·(y[n-1] + x[n] - x[n-1])
-    // where α = fc / (fc + sample_rate)
-    float alpha = m_cutoffFreq / (m_cutoffFreq + m_sampleRate);
-    float output = alpha * (m_lastOutput[channel] + input - m_lastInput[channel]);
-    m_lastInput[channel] = input;
-    m_lastOutput[channel] = output;
-    return output;
+    switch (id)
+    {
+        case kFilterTypeId:
+            // 8 steps: low pass, high pass, band pass, notch, bell, low
+            // shelf, high shelf, all pass
+            filter.setFilterType(std::min(static_cast<int>(FilterDSP::kFilterTypeAllPass),
+                                          static_cast<int>(normalizedValue * FilterDSP::kFilterTypeAllPass + 0.5)));
+            break;
+        case kCutoffFreqId:
+            // Same range as the controller's "Cutoff Frequency" parameter
+            filter.setCutoff(static_cast<SampleType>(kMinCutoffFreq + normalizedValue * (kMaxCutoffFreq - kMinCutoffFreq)));
+            break;
+        case kSlopeId:
+            // 5 steps: 6, 12, 24, 36, 48 dB/oct
+            filter.setSlope(std::min(static_cast<int>(FilterDSP::kSlope48dB),
+                                     static_cast<int>(normalizedValue * FilterDSP::kSlope48dB + 0.5)));
+            break;
+        case kAlignmentId:
+            filter.setAlignment(normalizedValue < 0.5 ? FilterDSP::kAlignmentButterworth : FilterDSP::kAlignmentLinkwitzRiley);
+            break;
+        case kModeId:
+            // 6 steps: standard, state variable, linear phase, ladder,
+            // graphic EQ, crossover
+            filter.setMode(std::min(static_cast<int>(FilterDSP::kFilterModeCrossover),
+                                    static_cast<int>(normalizedValue * FilterDSP::kFilterModeCrossover + 0.5)));
+            break;
+        case kResonanceId:
+            // Ladder only; 1 is the edge of self-oscillation
+            filter.setResonance(static_cast<SampleType>(normalizedValue));
+            break;
+        case kQId:
+            // Same range as the controller's "Q" parameter
+            filter.setQ(FilterDSP::kMinQ + normalizedValue * (FilterDSP::kMaxQ - FilterDSP::kMinQ));
+            break;
+        case kGainId:
+            // -24..+24 dB, bell and shelves only
+            filter.setGain((2.0 * normalizedValue - 1.0) * FilterDSP::kMaxGainDb);
+            break;
+        case kOversamplingId:
+            // 4 steps: 1x, 2x, 4x, 8x
+            filter.setOversampling(std::min(static_cast<int>(FilterDSP::kOversampling8x),
+                                            static_cast<int>(normalizedValue * FilterDSP::kOversampling8x + 0.5)));
+            break;
+        case kBankBandsId:
+            // 1 to 31 graphic EQ bands
+            filter.setNumBands(1 + static_cast<int>(normalizedValue * (FilterDSP::kMaxBankBands - 1) + 0.5));
+            break;
+        case kBankLayoutId:
+            filter.setBankLayout(normalizedValue < 0.5 ? FilterDSP::kBankLayoutSerial : FilterDSP::kBankLayoutParallel);
+            break;
+        case kCrossoverBandsId:
+            // 2 to 5 crossover bands
+            filter.setCrossoverBands(FilterDSP::kMinCrossoverBands
+                                     + static_cast<int>(normalizedValue * (FilterDSP::kMaxCrossoverBands - FilterDSP::kMinCrossoverBands) + 0.5));
+            break;
+        default:
+            // -12..+12 dB per graphic EQ band
+            if (id >= kBandGainId && id < kBandGainId + FilterDSP::kMaxBankBands)
+                filter.setBandGain(static_cast<int>(id - kBandGainId), (2.0 * normalizedValue - 1.0) * FilterDSP::kMaxBankGainDb);
+            // Same range as the controller's "Crossover N" parameters
+            else if (id >= kCrossoverFreqId && id < kCrossoverFreqId + FilterDSP::kMaxCrossoverSplits)
+                filter.setCrossoverFrequency(static_cast<int>(id - kCrossoverFreqId),
+                                             FilterDSP::kCrossoverMinFreq + normalizedValue * (FilterDSP::kCrossoverMaxFreq - FilterDSP::kCrossoverMinFreq));
+            break;
+    }
 }
 
 tresult FilterVST3::setState(IBStream* state)
@@ -156,12 +418,82 @@ tresult FilterVST3::setState(IBStream* state)
     
     float savedCutoff = 0.0f;
     int savedType = 0;
+    float savedBypass = 0.0f;
+    int savedSlope = FilterDSP::kSlope6dB;
+    int savedAlignment = FilterDSP::kAlignmentButterworth;
+    int savedMode = FilterDSP::kFilterModeStandard;
+    int savedOversampling = FilterDSP::kOversampling1x;
+    float savedResonance = 0.0f;
+    float savedQ = float(FilterDSP::kDefaultQ);
+    float savedGain = 0.0f;
+    int savedBands = FilterDSP::kMaxBankBands;
+    int savedLayout = FilterDSP::kBankLayoutSerial;
+    float savedBandGains[FilterDSP::kMaxBankBands] = {};
+    int savedCrossoverBands = FilterDSP::kMinCrossoverBands;
+    float savedCrossoverFreqs[FilterDSP::kMaxCrossoverSplits];
+    for (int32 split = 0; split < FilterDSP::kMaxCrossoverSplits; split++)
+        savedCrossoverFreqs[split] = float(FilterDSP::kDefaultCrossoverFrequencies[split]);
     
     if (streamer.readFloat(savedCutoff) == false) return kResultFalse;
     if (streamer.readInt32(savedType) == false) return kResultFalse;
     
-    m_cutoffFreq = savedCutoff;
-    m_filterType = savedType;
+    // Fields added after the first release; older states end here
+    if (streamer.readFloat(savedBypass))
+    {
+        streamer.readInt32(savedSlope);
+        streamer.readInt32(savedAlignment);
+        streamer.readInt32(savedMode);
+        streamer.readInt32(savedOversampling);
+        streamer.readFloat(savedResonance);
+        streamer.readFloat(savedQ);
+        streamer.readFloat(savedGain);
+        streamer.readInt32(savedBands);
+        streamer.readInt32(savedLayout);
+        for (int32 band = 0; band < FilterDSP::kMaxBankBands; band++)
+            streamer.readFloat(savedBandGains[band]);
+        streamer.readInt32(savedCrossoverBands);
+        for (int32 split = 0; split < FilterDSP::kMaxCrossoverSplits; split++)
+            streamer.readFloat(savedCrossoverFreqs[split]);
+    }
+    
+    m_filter.setCutoff(savedCutoff);
+    m_filter.setFilterType(savedType);
+    m_filter.setSlope(savedSlope);
+    m_filter.setAlignment(savedAlignment);
+    m_filter.setMode(savedMode);
+    m_filter.setOversampling(savedOversampling);
+    m_filter.setResonance(savedResonance);
+    m_filter.setQ(savedQ);
+    m_filter.setGain(savedGain);
+    m_filter64.setCutoff(savedCutoff);
+    m_filter64.setFilterType(savedType);
+    m_filter64.setSlope(savedSlope);
+    m_filter64.setAlignment(savedAlignment);
+    m_filter64.setMode(savedMode);
+    m_filter64.setOversampling(savedOversampling);
+    m_filter64.setResonance(savedResonance);
+    m_filter64.setQ(savedQ);
+    m_filter64.setGain(savedGain);
+    m_filter.setNumBands(savedBands);
+    m_filter.setBankLayout(savedLayout);
+    m_filter64.setNumBands(savedBands);
+    m_filter64.setBankLayout(savedLayout);
+    for (int32 band = 0; band < FilterDSP::kMaxBankBands; band++)
+    {
+        m_filter.setBandGain(band, savedBandGains[band]);
+        m_filter64.setBandGain(band, savedBandGains[band]);
+    }
+    m_filter.setCrossoverBands(savedCrossoverBands);
+    m_filter64.setCrossoverBands(savedCrossoverBands);
+    for (int32 split = 0; split < FilterDSP::kMaxCrossoverSplits; split++)
+    {
+        m_filter.setCrossoverFrequency(split, savedCrossoverFreqs[split]);
+        m_filter64.setCrossoverFrequency(split, savedCrossoverFreqs[split]);
+    }
+    m_bypass.reset(savedBypass >= 0.5f);
+    m_bypass64.reset(savedBypass >= 0.5f);
+    m_bypass.setDryDelay(m_filter.getLatencySamples());
+    m_bypass64.setDryDelay(m_filter64.getLatencySamples());
     
     return kResultOk;
 }
@@ -172,8 +504,23 @@ tresult FilterVST3::getState(IBStream* state)
     
     IBStreamer streamer(state, kLittleEndian);
     
-    streamer.writeFloat(m_cutoffFreq);
-    streamer.writeInt32(m_filterType);
+    streamer.writeFloat(m_filter.getCutoff());
+    streamer.writeInt32(m_filter.getFilterType());
+    streamer.writeFloat(m_bypass.isBypassed() ? 1.0f : 0.0f);
+    streamer.writeInt32(m_filter.getSlope());
+    streamer.writeInt32(m_filter.getAlignment());
+    streamer.writeInt32(m_filter.getMode());
+    streamer.writeInt32(m_filter.getOversampling());
+    streamer.writeFloat(m_filter.getResonance());
+    streamer.writeFloat(float(m_filter.getQ()));
+    streamer.writeFloat(float(m_filter.getGain()));
+    streamer.writeInt32(m_filter.getNumBands());
+    streamer.writeInt32(m_filter.getBankLayout());
+    for (int32 band = 0; band < FilterDSP::kMaxBankBands; band++)
+        streamer.writeFloat(float(m_filter.getBandGain(band)));
+    streamer.writeInt32(m_filter.getCrossoverBands());
+    for (int32 split = 0; split < FilterDSP::kMaxCrossoverSplits; split++)
+        streamer.writeFloat(float(m_filter.getCrossoverFrequency(split)));
     
     return kResultOk;
 }
\ No newline at end of file
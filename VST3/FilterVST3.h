@@ -3,6 +3,11 @@
 #include "public.sdk/source/vst/vstaudioeffect.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 #include "pluginterfaces/base/ustring.h"
+#include "BypassFader.h"
+#include "CacheAligned.h"
+#include "DenormalGuard.h"
+#include "FilterEngine.h"
+#include <atomic>
 
 using namespace Steinberg;
 using namespace Steinberg::Vst;
@@ -21,6 +26,11 @@ public:
     tresult PLUGIN_API setState(IBStream* state) SMTG_OVERRIDE;
     tresult PLUGIN_API getState(IBStream* state) SMTG_OVERRIDE;
     tresult PLUGIN_API setupProcessing(ProcessSetup& newSetup) SMTG_OVERRIDE;
+    tresult PLUGIN_API canProcessSampleSize(int32 symbolicSampleSize) SMTG_OVERRIDE;
+    uint32 PLUGIN_API getTailSamples() SMTG_OVERRIDE;
+    uint32 PLUGIN_API getLatencySamples() SMTG_OVERRIDE;
+    tresult PLUGIN_API setBusArrangements(SpeakerArrangement* inputs, int32 numIns,
+                                          SpeakerArrangement* outputs, int32 numOuts) SMTG_OVERRIDE;
 
     // Factory method
     static FUnknown* createInstance(void*) { return (IAudioProcessor*)new FilterVST3(); }
@@ -29,20 +39,104 @@ public:
     enum ParameterIds
     {
         kFilterTypeId = 0,
-        kCutoffFreqId = 1
+        kCutoffFreqId = 1,
+        kBypassId = 2,
+        kSlopeId = 3,
+        kAlignmentId = 4,
+        kModeId = 5,
+        kOversamplingId = 6,
+        kResonanceId = 7,
+        kQId = 8,
+        kGainId = 9,
+        kBankBandsId = 10,
+        kBankLayoutId = 11,
+        kBandGainId = 12,   // Graphic EQ band gains, kBandGainId + band
+        kCrossoverBandsId = kBandGainId + FilterDSP::kMaxBankBands,
+        kCrossoverFreqId    // Crossover split frequencies, kCrossoverFreqId + split
     };
 
+    // Output buses: the main output, then one aux bus for each crossover
+    // band above the lowest (FilterDSP::kFilterModeCrossover)
+    static const int32 kMaxOutputBuses = FilterDSP::kMaxCrossoverBands;
+
+    // Blocks that ran the filter and blocks skipped because the input was
+    // silent and the filter memory had decayed, since the last activation
+    uint64 getProcessedBlocks() const { return m_processedBlocks.load(std::memory_order_relaxed); }
+    uint64 getSilentBlocks() const { return m_silentBlocks.load(std::memory_order_relaxed); }
+
+    // Cutoff range (matches FilterVST3Controller)
+    static constexpr double kMinCutoffFreq = 20.0;
+    static constexpr double kMaxCutoffFreq = 20000.0;
+
 private:
-    // Filter state variables
-    float m_sampleRate;
-    float m_cutoffFreq;
-    int m_filterType; // 0 = LPF, 1 = HPF
+    // Number of parameters applied sample-accurately from the parameter queues
+    static const int32 kNumAutomatedParams = kCrossoverFreqId + FilterDSP::kMaxCrossoverSplits;
+
+    // Walks the points of one parameter queue while process() splits the block
+    struct ParamQueueCursor
+    {
+        IParamValueQueue* queue = nullptr;
+        int32 numPoints = 0;
+        int32 index = 0;
+        int32 offset = 0;
+        ParamValue value = 0.0;
+
+        void init(IParamValueQueue* paramQueue)
+        {
+            queue = paramQueue;
+            numPoints = paramQueue->getPointCount();
+            index = 0;
+            next();
+        }
+
+        bool hasPoint() const { return index <= numPoints && queue != nullptr; }
+
+        // Load the next point; past the last point hasPoint() turns false
+        void next()
+        {
+            if (index < numPoints && queue->getPoint(index, offset, value) == kResultTrue)
+                ++index;
+            else
+                index = numPoints + 1;
+        }
+    };
+
+    // Apply a normalized parameter value to both filter engines
+    void applyParameter(ParamID id, ParamValue normalizedValue);
+
+    template <typename SampleType>
+    static void applyToFilter(FilterDSP::FilterEngine<SampleType>& filter, ParamID id, ParamValue normalizedValue);
+
+    // Size the filter memory for the current output bus arrangement and
+    // block size, and the bypass delay for the largest latency
+    void prepareFilter();
+    
+    // Host's maxSamplesPerBlock (setupProcessing)
+    int32 m_maxBlockSize;
+
+    // Everything process() writes per block, allocated on its own cache
+    // lines so it shares none with other instances or with the members the
+    // host and controller threads touch
+    struct ProcessState
+    {
+        FilterDSP::FilterEngine<float> filter;
+        FilterDSP::FilterEngine<double> filter64;
+        FilterDSP::BypassFader<float> bypass;
+        FilterDSP::BypassFader<double> bypass64;
+    };
+    FilterDSP::CacheAlignedPtr<ProcessState> m_processState;
+
+    // Shared filter engines (parameters and per-channel memory) for 32- and
+    // 64-bit processing. Both receive every parameter change so the host can
+    // switch sample size in setupProcessing without losing settings.
+    FilterDSP::FilterEngine<float>& m_filter;
+    FilterDSP::FilterEngine<double>& m_filter64;
     
-    // Filter memory
-    float m_lastOutput[2]; // stereo
-    float m_lastInput[2];  // for HPF
+    // Bypass crossfade and pass-through for each sample size
+    FilterDSP::BypassFader<float>& m_bypass;
+    FilterDSP::BypassFader<double>& m_bypass64;
     
-    // Filter functions
-    float applyLowPassFilter(float input, int channel);
-    float applyHighPassFilter(float input, int channel);
+    // Silence statistics (see getSilentBlocks)
+    std::atomic<uint64> m_processedBlocks;
+    std::atomic<uint64> m_silentBlocks;
 };
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "FilterVST3Controller.h"
 #include "base/source/fstreamer.h"
 #include "pluginterfaces/base/ibstream.h"
+#include "pluginterfaces/base/ustring.h"
+#include <cstdio>
 
 using namespace Steinberg;
 using namespace Steinberg::Vst;
@@ -9,7 +11,21 @@ FilterVST3Controller::FilterVST3Controller()
 : mFilterTypeParam(nullptr)
 , mCutoffFreqParam(nullptr)
 , mBypassParam(nullptr)
+, mSlopeParam(nullptr)
+, mAlignmentParam(nullptr)
+, mModeParam(nullptr)
+, mOversamplingParam(nullptr)
+, mResonanceParam(nullptr)
+, mQParam(nullptr)
+, mGainParam(nullptr)
+, mBankBandsParam(nullptr)
+, mBankLayoutParam(nullptr)
+, mCrossoverBandsParam(nullptr)
 {
+    for (int32 band = 0; band < FilterDSP::kMaxBankBands; band++)
+        mBandGainParams[band] = nullptr;
+    for (int32 split = 0; split < FilterDSP::kMaxCrossoverSplits; split++)
+        mCrossoverFreqParams[split] = nullptr;
     setControllerClass(FilterVST3ControllerUID);
 }
 
@@ -23,7 +39,9 @@ tresult FilterVST3Controller::initialize(FUnknown* context)
     if (result == kResultTrue)
     {
         // Create parameters
-        mFilterTypeParam = new RangeParameter(STR16("Filter Type"), kFilterTypeId, nullptr, 0, 1, 0, 0, ParameterInfo::kCanAutomate);
+        // 0..7 = Low Pass, High Pass, Band Pass, Notch, Bell, Low Shelf,
+        // High Shelf, All Pass (band pass onwards are one biquad set by Q and Gain)
+        mFilterTypeParam = new RangeParameter(STR16("Filter Type"), kFilterTypeId, nullptr, 0, 7, 0, 7, ParameterInfo::kCanAutomate);
         mFilterTypeParam->setPrecision(0);
         parameters.addParameter(mFilterTypeParam);
 
@@ -34,6 +52,88 @@ tresult FilterVST3Controller::initialize(FUnknown* context)
         mBypassParam = new RangeParameter(STR16("Bypass"), kBypassId, nullptr, 0, 1, 0, 0, ParameterInfo::kCanAutomate | ParameterInfo::kIsBypass);
         mBypassParam->setPrecision(0);
         parameters.addParameter(mBypassParam);
+
+        // 0..4 = 6, 12, 24, 36, 48 dB/oct
+        mSlopeParam = new RangeParameter(STR16("Slope"), kSlopeId, nullptr, 0, 4, 0, 4, ParameterInfo::kCanAutomate);
+        mSlopeParam->setPrecision(0);
+        parameters.addParameter(mSlopeParam);
+
+        // 0 = Butterworth, 1 = Linkwitz-Riley
+        mAlignmentParam = new RangeParameter(STR16("Alignment"), kAlignmentId, nullptr, 0, 1, 0, 1, ParameterInfo::kCanAutomate);
+        mAlignmentParam->setPrecision(0);
+        parameters.addParameter(mAlignmentParam);
+
+        // 0 = Standard (one-pole / biquad cascade), 1 = State Variable,
+        // 2 = Linear Phase, 3 = Ladder, 4 = Graphic EQ, 5 = Crossover.
+        // Not automatable: linear phase changes the latency.
+        mModeParam = new RangeParameter(STR16("Mode"), kModeId, nullptr, 0, 5, 0, 5, 0);
+        mModeParam->setPrecision(0);
+        parameters.addParameter(mModeParam);
+
+        // 0..3 = 1x, 2x, 4x, 8x. Not automatable: it changes the latency.
+        mOversamplingParam = new RangeParameter(STR16("Oversampling"), kOversamplingId, nullptr, 0, 3, 0, 3, 0);
+        mOversamplingParam->setPrecision(0);
+        parameters.addParameter(mOversamplingParam);
+
+        // Ladder mode only; 1 = self-oscillation
+        mResonanceParam = new RangeParameter(STR16("Resonance"), kResonanceId, nullptr, 0, 1, 0, 0, ParameterInfo::kCanAutomate);
+        mResonanceParam->setPrecision(2);
+        parameters.addParameter(mResonanceParam);
+
+        // Band pass to all pass, and the state variable filter's resonance
+        mQParam = new RangeParameter(STR16("Q"), kQId, nullptr, FilterDSP::kMinQ, FilterDSP::kMaxQ, FilterDSP::kDefaultQ, 0, ParameterInfo::kCanAutomate);
+        mQParam->setPrecision(2);
+        parameters.addParameter(mQParam);
+
+        // Bell and shelves only
+        mGainParam = new RangeParameter(STR16("Gain"), kGainId, STR16("dB"), -FilterDSP::kMaxGainDb, FilterDSP::kMaxGainDb, 0, 0, ParameterInfo::kCanAutomate);
+        mGainParam->setPrecision(1);
+        parameters.addParameter(mGainParam);
+
+        // Graphic EQ mode: bands spread evenly over 20 Hz - 20 kHz
+        // (31 = third octaves), 0 = Serial, 1 = Parallel
+        mBankBandsParam = new RangeParameter(STR16("EQ Bands"), kBankBandsId, nullptr, 1, FilterDSP::kMaxBankBands,
+                                             FilterDSP::kMaxBankBands, FilterDSP::kMaxBankBands - 1, ParameterInfo::kCanAutomate);
+        mBankBandsParam->setPrecision(0);
+        parameters.addParameter(mBankBandsParam);
+
+        mBankLayoutParam = new RangeParameter(STR16("EQ Layout"), kBankLayoutId, nullptr, 0, 1, 0, 1, ParameterInfo::kCanAutomate);
+        mBankLayoutParam->setPrecision(0);
+        parameters.addParameter(mBankLayoutParam);
+
+        // One gain per band, from the lowest up; bands at 0 dB cost nothing
+        for (int32 band = 0; band < FilterDSP::kMaxBankBands; band++)
+        {
+            char title[32];
+            snprintf(title, sizeof(title), "EQ Band %d Gain", band + 1);
+            mBandGainParams[band] = new RangeParameter(UString128(title), kBandGainId + band, STR16("dB"),
+                                                       -FilterDSP::kMaxBankGainDb, FilterDSP::kMaxBankGainDb, 0, 0,
+                                                       ParameterInfo::kCanAutomate);
+            mBandGainParams[band]->setPrecision(1);
+            parameters.addParameter(mBandGainParams[band]);
+        }
+
+        // Crossover mode: the lowest band on the main output, the others on
+        // the "Band 2".."Band 5" buses. Splits past the band count are unused.
+        mCrossoverBandsParam = new RangeParameter(STR16("Crossover Bands"), kCrossoverBandsId, nullptr,
+                                                  FilterDSP::kMinCrossoverBands, FilterDSP::kMaxCrossoverBands,
+                                                  FilterDSP::kMinCrossoverBands,
+                                                  FilterDSP::kMaxCrossoverBands - FilterDSP::kMinCrossoverBands,
+                                                  ParameterInfo::kCanAutomate);
+        mCrossoverBandsParam->setPrecision(0);
+        parameters.addParameter(mCrossoverBandsParam);
+
+        for (int32 split = 0; split < FilterDSP::kMaxCrossoverSplits; split++)
+        {
+            char title[32];
+            snprintf(title, sizeof(title), "Crossover %d Frequency", split + 1);
+            mCrossoverFreqParams[split] = new RangeParameter(UString128(title), kCrossoverFreqId + split, STR16("Hz"),
+                                                             FilterDSP::kCrossoverMinFreq, FilterDSP::kCrossoverMaxFreq,
+                                                             FilterDSP::kDefaultCrossoverFrequencies[split], 0,
+                                                             ParameterInfo::kCanAutomate);
+            mCrossoverFreqParams[split]->setPrecision(0);
+            parameters.addParameter(mCrossoverFreqParams[split]);
+        }
     }
     return result;
 }
@@ -52,14 +152,68 @@ tresult FilterVST3Controller::setComponentState(IBStream* state)
     float savedCutoff = 0.0f;
     int savedType = 0;
     float savedBypass = 0.0f;
+    int savedSlope = 0;
+    int savedAlignment = 0;
+    int savedMode = 0;
+    int savedOversampling = 0;
+    float savedResonance = 0.0f;
+    float savedQ = float(FilterDSP::kDefaultQ);
+    float savedGain = 0.0f;
+    int savedBands = FilterDSP::kMaxBankBands;
+    int savedLayout = FilterDSP::kBankLayoutSerial;
+    float savedBandGains[FilterDSP::kMaxBankBands] = {};
+    int savedCrossoverBands = FilterDSP::kMinCrossoverBands;
+    float savedCrossoverFreqs[FilterDSP::kMaxCrossoverSplits];
+    for (int32 split = 0; split < FilterDSP::kMaxCrossoverSplits; split++)
+        savedCrossoverFreqs[split] = float(FilterDSP::kDefaultCrossoverFrequencies[split]);
     
     if (streamer.readFloat(savedCutoff) == false) return kResultFalse;
     if (streamer.readInt32(savedType) == false) return kResultFalse;
-    if (streamer.readFloat(savedBypass) == false) return kResultFalse;
     
-    if (mCutoffFreqParam) mCutoffFreqParam->setNormalized(savedCutoff / 20000.0f);
-    if (mFilterTypeParam) mFilterTypeParam->setNormalized(savedType);
+    // Older states end after the filter type
+    if (streamer.readFloat(savedBypass))
+    {
+        streamer.readInt32(savedSlope);
+        streamer.readInt32(savedAlignment);
+        streamer.readInt32(savedMode);
+        streamer.readInt32(savedOversampling);
+        streamer.readFloat(savedResonance);
+        streamer.readFloat(savedQ);
+        streamer.readFloat(savedGain);
+        streamer.readInt32(savedBands);
+        streamer.readInt32(savedLayout);
+        for (int32 band = 0; band < FilterDSP::kMaxBankBands; band++)
+            streamer.readFloat(savedBandGains[band]);
+        streamer.readInt32(savedCrossoverBands);
+        for (int32 split = 0; split < FilterDSP::kMaxCrossoverSplits; split++)
+            streamer.readFloat(savedCrossoverFreqs[split]);
+    }
+    
+    if (mCutoffFreqParam) mCutoffFreqParam->setNormalized(mCutoffFreqParam->toNormalized(savedCutoff));
+    if (mFilterTypeParam) mFilterTypeParam->setNormalized(mFilterTypeParam->toNormalized(savedType));
     if (mBypassParam) mBypassParam->setNormalized(savedBypass);
+    if (mSlopeParam) mSlopeParam->setNormalized(mSlopeParam->toNormalized(savedSlope));
+    if (mAlignmentParam) mAlignmentParam->setNormalized(savedAlignment);
+    if (mModeParam)
+        setParamNormalized(kModeId, mModeParam->toNormalized(savedMode));
+    if (mOversamplingParam)
+        setParamNormalized(kOversamplingId, mOversamplingParam->toNormalized(savedOversampling));
+    if (mResonanceParam) mResonanceParam->setNormalized(savedResonance);
+    if (mQParam) mQParam->setNormalized(mQParam->toNormalized(savedQ));
+    if (mGainParam) mGainParam->setNormalized(mGainParam->toNormalized(savedGain));
+    if (mBankBandsParam) mBankBandsParam->setNormalized(mBankBandsParam->toNormalized(savedBands));
+    if (mBankLayoutParam) mBankLayoutParam->setNormalized(savedLayout);
+    for (int32 band = 0; band < FilterDSP::kMaxBankBands; band++)
+    {
+        if (mBandGainParams[band])
+            mBandGainParams[band]->setNormalized(mBandGainParams[band]->toNormalized(savedBandGains[band]));
+    }
+    if (mCrossoverBandsParam) mCrossoverBandsParam->setNormalized(mCrossoverBandsParam->toNormalized(savedCrossoverBands));
+    for (int32 split = 0; split < FilterDSP::kMaxCrossoverSplits; split++)
+    {
+        if (mCrossoverFreqParams[split])
+            mCrossoverFreqParams[split]->setNormalized(mCrossoverFreqParams[split]->toNormalized(savedCrossoverFreqs[split]));
+    }
     
     return kResultOk;
 }
@@ -69,19 +223,62 @@ tresult FilterVST3Controller::setState(IBStream* state)
     return setComponentState(state);
 }
 
+tresult FilterVST3Controller::setParamNormalized(ParamID tag, ParamValue value)
+{
+    // The oversampling factor and the linear-phase mode change the
+    // processor's latency
+    const bool latencyChanged = (tag == kOversamplingId || tag == kModeId) && getParamNormalized(tag) != value;
+    tresult result = EditController::setParamNormalized(tag, value);
+    if (latencyChanged && componentHandler)
+        componentHandler->restartComponent(kLatencyChanged);
+    return result;
+}
+
 tresult FilterVST3Controller::getState(IBStream* state)
 {
     if (!state) return kResultFalse;
     
     IBStreamer streamer(state, kLittleEndian);
     
-    float cutoff = mCutoffFreqParam ? mCutoffFreqParam->getNormalized() * 20000.0f : 1000.0f;
-    int type = mFilterTypeParam ? (int)mFilterTypeParam->getNormalized() : 0;
+    float cutoff = mCutoffFreqParam ? (float)mCutoffFreqParam->toPlain(mCutoffFreqParam->getNormalized()) : 1000.0f;
+    int type = mFilterTypeParam ? (int)(mFilterTypeParam->toPlain(mFilterTypeParam->getNormalized()) + 0.5) : 0;
     float bypass = mBypassParam ? mBypassParam->getNormalized() : 0.0f;
+    int slope = mSlopeParam ? (int)(mSlopeParam->toPlain(mSlopeParam->getNormalized()) + 0.5) : 0;
+    int alignment = mAlignmentParam ? (int)(mAlignmentParam->getNormalized() + 0.5) : 0;
+    int mode = mModeParam ? (int)(mModeParam->toPlain(mModeParam->getNormalized()) + 0.5) : 0;
+    int oversampling = mOversamplingParam ? (int)(mOversamplingParam->toPlain(mOversamplingParam->getNormalized()) + 0.5) : 0;
+    float resonance = mResonanceParam ? (float)mResonanceParam->getNormalized() : 0.0f;
+    float q = mQParam ? (float)mQParam->toPlain(mQParam->getNormalized()) : (float)FilterDSP::kDefaultQ;
+    float gain = mGainParam ? (float)mGainParam->toPlain(mGainParam->getNormalized()) : 0.0f;
+    int bands = mBankBandsParam ? (int)(mBankBandsParam->toPlain(mBankBandsParam->getNormalized()) + 0.5) : FilterDSP::kMaxBankBands;
+    int layout = mBankLayoutParam ? (int)(mBankLayoutParam->getNormalized() + 0.5) : 0;
+    int crossoverBands = mCrossoverBandsParam ? (int)(mCrossoverBandsParam->toPlain(mCrossoverBandsParam->getNormalized()) + 0.5)
+                                              : FilterDSP::kMinCrossoverBands;
     
     streamer.writeFloat(cutoff);
     streamer.writeInt32(type);
     streamer.writeFloat(bypass);
+    streamer.writeInt32(slope);
+    streamer.writeInt32(alignment);
+    streamer.writeInt32(mode);
+    streamer.writeInt32(oversampling);
+    streamer.writeFloat(resonance);
+    streamer.writeFloat(q);
+    streamer.writeFloat(gain);
+    streamer.writeInt32(bands);
+    streamer.writeInt32(layout);
+    for (int32 band = 0; band < FilterDSP::kMaxBankBands; band++)
+    {
+        float bandGain = mBandGainParams[band] ? (float)mBandGainParams[band]->toPlain(mBandGainParams[band]->getNormalized()) : 0.0f;
+        streamer.writeFloat(bandGain);
+    }
+    streamer.writeInt32(crossoverBands);
+    for (int32 split = 0; split < FilterDSP::kMaxCrossoverSplits; split++)
+    {
+        float frequency = mCrossoverFreqParams[split] ? (float)mCrossoverFreqParams[split]->toPlain(mCrossoverFreqParams[split]->getNormalized())
+                                                      : (float)FilterDSP::kDefaultCrossoverFrequencies[split];
+        streamer.writeFloat(frequency);
+    }
     
     return kResultOk;
 } 
\ No newline at end of file
@@ -3,6 +3,8 @@
 #include "public.sdk/source/vst/vsteditcontroller.h"
 #include "pluginterfaces/vst/ivstparameterchanges.h"
 #include "base/source/fstreamer.h"
+#include "CrossoverDesigner.h"
+#include "FilterBankDesigner.h"
 
 using namespace Steinberg;
 using namespace Steinberg::Vst;
@@ -19,6 +21,7 @@ public:
     tresult PLUGIN_API setComponentState(IBStream* state) SMTG_OVERRIDE;
     tresult PLUGIN_API setState(IBStream* state) SMTG_OVERRIDE;
     tresult PLUGIN_API getState(IBStream* state) SMTG_OVERRIDE;
+    tresult PLUGIN_API setParamNormalized(ParamID tag, ParamValue value) SMTG_OVERRIDE;
 
     // Factory method
     static FUnknown* createInstance(void*) { return (IEditController*)new FilterVST3Controller(); }
@@ -28,7 +31,19 @@ public:
     {
         kFilterTypeId = 0,
         kCutoffFreqId = 1,
-        kBypassId = 2
+        kBypassId = 2,
+        kSlopeId = 3,
+        kAlignmentId = 4,
+        kModeId = 5,
+        kOversamplingId = 6,
+        kResonanceId = 7,
+        kQId = 8,
+        kGainId = 9,
+        kBankBandsId = 10,
+        kBankLayoutId = 11,
+        kBandGainId = 12,   // Graphic EQ band gains, kBandGainId + band
+        kCrossoverBandsId = kBandGainId + FilterDSP::kMaxBankBands,
+        kCrossoverFreqId    // Crossover split frequencies, kCrossoverFreqId + split
     };
 
 private:
@@ -36,4 +51,16 @@ private:
     Parameter* mFilterTypeParam;
     Parameter* mCutoffFreqParam;
     Parameter* mBypassParam;
+    Parameter* mSlopeParam;
+    Parameter* mAlignmentParam;
+    Parameter* mModeParam;
+    Parameter* mOversamplingParam;
+    Parameter* mResonanceParam;
+    Parameter* mQParam;
+    Parameter* mGainParam;
+    Parameter* mBankBandsParam;
+    Parameter* mBankLayoutParam;
+    Parameter* mBandGainParams[FilterDSP::kMaxBankBands];
+    Parameter* mCrossoverBandsParam;
+    Parameter* mCrossoverFreqParams[FilterDSP::kMaxCrossoverSplits];
 }; 
\ No newline at end of file
@@ -15,6 +15,7 @@ echo "📁 Copying source files..."
 cp -r CMakeLists.txt "$DIST_DIR/"
 cp -r FilterVST3.h "$DIST_DIR/"
 cp -r FilterVST3.cpp "$DIST_DIR/"
+cp -r ../DSP "$DIST_DIR/DSP"
 cp -r resource "$DIST_DIR/"
 cp -r build.sh "$DIST_DIR/"
 cp -r build.bat "$DIST_DIR/"